@@ -5,6 +5,7 @@
 #include "MainWindow.h"
 #include "SecurityManager.h"
 #include "SchemeRegistry.h"
+#include "TraceLog.h"
 #include "URLSuggestion.h"
 #include "WebWidget.h"
 #include "ui/welcome_window/WelcomeWindow.h"
@@ -12,6 +13,7 @@
 
 #include <memory>
 #include <vector>
+#include <QCoreApplication>
 #include <QMetaType>
 #include <QUrl>
 #include <QtGlobal>
@@ -146,6 +148,9 @@ int main(int argc, char *argv[])
         qWarning() << "Could not install handler for signal SIGSEGV";
 #endif
 
+    // Record a trace of the startup and of page loads, when requested through the environment
+    TraceLog::initFromEnvironment();
+
     SchemeRegistry::registerSchemes();
 
     // Check if any application arguments include URLs
@@ -161,10 +166,14 @@ int main(int argc, char *argv[])
         }
     }
 
-    // Check if there is an existing instance of the browser application
+    // Check if there is an existing instance of the browser application. This also claims the role of the
+    // first instance, before the slower setup of the application begins
     BrowserIPC ipc;
     if (ipc.hasExistingInstance())
     {
+        // The connection to the existing instance needs an application object
+        QCoreApplication ipcApp(argc, argv);
+
         QString ipcMessage;
 
         // If appArgUrls is not empty, concatenate the
@@ -6,6 +6,7 @@
 #include "InternalDownloadItem.h"
 #include "DownloadManager.h"
 #include "SchemeRegistry.h"
+#include "TraceLog.h"
 
 #include <QDir>
 #include <QDirIterator>
@@ -74,6 +75,44 @@ AdBlockManager::~AdBlockManager()
     save();
 }
 
+std::vector<ResourceUsage> AdBlockManager::getResourceUsage() const
+{
+    // The filter estimate covers the filters and the strings they were parsed into, but not their compiled
+    // regular expressions or the containers that index them
+    quint64 numFilters = 0;
+    qint64 filtersSize = 0;
+    for (const Subscription &subscription : m_subscriptions)
+    {
+        const std::size_t subscriptionSize = subscription.getNumFilters();
+        numFilters += subscriptionSize;
+        for (std::size_t i = 0; i < subscriptionSize; ++i)
+        {
+            if (const Filter *filter = subscription.getFilter(i))
+            {
+                filtersSize += static_cast<qint64>(sizeof(Filter))
+                        + (filter->getRule().capacity() + filter->getEvalString().capacity()
+                           + filter->getContentSecurityPolicy().capacity()) * static_cast<qint64>(sizeof(QChar));
+            }
+        }
+    }
+
+    auto getCacheSize = [](const LRUCache<std::string, QString> &cache) {
+        qint64 cacheSize = 0;
+        for (const auto &it : cache)
+        {
+            cacheSize += static_cast<qint64>(sizeof(std::string) + sizeof(QString) + it.first.capacity())
+                    + it.second.capacity() * static_cast<qint64>(sizeof(QChar));
+        }
+        return cacheSize;
+    };
+
+    return {
+        ResourceUsage { QStringLiteral("Ad block filters"), numFilters, filtersSize },
+        ResourceUsage { QStringLiteral("Ad block stylesheet cache"), m_domainStylesheetCache.size(), getCacheSize(m_domainStylesheetCache) },
+        ResourceUsage { QStringLiteral("Ad block script cache"), m_jsInjectionCache.size(), getCacheSize(m_jsInjectionCache) }
+    };
+}
+
 void AdBlockManager::setEnabled(bool value)
 {
     if (m_enabled == value)
@@ -392,6 +431,8 @@ const QString &AdBlockManager::getDomainJavaScript(const URL &url)
 
 bool AdBlockManager::shouldBlockRequest(QWebEngineUrlRequestInfo &info, const QUrl &firstPartyUrl)
 {
+    VIPER_TRACE_SCOPE("network", "AdBlockManager::shouldBlockRequest");
+
     if (!m_enabled || SchemeRegistry::isSchemeWhitelisted(info.requestUrl().scheme().toLower()))
         return false;
 
@@ -607,6 +648,8 @@ void AdBlockManager::onSettingChanged(BrowserSetting setting, const QVariant &va
 
 void AdBlockManager::loadSubscriptions()
 {
+    VIPER_TRACE_SCOPE("startup", "AdBlockManager::loadSubscriptions");
+
     if (!m_enabled)
         return;
 
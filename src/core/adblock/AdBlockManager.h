@@ -4,6 +4,7 @@
 #include "AdBlockFilter.h"
 #include "AdBlockFilterContainer.h"
 #include "AdBlockSubscription.h"
+#include "IResourceReporter.h"
 #include "LRUCache.h"
 #include "ServiceLocator.h"
 #include "Settings.h"
@@ -39,7 +40,7 @@ namespace adblock
  *        network requests against blocking and allowing filter rules before
  *        letting any requests go through.
  */
-class AdBlockManager : public QObject, public ISettingsObserver
+class AdBlockManager : public QObject, public ISettingsObserver, public IResourceReporter
 {
     friend class FilterParser;
     friend class AdBlockModel;
@@ -54,6 +55,9 @@ class AdBlockManager : public QObject, public ISettingsObserver
     /// AdBlockManager destructor
     ~AdBlockManager();
 
+    /// Returns the memory held by the filter lists and injection caches
+    std::vector<ResourceUsage> getResourceUsage() const override;
+
     /// Sets the state of the ad block manager. If true, it will filter network requests as per filter rules. Otherwise, no blocking will be done
     void setEnabled(bool value);
 
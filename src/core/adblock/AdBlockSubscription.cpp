@@ -200,6 +200,17 @@ Filter *Subscription::getFilter(size_t index)
     return m_filters[index].get();
 }
 
+const Filter *Subscription::getFilter(size_t index) const
+{
+    if (!m_enabled)
+        return nullptr;
+
+    if (index >= m_filters.size())
+        return nullptr;
+
+    return m_filters[index].get();
+}
+
 const QString &Subscription::getFilePath() const
 {
     return m_filePath;
@@ -89,6 +89,9 @@ class Subscription
     /// Returns the filter at the given index
     Filter *getFilter(size_t index);
 
+    /// Returns the filter at the given index
+    const Filter *getFilter(size_t index) const;
+
     /// Returns the absolute path of the subscription file
     const QString &getFilePath() const;
 
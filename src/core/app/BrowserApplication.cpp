@@ -21,6 +21,8 @@
 #include "SecurityManager.h"
 #include "SearchEngineManager.h"
 #include "Settings.h"
+#include "TabLifecycleManager.h"
+#include "TraceLog.h"
 #include "NetworkAccessManager.h"
 #include "RequestInterceptor.h"
 #include "UserAgentManager.h"
@@ -38,8 +40,10 @@
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QJsonDocument>
 #include <QPalette>
 #include <QPluginLoader>
+#include <QThread>
 #include <QUrl>
 #include <QDebug>
 #include <QWebEngineCookieStore>
@@ -51,7 +55,15 @@
 #include <QtWebEngineCoreVersion>
 
 BrowserApplication::BrowserApplication(BrowserIPC *ipc, int &argc, char **argv) :
-    QApplication(argc, argv)
+    QApplication(argc, argv),
+    m_databaseScheduler(),
+    m_serviceLocator(),
+    m_ipc(nullptr),
+    m_sessionTimerId(0),
+    m_tabLifecycleMgr(nullptr),
+    m_sessionMgr(m_databaseScheduler),
+    m_favoritePagesMgr(nullptr),
+    m_numPendingServices(2)
 {
     QCoreApplication::setOrganizationName(QLatin1String("Vaccarelli"));
     QCoreApplication::setApplicationName(QLatin1String("Viper-Browser"));
@@ -62,31 +74,47 @@ BrowserApplication::BrowserApplication(BrowserIPC *ipc, int &argc, char **argv)
     setWindowIcon(QIcon(QLatin1String(":/logo.png")));
 
     // Web profiles must be set up immediately upon browser initialization
+    m_startupTrace.beginStage("Web profiles");
     setupWebProfiles();
 
-    // Set pointer to the IPC handler. This is checked for pending messages on a regular basis
+    // Set pointer to the IPC handler, which announces messages from other instances as they arrive
     m_ipc = ipc;
-
-    // Check for IPC messages every 5 seconds
-    m_ipcTimerId = startTimer(1000 * 5);
+    if (m_ipc)
+    {
+        connect(m_ipc, &BrowserIPC::messageReceived, this, &BrowserApplication::checkBrowserIPC);
+        m_ipc->listen();
+    }
 
     // Instantiate and load settings
+    m_startupTrace.beginStage("Settings");
     m_settings = new Settings(m_defaultProfile->settings());
     registerService(m_settings);
 
+    // Databases are loaded on their own threads, so the scheduler is started as soon as the workers are
+    // registered. Only the services needed to show the first window are created on the GUI thread
+    m_startupTrace.beginStage("Database workers");
+    m_databaseScheduler.addWorker("BookmarkStore",
+                                  std::bind(DatabaseFactory::createDBWorker<BookmarkStore>, m_settings->getPathValue(BrowserSetting::BookmarkPath)));
+
+    // History queries are run on a pool of read-only connections, so they do not wait behind visits being recorded
+    const QString historyPath = m_settings->getPathValue(BrowserSetting::HistoryPath);
+    m_databaseScheduler.addWorker("HistoryStore",
+                                  std::bind(DatabaseFactory::createDBWorker<HistoryStore>, historyPath),
+                                  std::bind(DatabaseFactory::createReadOnlyWorker<HistoryStore>, historyPath));
+
+    const StartupTrace::Clock::time_point databaseStart = StartupTrace::Clock::now();
+    m_databaseScheduler.run();
+
     // Initialize favicon storage module
-    //m_databaseScheduler.addWorker("FaviconStore",
-    //                              std::bind(DatabaseFactory::createDBWorker<FaviconStore>, m_settings->getPathValue(BrowserSetting::FaviconPath)));
-    m_faviconMgr = new FaviconManager(m_settings->getPathValue(BrowserSetting::FaviconPath));
+    m_faviconMgr = new FaviconManager(m_databaseScheduler, m_settings->getPathValue(BrowserSetting::FaviconPath));
     registerService(m_faviconMgr);
 
     // Bookmark setup
-    m_databaseScheduler.addWorker("BookmarkStore",
-                                  std::bind(DatabaseFactory::createDBWorker<BookmarkStore>, m_settings->getPathValue(BrowserSetting::BookmarkPath)));
     m_bookmarkManager = new BookmarkManager(m_serviceLocator, m_databaseScheduler, nullptr);
     registerService(m_bookmarkManager);
 
     // Initialize cookie jar and cookie manager UI
+    m_startupTrace.beginStage("Cookies");
     m_cookieJar = new CookieJar(m_settings, m_defaultProfile, false);
     registerService(m_cookieJar);
 
@@ -97,6 +125,7 @@ BrowserApplication::BrowserApplication(BrowserIPC *ipc, int &argc, char **argv)
     m_defaultProfile->cookieStore()->loadAllCookies();
 
     // Initialize auto fill manager
+    m_startupTrace.beginStage("Services");
     m_autoFill = new AutoFill(m_settings);
     registerService(m_autoFill);
 
@@ -110,18 +139,43 @@ BrowserApplication::BrowserApplication(BrowserIPC *ipc, int &argc, char **argv)
     registerService(m_adBlockManager);
 
     // Instantiate the history manager and related systems
-    m_databaseScheduler.addWorker("HistoryStore",
-                                  std::bind(DatabaseFactory::createDBWorker<HistoryStore>, m_settings->getPathValue(BrowserSetting::HistoryPath)));
     m_historyMgr = new HistoryManager(m_serviceLocator, m_databaseScheduler);
     registerService(m_historyMgr);
 
-    m_thumbnailStore = DatabaseFactory::createWorker<WebPageThumbnailStore>(m_serviceLocator, m_settings->getPathValue(BrowserSetting::ThumbnailPath));
-    registerService(m_thumbnailStore.get());
+    // The extension storage and thumbnail store are loaded on their own strands, then moved to the GUI thread.
+    // The first window does not wait for them: they are registered, along with the favorite pages manager, once
+    // they have loaded
+    QThread *guiThread = thread();
+    const QString extStoragePath = m_settings->getPathValue(BrowserSetting::ExtensionStoragePath);
+    m_databaseScheduler.postTask("ExtStorage", [extStoragePath, guiThread](){
+        std::unique_ptr<ExtStorage> extStorage = DatabaseFactory::createWorker<ExtStorage>(extStoragePath);
+        extStorage->moveToThread(guiThread);
+        return extStorage;
+    }).then(this, [this](std::unique_ptr<ExtStorage> &&extStorage){
+        onExtStorageLoaded(std::move(extStorage));
+    });
 
-    m_favoritePagesMgr = new FavoritePagesManager(m_historyMgr, m_thumbnailStore.get(), m_settings->getPathValue(BrowserSetting::FavoritePagesFile));
-    registerService(m_favoritePagesMgr);
+    const QString thumbnailPath = m_settings->getPathValue(BrowserSetting::ThumbnailPath);
+    BookmarkManager *bookmarkManager = m_bookmarkManager;
+    HistoryManager *historyManager = m_historyMgr;
+    DatabaseTaskScheduler *databaseScheduler = &m_databaseScheduler;
+    m_databaseScheduler.postTask("WebPageThumbnailStore", [thumbnailPath, databaseScheduler, bookmarkManager, historyManager, guiThread](){
+        std::unique_ptr<WebPageThumbnailStore> thumbnailStore =
+                DatabaseFactory::createWorker<WebPageThumbnailStore>(thumbnailPath, *databaseScheduler, bookmarkManager, historyManager);
+        thumbnailStore->moveToThread(guiThread);
+        return thumbnailStore;
+    }).then(this, [this](std::unique_ptr<WebPageThumbnailStore> &&thumbnailStore){
+        onThumbnailStoreLoaded(std::move(thumbnailStore));
+    });
+
+    traceDatabaseStage("BookmarkStore", "Bookmark database", databaseStart);
+    traceDatabaseStage("HistoryStore", "History database", databaseStart);
+    traceDatabaseStage("FaviconStore", "Favicon database", databaseStart);
+    traceDatabaseStage("ExtStorage", "Extension storage database", databaseStart);
+    traceDatabaseStage("WebPageThumbnailStore", "Thumbnail database", databaseStart);
 
     // Create network access manager
+    m_startupTrace.beginStage("Network");
     m_networkAccessMgr = new NetworkAccessManager;
     m_networkAccessMgr->setCookieJar(m_cookieJar);
     registerService(m_networkAccessMgr);
@@ -134,27 +188,43 @@ BrowserApplication::BrowserApplication(BrowserIPC *ipc, int &argc, char **argv)
     registerService(m_userAgentMgr);
 
     // Setup user script manager
+    m_startupTrace.beginStage("User scripts");
     m_userScriptMgr = new UserScriptManager(m_downloadMgr, m_settings);
     registerService(m_userScriptMgr);
 
-    // Setup extension storage manager
-    m_extStorage = DatabaseFactory::createWorker<ExtStorage>(m_settings->getPathValue(BrowserSetting::ExtensionStoragePath));
-    registerService(m_extStorage.get());
-
     // Apply global web scripts
+    m_startupTrace.beginStage("Web scripts and settings");
     installGlobalWebScripts();
 
     // Apply web settings
     m_webSettings = new WebSettings(m_serviceLocator, m_defaultProfile->settings(), m_defaultProfile, m_privateProfile);
 
     // Load search engine information
+    m_startupTrace.beginStage("Search engines and ad block");
     SearchEngineManager::instance().loadSearchEngines(m_settings->getPathValue(BrowserSetting::SearchEnginesFile));
 
     // Load ad block subscriptions (will do nothing if disabled)
     m_adBlockManager->loadSubscriptions();
+    m_startupTrace.endStage();
 
     // Set browser's saved sessions file
     m_sessionMgr.setSessionFile(m_settings->getPathValue(BrowserSetting::SessionFile));
+    m_sessionMgr.setFaviconManager(m_faviconMgr);
+
+    // Write the changes made to the browsing session every 15 seconds, so it can be restored after a crash
+    m_sessionTimerId = startTimer(1000 * 15);
+
+    // Check whether background tabs need to be unloaded, while a memory or tab budget is set
+    m_tabLifecycleMgr = new TabLifecycleManager(m_settings, this);
+    connect(m_tabLifecycleMgr, &TabLifecycleManager::checkRequested, this, [this](){
+        m_tabLifecycleMgr->evaluate(getOpenWindows());
+    });
+
+    // Subsystems that report their memory on the viper://resources page
+    m_resourceMonitor.addReporter(m_faviconMgr);
+    m_resourceMonitor.addReporter(m_bookmarkManager);
+    m_resourceMonitor.addReporter(m_historyMgr);
+    m_resourceMonitor.addReporter(m_adBlockManager);
 
     // Inject services into the security manager
     SecurityManager::instance().setServiceLocator(m_serviceLocator);
@@ -166,14 +236,14 @@ BrowserApplication::BrowserApplication(BrowserIPC *ipc, int &argc, char **argv)
     const std::vector<QString> urlSchemes { QLatin1String("http"), QLatin1String("https"), QLatin1String("viper") };
     for (const QString &scheme : urlSchemes)
         QDesktopServices::setUrlHandler(scheme, this, "openUrl");
-
-    m_databaseScheduler.run();
 }
 
 BrowserApplication::~BrowserApplication()
 {
+    if (m_ipc)
+        disconnect(m_ipc, nullptr, this, nullptr);
     m_ipc = nullptr;
-    killTimer(m_ipcTimerId);
+    killTimer(m_sessionTimerId);
 
     m_databaseScheduler.stop();
 
@@ -194,6 +264,8 @@ BrowserApplication::~BrowserApplication()
     delete m_bookmarkManager;
     delete m_settings;
     delete m_defaultProfile;
+
+    TraceLog::writeOutputFile();
 }
 
 BrowserApplication *BrowserApplication::instance()
@@ -236,6 +308,16 @@ QWebEngineProfile *BrowserApplication::getPrivateBrowsingProfile()
     return m_privateProfile;
 }
 
+TabLifecycleManager *BrowserApplication::getTabLifecycleManager()
+{
+    return m_tabLifecycleMgr;
+}
+
+QJsonObject BrowserApplication::getResourceReport() const
+{
+    return m_resourceMonitor.getReport(getOpenWindows(), m_tabLifecycleMgr);
+}
+
 MainWindow *BrowserApplication::getWindowById(WId windowId) const
 {
     for (auto it = m_browserWindows.begin(); it != m_browserWindows.end(); ++it)
@@ -275,6 +357,8 @@ void BrowserApplication::prepareToQuit()
 MainWindow *BrowserApplication::getNewWindow()
 {
     bool firstWindow = m_browserWindows.empty();
+    if (firstWindow)
+        m_startupTrace.beginStage("First window");
 
     MainWindow *w = new MainWindow(m_serviceLocator, false);
     m_browserWindows.append(w);
@@ -310,6 +394,9 @@ MainWindow *BrowserApplication::getNewWindow()
         }
 
         m_adBlockManager->updateSubscriptions();
+
+        m_startupTrace.endStage();
+        m_startupTrace.report();
     }
 
     return w;
@@ -385,9 +472,11 @@ void BrowserApplication::timerEvent(QTimerEvent *event)
 {
     QApplication::timerEvent(event);
 
-    if (event->timerId() == m_ipcTimerId)
+    if (event->timerId() == m_sessionTimerId)
     {
-        checkBrowserIPC();
+        const StartupMode mode = static_cast<StartupMode>(m_settings->getValue(BrowserSetting::StartupMode).toInt());
+        if (mode == StartupMode::RestoreSession)
+            m_sessionMgr.checkpoint(getSessionWindows());
     }
 }
 
@@ -431,6 +520,15 @@ void BrowserApplication::setupWebProfiles()
 
     // Instantiate scheme handlers
     m_viperSchemeHandler = new ViperSchemeHandler(this);
+    m_viperSchemeHandler->registerPage(QStringLiteral("resources"), QByteArrayLiteral("text/html"), [this](){
+        return ResourceMonitor::toHtml(getResourceReport());
+    });
+    m_viperSchemeHandler->registerPage(QStringLiteral("resources.json"), QByteArrayLiteral("application/json"), [this](){
+        return QJsonDocument(getResourceReport()).toJson(QJsonDocument::Indented);
+    });
+    m_viperSchemeHandler->registerPage(QStringLiteral("trace.json"), QByteArrayLiteral("application/json"), [](){
+        return TraceLog::toJson();
+    });
     m_blockedSchemeHandler = new BlockedSchemeHandler(m_serviceLocator, this);
 
     // Attach request interceptor and scheme handlers to web profiles
@@ -443,50 +541,53 @@ void BrowserApplication::setupWebProfiles()
 
 void BrowserApplication::checkBrowserIPC()
 {
-    if (m_ipc == nullptr || !m_ipc->hasMessage())
+    if (m_ipc == nullptr)
         return;
 
-    std::vector<char> message = m_ipc->getMessage();
-    if (message.empty() || message.at(0) == '\0')
-        return;
+    while (m_ipc->hasMessage())
+    {
+        std::vector<char> message = m_ipc->getMessage();
+        if (message.empty() || message.at(0) == '\0')
+            continue;
 
-    // Handle message
-    std::string messageStdString(message.data(), message.size());
-    QString messageStr = QString::fromStdString(messageStdString);
+        // Handle message
+        std::string messageStdString(message.data(), message.size());
+        QString messageStr = QString::fromStdString(messageStdString);
 
-    if (messageStr.compare(QStringLiteral("new-window")) == 0)
-    {
-        static_cast<void>(getNewWindow());
-    }
-    else
-    {
-        // Try to first get the active window. If we can't get this, we will create a new window
-        MainWindow *activeWin = qobject_cast<MainWindow*>(activeWindow());
-        if (!activeWin)
+        if (messageStr.compare(QStringLiteral("new-window")) == 0)
+        {
+            static_cast<void>(getNewWindow());
+        }
+        else
         {
-            for (QPointer<MainWindow> &win : m_browserWindows)
+            // Try to first get the active window. If we can't get this, we will create a new window
+            MainWindow *activeWin = qobject_cast<MainWindow*>(activeWindow());
+            if (!activeWin)
             {
-                if (!win.isNull() && win->hasFocus())
+                for (QPointer<MainWindow> &win : m_browserWindows)
                 {
-                    activeWin = win.data();
-                    break;
+                    if (!win.isNull() && win->hasFocus())
+                    {
+                        activeWin = win.data();
+                        break;
+                    }
                 }
             }
-        }
 
-        if (!activeWin)
-            activeWin = getNewWindow();
+            if (!activeWin)
+                activeWin = getNewWindow();
 
-        QStringList urlList = messageStr.split(QChar('\t'), QStringSplitFlag::SkipEmptyParts);
-        for (const QString &urlStr : urlList)
-        {
-            QUrl url = QUrl::fromUserInput(urlStr);
-            if (!url.isEmpty() && !url.scheme().isEmpty() && url.isValid())
+            QStringList urlList = messageStr.split(QChar('\t'), QStringSplitFlag::SkipEmptyParts);
+            for (const QString &urlStr : urlList)
             {
-                if (activeWin->currentWebWidget()->isOnBlankPage())
-                    activeWin->loadUrl(url);
-                else
-                    activeWin->openLinkNewTab(url);
+                QUrl url = QUrl::fromUserInput(urlStr);
+                if (!url.isEmpty() && !url.scheme().isEmpty() && url.isValid())
+                {
+                    if (activeWin->currentWebWidget()->isOnBlankPage())
+                        activeWin->loadUrl(url);
+                    else
+                        activeWin->openLinkNewTab(url);
+                }
             }
         }
     }
@@ -536,15 +637,7 @@ void BrowserApplication::maybeSaveSession()
 {
     // Note: don't need to check if startup mode is set to restore session, this slot will not be
     //       activated unless that condition is already met
-    std::vector<MainWindow*> windows;
-    for (int i = 0; i < m_browserWindows.size(); ++i)
-    {
-        QPointer<MainWindow> m = m_browserWindows.at(i);
-        if (!m.isNull() && !m->isPrivate())
-        {
-            windows.push_back(m.data());
-        }
-    }
+    std::vector<MainWindow*> windows = getSessionWindows();
 
     // Only save session in this method if there's one window left. Saving more than one window is
     // handled by beforeBrowserQuit() method
@@ -553,3 +646,72 @@ void BrowserApplication::maybeSaveSession()
 
     m_sessionMgr.saveState(windows);
 }
+
+std::vector<MainWindow*> BrowserApplication::getSessionWindows() const
+{
+    std::vector<MainWindow*> windows;
+    for (const QPointer<MainWindow> &m : m_browserWindows)
+    {
+        if (!m.isNull() && !m->isPrivate())
+            windows.push_back(m.data());
+    }
+    return windows;
+}
+
+std::vector<MainWindow*> BrowserApplication::getOpenWindows() const
+{
+    std::vector<MainWindow*> windows;
+    for (const QPointer<MainWindow> &m : m_browserWindows)
+    {
+        if (!m.isNull())
+            windows.push_back(m.data());
+    }
+    return windows;
+}
+
+void BrowserApplication::traceDatabaseStage(const std::string &workerName, const char *stageName, StartupTrace::Clock::time_point startTime)
+{
+    // Tasks of the same priority run in the order they were posted, so this runs after the worker's startup tasks
+    m_databaseScheduler.post(workerName, [this, stageName, startTime](){
+        m_startupTrace.addStage(stageName, startTime);
+    });
+}
+
+bool BrowserApplication::areDeferredServicesLoaded() const
+{
+    return m_numPendingServices == 0;
+}
+
+void BrowserApplication::onExtStorageLoaded(std::unique_ptr<ExtStorage> &&extStorage)
+{
+    m_extStorage = std::move(extStorage);
+    if (m_extStorage)
+        registerService(m_extStorage.get());
+    else
+        qWarning() << "BrowserApplication - could not load the extension storage database";
+
+    onDeferredServiceLoaded();
+}
+
+void BrowserApplication::onThumbnailStoreLoaded(std::unique_ptr<WebPageThumbnailStore> &&thumbnailStore)
+{
+    m_thumbnailStore = std::move(thumbnailStore);
+    if (m_thumbnailStore)
+    {
+        registerService(m_thumbnailStore.get());
+        m_resourceMonitor.addReporter(m_thumbnailStore.get());
+    }
+    else
+        qWarning() << "BrowserApplication - could not load the thumbnail database";
+
+    m_favoritePagesMgr = new FavoritePagesManager(m_historyMgr, m_thumbnailStore.get(), m_settings->getPathValue(BrowserSetting::FavoritePagesFile));
+    registerService(m_favoritePagesMgr);
+
+    onDeferredServiceLoaded();
+}
+
+void BrowserApplication::onDeferredServiceLoaded()
+{
+    if (--m_numPendingServices == 0)
+        emit deferredServicesLoaded();
+}
@@ -10,9 +10,11 @@
 #include "BookmarkNode.h"
 #include "ClearHistoryOptions.h"
 #include "DatabaseTaskScheduler.h"
+#include "ResourceMonitor.h"
 #include "ServiceLocator.h"
 #include "SessionManager.h"
 #include "Settings.h"
+#include "StartupTrace.h"
 
 namespace adblock {
     class AdBlockManager;
@@ -33,6 +35,7 @@ class MainWindow;
 class NetworkAccessManager;
 class RequestInterceptor;
 class Settings;
+class TabLifecycleManager;
 class UserAgentManager;
 class UserScriptManager;
 class ViperSchemeHandler;
@@ -83,6 +86,13 @@ class BrowserApplication : public QApplication
     /// Returns a pointer to the private web browsing profile
     QWebEngineProfile *getPrivateBrowsingProfile();
 
+    /// Returns the tab lifecycle manager, which unloads background tabs when over the memory or tab budget
+    TabLifecycleManager *getTabLifecycleManager();
+
+    /// Returns a report of the memory and CPU time used by each tab and the memory held by each subsystem,
+    /// as served by the viper://resources page
+    QJsonObject getResourceReport() const;
+
     /// Searches for a window with the given identifier, returning a pointer to the
     /// MainWindow if found, or a nullptr otherwise.
     MainWindow *getWindowById(WId windowId) const;
@@ -93,10 +103,17 @@ class BrowserApplication : public QApplication
     /// Returns true if the application is *likely* using a dark theme
     bool isDarkTheme() const;
 
+    /// Returns true once the services that are loaded on database threads during startup, such as the
+    /// extension storage and the favorite pages manager, have been registered
+    bool areDeferredServicesLoaded() const;
+
 Q_SIGNALS:
     /// Emitted when any and all runtime plugins have been loaded into the application
     void pluginsLoaded();
 
+    /// Emitted once the services that are loaded on database threads during startup have been registered
+    void deferredServicesLoaded();
+
 public Q_SLOTS:
     /// Graceful exit handler
     void prepareToQuit();
@@ -128,7 +145,7 @@ private Q_SLOTS:
     void clearHistoryRange(HistoryType histType, std::pair<QDateTime, QDateTime> range);
 
 protected:
-    /// Called on a regular interval to check for messages in the IPC channel
+    /// Called on a regular interval to check for messages in the IPC channel, and to write checkpoints of the browsing session
     void timerEvent(QTimerEvent *event) override;
 
 private:
@@ -142,19 +159,49 @@ private Q_SLOTS:
     /// This includes instantiation of request interceptors and custom scheme handlers.
     void setupWebProfiles();
 
-    /// Checks for any unread inter-process messages. This would be empty, or it would
-    /// contain a request to open one or more URLs.
+    /// Handles the unread inter-process messages. Each message contains either a request to
+    /// open a new window, or a request to open one or more URLs.
     void checkBrowserIPC();
 
     /// Loads any dynamic plugins found in the installation directory
     void loadPlugins();
 
+    /// Returns the windows whose tabs are saved in the browsing session, which excludes private windows
+    std::vector<MainWindow*> getSessionWindows() const;
+
+    /// Returns all of the open browser windows, including private windows
+    std::vector<MainWindow*> getOpenWindows() const;
+
+    /// Records a stage of the startup trace once the tasks that have been posted to the given database worker
+    /// so far have finished, measuring the time since the given start time
+    void traceDatabaseStage(const std::string &workerName, const char *stageName, StartupTrace::Clock::time_point startTime);
+
+    /// Registers the extension storage, once it has been loaded on its database thread
+    void onExtStorageLoaded(std::unique_ptr<ExtStorage> &&extStorage);
+
+    /// Registers the thumbnail store once it has been loaded on its database thread, along with the favorite
+    /// pages manager that depends on it
+    void onThumbnailStoreLoaded(std::unique_ptr<WebPageThumbnailStore> &&thumbnailStore);
+
+    /// Counts down the services being loaded during startup, notifying their consumers once all have been registered
+    void onDeferredServiceLoaded();
+
 private:
+    /// Database worker task scheduler. Declared before the services that hold a reference to it, so it is
+    /// constructed before them and destroyed after them
+    DatabaseTaskScheduler m_databaseScheduler;
+
+    /// Service locator - stores the bookmark manager, history manager, favicon manager, and other important services
+    ViperServiceLocator m_serviceLocator;
+
     /// Inter-process communication handler
     BrowserIPC *m_ipc;
 
-    /// Unique identifier of the timer that is used to check for pending messages in the IPC channel
-    int m_ipcTimerId;
+    /// Unique identifier of the timer that is used to write checkpoints of the browsing session
+    int m_sessionTimerId;
+
+    /// Unloads background tabs when the browser is over its memory or tab budget
+    TabLifecycleManager *m_tabLifecycleMgr;
 
     /// Application settings
     Settings *m_settings;
@@ -225,11 +272,14 @@ private Q_SLOTS:
     /// Web page thumbnail storage manager
     std::unique_ptr<WebPageThumbnailStore> m_thumbnailStore;
 
-    /// Service locator - stores the bookmark manager, history manager, favicon manager, and other important services
-    ViperServiceLocator m_serviceLocator;
+    /// Number of services loaded on database threads during startup that have not been registered yet
+    int m_numPendingServices;
 
-    /// Database worker task scheduler
-    DatabaseTaskScheduler m_databaseScheduler;
+    /// Records the time spent in each stage of the startup
+    StartupTrace m_startupTrace;
+
+    /// Collects the resources used by each tab and subsystem for the viper://resources page
+    ResourceMonitor m_resourceMonitor;
 };
 
 #define sBrowserApplication BrowserApplication::instance()
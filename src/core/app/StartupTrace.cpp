@@ -0,0 +1,80 @@
+#include "StartupTrace.h"
+#include "TraceLog.h"
+
+#include <algorithm>
+
+#include <QString>
+
+#include <QDebug>
+
+StartupTrace::StartupTrace() :
+    m_startTime(Clock::now()),
+    m_currentStage(nullptr),
+    m_currentStageStart(),
+    m_stages(),
+    m_reported(false),
+    m_mutex()
+{
+}
+
+void StartupTrace::beginStage(const char *name)
+{
+    endStage();
+
+    m_currentStage = name;
+    m_currentStageStart = Clock::now();
+}
+
+void StartupTrace::endStage()
+{
+    if (!m_currentStage)
+        return;
+
+    addStage(m_currentStage, m_currentStageStart);
+    m_currentStage = nullptr;
+}
+
+void StartupTrace::addStage(const char *name, Clock::time_point startTime)
+{
+    Stage stage { name, startTime, Clock::now() };
+
+    if (TraceLog::isEnabled())
+        TraceLog::addSpan("startup", name, stage.startTime, stage.endTime);
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (m_reported && TraceLog::isEnabled())
+        logStage(stage);
+
+    m_stages.push_back(std::move(stage));
+}
+
+void StartupTrace::report()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_reported = true;
+
+    // The stages are only logged while tracing, so that normal startups stay quiet
+    if (!TraceLog::isEnabled())
+        return;
+
+    std::vector<Stage> stages = m_stages;
+    std::stable_sort(stages.begin(), stages.end(), [](const Stage &a, const Stage &b) {
+        return a.startTime < b.startTime;
+    });
+
+    const std::chrono::duration<double, std::milli> elapsed = Clock::now() - m_startTime;
+    qDebug().noquote() << QString("Startup trace: first window shown after %1 ms").arg(elapsed.count(), 0, 'f', 1);
+
+    for (const Stage &stage : stages)
+        logStage(stage);
+}
+
+void StartupTrace::logStage(const Stage &stage) const
+{
+    const std::chrono::duration<double, std::milli> duration = stage.endTime - stage.startTime;
+    const std::chrono::duration<double, std::milli> finishedAt = stage.endTime - m_startTime;
+    qDebug().noquote() << QString("Startup trace: %1 took %2 ms, finished %3 ms after launch")
+                          .arg(QLatin1String(stage.name))
+                          .arg(duration.count(), 0, 'f', 1)
+                          .arg(finishedAt.count(), 0, 'f', 1);
+}
@@ -0,0 +1,80 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+/**
+ * @class StartupTrace
+ * @brief Records the time spent in each stage of the browser's startup, from the construction
+ *        of the application to the first window being shown.
+ *
+ *        Stages that run on the GUI thread are recorded one after the other with beginStage().
+ *        Stages that run on other threads, such as the loading of a database, are recorded with
+ *        addStage() once they finish. Each stage is recorded as a span in the \ref TraceLog, and the
+ *        stages are only logged when tracing is enabled. Stages that finish after the trace has been
+ *        reported are logged as soon as they are recorded.
+ */
+class StartupTrace
+{
+public:
+    /// Clock used to time each stage
+    using Clock = std::chrono::steady_clock;
+
+    /// Constructs the trace, starting its clock
+    StartupTrace();
+
+    /// Ends the current stage on the GUI thread, if there is one, and begins a new stage with the given name,
+    /// which must be a string literal
+    void beginStage(const char *name);
+
+    /// Ends the current stage on the GUI thread
+    void endStage();
+
+    /// Records a stage that began at the given time and has just finished. The name must be a string literal.
+    /// May be called from any thread
+    void addStage(const char *name, Clock::time_point startTime);
+
+    /// Logs the duration of every stage recorded so far, along with the time elapsed since the trace was started,
+    /// if tracing is enabled
+    void report();
+
+private:
+    /// A single stage of the startup
+    struct Stage
+    {
+        /// Name of the stage
+        const char *name;
+
+        /// Time at which the stage began
+        Clock::time_point startTime;
+
+        /// Time at which the stage finished
+        Clock::time_point endTime;
+    };
+
+    /// Logs the duration of the given stage
+    void logStage(const Stage &stage) const;
+
+private:
+    /// Time at which the trace was started
+    Clock::time_point m_startTime;
+
+    /// Name of the current stage on the GUI thread, or a nullptr if there is no current stage
+    const char *m_currentStage;
+
+    /// Time at which the current stage on the GUI thread began
+    Clock::time_point m_currentStageStart;
+
+    /// Stages that have finished
+    std::vector<Stage> m_stages;
+
+    /// Set once the trace has been reported
+    bool m_reported;
+
+    /// Guards the list of stages, which can be added to from any thread
+    mutable std::mutex m_mutex;
+};
+
+#endif // STARTUPTRACE_H
@@ -4,6 +4,7 @@
 #include "Settings.h"
 #include "WebPage.h"
 
+#include <algorithm>
 #include <type_traits>
 #include <vector>
 
@@ -14,6 +15,7 @@
 
 AutoFill::AutoFill(Settings *settings) :
     QObject(nullptr),
+    m_credentialIndex(),
     m_credentialStore(nullptr),
     m_formFillScript(),
     m_enabled(settings->getValue(BrowserSetting::EnableAutoFill).toBool())
@@ -47,29 +49,36 @@ void AutoFill::onFormSubmitted(WebPage *page, const QString &pageUrl, const QStr
 
     // Todo: check if URL is blocked from inclusion in auto fill system
 
-    // Fetch or create a new set of credentials associated with the login
+    const QUrl url = QUrl::fromUserInput(pageUrl);
+
+    // Fetch or create a new set of credentials associated with the login. The store is only
+    // queried if the index contains a login with the same username
     bool isExisting = false;
     WebCredentials credentials;
-    std::vector<WebCredentials> savedLogins = m_credentialStore->getCredentialsFor(pageUrl);
-    for (const WebCredentials &creds : savedLogins)
+    if (hasIndexedCredentials(url.host(), username))
     {
-        if (creds.Username.compare(username) == 0)
+        std::vector<WebCredentials> savedLogins = m_credentialStore->getCredentialsFor(url);
+        for (const WebCredentials &creds : savedLogins)
         {
-            isExisting = true;
-            credentials = creds;
-            credentials.LastLogin = QDateTime::currentDateTime();
-            // Update last login time in data store. If password has changed, a dialog will appear
-            // to ask the user whether or not they want it to be updated.
-            m_credentialStore->updateCredentials(credentials);
-
-            if (creds.Password.compare(password) == 0)
-                return;
-
-            break;
+            if (creds.Username.compare(username) == 0)
+            {
+                isExisting = true;
+                credentials = creds;
+                credentials.LastLogin = QDateTime::currentDateTime();
+                // Update last login time in data store. If password has changed, a dialog will appear
+                // to ask the user whether or not they want it to be updated.
+                m_credentialStore->updateCredentials(credentials);
+                indexCredentials(credentials);
+
+                if (creds.Password.compare(password) == 0)
+                    return;
+
+                break;
+            }
         }
     }
 
-    credentials.Host = QUrl::fromUserInput(pageUrl).host();
+    credentials.Host = url.host();
     credentials.Username = username;
     credentials.Password = password;
     credentials.LastLogin = QDateTime::currentDateTime();
@@ -101,11 +110,21 @@ void AutoFill::onPageLoaded(bool ok)
     if (!page)
         return;
 
-    std::vector<WebCredentials> savedLogins = m_credentialStore->getCredentialsFor(page->url());
+    const QUrl pageUrl = page->url();
+    auto it = m_credentialIndex.find(pageUrl.host());
+    if (it == m_credentialIndex.end() || it->second.empty())
+        return;
+
+    // Only fetch the secrets once the page is known to have saved logins
+    std::vector<WebCredentials> savedLogins = m_credentialStore->getCredentialsFor(pageUrl);
     if (savedLogins.empty())
         return;
 
-    const WebCredentials &lastUsedCreds = savedLogins.at(0);
+    const QString &lastUsername = it->second.front().Username;
+    auto credsIt = std::find_if(savedLogins.cbegin(), savedLogins.cend(), [&lastUsername](const WebCredentials &creds) {
+        return creds.Username.compare(lastUsername) == 0;
+    });
+    const WebCredentials &lastUsedCreds = (credsIt != savedLogins.cend()) ? *credsIt : savedLogins.at(0);
 
     QString scriptData;
 
@@ -122,13 +141,9 @@ std::vector<WebCredentials> AutoFill::getAllCredentials()
     if (!m_credentialStore)
         return result;
 
-    std::vector<QString> savedHosts = m_credentialStore->getHostNames();
-    if (savedHosts.empty())
-        return result;
-
-    for (const QString &host : savedHosts)
+    for (const auto &it : m_credentialIndex)
     {
-        QUrl url = QUrl::fromUserInput(host);
+        QUrl url = QUrl::fromUserInput(it.first);
         std::vector<WebCredentials> temp = m_credentialStore->getCredentialsFor(url);
 
         result.reserve(result.size() + temp.size());
@@ -140,20 +155,29 @@ std::vector<WebCredentials> AutoFill::getAllCredentials()
 
 void AutoFill::saveCredentials(const WebCredentials &credentials)
 {
-    if (m_credentialStore)
-        m_credentialStore->addCredentials(credentials);
+    if (!m_credentialStore)
+        return;
+
+    m_credentialStore->addCredentials(credentials);
+    indexCredentials(credentials);
 }
 
 void AutoFill::updateCredentials(const WebCredentials &credentials)
 {
-    if (m_credentialStore)
-        m_credentialStore->updateCredentials(credentials);
+    if (!m_credentialStore)
+        return;
+
+    m_credentialStore->updateCredentials(credentials);
+    indexCredentials(credentials);
 }
 
 void AutoFill::removeCredentials(const WebCredentials &credentials)
 {
-    if (m_credentialStore)
-        m_credentialStore->removeCredentials(credentials);
+    if (!m_credentialStore)
+        return;
+
+    m_credentialStore->removeCredentials(credentials);
+    unindexCredentials(credentials);
 }
 
 void AutoFill::onSettingChanged(BrowserSetting setting, const QVariant &value)
@@ -175,8 +199,75 @@ void AutoFill::onPluginsLoaded()
     QObject *provider = nullptr;
 #endif
 
-    if (CredentialStore *store = qobject_cast<CredentialStore*>(provider))
-        m_credentialStore = store;
-    else
+    CredentialStore *store = qobject_cast<CredentialStore*>(provider);
+    if (!store)
+    {
         qWarning() << "No credential store found. Disabling AutoFill.";
+        return;
+    }
+
+    // The store is only used on the GUI thread. The index is built from the metadata of the credentials,
+    // which the store can return without decrypting any passwords
+    m_credentialIndex = buildCredentialIndex(store);
+    m_credentialStore = store;
+}
+
+AutoFill::CredentialIndex AutoFill::buildCredentialIndex(CredentialStore *store)
+{
+    CredentialIndex index;
+
+    for (const WebCredentialInfo &info : store->getCredentialInfo())
+        index[info.Host].push_back(CredentialInfo { info.Username, info.LastLogin });
+
+    for (auto &it : index)
+    {
+        std::stable_sort(it.second.begin(), it.second.end(), [](const CredentialInfo &a, const CredentialInfo &b) {
+            return a.LastLogin > b.LastLogin;
+        });
+    }
+
+    return index;
+}
+
+void AutoFill::indexCredentials(const WebCredentials &credentials)
+{
+    std::vector<CredentialInfo> &entries = m_credentialIndex[credentials.Host];
+
+    auto it = std::find_if(entries.begin(), entries.end(), [&credentials](const CredentialInfo &info) {
+        return info.Username.compare(credentials.Username) == 0;
+    });
+    if (it != entries.end())
+        entries.erase(it);
+
+    CredentialInfo info { credentials.Username, credentials.LastLogin };
+    auto pos = std::find_if(entries.begin(), entries.end(), [&info](const CredentialInfo &other) {
+        return info.LastLogin >= other.LastLogin;
+    });
+    entries.insert(pos, info);
+}
+
+void AutoFill::unindexCredentials(const WebCredentials &credentials)
+{
+    auto hostIt = m_credentialIndex.find(credentials.Host);
+    if (hostIt == m_credentialIndex.end())
+        return;
+
+    std::vector<CredentialInfo> &entries = hostIt->second;
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [&credentials](const CredentialInfo &info) {
+        return info.Username.compare(credentials.Username) == 0;
+    }), entries.end());
+
+    if (entries.empty())
+        m_credentialIndex.erase(hostIt);
+}
+
+bool AutoFill::hasIndexedCredentials(const QString &host, const QString &username) const
+{
+    auto it = m_credentialIndex.find(host);
+    if (it == m_credentialIndex.end())
+        return false;
+
+    return std::any_of(it->second.cbegin(), it->second.cend(), [&username](const CredentialInfo &info) {
+        return info.Username.compare(username) == 0;
+    });
 }
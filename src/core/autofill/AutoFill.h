@@ -6,7 +6,10 @@
 #include "ISettingsObserver.h"
 
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
+#include <QDateTime>
 #include <QMap>
 #include <QObject>
 #include <QPointer>
@@ -20,6 +23,10 @@ class WebPage;
  * @class AutoFill
  * @brief Handles automatic filling of form data that the user allows
  *        the system to manage for them.
+ *
+ *        The usernames saved for each host are kept in an index, which is built from the credential store's
+ *        metadata once the store has been loaded. Pages of hosts without saved logins never reach the
+ *        credential store, and passwords are only fetched when a form is about to be filled.
  */
 class AutoFill : public QObject, public ISettingsObserver
 {
@@ -29,7 +36,6 @@ class AutoFill : public QObject, public ISettingsObserver
 
 public:
     /// Constructs the AutoFill manager given a pointer to the application settings
-    /// AutoFill constructor
     explicit AutoFill(Settings *settings);
 
     /// Destructor
@@ -72,6 +78,35 @@ private Q_SLOTS:
     void onPluginsLoaded();
 
 private:
+    /// Information about a set of saved credentials, without the password or form data
+    struct CredentialInfo
+    {
+        /// Username or email value
+        QString Username;
+
+        /// The last time that the credentials were used to log in to the website
+        QDateTime LastLogin;
+    };
+
+    /// Maps each host to the credentials saved for it, ordered from the most to the least recently used
+    using CredentialIndex = std::unordered_map<QString, std::vector<CredentialInfo>>;
+
+    /// Builds an index of the credentials in the given store, from their metadata only
+    static CredentialIndex buildCredentialIndex(CredentialStore *store);
+
+    /// Adds the given credentials to the index, or updates them if the index already contains their host and username
+    void indexCredentials(const WebCredentials &credentials);
+
+    /// Removes the given credentials from the index
+    void unindexCredentials(const WebCredentials &credentials);
+
+    /// Returns true if the index contains credentials with the given username for the host
+    bool hasIndexedCredentials(const QString &host, const QString &username) const;
+
+private:
+    /// Index of the saved credentials by host
+    CredentialIndex m_credentialIndex;
+
     /// Credential storage system
     CredentialStore *m_credentialStore;
     //std::unique_ptr<CredentialStore> m_credentialStore;
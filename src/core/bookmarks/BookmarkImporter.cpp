@@ -1,146 +1,316 @@
 #include "BookmarkImporter.h"
 #include "BookmarkNode.h"
 
+#include <algorithm>
+#include <cctype>
 #include <stack>
 #include <utility>
 #include <QDebug>
 #include <QFile>
+#include <QMetaObject>
 #include <QUrl>
 
-BookmarkImporter::BookmarkImporter(BookmarkManager *bookmarkMgr) :
-    m_bookmarkManager(bookmarkMgr),
-    m_folderStartTag("<DL><p>"),
-    m_folderEndTag("</DL><p>"),
-    m_folderNameStartTag("<DT><H3"),
-    m_folderNameEndTag("</H3>"),
-    m_bookmarkStartTag("<DT><A"),
-    m_bookmarkEndTag("</A>"),
-    m_startTag('<'),
-    m_endTag('>')
+namespace
 {
-}
 
-bool BookmarkImporter::import(const QString &fileName, BookmarkNode *importFolder)
+/**
+ * @class NetscapeTokenizer
+ * @brief Splits the raw bytes of a Netscape bookmark file into tags and text, moving
+ *        forward through the data exactly once without copying it.
+ */
+class NetscapeTokenizer
 {
-    if (!importFolder)
-        return false;
-
-    // Attempt to read bookmark file contents
-    QFile file(fileName);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-        return false;
-    QByteArray contents = file.readAll();
-    file.close();
+public:
+    /// Types of tokens produced by the tokenizer
+    enum class TokenType
+    {
+        StartTag,
+        EndTag,
+        Text,
+        End
+    };
 
-    if (contents.isEmpty())
-        return false;
+    /// A single token. All views point into the data given to the tokenizer
+    struct Token
+    {
+        TokenType type { TokenType::End };
 
-    QString pageHtml = QString::fromUtf8(contents);
-    const int pageHtmlSize = pageHtml.size();
+        /// Name of the tag, for start and end tags
+        std::string_view name;
 
-    // Find first <DL><p> for root folder
-    int pos = pageHtml.indexOf(m_folderStartTag, 0, Qt::CaseInsensitive);
-    if (pos == -1)
-        return false;
-    pos += m_folderStartTag.size();
+        /// Raw attribute string of a start tag, or the contents of a text token
+        std::string_view value;
+    };
 
-    BookmarkNode *currentNode = importFolder;
-    std::stack<BookmarkNode*> s;
+    /// Constructs the tokenizer over the given data
+    explicit NetscapeTokenizer(std::string_view data) :
+        m_data(data),
+        m_pos(0)
+    {
+    }
 
-    m_bookmarkManager->setCanUpdateList(false);
-    while (pos > 0 && pos < pageHtmlSize && currentNode != nullptr)
+    /// Returns the next token in the data, or a token of type End when all of the data has been consumed
+    Token next()
     {
-        pos = pageHtml.indexOf(m_startTag, pos);
-        if (pos == -1)
-            break;
+        Token token;
 
-        // Determine element type by comparing pos to position of the next sub-folder, bookmark and closing folder tag
-        int nextFolderStartPos = pageHtml.indexOf(m_folderNameStartTag, pos, Qt::CaseInsensitive);
-        if (pos == nextFolderStartPos)
+        while (m_pos < m_data.size())
         {
-            // Skip folder attributes and only get the name, contained within the <h3>element</h3>
-            pos = pageHtml.indexOf(m_endTag, pos + m_folderNameStartTag.size()) + 1;
-            int nameEndPos = pageHtml.indexOf(m_folderNameEndTag, pos, Qt::CaseInsensitive);
-            if (nameEndPos < 0)
+            if (m_data[m_pos] != '<')
             {
-                qDebug() << "Error: invalid bookmark html. Halting import";
-                m_bookmarkManager->setCanUpdateList(true);
-                return false;
+                const std::size_t textEnd = std::min(m_data.find('<', m_pos), m_data.size());
+                token.type = TokenType::Text;
+                token.value = m_data.substr(m_pos, textEnd - m_pos);
+                m_pos = textEnd;
+                return token;
             }
 
-            QString folderName = pageHtml.mid(pos, nameEndPos - pos);
+            const std::size_t tagEnd = m_data.find('>', m_pos);
+            if (tagEnd == std::string_view::npos)
+            {
+                m_pos = m_data.size();
+                break;
+            }
 
-            // Create bookmark folder for the child element and start parsing child node
-            s.push(currentNode);
-            currentNode = m_bookmarkManager->addFolder(folderName, currentNode);
-            pos = pageHtml.indexOf(m_folderStartTag, nameEndPos + m_folderNameEndTag.size(), Qt::CaseInsensitive);
-            if (pos > 0)
-                pos += m_folderStartTag.size();
-            continue;
+            std::string_view tag = m_data.substr(m_pos + 1, tagEnd - m_pos - 1);
+            m_pos = tagEnd + 1;
+
+            // Skip comments and the doctype declaration
+            if (tag.empty() || tag.front() == '!' || tag.front() == '?')
+                continue;
+
+            token.type = TokenType::StartTag;
+            if (tag.front() == '/')
+            {
+                token.type = TokenType::EndTag;
+                tag.remove_prefix(1);
+            }
+
+            std::size_t nameEnd = 0;
+            while (nameEnd < tag.size() && !std::isspace(static_cast<unsigned char>(tag[nameEnd])) && tag[nameEnd] != '/')
+                ++nameEnd;
+
+            token.name = tag.substr(0, nameEnd);
+            token.value = tag.substr(nameEnd);
+            return token;
         }
 
-        int nextFolderEndPos = pageHtml.indexOf(m_folderEndTag, pos - 1, Qt::CaseInsensitive);
-        if (pos == nextFolderEndPos)
+        token.type = TokenType::End;
+        return token;
+    }
+
+    /// Returns all of the text up to the end tag with the given name, consuming the end tag as well
+    std::string_view textUntilEndTag(std::string_view tagName)
+    {
+        const std::size_t start = m_pos;
+        std::size_t textEnd = m_pos;
+
+        for (;;)
         {
-            // Current folder is done being imported, retrieve last folder from the stack and resume importing of that folder
-            pos += m_folderEndTag.size();
-            if (!s.empty())
+            textEnd = m_pos;
+            Token token = next();
+            if (token.type == TokenType::End)
+                break;
+
+            if (token.type == TokenType::EndTag && equalsIgnoreCase(token.name, tagName))
+                break;
+        }
+
+        return m_data.substr(start, textEnd - start);
+    }
+
+    /// Case-insensitive comparison of two ASCII strings
+    static bool equalsIgnoreCase(std::string_view a, std::string_view b)
+    {
+        if (a.size() != b.size())
+            return false;
+
+        for (std::size_t i = 0; i < a.size(); ++i)
+        {
+            if (std::toupper(static_cast<unsigned char>(a[i])) != std::toupper(static_cast<unsigned char>(b[i])))
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Returns the value of the attribute with the given name, or an empty view if the attribute is not present
+    static std::string_view getAttribute(std::string_view attributes, std::string_view name)
+    {
+        std::size_t pos = 0;
+        while (pos + name.size() < attributes.size())
+        {
+            if (equalsIgnoreCase(attributes.substr(pos, name.size()), name)
+                    && attributes[pos + name.size()] == '='
+                    && (pos == 0 || std::isspace(static_cast<unsigned char>(attributes[pos - 1]))))
             {
-                currentNode = s.top();
-                s.pop();
+                std::size_t valueStart = pos + name.size() + 1;
+                if (valueStart >= attributes.size())
+                    return {};
+
+                char delimiter = attributes[valueStart];
+                if (delimiter == '"' || delimiter == '\'')
+                    ++valueStart;
+                else
+                    delimiter = ' ';
+
+                std::size_t valueEnd = attributes.find(delimiter, valueStart);
+                if (valueEnd == std::string_view::npos)
+                    valueEnd = attributes.size();
+
+                return attributes.substr(valueStart, valueEnd - valueStart);
             }
-            else
-                currentNode = nullptr;
-            continue;
+
+            ++pos;
         }
 
-        int nextBookmarkPos = pageHtml.indexOf(m_bookmarkStartTag, pos, Qt::CaseInsensitive);
-        if (pos == nextBookmarkPos)
+        return {};
+    }
+
+private:
+    /// Data being tokenized
+    std::string_view m_data;
+
+    /// Current position in the data
+    std::size_t m_pos;
+};
+
+/// Converts a view of the bookmark file into a QString, decoding the character entities used by bookmark exporters
+QString toQString(std::string_view value)
+{
+    QString result = QString::fromUtf8(value.data(), static_cast<qsizetype>(value.size())).trimmed();
+    if (!result.contains(QLatin1Char('&')))
+        return result;
+
+    result.replace(QLatin1String("&lt;"), QLatin1String("<"))
+          .replace(QLatin1String("&gt;"), QLatin1String(">"))
+          .replace(QLatin1String("&quot;"), QLatin1String("\""))
+          .replace(QLatin1String("&#39;"), QLatin1String("'"))
+          .replace(QLatin1String("&amp;"), QLatin1String("&"));
+    return result;
+}
+
+}
+
+BookmarkImporter::BookmarkImporter(BookmarkManager *bookmarkMgr) :
+    m_bookmarkManager(bookmarkMgr)
+{
+}
+
+bool BookmarkImporter::import(const QString &fileName, BookmarkNode *importFolder)
+{
+    if (!importFolder || !m_bookmarkManager)
+        return false;
+
+    // Attempt to read bookmark file contents. The file is memory mapped when possible so the
+    // tokenizer can read the bytes directly, without a copy into a QByteArray or QString
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 fileSize = file.size();
+    if (fileSize <= 0)
+        return false;
+
+    QByteArray contents;
+    std::string_view data;
+    if (uchar *mapped = file.map(0, fileSize))
+        data = std::string_view(reinterpret_cast<const char*>(mapped), static_cast<std::size_t>(fileSize));
+    else
+    {
+        contents = file.readAll();
+        data = std::string_view(contents.constData(), static_cast<std::size_t>(contents.size()));
+    }
+
+    std::unique_ptr<BookmarkNode> importedRoot = parse(data);
+    file.close();
+
+    if (!importedRoot)
+    {
+        qDebug() << "Error: invalid bookmark html. Halting import";
+        return false;
+    }
+
+    // Nodes are added to the bookmark tree on the thread of the bookmark manager, as the import may run in a worker thread
+    std::shared_ptr<BookmarkNode> importedNodes = std::move(importedRoot);
+    BookmarkManager *bookmarkManager = m_bookmarkManager;
+    QMetaObject::invokeMethod(bookmarkManager, [bookmarkManager, importedNodes, importFolder](){
+        bookmarkManager->importNodes(importedNodes.get(), importFolder);
+    });
+
+    return true;
+}
+
+std::unique_ptr<BookmarkNode> BookmarkImporter::parse(std::string_view data) const
+{
+    using TokenType = NetscapeTokenizer::TokenType;
+
+    std::unique_ptr<BookmarkNode> root = std::make_unique<BookmarkNode>(BookmarkNode::Folder, QString());
+
+    NetscapeTokenizer tokenizer(data);
+
+    // The first <DL> element contains the root folder. Every <H3> element names a sub-folder,
+    // whose contents are found in the <DL> element that follows it
+    std::stack<BookmarkNode*> folders;
+    BookmarkNode *currentFolder = nullptr;
+    BookmarkNode *pendingFolder = nullptr;
+
+    for (NetscapeTokenizer::Token token = tokenizer.next(); token.type != TokenType::End; token = tokenizer.next())
+    {
+        if (token.type == TokenType::StartTag)
         {
-            // Get bookmark URL and name, add bookmark to current folder
-            pos += m_bookmarkStartTag.size() - 1;
-            int attrEndPos = pageHtml.indexOf(m_endTag, pos);
-            if (attrEndPos < 0)
+            if (NetscapeTokenizer::equalsIgnoreCase(token.name, "DL"))
             {
-                qDebug() << "Error: invalid bookmark html. Halting import";
-                m_bookmarkManager->setCanUpdateList(true);
-                return false;
-            }
+                if (!currentFolder)
+                {
+                    currentFolder = root.get();
+                    continue;
+                }
 
-            // URL parsing
-            QString attributeStr = pageHtml.mid(pos, attrEndPos - pos);
-            int urlStartPos = attributeStr.indexOf(QStringLiteral("HREF="), 0, Qt::CaseInsensitive);
-            if (urlStartPos < 0)
+                folders.push(currentFolder);
+                if (pendingFolder)
+                {
+                    currentFolder = pendingFolder;
+                    pendingFolder = nullptr;
+                }
+            }
+            else if (!currentFolder)
             {
-                qDebug() << "Error: invalid bookmark html. Halting import";
-                m_bookmarkManager->setCanUpdateList(true);
-                return false;
+                continue;
             }
-            urlStartPos += 6;
-            int urlEndPos = attributeStr.indexOf(u'"', urlStartPos);
-            if (urlEndPos < 0)
+            else if (NetscapeTokenizer::equalsIgnoreCase(token.name, "H3"))
             {
-                qDebug() << "Error: invalid bookmark html. Halting import";
-                m_bookmarkManager->setCanUpdateList(true);
-                return false;
+                const QString folderName = toQString(tokenizer.textUntilEndTag("H3"));
+                pendingFolder = currentFolder->appendNode(std::make_unique<BookmarkNode>(BookmarkNode::Folder, folderName));
             }
+            else if (NetscapeTokenizer::equalsIgnoreCase(token.name, "A"))
+            {
+                const std::string_view href = NetscapeTokenizer::getAttribute(token.value, "HREF");
+                if (href.empty())
+                    return nullptr;
 
-            QString url = attributeStr.mid(urlStartPos, urlEndPos - urlStartPos);
-
-            // Bookmark name
-            pos = attrEndPos + 1;
-            int nameEndPos = pageHtml.indexOf(m_bookmarkEndTag, pos, Qt::CaseInsensitive);
-
-            QString name = pageHtml.mid(pos, nameEndPos - pos);
+                const QString name = toQString(tokenizer.textUntilEndTag("A"));
 
-            m_bookmarkManager->appendBookmark(name, QUrl::fromUserInput(url), currentNode);
+                BookmarkNode *bookmark = currentFolder->appendNode(std::make_unique<BookmarkNode>(BookmarkNode::Bookmark, name));
+                bookmark->setURL(QUrl::fromUserInput(toQString(href)));
+            }
+        }
+        else if (token.type == TokenType::EndTag
+                 && currentFolder != nullptr
+                 && NetscapeTokenizer::equalsIgnoreCase(token.name, "DL"))
+        {
+            // Current folder is done being imported, resume importing of its parent folder
+            pendingFolder = nullptr;
+            if (folders.empty())
+                break;
 
-            pos = nameEndPos + m_bookmarkEndTag.size();
-            continue;
+            currentFolder = folders.top();
+            folders.pop();
         }
-        ++pos;
     }
-    m_bookmarkManager->setCanUpdateList(true);
 
-    return true;
+    if (!currentFolder)
+        return nullptr;
+
+    return root;
 }
@@ -3,7 +3,10 @@
 
 #include "BookmarkManager.h"
 
-#include <QLatin1String>
+#include <memory>
+#include <string_view>
+
+class BookmarkNode;
 
 /**
  * @class BookmarkImporter
@@ -25,25 +28,17 @@ class BookmarkImporter
      */
     bool import(const QString &fileName, BookmarkNode *importFolder);
 
+private:
+    /**
+     * @brief Parses the Netscape formatted bookmark data into a detached bookmark tree, in a single pass over the data
+     * @param data Contents of the bookmark file
+     * @return Folder containing the parsed bookmarks, or a nullptr if the data could not be parsed
+     */
+    std::unique_ptr<BookmarkNode> parse(std::string_view data) const;
+
 private:
     /// Bookmark node manager
     BookmarkManager *m_bookmarkManager;
-
-    /// Folder element opening and closing tags
-    QLatin1String m_folderStartTag;
-    QLatin1String m_folderEndTag;
-
-    /// Folder name element opening and closing tags
-    QLatin1String m_folderNameStartTag;
-    QLatin1String m_folderNameEndTag;
-
-    /// Bookmark element opening and closing tags
-    QLatin1String m_bookmarkStartTag;
-    QLatin1String m_bookmarkEndTag;
-
-    /// XML element opening and closing characters
-    QChar m_startTag;
-    QChar m_endTag;
 };
 
 #endif // BOOKMARKIMPORTER_H
@@ -3,13 +3,14 @@
 #include "BookmarkStore.h"
 #include "CommonUtil.h"
 #include "FaviconManager.h"
+#include "TraceLog.h"
 
 #include <chrono>
 #include <deque>
 #include <memory>
 
+#include <QThread>
 #include <QTimer>
-#include <QtConcurrent>
 
 using namespace std::chrono_literals;
 
@@ -21,23 +22,32 @@ BookmarkManager::BookmarkManager(const ViperServiceLocator &serviceLocator, Data
     m_bookmarkStore(nullptr),
     m_faviconManager(nullptr),
     m_lookupCache(24),
-    m_nodeList(),
-    m_canUpdateList(true),
+    m_snapshotMutex(),
+    m_snapshot(std::make_shared<const BookmarkSnapshot>(nullptr)),
+    m_loadedIcons(),
+    m_changeNotificationPending(false),
     m_nextBookmarkId(0),
-    m_numBookmarks(0),
-    m_nodeListFuture(),
-    m_mutex()
+    m_numBookmarks(0)
 {
+    VIPER_TRACE_SCOPE("startup", "BookmarkManager");
+
     m_faviconManager = serviceLocator.getServiceAs<FaviconManager>("FaviconManager");
     setObjectName(QLatin1String("BookmarkManager"));
 
+    // Icons requested before the favicon store was loaded are blank, and are requested again once it is ready
+    if (m_faviconManager != nullptr)
+    {
+        connect(m_faviconManager, &FaviconManager::storeReady,     this, &BookmarkManager::loadBookmarkIcons);
+        connect(m_faviconManager, &FaviconManager::pageIconLoaded, this, &BookmarkManager::onPageIconLoaded);
+    }
+
     QTimer::singleShot(250ms, this, &BookmarkManager::checkIfLoaded);
 
-    m_taskScheduler.onInit([this](){
+    m_taskScheduler.onInit("BookmarkStore", [this](){
         m_bookmarkStore = static_cast<BookmarkStore*>(m_taskScheduler.getWorker("BookmarkStore"));
     });
 
-    m_taskScheduler.post([this](){
+    m_taskScheduler.post(DatabaseTaskPriority::Interactive, "BookmarkStore", [this](){
         m_nextBookmarkId = m_bookmarkStore->getMaxUniqueId() + 1;
         setRootNode(m_bookmarkStore->getRootNode());
     });
@@ -47,6 +57,38 @@ BookmarkManager::~BookmarkManager()
 {
 }
 
+std::vector<ResourceUsage> BookmarkManager::getResourceUsage() const
+{
+    Snapshot snapshot;
+    {
+        std::lock_guard<std::mutex> _(m_snapshotMutex);
+        snapshot = m_snapshot;
+    }
+
+    // The estimate covers the nodes of the latest snapshot and their names, shortcuts and URLs, but not their icons
+    qint64 nodesSize = 0;
+    for (const BookmarkSnapshotNode *node : *snapshot)
+    {
+        nodesSize += static_cast<qint64>(sizeof(BookmarkSnapshotNode) + sizeof(std::shared_ptr<const BookmarkSnapshotNode>))
+                + (node->getName().capacity() + node->getShortcut().capacity()) * static_cast<qint64>(sizeof(QChar))
+                + node->getURL().toString().size() * static_cast<qint64>(sizeof(QChar));
+    }
+
+    return {
+        ResourceUsage { QStringLiteral("Bookmark nodes"), snapshot->size(), nodesSize },
+        ResourceUsage { QStringLiteral("Bookmark lookup cache"), m_lookupCache.size(), -1 }
+    };
+}
+
+BookmarkManager::Snapshot BookmarkManager::getSnapshot()
+{
+    if (QThread::currentThread() == thread())
+        publishSnapshot();
+
+    std::lock_guard<std::mutex> _(m_snapshotMutex);
+    return m_snapshot;
+}
+
 BookmarkNode *BookmarkManager::getRoot() const
 {
     return m_rootNode.get();
@@ -70,17 +112,7 @@ BookmarkNode *BookmarkManager::getBookmark(const QUrl &url)
             return node;
     }
 
-    if (!m_nodeListFuture.isCanceled() && m_nodeListFuture.isRunning())
-        m_nodeListFuture.waitForFinished();
-
-    for (BookmarkNode *node : m_nodeList)
-    {
-        if (node->getType() == BookmarkNode::Bookmark
-                && CommonUtil::doUrlsMatch(url, node->getURL(), true))
-            return node;
-    }
-
-    return nullptr;
+    return findBookmark(url);
 }
 
 bool BookmarkManager::isBookmarked(const QUrl &url)
@@ -92,32 +124,10 @@ bool BookmarkManager::isBookmarked(const QUrl &url)
     if (m_lookupCache.has(urlStdStr) && m_lookupCache.get(urlStdStr) != nullptr)
         return true;
 
-    std::deque<BookmarkNode*> queue;
-    queue.push_back(m_rootNode.get());
-    while (!queue.empty())
+    if (BookmarkNode *node = findBookmark(url))
     {
-        BookmarkNode *n = queue.front();
-
-        for (const auto &node : n->m_children)
-        {
-            BookmarkNode *childNode = node.get();
-            if (!childNode)
-                continue;
-
-            if (childNode->getType() == BookmarkNode::Folder)
-            {
-                queue.push_back(childNode);
-                continue;
-            }
-
-            if (CommonUtil::doUrlsMatch(url, childNode->getURL(), true))
-            {
-                m_lookupCache.put(urlStdStr, childNode);
-                return true;
-            }
-        }
-
-        queue.pop_front();
+        m_lookupCache.put(urlStdStr, node);
+        return true;
     }
 
     return false;
@@ -132,6 +142,7 @@ void BookmarkManager::appendBookmark(const QString &name, const QUrl &url, Bookm
     const int bookmarkId = m_nextBookmarkId++;
 
     // Create new bookmark
+    folder->invalidateSnapshot();
     BookmarkNode *bookmark = folder->appendNode(std::make_unique<BookmarkNode>(BookmarkNode::Bookmark, name));
     bookmark->setUniqueId(bookmarkId);
     bookmark->setURL(url);
@@ -140,7 +151,7 @@ void BookmarkManager::appendBookmark(const QString &name, const QUrl &url, Bookm
     m_numBookmarks++;
 
     scheduleBookmarkInsert(bookmark);
-    scheduleResetList();
+    notifyBookmarksChanged();
 }
 
 void BookmarkManager::insertBookmark(const QString &name, const QUrl &url, BookmarkNode *folder, int position)
@@ -157,6 +168,7 @@ void BookmarkManager::insertBookmark(const QString &name, const QUrl &url, Bookm
     const int bookmarkId = m_nextBookmarkId++;
 
     // Create new bookmark
+    folder->invalidateSnapshot();
     BookmarkNode *bookmark = folder->insertNode(std::make_unique<BookmarkNode>(BookmarkNode::Bookmark, name), position);
     bookmark->setUniqueId(bookmarkId);
     bookmark->setURL(url);
@@ -165,7 +177,7 @@ void BookmarkManager::insertBookmark(const QString &name, const QUrl &url, Bookm
     m_numBookmarks++;
 
     scheduleBookmarkInsert(bookmark);
-    scheduleResetList();
+    notifyBookmarksChanged();
 }
 
 BookmarkNode *BookmarkManager::addFolder(const QString &name, BookmarkNode *parent)
@@ -179,6 +191,7 @@ BookmarkNode *BookmarkManager::addFolder(const QString &name, BookmarkNode *pare
     const int folderId = m_nextBookmarkId++;
 
     // Append bookmark folder to parent
+    parent->invalidateSnapshot();
     BookmarkNode *folder = parent->appendNode(std::make_unique<BookmarkNode>(BookmarkNode::Folder, name));
     folder->setUniqueId(folderId);
     folder->setIcon(QIcon::fromTheme(QLatin1String("folder")));
@@ -186,7 +199,7 @@ BookmarkNode *BookmarkManager::addFolder(const QString &name, BookmarkNode *pare
     m_numBookmarks++;
 
     scheduleBookmarkInsert(folder);
-    scheduleResetList();
+    notifyBookmarksChanged();
 
     return folder;
 }
@@ -207,21 +220,9 @@ void BookmarkManager::removeBookmark(const QUrl &url)
         }
     }
 
-    if (!m_nodeListFuture.isCanceled() && m_nodeListFuture.isRunning())
-        m_nodeListFuture.waitForFinished();
-
-    for (BookmarkNode *node : m_nodeList)
-    {
-        if (node->getType() != BookmarkNode::Bookmark)
-            continue;
-
-        // Bookmark URLs are unique, once match is found, remove bookmark and return
-        if (CommonUtil::doUrlsMatch(url, node->getURL(), true))
-        {
-            removeBookmark(node);
-            return;
-        }
-    }
+    // Bookmark URLs are unique, so only the first match is removed
+    if (BookmarkNode *node = findBookmark(url))
+        removeBookmark(node);
 }
 
 void BookmarkManager::removeBookmark(BookmarkNode *item)
@@ -251,6 +252,8 @@ void BookmarkManager::removeBookmark(BookmarkNode *item)
                 const std::string urlStdStr = child->m_url.toString().toStdString();
                 if (m_lookupCache.has(urlStdStr))
                     m_lookupCache.put(urlStdStr, nullptr);
+
+                m_numBookmarks--;
             }
         }
 
@@ -267,10 +270,12 @@ void BookmarkManager::removeBookmark(BookmarkNode *item)
             parent = m_rootNode.get();
 
         if (m_bookmarkStore)
-            m_taskScheduler.post(&BookmarkStore::removeNode, std::ref(m_bookmarkStore), node->getUniqueId(),
+            m_taskScheduler.post("BookmarkStore", &BookmarkStore::removeNode, std::ref(m_bookmarkStore), node->getUniqueId(),
                                  parent->getUniqueId(), node->getPosition());
         //emit bookmarkDeleted(node->getUniqueId(), parent->getUniqueId(), node->getPosition());
 
+        m_numBookmarks--;
+
         deleteQueue.pop_back();
     }
 
@@ -283,8 +288,9 @@ void BookmarkManager::removeBookmark(BookmarkNode *item)
 
     if (BookmarkNode *parent = item->getParent())
     {
+        parent->invalidateSnapshot();
         parent->removeNode(item);
-        scheduleResetList();
+        notifyBookmarksChanged();
     }
 }
 
@@ -325,6 +331,8 @@ BookmarkNode *BookmarkManager::setBookmarkParent(BookmarkNode *bookmark, Bookmar
     }
 
     BookmarkNode *oldParent = bookmark->getParent();
+    oldParent->invalidateSnapshot();
+    parent->invalidateSnapshot();
     for (auto it = oldParent->m_children.begin(); it != oldParent->m_children.end(); ++it)
     {
         if (it->get()->getUniqueId() == bookmark->getUniqueId())
@@ -339,7 +347,7 @@ BookmarkNode *BookmarkManager::setBookmarkParent(BookmarkNode *bookmark, Bookmar
     bookmark->m_parent = parent;
 
     scheduleBookmarkUpdate(bookmark);
-    scheduleResetList();
+    notifyBookmarksChanged();
 
     return bookmark;
 }
@@ -359,13 +367,14 @@ void BookmarkManager::setBookmarkPosition(BookmarkNode *bookmark, int position)
     // Adjust position of node in parent's child list
     if (position > currentPos)
         ++position;
-    static_cast<void>(parent->insertNode(std::make_unique<BookmarkNode>(std::move(*bookmark)), position));
+    parent->invalidateSnapshot();
+    parent->insertNode(std::make_unique<BookmarkNode>(std::move(*bookmark)), position);
     parent->removeNode(bookmark);
 
     bookmark = parent->getNode(position);
 
     scheduleBookmarkUpdate(bookmark);
-    scheduleResetList();
+    notifyBookmarksChanged();
 }
 
 void BookmarkManager::setBookmarkShortcut(BookmarkNode *bookmark, const QString &shortcut)
@@ -418,6 +427,73 @@ void BookmarkManager::setRootNode(std::shared_ptr<BookmarkNode> node)
         m_bookmarkBar = m_rootNode.get();
 }
 
+void BookmarkManager::importNodes(BookmarkNode *importedRoot, BookmarkNode *folder)
+{
+    if (!importedRoot)
+        return;
+
+    if (!folder)
+        folder = getBookmarksBar();
+    if (!folder)
+        return;
+
+    std::vector<BookmarkRecord> records;
+    std::vector<BookmarkNode*> importedNodes;
+
+    // Move the top-level nodes to the end of the target folder. Existing children of the folder keep their
+    // positions, so no sibling positions need to be updated in the database
+    folder->invalidateSnapshot();
+
+    std::deque<BookmarkNode*> queue;
+    for (auto &child : importedRoot->m_children)
+        queue.push_back(folder->appendNode(std::move(child)));
+    importedRoot->m_children.clear();
+
+    int position = folder->getNumChildren() - static_cast<int>(queue.size());
+    const QIcon folderIcon = QIcon::fromTheme(QLatin1String("folder"));
+
+    // Assign identifiers and positions in breadth-first order, which places every parent ahead of its children
+    while (!queue.empty())
+    {
+        BookmarkNode *node = queue.front();
+        queue.pop_front();
+
+        node->setUniqueId(m_nextBookmarkId++);
+
+        if (node->getType() == BookmarkNode::Folder)
+            node->setIcon(folderIcon);
+        else
+            node->setIcon(m_faviconManager ? m_faviconManager->getFavicon(node->getURL()) : QIcon());
+
+        records.emplace_back(node->getUniqueId(), node->getParent()->getUniqueId(),
+                             static_cast<int>(node->getType()), node->getName(),
+                             node->getURL(), node->getShortcut(), position++);
+        importedNodes.push_back(node);
+
+        if (node->getType() == BookmarkNode::Folder)
+        {
+            // Child positions are relative to the folder, and are assigned as the children are dequeued
+            for (auto &child : node->m_children)
+                queue.push_back(child.get());
+        }
+
+        // The next node in the queue starts a new sibling group when its parent differs from the current node's parent
+        if (!queue.empty() && queue.front()->getParent() != node->getParent())
+            position = 0;
+    }
+
+    m_numBookmarks += static_cast<int>(importedNodes.size());
+
+    if (m_bookmarkStore)
+    {
+        m_taskScheduler.post("BookmarkStore", [store = m_bookmarkStore, records = std::move(records)](){
+            store->insertNodes(records);
+        });
+    }
+
+    notifyBookmarksChanged();
+}
+
 void BookmarkManager::checkIfLoaded()
 {
     if (!m_rootNode.get())
@@ -426,31 +502,88 @@ void BookmarkManager::checkIfLoaded()
         return;
     }
 
-    if (m_faviconManager != nullptr)
+    loadBookmarkIcons();
+
+    m_numBookmarks.store(static_cast<int>(getSnapshot()->size()) + 1);
+    notifyBookmarksChanged();
+}
+
+void BookmarkManager::loadBookmarkIcons()
+{
+    if (m_faviconManager == nullptr || !m_rootNode.get())
+        return;
+
+    std::deque<BookmarkNode*> queue;
+    queue.push_back(m_rootNode.get());
+    while (!queue.empty())
     {
-        std::deque<BookmarkNode*> queue;
-        queue.push_back(m_rootNode.get());
-        while (!queue.empty())
+        BookmarkNode *n = queue.front();
+
+        for (const auto &node : n->m_children)
         {
-            BookmarkNode *n = queue.front();
+            BookmarkNode *childNode = node.get();
+            if (!childNode)
+                continue;
 
-            for (const auto &node : n->m_children)
+            if (childNode->getType() == BookmarkNode::Bookmark)
+                childNode->setIcon(m_faviconManager->getFavicon(childNode->getURL()));
+            else if (childNode->getType() == BookmarkNode::Folder)
+                queue.push_back(childNode);
+        }
+
+        queue.pop_front();
+    }
+
+    notifyBookmarksChanged();
+}
+
+void BookmarkManager::onPageIconLoaded(const QUrl &pageUrl, const QIcon &icon)
+{
+    const bool isUpdatePending = !m_loadedIcons.isEmpty();
+    m_loadedIcons.insert(pageUrl, icon);
+    if (isUpdatePending)
+        return;
+
+    QMetaObject::invokeMethod(this, &BookmarkManager::applyLoadedIcons, Qt::QueuedConnection);
+}
+
+void BookmarkManager::applyLoadedIcons()
+{
+    QHash<QUrl, QIcon> loadedIcons;
+    loadedIcons.swap(m_loadedIcons);
+
+    if (!m_rootNode.get())
+        return;
+
+    bool hasChanged = false;
+
+    std::deque<BookmarkNode*> queue;
+    queue.push_back(m_rootNode.get());
+    while (!queue.empty())
+    {
+        BookmarkNode *n = queue.front();
+        queue.pop_front();
+
+        for (const auto &node : n->m_children)
+        {
+            BookmarkNode *childNode = node.get();
+            if (childNode->getType() == BookmarkNode::Folder)
             {
-                BookmarkNode *childNode = node.get();
-                if (!childNode)
-                    continue;
-
-                if (childNode->getType() == BookmarkNode::Bookmark)
-                    childNode->setIcon(m_faviconManager->getFavicon(childNode->getURL()));
-                else if (childNode->getType() == BookmarkNode::Folder)
-                    queue.push_back(childNode);
+                queue.push_back(childNode);
+                continue;
             }
 
-            queue.pop_front();
+            auto it = loadedIcons.find(FaviconManager::getPageKey(childNode->getURL()));
+            if (it != loadedIcons.end())
+            {
+                childNode->setIcon(it.value());
+                hasChanged = true;
+            }
         }
     }
 
-    resetBookmarkList();
+    if (hasChanged)
+        notifyBookmarksChanged();
 }
 
 void BookmarkManager::scheduleBookmarkInsert(const BookmarkNode *node)
@@ -459,7 +592,7 @@ void BookmarkManager::scheduleBookmarkInsert(const BookmarkNode *node)
         return;
 
     // params: int nodeId, int parentId, int nodeType, const QString &name, const QUrl &url, int position
-    m_taskScheduler.post(&BookmarkStore::insertNode, std::ref(m_bookmarkStore),
+    m_taskScheduler.post("BookmarkStore", &BookmarkStore::insertNode, std::ref(m_bookmarkStore),
                          node->getUniqueId(), node->getParent()->getUniqueId(),
                          static_cast<int>(node->getType()), node->getName(),
                          node->getURL(), node->getPosition());
@@ -471,61 +604,78 @@ void BookmarkManager::scheduleBookmarkUpdate(const BookmarkNode *node)
         return;
 
     // params: int nodeId, int parentId, const QString &name, const QString &url, const QString &shortcut, int position
-    m_taskScheduler.post(&BookmarkStore::updateNode, std::ref(m_bookmarkStore),
+    m_taskScheduler.post("BookmarkStore", &BookmarkStore::updateNode, std::ref(m_bookmarkStore),
                          node->getUniqueId(), node->getParent()->getUniqueId(),
                          node->getName(), node->getURL(), node->getShortcut(),
                          node->getPosition());
 }
 
-void BookmarkManager::scheduleResetList()
-{
-    if (m_canUpdateList)
-        m_nodeListFuture = QtConcurrent::run(&BookmarkManager::resetBookmarkList, this);
-}
-
-void BookmarkManager::setCanUpdateList(bool value)
+void BookmarkManager::notifyBookmarksChanged()
 {
-    m_canUpdateList = value;
-    if (value)
-        scheduleResetList();
-}
+    if (m_changeNotificationPending)
+        return;
 
-void BookmarkManager::waitToFinishList()
-{
-    if (!m_nodeListFuture.isCanceled() && m_nodeListFuture.isRunning())
-        m_nodeListFuture.waitForFinished();
+    m_changeNotificationPending = true;
+    QMetaObject::invokeMethod(this, [this](){
+        m_changeNotificationPending = false;
+        publishSnapshot();
+        Q_EMIT bookmarksChanged();
+    }, Qt::QueuedConnection);
 }
 
-void BookmarkManager::resetBookmarkList()
+BookmarkNode *BookmarkManager::findBookmark(const QUrl &url) const
 {
-    std::lock_guard<std::mutex> _(m_mutex);
-
-    int numBookmarks = 1;
-    std::vector<BookmarkNode*> nodeList;
+    if (!m_rootNode.get())
+        return nullptr;
 
     std::deque<BookmarkNode*> queue;
     queue.push_back(m_rootNode.get());
     while (!queue.empty())
     {
         BookmarkNode *n = queue.front();
+        queue.pop_front();
 
         for (const auto &node : n->m_children)
         {
-            ++numBookmarks;
             BookmarkNode *childNode = node.get();
             if (!childNode)
                 continue;
 
-            nodeList.push_back(childNode);
-
             if (childNode->getType() == BookmarkNode::Folder)
                 queue.push_back(childNode);
+            else if (CommonUtil::doUrlsMatch(url, childNode->getURL(), true))
+                return childNode;
         }
-
-        queue.pop_front();
     }
 
-    m_numBookmarks.store(numBookmarks);
-    m_nodeList = std::move(nodeList);
-    Q_EMIT bookmarksChanged();
+    return nullptr;
+}
+
+std::shared_ptr<const BookmarkSnapshotNode> BookmarkManager::getSnapshotNode(BookmarkNode *node)
+{
+    if (node->m_snapshot)
+        return node->m_snapshot;
+
+    BookmarkSnapshotNode::Children children;
+    children.reserve(node->m_children.size());
+    for (const auto &child : node->m_children)
+        children.push_back(getSnapshotNode(child.get()));
+
+    node->m_snapshot = std::make_shared<const BookmarkSnapshotNode>(*node, std::move(children));
+    return node->m_snapshot;
+}
+
+void BookmarkManager::publishSnapshot()
+{
+    BookmarkNode *root = m_rootNode.get();
+
+    // The root keeps its copy until a node in the tree changes, in which case it is copied again along with
+    // the path to each changed node. Unchanged folders are shared with the previous snapshot
+    if (!root || root->m_snapshot)
+        return;
+
+    Snapshot snapshot = std::make_shared<const BookmarkSnapshot>(getSnapshotNode(root));
+
+    std::lock_guard<std::mutex> _(m_snapshotMutex);
+    m_snapshot = std::move(snapshot);
 }
@@ -1,17 +1,22 @@
 #ifndef BOOKMARKNODEMANAGER_H
 #define BOOKMARKNODEMANAGER_H
 
+#include "BookmarkSnapshot.h"
 #include "DatabaseTaskScheduler.h"
+#include "IResourceReporter.h"
 #include "LRUCache.h"
 #include "ServiceLocator.h"
 
 #include <atomic>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
 
-#include <QFuture>
+#include <QHash>
+#include <QIcon>
 #include <QObject>
+#include <QUrl>
 
 class BookmarkNode;
 class BookmarkStore;
@@ -23,7 +28,7 @@ class FaviconManager;
  *        to a bookmark occurs so the \ref BookmarkStore can save the state to the database.
  * @ingroup Bookmarks
  */
-class BookmarkManager : public QObject
+class BookmarkManager : public QObject, public IResourceReporter
 {
     friend class BookmarkImporter;
     friend class BookmarkStore;
@@ -32,8 +37,8 @@ class BookmarkManager : public QObject
     Q_OBJECT
 
 public:
-    using iterator = std::vector<BookmarkNode*>::iterator;
-    using const_iterator = std::vector<BookmarkNode*>::const_iterator;
+    /// Shared, read-only view of the bookmark tree at a point in time
+    using Snapshot = std::shared_ptr<const BookmarkSnapshot>;
 
     /// Constructs the bookmark node manager, given the service locator, task scheduler and a pointer to the manager's parent
     explicit BookmarkManager(const ViperServiceLocator &serviceLocator, DatabaseTaskScheduler &taskScheduler, QObject *parent);
@@ -41,11 +46,14 @@ class BookmarkManager : public QObject
     /// BookmarkManager destructor
     ~BookmarkManager();
 
-    /// Returns an iterator pointing to the first bookmark in the collection
-    const_iterator begin() const { return m_nodeList.cbegin(); }
+    /// Returns the memory held by the bookmark collection and its lookup cache
+    std::vector<ResourceUsage> getResourceUsage() const override;
 
-    /// Returns an iterator at the end of the bookmark collection
-    const_iterator end() const { return m_nodeList.cend(); }
+    /// Returns a consistent snapshot of every node in the bookmark collection, in tree order. The snapshot holds
+    /// copies of the nodes, so it can be iterated from any thread and is not affected by changes made after it
+    /// was taken. Callers on the manager's thread see every change made so far, while other threads see the
+    /// changes once the bookmarksChanged() signal has been emitted
+    Snapshot getSnapshot();
 
     /// Returns the root of the bookmark tree
     BookmarkNode *getRoot() const;
@@ -127,19 +135,26 @@ class BookmarkManager : public QObject
     /// Sets the root node of the bookmark tree - this is called by the \ref BookmarkStore after loading the data
     void setRootNode(std::shared_ptr<BookmarkNode> node);
 
-    /// Runs resetBookmarkList concurrently as long as a major change isn't being made to the bookmark collection
-    void scheduleResetList();
-
-    /// Sets the flag indicating whether or not the flattened list of bookmarks should be updated
-    void setCanUpdateList(bool value);
-
-    /// Waits on any asynchronous resetBookmarkList() operations
-    void waitToFinishList();
+    /**
+     * @brief Moves the bookmarks parsed by the \ref BookmarkImporter to the end of the given folder. Unique identifiers
+     *        and positions are assigned in memory, and the new nodes are saved to the database in a single batch.
+     * @param importedRoot Detached folder containing the imported bookmarks and sub-folders. Its children are moved out of it
+     * @param folder Folder that will become the parent of the imported nodes
+     */
+    void importNodes(BookmarkNode *importedRoot, BookmarkNode *folder);
 
 private Q_SLOTS:
     /// Runs on a regular interval until the root bookmark node has been populated
     void checkIfLoaded();
 
+    /// Sets the icon of each bookmark in the tree from the favicon manager. Called once the bookmarks
+    /// have been loaded, and again once the favicon store has been loaded
+    void loadBookmarkIcons();
+
+    /// Called when the favicon of a page that was not cached has been found. The icons of the bookmarks to the page
+    /// are updated once control returns to the event loop, along with any other icons that were found by then
+    void onPageIconLoaded(const QUrl &pageUrl, const QIcon &icon);
+
 private:
     /// Schedules an create bookmark operation in the repository
     void scheduleBookmarkInsert(const BookmarkNode *node);
@@ -147,8 +162,23 @@ private Q_SLOTS:
     /// Schedules a boookmark update to the database worker
     void scheduleBookmarkUpdate(const BookmarkNode *node);
 
-    /// Resets the flat list of bookmark node pointers, used for iteration & bookmark searches
-    void resetBookmarkList();
+    /// Searches the bookmark tree for a bookmark with the given URL, returning a nullptr if it is not found
+    BookmarkNode *findBookmark(const QUrl &url) const;
+
+    /// Returns the copy of the given node for the bookmark snapshot, copying the node and any of its
+    /// descendants that have changed since the last snapshot
+    std::shared_ptr<const BookmarkSnapshotNode> getSnapshotNode(BookmarkNode *node);
+
+    /// Publishes a new snapshot of the bookmark tree, if it has changed since the last snapshot was taken.
+    /// Only the nodes that changed, and their ancestors, are copied again
+    void publishSnapshot();
+
+    /// Sets the icons of the bookmarks to the pages in \ref m_loadedIcons, in a single pass over the tree
+    void applyLoadedIcons();
+
+    /// Emits the bookmarksChanged() signal once control returns to the event loop, coalescing
+    /// multiple changes to the collection into a single notification
+    void notifyBookmarksChanged();
 
 private:
     /// Reference to the task scheduler. Needed to queue work for the \ref BookmarkStore
@@ -169,24 +199,23 @@ private Q_SLOTS:
     /// Cache of bookmark nodes that were recently searched for within the application
     LRUCache<std::string, BookmarkNode*> m_lookupCache;
 
-    /// Container of bookmark node pointers, flattened version of tree structure used for bookmark iteration
-    std::vector<BookmarkNode*> m_nodeList;
+    /// Guards the latest snapshot of the bookmark tree, which is read from other threads
+    mutable std::mutex m_snapshotMutex;
+
+    /// Latest snapshot of the bookmark tree
+    Snapshot m_snapshot;
 
-    /// Flag indicating whether or not a major change is happening to the bookmark tree.
-    /// If true, the flattened bookmark list will not update itself until this flag is set back to false.
-    bool m_canUpdateList;
+    /// Favicons that were loaded since the bookmark icons were last updated, keyed by page URL
+    QHash<QUrl, QIcon> m_loadedIcons;
+
+    /// Flag indicating whether or not a bookmarksChanged() notification is waiting to be emitted
+    bool m_changeNotificationPending;
 
     /// Next unique identifier to be assigned to a bookmark
     int m_nextBookmarkId;
 
     /// Stores the number of bookmarks in the tree.
     std::atomic_int m_numBookmarks;
-
-    /// Future associated with the m_nodeList regeneration method
-    QFuture<void> m_nodeListFuture;
-
-    /// Mutex
-    mutable std::mutex m_mutex;
 };
 
 #endif // BOOKMARKNODEMANAGER_H
@@ -10,7 +10,8 @@ BookmarkNode::BookmarkNode() :
     m_url(),
     m_icon(),
     m_shortcut(),
-    m_type(BookmarkNode::Bookmark)
+    m_type(BookmarkNode::Bookmark),
+    m_snapshot(nullptr)
 {
 }
 
@@ -21,7 +22,8 @@ BookmarkNode::BookmarkNode(BookmarkNode::NodeType type, const QString &name) :
     m_url(),
     m_icon(),
     m_shortcut(),
-    m_type(type)
+    m_type(type),
+    m_snapshot(nullptr)
 {
 }
 
@@ -35,6 +37,10 @@ BookmarkNode::BookmarkNode(BookmarkNode &&other) noexcept
     m_parent = other.m_parent;
     m_icon = std::move(other.m_icon);
     m_children = std::move(other.m_children);
+    m_snapshot = std::move(other.m_snapshot);
+
+    for (auto &child : m_children)
+        child->m_parent = this;
 }
 
 int BookmarkNode::getPosition() const
@@ -59,6 +65,7 @@ BookmarkNode::NodeType BookmarkNode::getType() const
 void BookmarkNode::setType(BookmarkNode::NodeType type)
 {
     m_type = type;
+    invalidateSnapshot();
 }
 
 const QString &BookmarkNode::getName() const
@@ -69,6 +76,7 @@ const QString &BookmarkNode::getName() const
 void BookmarkNode::setName(const QString &name)
 {
     m_name = name;
+    invalidateSnapshot();
 }
 
 const QString &BookmarkNode::getShortcut() const
@@ -79,6 +87,7 @@ const QString &BookmarkNode::getShortcut() const
 void BookmarkNode::setShortcut(const QString &shortcut)
 {
     m_shortcut = shortcut;
+    invalidateSnapshot();
 }
 
 const QUrl &BookmarkNode::getURL() const
@@ -89,6 +98,7 @@ const QUrl &BookmarkNode::getURL() const
 void BookmarkNode::setURL(const QUrl &url)
 {
     m_url = url;
+    invalidateSnapshot();
 }
 
 const QIcon &BookmarkNode::getIcon() const
@@ -99,6 +109,7 @@ const QIcon &BookmarkNode::getIcon() const
 void BookmarkNode::setIcon(const QIcon &icon)
 {
     m_icon = icon;
+    invalidateSnapshot();
 }
 
 int BookmarkNode::getUniqueId() const
@@ -109,6 +120,14 @@ int BookmarkNode::getUniqueId() const
 void BookmarkNode::setUniqueId(int id)
 {
     m_id = id;
+    invalidateSnapshot();
+}
+
+void BookmarkNode::invalidateSnapshot()
+{
+    // A folder is only copied along with its children, so once a node has no copy, neither do its ancestors
+    for (BookmarkNode *node = this; node != nullptr && node->m_snapshot; node = node->m_parent)
+        node->m_snapshot.reset();
 }
 
 QDataStream& operator<<(QDataStream &out, BookmarkNode *&node)
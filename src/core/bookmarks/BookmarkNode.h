@@ -6,12 +6,16 @@
 
 #include "TreeNode.h"
 
+#include <memory>
+
 #include <QDataStream>
 #include <QIcon>
 #include <QMetaType>
 #include <QString>
 #include <QUrl>
 
+class BookmarkSnapshotNode;
+
 /**
  * @class BookmarkNode
  * @brief Individual node that is a part of the Bookmarks tree. Each node
@@ -20,7 +24,9 @@
  */
 class BookmarkNode : public TreeNode<BookmarkNode> , public sqlite::Row
 {
+    friend class BookmarkImporter;
     friend class BookmarkManager;
+    friend class BookmarkSnapshotNode;
     friend class BookmarkStore;
 
 public:
@@ -77,6 +83,10 @@ class BookmarkNode : public TreeNode<BookmarkNode> , public sqlite::Row
     /// Sets the URL of the node
     void setURL(const QUrl &url);
 
+    /// Discards the copies of this node and its ancestors that were made for the last bookmark snapshot,
+    /// so they are copied again by the next snapshot. Called whenever the node or its children change
+    void invalidateSnapshot();
+
 protected:
     /// Unique identifier of the node as stored in the database
     int m_id;
@@ -96,6 +106,10 @@ class BookmarkNode : public TreeNode<BookmarkNode> , public sqlite::Row
     /// Type of node
     NodeType m_type;
 
+    /// Copy of this node that was made for the last bookmark snapshot, or a nullptr if the node has changed since.
+    /// Only accessed on the thread of the \ref BookmarkManager
+    std::shared_ptr<const BookmarkSnapshotNode> m_snapshot;
+
 public:
     /// Writes the bookmark node into the prepared statement
     void marshal(sqlite::PreparedStatement &stmt) const override
@@ -0,0 +1,120 @@
+#include "BookmarkSnapshot.h"
+
+BookmarkSnapshotNode::BookmarkSnapshotNode(const BookmarkNode &node, Children children) :
+    m_id(node.getUniqueId()),
+    m_type(node.getType()),
+    m_name(node.getName()),
+    m_url(node.getURL()),
+    m_icon(node.getIcon()),
+    m_shortcut(node.getShortcut()),
+    m_children(std::move(children)),
+    m_numDescendants(m_children.size())
+{
+    for (const auto &child : m_children)
+        m_numDescendants += child->getNumDescendants();
+}
+
+int BookmarkSnapshotNode::getUniqueId() const
+{
+    return m_id;
+}
+
+BookmarkNode::NodeType BookmarkSnapshotNode::getType() const
+{
+    return m_type;
+}
+
+const QString &BookmarkSnapshotNode::getName() const
+{
+    return m_name;
+}
+
+const QString &BookmarkSnapshotNode::getShortcut() const
+{
+    return m_shortcut;
+}
+
+const QUrl &BookmarkSnapshotNode::getURL() const
+{
+    return m_url;
+}
+
+const QIcon &BookmarkSnapshotNode::getIcon() const
+{
+    return m_icon;
+}
+
+const BookmarkSnapshotNode::Children &BookmarkSnapshotNode::getChildren() const
+{
+    return m_children;
+}
+
+std::size_t BookmarkSnapshotNode::getNumDescendants() const
+{
+    return m_numDescendants;
+}
+
+BookmarkSnapshot::const_iterator::const_iterator(const BookmarkSnapshotNode *root) :
+    m_path(),
+    m_current(nullptr)
+{
+    if (!root || root->getChildren().empty())
+        return;
+
+    m_path.emplace_back(root, 0);
+    m_current = root->getChildren().front().get();
+}
+
+BookmarkSnapshot::const_iterator &BookmarkSnapshot::const_iterator::operator++()
+{
+    if (!m_current)
+        return *this;
+
+    // Descend into the current folder before visiting its siblings
+    if (!m_current->getChildren().empty())
+    {
+        m_path.emplace_back(m_current, 0);
+        m_current = m_current->getChildren().front().get();
+        return *this;
+    }
+
+    while (!m_path.empty())
+    {
+        auto &parent = m_path.back();
+        if (++parent.second < parent.first->getChildren().size())
+        {
+            m_current = parent.first->getChildren().at(parent.second).get();
+            return *this;
+        }
+
+        m_path.pop_back();
+    }
+
+    m_current = nullptr;
+    return *this;
+}
+
+BookmarkSnapshot::BookmarkSnapshot(std::shared_ptr<const BookmarkSnapshotNode> root) :
+    m_root(std::move(root))
+{
+}
+
+BookmarkSnapshot::const_iterator BookmarkSnapshot::begin() const
+{
+    return const_iterator(m_root.get());
+}
+
+BookmarkSnapshot::const_iterator BookmarkSnapshot::end() const
+{
+    return const_iterator();
+}
+
+std::size_t BookmarkSnapshot::size() const
+{
+    return m_root ? m_root->getNumDescendants() : 0;
+}
+
+const BookmarkSnapshotNode *BookmarkSnapshot::getRoot() const
+{
+    return m_root.get();
+}
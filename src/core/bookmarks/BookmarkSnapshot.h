@@ -0,0 +1,149 @@
+#ifndef BOOKMARKSNAPSHOT_H
+#define BOOKMARKSNAPSHOT_H
+
+#include "BookmarkNode.h"
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <QIcon>
+#include <QString>
+#include <QUrl>
+
+/**
+ * @class BookmarkSnapshotNode
+ * @brief Immutable copy of a \ref BookmarkNode and its children, as of the time the copy was made.
+ *        Copies of the folders and bookmarks that have not changed are shared between snapshots.
+ * @ingroup Bookmarks
+ */
+class BookmarkSnapshotNode
+{
+public:
+    /// Copies of the child nodes, in the order of their positions
+    using Children = std::vector<std::shared_ptr<const BookmarkSnapshotNode>>;
+
+    /// Copies the data of the given node, taking the copies of its children
+    BookmarkSnapshotNode(const BookmarkNode &node, Children children);
+
+    /// Returns the unique identifier of the node
+    int getUniqueId() const;
+
+    /// Returns the type of the node
+    BookmarkNode::NodeType getType() const;
+
+    /// Returns the name of the node
+    const QString &getName() const;
+
+    /// Returns the shortcut used to load the bookmark
+    const QString &getShortcut() const;
+
+    /// Returns the URL of the bookmark, or an empty URL if the node is a folder
+    const QUrl &getURL() const;
+
+    /// Returns the icon associated with the node
+    const QIcon &getIcon() const;
+
+    /// Returns the copies of the node's children
+    const Children &getChildren() const;
+
+    /// Returns the number of nodes below this node in the tree
+    std::size_t getNumDescendants() const;
+
+private:
+    /// Unique identifier of the node
+    int m_id;
+
+    /// Type of node
+    BookmarkNode::NodeType m_type;
+
+    /// Name of the node
+    QString m_name;
+
+    /// URL of the node
+    QUrl m_url;
+
+    /// Icon of the node
+    QIcon m_icon;
+
+    /// Shortcut to load the bookmark
+    QString m_shortcut;
+
+    /// Copies of the child nodes
+    Children m_children;
+
+    /// Number of nodes below this node in the tree
+    std::size_t m_numDescendants;
+};
+
+/**
+ * @class BookmarkSnapshot
+ * @brief Consistent, read-only view of the bookmark tree at a point in time. It can be iterated from any thread,
+ *        and is not affected by changes made to the bookmark collection after it was taken.
+ *
+ *        Iterating the snapshot visits every node except the root, in tree order: each folder is followed by
+ *        its children, in the order of their positions.
+ * @ingroup Bookmarks
+ */
+class BookmarkSnapshot
+{
+public:
+    /// Iterates the nodes of a snapshot in tree order
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = const BookmarkSnapshotNode*;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const value_type*;
+        using reference         = const value_type&;
+
+        /// Constructs the end iterator
+        const_iterator() = default;
+
+        /// Constructs an iterator that begins with the first child of the given root node
+        explicit const_iterator(const BookmarkSnapshotNode *root);
+
+        /// Returns the current node
+        reference operator*() const { return m_current; }
+
+        /// Advances to the next node in tree order
+        const_iterator &operator++();
+
+        /// Returns true if both iterators point to the same node
+        bool operator==(const const_iterator &other) const { return m_current == other.m_current; }
+
+        /// Returns true if the iterators point to different nodes
+        bool operator!=(const const_iterator &other) const { return m_current != other.m_current; }
+
+    private:
+        /// Folders between the root and the current node, along with the index of the child being visited in each
+        std::vector<std::pair<const BookmarkSnapshotNode*, std::size_t>> m_path;
+
+        /// Current node, or a nullptr once every node has been visited
+        const BookmarkSnapshotNode *m_current { nullptr };
+    };
+
+    /// Constructs the snapshot of the tree under the given root node, which may be a nullptr if the bookmarks are not loaded
+    explicit BookmarkSnapshot(std::shared_ptr<const BookmarkSnapshotNode> root);
+
+    /// Returns an iterator to the first node below the root
+    const_iterator begin() const;
+
+    /// Returns the end iterator
+    const_iterator end() const;
+
+    /// Returns the number of nodes in the snapshot, excluding the root
+    std::size_t size() const;
+
+    /// Returns the copy of the root node, or a nullptr if the bookmarks were not loaded when the snapshot was taken
+    const BookmarkSnapshotNode *getRoot() const;
+
+private:
+    /// Copy of the root node
+    std::shared_ptr<const BookmarkSnapshotNode> m_root;
+};
+
+#endif // BOOKMARKSNAPSHOT_H
@@ -63,6 +63,30 @@ void BookmarkStore::insertNode(int nodeId, int parentId, int nodeType, const QSt
         qWarning() << "BookmarkStore::onBookmarkCreated - could not update bookmark positions.";
 }
 
+void BookmarkStore::insertNodes(const std::vector<BookmarkRecord> &records)
+{
+    if (records.empty())
+        return;
+
+    if (!m_database.beginTransaction())
+    {
+        qWarning() << "BookmarkStore::insertNodes - could not start transaction";
+        return;
+    }
+
+    auto stmt = m_database.prepare(R"(INSERT OR REPLACE INTO Bookmarks(ID, ParentID, Type, Name, URL, Shortcut, Position) VALUES (?, ?, ?, ?, ?, ?, ?))");
+    for (const BookmarkRecord &record : records)
+    {
+        stmt << record;
+        if (!stmt.execute())
+            qWarning() << "BookmarkStore::insertNodes - could not save bookmark " << record.name << ", id " << record.id;
+        stmt.reset();
+    }
+
+    if (!m_database.commitTransaction())
+        qWarning() << "BookmarkStore::insertNodes - could not commit transaction";
+}
+
 void BookmarkStore::removeNode(int nodeId, int parentId, int position)
 {
     auto stmt = m_database.prepare(R"(DELETE FROM Bookmarks WHERE ID = ? OR ParentID = ?)");
@@ -11,10 +11,69 @@
 
 #include <QObject>
 #include <QString>
+#include <QUrl>
 
 class BookmarkNode;
 class BookmarkManager;
 
+/**
+ * @struct BookmarkRecord
+ * @brief Copy of the persisted properties of a bookmark node, used to save a batch
+ *        of new nodes from the database thread without touching the bookmark tree.
+ * @ingroup Bookmarks
+ */
+struct BookmarkRecord final : public sqlite::Row
+{
+    /// Unique identifier of the node
+    int id;
+
+    /// Unique identifier of the node's parent folder
+    int parentId;
+
+    /// Type of node, as a BookmarkNode::NodeType
+    int type;
+
+    /// Name of the node
+    QString name;
+
+    /// URL of the node, empty for folders
+    QUrl url;
+
+    /// Shortcut used to load the bookmark
+    QString shortcut;
+
+    /// Position of the node relative to its siblings
+    int position;
+
+    /// Constructs a bookmark record
+    BookmarkRecord(int id, int parentId, int type, const QString &name, const QUrl &url, const QString &shortcut, int position) :
+        sqlite::Row(),
+        id(id),
+        parentId(parentId),
+        type(type),
+        name(name),
+        url(url),
+        shortcut(shortcut),
+        position(position)
+    {
+    }
+
+    /// Writes the bookmark record into the prepared statement
+    void marshal(sqlite::PreparedStatement &stmt) const override
+    {
+        stmt << id
+             << parentId
+             << type
+             << name
+             << url
+             << shortcut
+             << position;
+    }
+
+    /// Not used
+    void unmarshal(sqlite::PreparedStatement &/*stmt*/) override {}
+};
+
 /**
  * @defgroup Bookmarks Bookmark System
  */
@@ -47,6 +106,10 @@ class BookmarkStore : public DatabaseWorker
     /// Inserts or replaces the given bookmark node into the database
     void insertNode(int nodeId, int parentId, int nodeType, const QString &name, const QUrl &url, int position);
 
+    /// Inserts a batch of new bookmark nodes into the database within a single transaction. The records must
+    /// already have their final positions, as the positions of any sibling nodes are not updated.
+    void insertNodes(const std::vector<BookmarkRecord> &records);
+
     /// Removes a node from the database with the given id, parent id and position
     void removeNode(int nodeId, int parentId, int position);
 
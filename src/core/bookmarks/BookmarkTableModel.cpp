@@ -4,6 +4,7 @@
 
 #include <deque>
 #include <set>
+#include <vector>
 
 #include <QByteArray>
 #include <QDataStream>
@@ -295,15 +296,27 @@ void BookmarkTableModel::searchFor(const QString &text)
     // Make term lowercase (case-insensitive search)
     QString query = text.toLower();
 
-    // Iterate through bookmark collection for any bookmark titles or urls containing the search term
-    for (auto it = m_bookmarkMgr->begin(); it != m_bookmarkMgr->end(); ++it)
+    // Search the bookmark tree in tree order for any bookmark titles or urls containing the search term. The tree
+    // itself is walked, rather than a snapshot, since the search results refer to the nodes
+    std::vector<BookmarkNode*> nodeStack;
+    if (BookmarkNode *rootNode = m_bookmarkMgr->getRoot())
     {
-        BookmarkNode *node = *it;
+        for (int i = rootNode->getNumChildren() - 1; i >= 0; --i)
+            nodeStack.push_back(rootNode->getNode(i));
+    }
+    while (!nodeStack.empty())
+    {
+        BookmarkNode *node = nodeStack.back();
+        nodeStack.pop_back();
+
         if (node->getName().toLower().contains(query)
                 || node->getURL().toString().toLower().contains(query))
         {
             m_searchResults.push_back(node);
         }
+
+        for (int i = node->getNumChildren() - 1; i >= 0; --i)
+            nodeStack.push_back(node->getNode(i));
     }
 
     endResetModel();
@@ -16,6 +16,9 @@ class LRUCache
     typedef typename std::list<Node>::iterator ListIterator;
 
 public:
+    /// Iterates the key-value pairs of the cache, from the most to the least recently used
+    typedef typename std::list<Node>::const_iterator const_iterator;
+
     /// Constructs the LRU cache with a given maximum capacity
     explicit LRUCache(size_t maxSize) : m_maxSize(maxSize), m_list(), m_map() {}
 
@@ -72,6 +75,24 @@ class LRUCache
         m_list.clear();
     }
 
+    /// Returns the number of items in the cache
+    size_t size() const
+    {
+        return m_list.size();
+    }
+
+    /// Returns an iterator to the most recently used key-value pair, without changing the order of the cache
+    const_iterator begin() const
+    {
+        return m_list.cbegin();
+    }
+
+    /// Returns the end iterator
+    const_iterator end() const
+    {
+        return m_list.cend();
+    }
+
 private:
     /// The maximum number of key-value pairs in the cache
     size_t m_maxSize;
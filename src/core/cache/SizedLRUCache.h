@@ -0,0 +1,121 @@
+#ifndef SIZEDLRUCACHE_H
+#define SIZEDLRUCACHE_H
+
+#include <cstddef>
+#include <list>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+
+/**
+ * @class SizedLRUCache
+ * @brief A least recently used cache that is bounded by the total size of its values, rather than
+ *        by the number of values. The size of each value is given when it is placed into the cache,
+ *        in whichever unit the cache was constructed with (typically bytes)
+ */
+template <typename KeyType, typename ValueType>
+class SizedLRUCache
+{
+    typedef typename std::tuple<KeyType, ValueType, std::size_t> Node;
+    typedef typename std::list<Node>::iterator ListIterator;
+
+public:
+    /// Constructs the cache with a given maximum total size
+    explicit SizedLRUCache(std::size_t maxSize) : m_maxSize(maxSize), m_totalSize(0), m_list(), m_map() {}
+
+    /// Returns true if the cache contains an item associated with the given key, false if else
+    bool has(const KeyType &key) const
+    {
+        return m_map.find(key) != m_map.end();
+    }
+
+    /// Returns a const reference to the value associated with the given key.
+    /// Throws an out_of_range exception if the key-value pair is not in the cache
+    const ValueType &get(const KeyType &key)
+    {
+        auto it = m_map.find(key);
+        if (it == m_map.end())
+            throw std::out_of_range("SizedLRUCache: key is not in the cache, cannot fetch value");
+
+        // Move item to front of the list
+        m_list.splice(m_list.begin(), m_list, it->second);
+
+        return std::get<1>(*it->second);
+    }
+
+    /// Places the key-value pair into the front of the cache, evicting the least recently used items until the total
+    /// size is within the limit. A value that is larger than the limit by itself is not cached
+    void put(const KeyType &key, const ValueType &value, std::size_t size)
+    {
+        remove(key);
+
+        if (size > m_maxSize)
+            return;
+
+        m_list.push_front(Node{key, value, size});
+        m_map[key] = m_list.begin();
+        m_totalSize += size;
+
+        while (m_totalSize > m_maxSize)
+        {
+            // Remove LRU item
+            const Node &lruNode = m_list.back();
+            m_totalSize -= std::get<2>(lruNode);
+            m_map.erase(std::get<0>(lruNode));
+            m_list.pop_back();
+        }
+    }
+
+    /// Removes the item associated with the given key, if it is in the cache
+    void remove(const KeyType &key)
+    {
+        auto it = m_map.find(key);
+        if (it == m_map.end())
+            return;
+
+        m_totalSize -= std::get<2>(*it->second);
+        m_list.erase(it->second);
+        m_map.erase(it);
+    }
+
+    /// Clears the cache
+    void clear()
+    {
+        m_map.clear();
+        m_list.clear();
+        m_totalSize = 0;
+    }
+
+    /// Returns the number of items in the cache
+    std::size_t count() const
+    {
+        return m_list.size();
+    }
+
+    /// Returns the total size of the items in the cache
+    std::size_t totalSize() const
+    {
+        return m_totalSize;
+    }
+
+    /// Returns the maximum total size of the items in the cache
+    std::size_t maxSize() const
+    {
+        return m_maxSize;
+    }
+
+private:
+    /// The maximum total size of the items in the cache
+    std::size_t m_maxSize;
+
+    /// The total size of the items in the cache
+    std::size_t m_totalSize;
+
+    /// A doubly-linked list of key-value-size tuples
+    std::list<Node> m_list;
+
+    /// A hashmap of keys pointing to corresponding tuple iterators in the list
+    std::unordered_map<KeyType, ListIterator> m_map;
+};
+
+#endif // SIZEDLRUCACHE_H
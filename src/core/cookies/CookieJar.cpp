@@ -1,3 +1,4 @@
+#include <QCoreApplication>
 #include <QDateTime>
 #include <QFile>
 #include <QNetworkCookie>
@@ -13,12 +14,50 @@
 #include "CookieJar.h"
 #include "Settings.h"
 
+namespace
+{
+    /// Returns the domain of the cookie in lower case, without a leading dot
+    QString getCookieDomain(const QNetworkCookie &cookie)
+    {
+        QString domain = cookie.domain().toLower();
+        if (domain.startsWith(QLatin1Char('.')))
+            domain.remove(0, 1);
+        return domain;
+    }
+
+    /// Returns a key that identifies the cookie within its domain
+    QString getCookieKey(const QNetworkCookie &cookie)
+    {
+        return QString::fromUtf8(cookie.name()) + QLatin1Char('\n') + cookie.path();
+    }
+
+    /// Calls the given function with the host and each of its parent domains, stopping early if the function returns true.
+    /// Returns true if the function returned true for one of the domains
+    template <typename Function>
+    bool forEachDomainOf(const QString &host, Function &&fn)
+    {
+        qsizetype pos = 0;
+        while (pos >= 0 && pos < host.size())
+        {
+            if (fn(host.mid(pos)))
+                return true;
+
+            pos = host.indexOf(QLatin1Char('.'), pos);
+            if (pos >= 0)
+                ++pos;
+        }
+        return false;
+    }
+}
+
 CookieJar::CookieJar(Settings *settings, QWebEngineProfile *defaultProfile, bool privateJar, QObject *parent) :
     QNetworkCookieJar(parent),
     m_enableCookies(false),
     m_privateJar(privateJar),
     m_store(nullptr),
     m_exemptParties(),
+    m_exemptHosts(std::make_shared<const std::unordered_set<QString>>()),
+    m_cookieDomains(),
     m_exemptThirdPartyCookieFileName(),
     m_mutex()
 {
@@ -45,7 +84,7 @@ CookieJar::CookieJar(Settings *settings, QWebEngineProfile *defaultProfile, bool
         loadExemptThirdParties();
 
 #if (QTWEBENGINECORE_VERSION >= QT_VERSION_CHECK(5, 11, 0))
-    connect(sBrowserApplication, &BrowserApplication::aboutToQuit, this, [this]() {
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, [this]() {
         if (m_store)
             m_store->setCookieFilter(nullptr);
     });
@@ -68,18 +107,12 @@ bool CookieJar::hasCookiesFor(const QString &host) const
     if (host.isEmpty())
         return false;
 
-    // If host string of format "xxx.yyy.zzz", must check for any cookies ending
-    // in ".yyy.zzz"
-    QString hostSearch = host;
-    int numDots = host.count(QChar('.'));
-    if (numDots > 1)
-        hostSearch = host.right(host.size() - host.indexOf(QChar('.'), 0));
-
-    auto cookies = allCookies();
-    for (const QNetworkCookie &cookie : cookies)
-        if (cookie.domain().endsWith(hostSearch))
-            return true;
-    return false;
+    std::lock_guard<std::mutex> _(m_mutex);
+
+    // A cookie applies to the host if it was set for the host itself, or for one of its parent domains
+    return forEachDomainOf(host.toLower(), [this](const QString &domain) {
+        return m_cookieDomains.find(domain) != m_cookieDomains.end();
+    });
 }
 
 void CookieJar::eraseAllCookies()
@@ -88,6 +121,11 @@ void CookieJar::eraseAllCookies()
     setAllCookies(noCookies);
     m_store->deleteAllCookies();
 
+    {
+        std::lock_guard<std::mutex> _(m_mutex);
+        m_cookieDomains.clear();
+    }
+
     emit cookiesRemoved();
 }
 
@@ -109,20 +147,7 @@ void CookieJar::setThirdPartyCookiesEnabled(bool value)
 
     m_store->setCookieFilter([this](const QWebEngineCookieStore::FilterRequest &request) -> bool {
         if (request.thirdParty && m_enableCookies)
-        {
-            const QString originHost = request.origin.host();
-            for (const auto &url : qAsConst(m_exemptParties))
-            {
-                const QString urlHost = url.host();
-                if (urlHost == originHost)
-                    return true;
-
-                const int domainIndex = originHost.indexOf(urlHost);
-                if (domainIndex > 0 && originHost.at(domainIndex - 1) == QLatin1Char('.'))
-                    return true;
-            }
-            return false;
-        }
+            return isExemptThirdParty(request.origin.host());
         return m_enableCookies;
     });
 #else
@@ -130,6 +155,19 @@ void CookieJar::setThirdPartyCookiesEnabled(bool value)
 #endif
 }
 
+bool CookieJar::isExemptThirdParty(const QString &host) const
+{
+    // The snapshot is never modified after it is published, so it can be read without locking
+    std::shared_ptr<const std::unordered_set<QString>> exemptHosts = std::atomic_load(&m_exemptHosts);
+    if (exemptHosts->empty() || host.isEmpty())
+        return false;
+
+    // An exemption applies to the host itself and to its subdomains
+    return forEachDomainOf(host.toLower(), [&exemptHosts](const QString &domain) {
+        return exemptHosts->find(domain) != exemptHosts->end();
+    });
+}
+
 const QSet<URL> &CookieJar::getExemptThirdPartyHosts() const
 {
     return m_exemptParties;
@@ -139,12 +177,14 @@ void CookieJar::addThirdPartyExemption(const QUrl &hostUrl)
 {
     URL url(hostUrl);
     m_exemptParties.insert(url);
+    publishExemptHosts();
 }
 
 void CookieJar::removeThirdPartyExemption(const QUrl &hostUrl)
 {
     URL url(hostUrl);
-    m_exemptParties.remove(hostUrl);
+    m_exemptParties.remove(url);
+    publishExemptHosts();
 }
 
 void CookieJar::loadExemptThirdParties()
@@ -164,6 +204,8 @@ void CookieJar::loadExemptThirdParties()
         if (!host.isEmpty())
             m_exemptParties.insert(URL(host));
     }
+
+    publishExemptHosts();
 }
 
 void CookieJar::saveExemptThirdParties()
@@ -200,7 +242,7 @@ void CookieJar::onCookieAdded(const QNetworkCookie &cookie)
         std::lock_guard<std::mutex> _(m_mutex);
 
         if (m_enableCookies)
-            static_cast<void>(insertCookie(cookie));
+            updateCookieIndex(cookie, insertCookie(cookie));
         else
             m_store->deleteCookie(cookie);
     } catch (const std::exception &ex) {
@@ -212,6 +254,7 @@ void CookieJar::onCookieRemoved(const QNetworkCookie &cookie)
 {
     std::lock_guard<std::mutex> _(m_mutex);
     static_cast<void>(deleteCookie(cookie));
+    updateCookieIndex(cookie, false);
 }
 
 void CookieJar::onSettingChanged(BrowserSetting setting, const QVariant &value)
@@ -257,4 +300,43 @@ void CookieJar::removeExpired()
     }
 
     setAllCookies(cookies);
+
+    std::lock_guard<std::mutex> _(m_mutex);
+    m_cookieDomains.clear();
+    for (const QNetworkCookie &cookie : qAsConst(cookies))
+        updateCookieIndex(cookie, true);
+}
+
+void CookieJar::updateCookieIndex(const QNetworkCookie &cookie, bool isStored)
+{
+    const QString domain = getCookieDomain(cookie);
+    if (isStored)
+    {
+        m_cookieDomains[domain].insert(getCookieKey(cookie));
+        return;
+    }
+
+    auto it = m_cookieDomains.find(domain);
+    if (it == m_cookieDomains.end())
+        return;
+
+    it->second.remove(getCookieKey(cookie));
+    if (it->second.isEmpty())
+        m_cookieDomains.erase(it);
+}
+
+void CookieJar::publishExemptHosts()
+{
+    auto exemptHosts = std::make_shared<std::unordered_set<QString>>();
+    for (const auto &url : qAsConst(m_exemptParties))
+    {
+        QString host = url.host();
+        if (host.isEmpty())
+            host = url.toString(URL::EncodeUnicode);
+
+        if (!host.isEmpty())
+            exemptHosts->insert(host.toLower());
+    }
+
+    std::atomic_store(&m_exemptHosts, std::shared_ptr<const std::unordered_set<QString>>(std::move(exemptHosts)));
 }
@@ -4,9 +4,12 @@
 #include "ISettingsObserver.h"
 #include "URL.h"
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <QDateTime>
 #include <QNetworkCookieJar>
 #include <QSet>
@@ -19,9 +22,15 @@ class Settings;
 /**
  * @class CookieJar
  * @brief Implements ability to store and load cookies on disk
+ *
+ *        The jar keeps an index of its cookies by domain, so checking whether a host has cookies only looks up
+ *        the host and its parent domains. The hosts that are exempt from the third party cookie filter are
+ *        published to the filter, which runs on the network thread, as an immutable snapshot that is replaced
+ *        atomically whenever the exemptions change.
  */
 class CookieJar : public QNetworkCookieJar, public ISettingsObserver
 {
+    friend class CookieJarTest;
     friend class CookieTableModel;
 
     Q_OBJECT
@@ -46,6 +55,10 @@ class CookieJar : public QNetworkCookieJar, public ISettingsObserver
     /// Enables third party cookies to be set if the given value is true, otherwise will filter out third party cookies that aren't exempt
     void setThirdPartyCookiesEnabled(bool value);
 
+    /// Returns true if the given host, or one of its parent domains, is exempt from the third party cookie filter.
+    /// Safe to call from the network thread
+    bool isExemptThirdParty(const QString &host) const;
+
     /// Returns a const reference to the set of exempt third party hosts that can set cookies.
     const QSet<URL> &getExemptThirdPartyHosts() const;
 
@@ -83,9 +96,15 @@ private Q_SLOTS:
     /// Removes expired cookies from both the database and the list in memory
     void removeExpired();
 
+    /// Adds the cookie to the domain index if isStored is true, otherwise removes it from the index. Must be called with the mutex held
+    void updateCookieIndex(const QNetworkCookie &cookie, bool isStored);
+
+    /// Publishes a new snapshot of the exempt third party hosts to the cookie filter
+    void publishExemptHosts();
+
 private:
     /// True if cookies are enabled by the user, false if all cookies will immediately be removed
-    bool m_enableCookies;
+    std::atomic_bool m_enableCookies;
 
     /// True if private browsing cookie jar (e.g., no persistence), false if standard cookie jar
     bool m_privateJar;
@@ -96,10 +115,17 @@ private Q_SLOTS:
     /// Set of exempt third party cookie setters
     QSet<URL> m_exemptParties;
 
+    /// Snapshot of the lower case host names in m_exemptParties, which is read by the cookie filter on the network thread.
+    /// Only accessed through std::atomic_load and std::atomic_store
+    std::shared_ptr<const std::unordered_set<QString>> m_exemptHosts;
+
+    /// Index of the cookies in the jar, mapping each cookie domain (without a leading dot) to the name and path of its cookies
+    std::unordered_map<QString, QSet<QString>> m_cookieDomains;
+
     /// Name of the file containing exceptions to the third-party cookie filtering policy (if enabled)
     QString m_exemptThirdPartyCookieFileName;
 
-    /// Mutex used within the handlers for a cookie being added or removed
+    /// Mutex used within the handlers for a cookie being added or removed, and to guard the cookie domain index
     mutable std::mutex m_mutex;
 };
 
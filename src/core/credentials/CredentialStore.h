@@ -30,13 +30,26 @@ struct WebCredentials
     QMap<QString, QString> FormData;
 };
 
+/// Describes a set of saved credentials, without their password or form data
+struct WebCredentialInfo
+{
+    /// Host location where the credentials are used
+    QString Host;
+
+    /// The last time that the credentials were used to log in to the website
+    QDateTime LastLogin;
+
+    /// Username or email value
+    QString Username;
+};
+
 QDataStream& operator<<(QDataStream &out, const WebCredentials &creds);
 QDataStream& operator>>(QDataStream &in, WebCredentials &creds);
 
 /**
  * @class CredentialStore
  * @brief Interface used to access credentials encrypted on the
- *        user's system
+ *        user's system. Stores are created and used on the GUI thread.
  */
 class CredentialStore
 {
@@ -47,10 +60,14 @@ class CredentialStore
     /// Returns a list of the hosts which have at least one set of credentials in the store
     virtual std::vector<QString> getHostNames() = 0;
 
+    /// Returns the host, username and last login time of every set of credentials in the store. Stores that keep
+    /// the passwords encrypted do not decrypt them to answer this
+    virtual std::vector<WebCredentialInfo> getCredentialInfo() = 0;
+
     /// Adds a set of credentials to the store
     virtual void addCredentials(const WebCredentials &credentials) = 0;
 
-    /// Returns a list of the credentials that have been saved for the given url
+    /// Returns a list of the credentials that have been saved for the given url, including their passwords
     virtual std::vector<WebCredentials> getCredentialsFor(const QUrl &url) = 0;
 
     /// Removes the set of credentials from the store
@@ -64,7 +81,7 @@ class CredentialStore
     CredentialStore() = default;
 };
 
-#define CredentialStore_iid "org.viper-browser.core.credential-store/1.0"
+#define CredentialStore_iid "org.viper-browser.core.credential-store/1.1"
 Q_DECLARE_INTERFACE(CredentialStore, CredentialStore_iid)
 
 #endif // CREDENTIALSTORE_H
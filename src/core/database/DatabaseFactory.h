@@ -2,10 +2,10 @@
 #define DATABASEFACTORY_H
 
 #include "DatabaseWorker.h"
-#include "ServiceLocator.h"
 
 #include <memory>
 #include <type_traits>
+#include <utility>
 #include <QFile>
 
 /**
@@ -33,31 +33,32 @@ class DatabaseFactory
         return worker;
     }
 
-    /// Creates and returns a unique_ptr of an object that inherits the DatabaseWorker class
+    /// Creates and returns a read-only instance of an object that inherits the DatabaseWorker class. The database
+    /// is neither set up nor loaded, so the worker is only suitable for queries. Returns a nullptr if the database
+    /// file does not exist or could not be opened
     template <class Derived>
-    static std::unique_ptr<Derived> createWorker(const QString &databaseFile)
+    static std::unique_ptr<DatabaseWorker> createReadOnlyWorker(const QString &databaseFile)
     {
         static_assert(std::is_base_of<DatabaseWorker, Derived>::value, "Object should inherit from DatabaseWorker");
 
-        auto worker = std::make_unique<Derived>(databaseFile);
-        // Check whether or not a call to DatabaseWorker::setup is needed.
-        // If any of the following conditions are met, setup() must be called:
-        //    1. Database file is not present on file system
-        //    2. Database file exists, but table structure(s) are not present or corrupted
-        if (!QFile::exists(databaseFile) || !worker->hasProperStructure())
-            worker->setup();
+        if (!QFile::exists(databaseFile))
+            return nullptr;
+
+        auto worker = std::make_unique<Derived>(databaseFile, sqlite::Database::OpenMode::ReadOnly);
+        if (!worker->isValid())
+            return nullptr;
 
-        worker->load();
         return worker;
     }
 
-    /// Creates and returns a unique_ptr of an object that inherits the DatabaseWorker class
-    template <class Derived>
-    static std::unique_ptr<Derived> createWorker(const ViperServiceLocator &serviceLocator, const QString &databaseFile)
+    /// Creates and returns a unique_ptr of an object that inherits the DatabaseWorker class. Any arguments
+    /// after the database file are passed to the constructor of the object, following the database file
+    template <class Derived, class ...Args>
+    static std::unique_ptr<Derived> createWorker(const QString &databaseFile, Args &&...args)
     {
         static_assert(std::is_base_of<DatabaseWorker, Derived>::value, "Object should inherit from DatabaseWorker");
 
-        auto worker = std::make_unique<Derived>(serviceLocator, databaseFile);
+        auto worker = std::make_unique<Derived>(databaseFile, std::forward<Args>(args)...);
         // Check whether or not a call to DatabaseWorker::setup is needed.
         // If any of the following conditions are met, setup() must be called:
         //    1. Database file is not present on file system
@@ -1,13 +1,19 @@
 #include "DatabaseWorker.h"
 
+#include <string>
+
 #include <QDebug>
 
-DatabaseWorker::DatabaseWorker(const QString &dbFile) :
-    m_database(dbFile.toStdString())
+DatabaseWorker::DatabaseWorker(const QString &dbFile, sqlite::Database::OpenMode openMode) :
+    m_database(dbFile.toStdString(), openMode)
 {
     if (!m_database.isValid())
         qWarning() << "Unable to open database " << dbFile;
 
+    // The journal mode is persistent, and is set by the read-write connection
+    if (openMode == sqlite::Database::OpenMode::ReadOnly)
+        return;
+
     // Turn synchronous setting off
     if (!m_database.execute("PRAGMA journal_mode=WAL"))
         qWarning() << "In DatabaseWorker constructor - could not set journal mode.";
@@ -26,6 +32,11 @@ bool DatabaseWorker::exec(const QString &queryString)
     return m_database.execute(queryString.toStdString());
 }
 
+bool DatabaseWorker::isValid() const
+{
+    return m_database.isValid();
+}
+
 bool DatabaseWorker::hasTable(const QString &tableName)
 {
     sqlite::PreparedStatement stmt = m_database.prepare(R"(SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name = ?)");
@@ -39,3 +50,19 @@ bool DatabaseWorker::hasTable(const QString &tableName)
 
     return false;
 }
+
+int DatabaseWorker::getSchemaVersion()
+{
+    sqlite::PreparedStatement stmt = m_database.prepare(R"(PRAGMA user_version)");
+    int version = 0;
+    if (stmt.next())
+        stmt >> version;
+
+    return version;
+}
+
+bool DatabaseWorker::setSchemaVersion(int version)
+{
+    // PRAGMA statements cannot take bound parameters
+    return m_database.execute("PRAGMA user_version = " + std::to_string(version));
+}
@@ -17,8 +17,10 @@ class DatabaseWorker
     /**
      * @brief DatabaseWorker Constructs an object that interacts with a SQLite database
      * @param dbFile Full path of the database file
+     * @param openMode Mode in which the database connection is opened. Read-only workers do not
+     *                 change the journal mode, and are never asked to set up or load the database
      */
-    explicit DatabaseWorker(const QString &dbFile);
+    explicit DatabaseWorker(const QString &dbFile, sqlite::Database::OpenMode openMode = sqlite::Database::OpenMode::ReadWrite);
 
     /// Closes the database connection
     virtual ~DatabaseWorker();
@@ -26,10 +28,19 @@ class DatabaseWorker
     /// Executes the given query string, returning true on success, false on failure.
     bool exec(const QString &queryString);
 
+    /// Returns true if the database connection is open, false if else
+    bool isValid() const;
+
 protected:
     /// Returns true if the database contains the given table, false if else.
     bool hasTable(const QString &tableName);
 
+    /// Returns the schema version stored in the database (PRAGMA user_version), which is 0 for a new database
+    int getSchemaVersion();
+
+    /// Stores the given schema version in the database, returning true on success
+    bool setSchemaVersion(int version);
+
 protected:
     /// Returns true if the database contains the table structure(s) needed for it to function properly, false if else.
     virtual bool hasProperStructure() = 0;
@@ -1,6 +1,7 @@
 #include "sqlite3.h"
 
 #include "internal/implementation.h"
+#include "internal/StatementCache.h"
 #include "Badge.h"
 #include "Database.h"
 #include "PreparedStatement.h"
@@ -10,14 +11,16 @@
 namespace sqlite
 {
 
-Database::Database(const std::string &fileName) :
+Database::Database(const std::string &fileName, OpenMode mode) :
     m_handle{nullptr},
     m_isHandleValid{false},
-    m_lastError{}
+    m_lastError{},
+    m_statementCache{std::make_shared<internal::StatementCache>(internal::DefaultStatementCacheCapacity)}
 {
     internal::Implementation::instance().init();
 
-    if (sqlite3_open_v2(fileName.c_str(), &m_handle, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL) == SQLITE_OK)
+    const int flags = (mode == OpenMode::ReadOnly) ? SQLITE_OPEN_READONLY : (SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+    if (sqlite3_open_v2(fileName.c_str(), &m_handle, flags, NULL) == SQLITE_OK)
     {
         m_isHandleValid = true;
         sqlite3_busy_handler(m_handle, internal::busyHandler, nullptr); 
@@ -26,6 +29,9 @@ Database::Database(const std::string &fileName) :
 
 Database::~Database()
 {
+    // Cached statements must be finalized before the connection can be closed
+    m_statementCache->close();
+
     if (m_isHandleValid && m_handle != nullptr)
     {
         sqlite3_close_v2(m_handle);
@@ -84,12 +90,38 @@ const std::string &Database::getLastError() const
 
 PreparedStatement Database::prepare(const std::string &sql) const
 {
-    return PreparedStatement({}, m_handle, sql);
+    sqlite3_stmt *handle = m_statementCache->acquire(sql);
+    if (handle == nullptr
+            && sqlite3_prepare_v2(m_handle, sql.c_str(), 1 + static_cast<int>(sql.size()), &handle, NULL) != SQLITE_OK)
+        handle = nullptr;
+
+    return PreparedStatement({}, handle, m_statementCache, m_statementCache->getCounters(sql));
 }
 
 PreparedStatement Database::prepare(const char *sql, int nByte) const
 {
-    return PreparedStatement({}, m_handle, sql, nByte);
+    // The cache is keyed by the SQL text, without the null terminator
+    std::string sqlStr = nByte < 0 ? std::string(sql) : std::string(sql, static_cast<std::size_t>(nByte));
+    const std::size_t nullPos = sqlStr.find('\0');
+    if (nullPos != std::string::npos)
+        sqlStr.resize(nullPos);
+
+    return prepare(sqlStr);
+}
+
+void Database::setStatementCacheCapacity(std::size_t capacity)
+{
+    m_statementCache->setCapacity(capacity);
+}
+
+std::vector<StatementStats> Database::getStatementStats() const
+{
+    return m_statementCache->getStatistics();
+}
+
+void Database::resetStatementStats()
+{
+    m_statementCache->resetStatistics();
 }
 
 }
@@ -1,7 +1,11 @@
 #ifndef _SQLITE_DATABASE_H_
 #define _SQLITE_DATABASE_H_
 
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
 struct sqlite3;
 
@@ -10,6 +14,24 @@ namespace sqlite
 
 class PreparedStatement;
 
+namespace internal
+{
+    class StatementCache;
+}
+
+/// Execution statistics of a single SQL statement, used to find slow queries
+struct StatementStats
+{
+    /// SQL text of the statement
+    std::string sql;
+
+    /// Number of times the statement has been executed
+    uint64_t numExecutions;
+
+    /// Cumulative time spent executing the statement and stepping through its results
+    std::chrono::nanoseconds totalTime;
+};
+
 /**
  * @class Database
  * @brief Point of entry for the library's wrapper functionality.
@@ -23,9 +45,16 @@ class Database
     Database(const Database&) = delete;
     Database &operator=(const Database&) = delete;
 
+    /// Modes in which the database connection can be opened
+    enum class OpenMode
+    {
+        ReadWrite, /// Opens the database for reading and writing, creating the file if it does not exist
+        ReadOnly   /// Opens an existing database for reading only
+    };
+
     /// Constructs the database with a given database file.
     /// The connection is opened immediately in the constructor
-    explicit Database(const std::string &fileName);
+    explicit Database(const std::string &fileName, OpenMode mode = OpenMode::ReadWrite);
 
     /// Closes the database connection
     ~Database();
@@ -52,20 +81,32 @@ class Database
     bool isValid() const;
 
     /**
-     * @brief Prepares the given SQL statement
+     * @brief Prepares the given SQL statement. If a statement with the same SQL text was prepared
+     *        earlier and is no longer in use, its compiled handle is reused from the statement cache
      * @param sql The SQL string to be prepared
-     * @return Prepared statement object
+     * @return Prepared statement object, in a reset state with no bound parameters
      */
     PreparedStatement prepare(const std::string &sql) const;
 
     /**
-     * @brief Prepares the given SQL statement
+     * @brief Prepares the given SQL statement. If a statement with the same SQL text was prepared
+     *        earlier and is no longer in use, its compiled handle is reused from the statement cache
      * @param sql Pointer to the SQL string in UTF-8 format
      * @param nByte Length of the string, in bytes, including the null terminator ('\0')
-     * @return Prepared statement object
+     * @return Prepared statement object, in a reset state with no bound parameters
      */
     PreparedStatement prepare(const char *sql, int nByte) const;
 
+    /// Sets the maximum number of idle prepared statements kept in the statement cache. Defaults to 32
+    void setStatementCacheCapacity(std::size_t capacity);
+
+    /// Returns the execution count and cumulative execution time of every statement prepared on this
+    /// connection, ordered from the most to the least total time spent
+    std::vector<StatementStats> getStatementStats() const;
+
+    /// Resets the execution statistics of all statements prepared on this connection
+    void resetStatementStats();
+
 private:
     /// Pointer to the database connection
     sqlite3 *m_handle;
@@ -75,6 +116,9 @@ class Database
 
     /// Contains any error message set from the last failing call to execute(const char*)
     std::string m_lastError;
+
+    /// Cache of compiled statements that are not currently in use, as well as their execution statistics
+    std::shared_ptr<internal::StatementCache> m_statementCache;
 };
 
 }
@@ -1,45 +1,56 @@
 #include "Database.h"
 #include "PreparedStatement.h"
+#include "internal/StatementCache.h"
+
+#include <chrono>
 
 namespace sqlite
 {
 
-PreparedStatement::PreparedStatement(Badge<Database>, sqlite3 *db, const std::string &sql) :
-    m_handle{nullptr},
+PreparedStatement::PreparedStatement(Badge<Database>, sqlite3_stmt *handle,
+                                     std::shared_ptr<internal::StatementCache> cache,
+                                     std::shared_ptr<internal::StatementCounters> counters) :
+    m_handle{handle},
     m_state{State::NotReady},
     m_colIdx{0},
-    m_numCols{0}
+    m_numCols{0},
+    m_cache{std::move(cache)},
+    m_counters{std::move(counters)}
 {
-    const int status = sqlite3_prepare_v2(db, sql.c_str(), 1 + static_cast<int>(sql.size()),
-            &m_handle, NULL);
-
-    if (status == SQLITE_OK)
+    if (m_handle != nullptr)
         m_state = State::Ready;
-    else
-        m_handle = nullptr;
 }
 
-PreparedStatement::PreparedStatement(Badge<Database>, sqlite3 *db, const char *sql, int nByte) :
-    m_handle{nullptr},
-    m_state{State::NotReady},
-    m_colIdx{0},
-    m_numCols{0}
+PreparedStatement::~PreparedStatement()
 {
-    const int status = sqlite3_prepare_v2(db, sql, nByte, &m_handle, NULL);
+    release();
+}
 
-    if (status == SQLITE_OK)
-        m_state = State::Ready;
+void PreparedStatement::release() noexcept
+{
+    if (m_handle == nullptr)
+        return;
+
+    if (m_cache)
+        m_cache->release(m_handle);
     else
-        m_handle = nullptr;
+        sqlite3_finalize(m_handle);
+
+    m_handle = nullptr;
 }
 
-PreparedStatement::~PreparedStatement()
+int PreparedStatement::step()
 {
-    if (m_handle != nullptr)
-    {
-        sqlite3_finalize(m_handle);
-        m_handle = nullptr;
-    }
+    if (!m_counters)
+        return sqlite3_step(m_handle);
+
+    const auto startTime = std::chrono::steady_clock::now();
+    const int status = sqlite3_step(m_handle);
+    const auto elapsed = std::chrono::steady_clock::now() - startTime;
+
+    m_counters->totalTimeNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                                      std::memory_order_relaxed);
+    return status;
 }
 
 bool PreparedStatement::execute()
@@ -47,7 +58,10 @@ bool PreparedStatement::execute()
     if (m_handle == nullptr || m_state != State::Ready)
         return false;
 
-    const int status = sqlite3_step(m_handle);
+    if (m_counters)
+        m_counters->numExecutions.fetch_add(1, std::memory_order_relaxed);
+
+    const int status = step();
     if (status == SQLITE_DONE)
     {
         sqlite3_reset(m_handle);
@@ -79,7 +93,10 @@ bool PreparedStatement::next()
     }
     else if (m_state == State::Ready || m_state == State::InProgress)
     {
-        const int status = sqlite3_step(m_handle);
+        if (m_state == State::Ready && m_counters)
+            m_counters->numExecutions.fetch_add(1, std::memory_order_relaxed);
+
+        const int status = step();
         if (status == SQLITE_ROW)
         {
             if (m_state == State::Ready)
@@ -115,4 +132,9 @@ void PreparedStatement::reset()
     m_numCols = 0;
 }
 
+bool PreparedStatement::isValid() const
+{
+    return m_handle != nullptr;
+}
+
 }
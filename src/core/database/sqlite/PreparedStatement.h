@@ -8,6 +8,7 @@
 #include "Row.h"
 
 #include <iostream>
+#include <memory>
 #include <string>
 #include <type_traits>
 
@@ -16,6 +17,12 @@ namespace sqlite
 
 class Database;
 
+namespace internal
+{
+    class StatementCache;
+    struct StatementCounters;
+}
+
 class PreparedStatement
 {
     /// Possible states in which the prepared statement may be found
@@ -29,17 +36,14 @@ class PreparedStatement
     };
 
 public:
-    /// Constructs the statement with a given query string. This may only
-    /// be called by the \ref Database class . PreparedStatements are
-    /// generated by calling Database.prepare(..)
-    PreparedStatement(Badge<Database>, sqlite3 *db, const std::string &sql);
-
-    /// Constructs the statement with a given query string, in raw form with the
-    /// number of bytes specified. This may only be called by the \ref Database class 
-    /// PreparedStatements are generated by calling Database.prepare(..)
-    PreparedStatement(Badge<Database>, sqlite3 *db, const char *sql, int nByte);
-
-    /// Frees the resources that were associated with the statement
+    /// Constructs the statement from a compiled statement handle, which is returned to the
+    /// statement cache when the statement is destroyed. This may only be called by the
+    /// \ref Database class . PreparedStatements are generated by calling Database.prepare(..)
+    PreparedStatement(Badge<Database>, sqlite3_stmt *handle,
+                      std::shared_ptr<internal::StatementCache> cache,
+                      std::shared_ptr<internal::StatementCounters> counters);
+
+    /// Returns the statement handle to the statement cache
     ~PreparedStatement();
 
     /**
@@ -64,6 +68,9 @@ class PreparedStatement
     /// any bound parameters in the process.
     void reset();
 
+    /// Returns true if the statement was compiled successfully, false if else
+    bool isValid() const;
+
     template<class T>
     void bind(int index, const T &value, bool copyData = false)
     {
@@ -192,7 +199,9 @@ class PreparedStatement
         m_handle{other.m_handle},
         m_state{other.m_state},
         m_colIdx{other.m_colIdx},
-        m_numCols{other.m_numCols}
+        m_numCols{other.m_numCols},
+        m_cache{std::move(other.m_cache)},
+        m_counters{std::move(other.m_counters)}
     {
         other.m_handle = nullptr;
         other.m_state = State::NotReady;
@@ -202,13 +211,14 @@ class PreparedStatement
     {
         if (this != &other)
         {
-            if (m_handle != nullptr)
-                sqlite3_finalize(m_handle);
+            release();
 
             m_handle = other.m_handle;
             m_state = other.m_state;
             m_colIdx = other.m_colIdx;
             m_numCols = other.m_numCols;
+            m_cache = std::move(other.m_cache);
+            m_counters = std::move(other.m_counters);
 
             other.m_handle = nullptr;
             other.m_state = State::NotReady;
@@ -217,6 +227,13 @@ class PreparedStatement
         return *this;
     }
 
+private:
+    /// Returns the statement handle to the statement cache, or finalizes it if there is no cache
+    void release() noexcept;
+
+    /// Evaluates the statement by a single step, recording the time spent in the statement's counters
+    int step();
+
 private:
     /// SQLite statement handle
     sqlite3_stmt *m_handle;
@@ -229,6 +246,12 @@ class PreparedStatement
 
     /// Number of columns in the result set of the last query
     int m_numCols;
+
+    /// Cache that owns the statement handle while it is not in use
+    std::shared_ptr<internal::StatementCache> m_cache;
+
+    /// Execution counters shared by all statements with the same SQL text
+    std::shared_ptr<internal::StatementCounters> m_counters;
 };
 
 // Stream operators
@@ -0,0 +1,154 @@
+#include "sqlite3.h"
+#include "internal/StatementCache.h"
+#include "Database.h"
+
+#include <algorithm>
+
+namespace sqlite
+{
+namespace internal
+{
+
+StatementCache::StatementCache(std::size_t capacity) :
+    m_mutex{},
+    m_capacity{capacity},
+    m_closed{false},
+    m_idleList{},
+    m_idleMap{},
+    m_counters{}
+{
+}
+
+StatementCache::~StatementCache()
+{
+    close();
+}
+
+sqlite3_stmt *StatementCache::acquire(const std::string &sql)
+{
+    std::lock_guard<std::mutex> _{ m_mutex };
+
+    auto it = m_idleMap.find(sql);
+    if (it == m_idleMap.end())
+        return nullptr;
+
+    sqlite3_stmt *handle = it->second->second;
+    m_idleList.erase(it->second);
+    m_idleMap.erase(it);
+    return handle;
+}
+
+void StatementCache::release(sqlite3_stmt *handle)
+{
+    if (handle == nullptr)
+        return;
+
+    sqlite3_reset(handle);
+    sqlite3_clear_bindings(handle);
+
+    std::lock_guard<std::mutex> _{ m_mutex };
+
+    if (m_closed || m_capacity == 0)
+    {
+        sqlite3_finalize(handle);
+        return;
+    }
+
+    const char *sql = sqlite3_sql(handle);
+    m_idleList.emplace_front(sql != nullptr ? std::string(sql) : std::string(), handle);
+    m_idleMap.emplace(m_idleList.front().first, m_idleList.begin());
+
+    evict();
+}
+
+std::shared_ptr<StatementCounters> StatementCache::getCounters(const std::string &sql)
+{
+    std::lock_guard<std::mutex> _{ m_mutex };
+
+    std::shared_ptr<StatementCounters> &counters = m_counters[sql];
+    if (!counters)
+        counters = std::make_shared<StatementCounters>();
+
+    return counters;
+}
+
+std::vector<StatementStats> StatementCache::getStatistics() const
+{
+    std::vector<StatementStats> result;
+
+    {
+        std::lock_guard<std::mutex> _{ m_mutex };
+
+        result.reserve(m_counters.size());
+        for (const auto &it : m_counters)
+        {
+            result.push_back(StatementStats {
+                it.first,
+                it.second->numExecutions.load(std::memory_order_relaxed),
+                std::chrono::nanoseconds{it.second->totalTimeNs.load(std::memory_order_relaxed)}
+            });
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const StatementStats &a, const StatementStats &b) {
+        return a.totalTime > b.totalTime;
+    });
+
+    return result;
+}
+
+void StatementCache::resetStatistics()
+{
+    std::lock_guard<std::mutex> _{ m_mutex };
+
+    for (auto &it : m_counters)
+    {
+        it.second->numExecutions.store(0, std::memory_order_relaxed);
+        it.second->totalTimeNs.store(0, std::memory_order_relaxed);
+    }
+}
+
+void StatementCache::setCapacity(std::size_t capacity)
+{
+    std::lock_guard<std::mutex> _{ m_mutex };
+
+    m_capacity = capacity;
+    evict();
+}
+
+void StatementCache::close()
+{
+    std::lock_guard<std::mutex> _{ m_mutex };
+
+    m_closed = true;
+
+    for (auto &node : m_idleList)
+        sqlite3_finalize(node.second);
+
+    m_idleList.clear();
+    m_idleMap.clear();
+}
+
+void StatementCache::evict()
+{
+    while (m_idleList.size() > m_capacity)
+    {
+        auto lruIt = std::prev(m_idleList.end());
+
+        auto range = m_idleMap.equal_range(lruIt->first);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second == lruIt)
+            {
+                m_idleMap.erase(it);
+                break;
+            }
+        }
+
+        sqlite3_finalize(lruIt->second);
+        m_idleList.erase(lruIt);
+    }
+}
+
+}
+}
@@ -0,0 +1,104 @@
+#ifndef _SQLITE_INTERNAL_STATEMENT_CACHE_H_
+#define _SQLITE_INTERNAL_STATEMENT_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct sqlite3_stmt;
+
+namespace sqlite
+{
+
+struct StatementStats;
+
+namespace internal
+{
+
+/// Execution counters shared by every prepared statement created from the same SQL text
+struct StatementCounters
+{
+    /// Number of times the statement has been executed
+    std::atomic<uint64_t> numExecutions { 0 };
+
+    /// Cumulative time spent stepping through the statement, in nanoseconds
+    std::atomic<int64_t> totalTimeNs { 0 };
+};
+
+/**
+ * @class StatementCache
+ * @brief Least recently used cache of idle SQLite statement handles, keyed by their SQL text.
+ *        Handles are checked out of the cache while a \ref PreparedStatement is using them,
+ *        and are reset and returned to the cache when that statement is destroyed.
+ */
+class StatementCache
+{
+public:
+    /// Constructs the cache with a maximum number of idle statement handles
+    explicit StatementCache(std::size_t capacity);
+
+    /// Finalizes all idle statement handles
+    ~StatementCache();
+
+    /// Removes and returns an idle statement handle for the given SQL text, or a nullptr if there are none
+    sqlite3_stmt *acquire(const std::string &sql);
+
+    /// Resets the given statement handle and places it at the front of the cache. The handle will be
+    /// finalized instead if the cache has been closed, or the least recently used handle is finalized
+    /// if the cache is above capacity
+    void release(sqlite3_stmt *handle);
+
+    /// Returns the execution counters associated with the given SQL text
+    std::shared_ptr<StatementCounters> getCounters(const std::string &sql);
+
+    /// Returns the execution statistics of every statement that has been prepared with the cache
+    std::vector<StatementStats> getStatistics() const;
+
+    /// Resets the execution statistics of all statements
+    void resetStatistics();
+
+    /// Sets the maximum number of idle statement handles held by the cache
+    void setCapacity(std::size_t capacity);
+
+    /// Finalizes all idle statement handles, and prevents any more handles from being cached.
+    /// This is called before the database connection is closed
+    void close();
+
+private:
+    /// Finalizes least recently used handles until the cache is within its capacity. Requires a lock on the mutex
+    void evict();
+
+private:
+    /// Node of the idle list, containing the SQL text and its statement handle
+    using Node = std::pair<std::string, sqlite3_stmt*>;
+
+    /// Guards all members of the cache
+    mutable std::mutex m_mutex;
+
+    /// Maximum number of idle statement handles
+    std::size_t m_capacity;
+
+    /// Flag indicating whether or not the cache has been closed
+    bool m_closed;
+
+    /// Idle statement handles, in order of most to least recently used
+    std::list<Node> m_idleList;
+
+    /// Maps SQL text to the idle statement handles of that text
+    std::unordered_multimap<std::string, std::list<Node>::iterator> m_idleMap;
+
+    /// Execution counters of each SQL statement
+    std::unordered_map<std::string, std::shared_ptr<StatementCounters>> m_counters;
+};
+
+}
+
+}
+
+#endif // _SQLITE_INTERNAL_STATEMENT_CACHE_H_
@@ -1,6 +1,7 @@
 #ifndef _SQLITE_INTERNAL_IMPLEMENTATION_H_
 #define _SQLITE_INTERNAL_IMPLEMENTATION_H_
 
+#include <cstddef>
 #include <mutex>
 
 namespace sqlite
@@ -11,6 +12,9 @@ namespace internal
 
 constexpr int BusyTimeoutIntervalMs = 250;
 
+/// Default number of idle prepared statements kept by each database connection
+constexpr std::size_t DefaultStatementCacheCapacity = 32;
+
 /// Handles a busy error when a database is locked by another thread
 int busyHandler(void*, int numTries);
 
@@ -1,11 +1,41 @@
 #include "ExtStorage.h"
 
+#include <chrono>
+#include <set>
+
+#include <QTimerEvent>
 #include <QDebug>
 
+namespace
+{
+    /// Time between the first pending change and the write-back of all pending changes
+    constexpr std::chrono::milliseconds FlushDelay { 2000 };
+
+    /// Returns the smallest string that is greater than every string that begins with the given prefix
+    std::string getPrefixUpperBound(std::string prefix)
+    {
+        while (!prefix.empty())
+        {
+            unsigned char &lastByte = reinterpret_cast<unsigned char&>(prefix.back());
+            if (lastByte < 0xFF)
+            {
+                ++lastByte;
+                return prefix;
+            }
+            prefix.pop_back();
+        }
+
+        // Valid UTF-8 never contains a 0xFF byte, so this is greater than every key
+        return std::string(1, '\xFF');
+    }
+}
+
 ExtStorage::ExtStorage(const QString &dbFile, QObject *parent) :
     QObject(parent),
     DatabaseWorker(dbFile),
     m_statements(),
+    m_pendingWrites(),
+    m_flushTimerId(0),
     m_mutex()
 {
     setObjectName("storage");
@@ -20,31 +50,26 @@ ExtStorage::ExtStorage(const QString &dbFile, QObject *parent) :
                                        m_database.prepare(R"(INSERT OR REPLACE INTO ItemTable(key, value) VALUES (?, ?))")));
     m_statements.insert(std::make_pair(Statement::DeleteKey,
                                        m_database.prepare(R"(DELETE FROM ItemTable WHERE key = ?)")));
-    m_statements.insert(std::make_pair(Statement::GetSimilarKeys,
-                                       m_database.prepare(R"(SELECT key FROM ItemTable WHERE key LIKE ?)")));
+    // A range on the key can be answered from the index of the UNIQUE constraint, unlike a LIKE pattern
+    m_statements.insert(std::make_pair(Statement::GetKeyRange,
+                                       m_database.prepare(R"(SELECT key FROM ItemTable WHERE key >= ? AND key < ?)")));
 }
 
 ExtStorage::~ExtStorage()
 {
+    flush();
 }
 
 QVariantMap ExtStorage::getResult(const QString &extUID, const QVariantMap &keys)
 {
-    sqlite::PreparedStatement &stmt = m_statements.at(Statement::GetValue);
-    stmt.reset();
+    std::lock_guard<std::mutex> _(m_mutex);
 
     QVariantMap results;
     for (auto it = keys.cbegin(); it != keys.cend(); ++it)
     {
-        std::string boundParam = QString("%1%2").arg(extUID, it.key()).toStdString();
-        stmt.bind(0, boundParam);
-        if (stmt.next())
-        {
-            sqlite::Blob blob;
-            stmt >> blob;
-            QVariant temp = QVariant(QString::fromStdString(blob.data));
-            results.insert(it.key(), temp);
-        }
+        QString value;
+        if (readValue(QString("%1%2").arg(extUID, it.key()).toStdString(), value))
+            results.insert(it.key(), QVariant(value));
         else
             results.insert(it.key(), it.value());
     }
@@ -53,72 +78,159 @@ QVariantMap ExtStorage::getResult(const QString &extUID, const QVariantMap &keys
 
 QVariant ExtStorage::getItem(const QString &extUID, const QString &key)
 {
-    QVariant result;
+    std::lock_guard<std::mutex> _(m_mutex);
 
-    sqlite::PreparedStatement &stmt = m_statements.at(Statement::GetValue);
-    stmt.reset();
+    QString value;
+    if (readValue(QString("%1%2").arg(extUID, key).toStdString(), value))
+        return QVariant(value);
+
+    return QVariant();
+}
+
+void ExtStorage::setItem(const QString &extUID, const QString &key, const QVariant &value)
+{
+    std::lock_guard<std::mutex> _(m_mutex);
+    queueWrite(QString("%1%2").arg(extUID, key).toStdString(), value.toString().toStdString());
+}
+
+void ExtStorage::removeItem(const QString &extUID, const QString &key)
+{
+    std::lock_guard<std::mutex> _(m_mutex);
+    queueWrite(QString("%1%2").arg(extUID, key).toStdString(), std::nullopt);
+}
+
+QVariantList ExtStorage::listKeys(const QString &extUID)
+{
+    std::lock_guard<std::mutex> _(m_mutex);
 
-    std::string boundParam = QString("%1%2").arg(extUID, key).toStdString();
-    stmt.bind(0, boundParam);
+    const std::string lowerBound = extUID.toStdString();
+    const std::string upperBound = getPrefixUpperBound(lowerBound);
 
-    if (stmt.next())
+    std::set<std::string> keys;
+
+    sqlite::PreparedStatement &stmt = m_statements.at(Statement::GetKeyRange);
+    stmt.reset();
+    stmt.bind(0, lowerBound);
+    stmt.bind(1, upperBound);
+
+    while (stmt.next())
     {
         sqlite::Blob blob;
         stmt >> blob;
-        result = QVariant(QString::fromStdString(blob.data));
+        keys.insert(blob.data);
     }
 
+    // Apply the changes that have not been written to the database yet
+    for (auto it = m_pendingWrites.lower_bound(lowerBound); it != m_pendingWrites.end() && it->first < upperBound; ++it)
+    {
+        if (it->second.has_value())
+            keys.insert(it->first);
+        else
+            keys.erase(it->first);
+    }
+
+    QVariantList result;
+    for (const std::string &key : keys)
+        result.push_back(QVariant(QString::fromStdString(key)));
+
     return result;
 }
 
-void ExtStorage::setItem(const QString &extUID, const QString &key, const QVariant &value)
+void ExtStorage::flush()
 {
-    sqlite::PreparedStatement &stmt = m_statements.at(Statement::SetValue);
-    stmt.reset();
+    std::lock_guard<std::mutex> _(m_mutex);
+
+    if (m_flushTimerId != 0)
+    {
+        killTimer(m_flushTimerId);
+        m_flushTimerId = 0;
+    }
+
+    if (m_pendingWrites.empty())
+        return;
+
+    const bool inTransaction = m_database.beginTransaction();
+    if (!inTransaction)
+        qWarning() << "ExtStorage::flush - could not start transaction";
+
+    for (const auto &it : m_pendingWrites)
+    {
+        if (it.second.has_value())
+        {
+            sqlite::PreparedStatement &stmt = m_statements.at(Statement::SetValue);
+            stmt.reset();
 
-    std::string boundKey = QString("%1%2").arg(extUID, key).toStdString();
-    sqlite::Blob boundVal { value.toString().toStdString() };
+            sqlite::Blob boundVal { *it.second };
+            stmt.bind(0, it.first);
+            stmt.bind(1, boundVal);
+
+            if (!stmt.execute())
+                qDebug() << "ExtStorage::flush - could not update value with key name " << QString::fromStdString(it.first);
+        }
+        else
+        {
+            sqlite::PreparedStatement &stmt = m_statements.at(Statement::DeleteKey);
+            stmt.reset();
+
+            stmt.bind(0, it.first);
+            if (!stmt.execute())
+                qDebug() << "ExtStorage::flush - could not remove key from the database. Key name: "
+                         << QString::fromStdString(it.first);
+        }
+    }
+
+    if (inTransaction && !m_database.commitTransaction())
+    {
+        qWarning() << "ExtStorage::flush - could not commit transaction";
+        m_database.rollbackTransaction();
 
-    stmt.bind(0, boundKey);
-    stmt.bind(1, boundVal);
+        // Keep the changes in memory, and try again later
+        m_flushTimerId = startTimer(FlushDelay);
+        return;
+    }
 
-    if (!stmt.execute())
-        qDebug() << "ExtStorage::setItem - could not update value with key name " << QString::fromStdString(boundKey);
+    m_pendingWrites.clear();
 }
 
-void ExtStorage::removeItem(const QString &extUID, const QString &key)
+void ExtStorage::timerEvent(QTimerEvent *event)
 {
-    sqlite::PreparedStatement &stmt = m_statements.at(Statement::DeleteKey);
-    stmt.reset();
-
-    std::string boundKey = QString("%1%2").arg(extUID, key).toStdString();
-    stmt.bind(0, boundKey);
-    if (!stmt.execute())
-        qDebug() << "ExtStorage::removeItem - could not remove key from the database. Key name: "
-                 << QString::fromStdString(boundKey);
+    if (event->timerId() == m_flushTimerId)
+        flush();
+    else
+        QObject::timerEvent(event);
 }
 
-QVariantList ExtStorage::listKeys(const QString &extUID)
+bool ExtStorage::readValue(const std::string &key, QString &value)
 {
-    sqlite::PreparedStatement &stmt = m_statements.at(Statement::GetSimilarKeys);
+    auto it = m_pendingWrites.find(key);
+    if (it != m_pendingWrites.end())
+    {
+        if (!it->second.has_value())
+            return false;
+
+        value = QString::fromStdString(*it->second);
+        return true;
+    }
+
+    sqlite::PreparedStatement &stmt = m_statements.at(Statement::GetValue);
     stmt.reset();
+    stmt.bind(0, key);
 
-    std::string boundKey = QString("%1%").arg(extUID).toStdString();
-    stmt.bind(0, boundKey);
+    if (!stmt.next())
+        return false;
 
-    QVariantList result;
+    sqlite::Blob blob;
+    stmt >> blob;
+    value = QString::fromStdString(blob.data);
+    return true;
+}
 
-    if (stmt.execute())
-    {
-        while (stmt.next())
-        {
-            sqlite::Blob blob;
-            stmt >> blob;
-            result.push_back(QVariant(QString::fromStdString(blob.data)));
-        }
-    }
+void ExtStorage::queueWrite(std::string key, std::optional<std::string> value)
+{
+    m_pendingWrites[std::move(key)] = std::move(value);
 
-    return result;
+    if (m_flushTimerId == 0)
+        m_flushTimerId = startTimer(FlushDelay);
 }
 
 bool ExtStorage::hasProperStructure()
@@ -5,6 +5,8 @@
 
 #include <map>
 #include <mutex>
+#include <optional>
+#include <string>
 
 #include <QMap>
 #include <QMetaType>
@@ -15,6 +17,10 @@
 /**
  * @class ExtStorage
  * @brief Allows browser extensions to store and retrieve data, in a similar manner as with the Web Storage API
+ *
+ *        Changes are held in memory and written back to the database in a single transaction shortly after they are
+ *        made, so repeated writes to the same key only reach the disk once. Reads check the pending changes before
+ *        the database, so an extension always sees its own writes.
  */
 class ExtStorage : public QObject, private DatabaseWorker
 {
@@ -25,7 +31,7 @@ class ExtStorage : public QObject, private DatabaseWorker
         GetValue,
         SetValue,
         DeleteKey,
-        GetSimilarKeys
+        GetKeyRange
     };
 
     Q_OBJECT
@@ -35,9 +41,12 @@ class ExtStorage : public QObject, private DatabaseWorker
     /// optional pointer to the parent object
     explicit ExtStorage(const QString &dbFile, QObject *parent = nullptr);
 
-    /// Extension storage destructor
+    /// Writes any pending changes to the database before destruction
     virtual ~ExtStorage();
 
+    /// Writes all pending changes to the database in a single transaction
+    void flush();
+
 public Q_SLOTS:
     /**
      * @brief Searches the caller's storage region
@@ -80,6 +89,9 @@ public Q_SLOTS:
     QVariantList listKeys(const QString &extUID);
 
 protected:
+    /// Flushes the pending changes when the write-back timer fires
+    void timerEvent(QTimerEvent *event) override;
+
     /// Returns true if the extension database contains the table structure(s) needed for it to function properly,
     /// false if else.
     bool hasProperStructure() override;
@@ -90,11 +102,30 @@ public Q_SLOTS:
     /// Loads records from the database
     void load() override {}
 
+private:
+    /**
+     * @brief Reads the value of an item, checking the pending changes before the database. Must be called with the mutex held
+     * @param key Storage key of the item, which is prefixed by the extension identifier
+     * @param value Set to the value of the item, if it was found
+     * @return True if the item exists, false if it does not exist or was removed
+     */
+    bool readValue(const std::string &key, QString &value);
+
+    /// Queues a change to the item with the given storage key, where a null value removes the item. Must be called with the mutex held
+    void queueWrite(std::string key, std::optional<std::string> value);
+
 private:
     /// Map of prepared statements
     std::map<Statement, sqlite::PreparedStatement> m_statements;
 
-    /// Mutex
+    /// Changes that have not been written to the database yet, mapping each storage key to its new value, or to a
+    /// null value if the item was removed
+    std::map<std::string, std::optional<std::string>> m_pendingWrites;
+
+    /// Identifier of the write-back timer, or 0 if no flush is scheduled
+    int m_flushTimerId;
+
+    /// Mutex guarding the prepared statements and pending changes
     std::mutex m_mutex;
 };
 
@@ -240,7 +240,7 @@ void FavoritePagesManager::loadFromHistory()
     // Load most frequent visits, and then remove any that the user requested to be excluded from
     // the new tab page
     const int numResults = 10 + static_cast<int>(m_excludedPages.size());
-    m_historyManager->loadMostVisitedEntries(numResults, [=](std::vector<WebPageInformation> &&results){
+    m_historyManager->loadMostVisitedEntries(numResults).then(this, [this](std::vector<WebPageInformation> &&results){
         int itemPosition = static_cast<int>(m_favoritePages.size());
         m_mostVisitedPages = std::move(results);
         for (auto it = m_mostVisitedPages.begin(); it != m_mostVisitedPages.end();)
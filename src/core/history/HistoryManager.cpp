@@ -2,6 +2,7 @@
 #include "HistoryManager.h"
 #include "HistoryStore.h"
 #include "Settings.h"
+#include "TraceLog.h"
 
 #include <algorithm>
 #include <array>
@@ -20,6 +21,8 @@ HistoryManager::HistoryManager(const ViperServiceLocator &serviceLocator, Databa
     m_historyStore(nullptr),
     m_lastVisitId(0)
 {
+    VIPER_TRACE_SCOPE("startup", "HistoryManager");
+
     setObjectName(QLatin1String("HistoryManager"));
 
     if (Settings *settings = serviceLocator.getServiceAs<Settings>("Settings"))
@@ -31,15 +34,16 @@ HistoryManager::HistoryManager(const ViperServiceLocator &serviceLocator, Databa
     else
         qWarning() << "Could not fetch application settings in history manager!";
 
-    m_taskScheduler.onInit([this](){
+    m_taskScheduler.onInit("HistoryStore", [this](){
         m_historyStore = static_cast<HistoryStore*>(m_taskScheduler.getWorker("HistoryStore"));
     });
 
-    m_taskScheduler.post([this](){
-        //onHistoryRecordsLoaded(m_historyStore->getEntries());
-        onRecentItemsLoaded(m_historyStore->getRecentItems());
-
-        m_lastVisitId = m_historyStore->getLastVisitId();
+    // Recent items are loaded on the database thread, and handed to the history manager on its own thread
+    m_taskScheduler.postTask("HistoryStore", [this](){
+        return std::make_pair(m_historyStore->getRecentItems(), m_historyStore->getLastVisitId());
+    }, DatabaseTaskPriority::Interactive).then(this, [this](std::pair<std::deque<HistoryEntry>, uint64_t> &&result){
+        onRecentItemsLoaded(std::move(result.first));
+        m_lastVisitId = std::max(m_lastVisitId, result.second);
     });
 }
 
@@ -57,12 +61,33 @@ HistoryManager::~HistoryManager()
     }
 }
 
+std::vector<ResourceUsage> HistoryManager::getResourceUsage() const
+{
+    // The estimate covers the entries, their URL strings, titles and visit times, but not the storage shared by their URLs
+    qint64 entriesSize = 0;
+    for (const auto &it : m_historyItems)
+    {
+        entriesSize += static_cast<qint64>(sizeof(HistoryUrlKey) + sizeof(LocalHistoryEntry))
+                + (it.first.Text.capacity() + it.second.Title.capacity()) * static_cast<qint64>(sizeof(QChar))
+                + static_cast<qint64>(it.second.Visits.capacity() * sizeof(qint64));
+    }
+
+    qint64 recentSize = 0;
+    for (const HistoryEntry &entry : m_recentItems)
+        recentSize += static_cast<qint64>(sizeof(HistoryEntry)) + entry.Title.capacity() * static_cast<qint64>(sizeof(QChar));
+
+    return {
+        ResourceUsage { QStringLiteral("History entries"), m_historyItems.size(), entriesSize },
+        ResourceUsage { QStringLiteral("Recent history"), m_recentItems.size(), recentSize }
+    };
+}
+
 void HistoryManager::clearAllHistory()
 {
     m_recentItems.clear();
     m_historyItems.clear();
 
-    m_taskScheduler.post(&HistoryStore::clearAllHistory, std::ref(m_historyStore));
+    m_taskScheduler.post("HistoryStore", &HistoryStore::clearAllHistory, std::ref(m_historyStore));
 }
 
 void HistoryManager::clearHistoryFrom(const QDateTime &start)
@@ -72,39 +97,35 @@ void HistoryManager::clearHistoryFrom(const QDateTime &start)
 
 void HistoryManager::clearHistoryInRange(std::pair<QDateTime, QDateTime> range)
 {
-    m_taskScheduler.post([this, range](){
-        m_recentItems.clear();
+    m_recentItems.clear();
 
+    m_taskScheduler.postTask("HistoryStore", [this, range](){
         m_historyStore->clearHistoryInRange(range);
-
-        onRecentItemsLoaded(m_historyStore->getRecentItems());
+        return m_historyStore->getRecentItems();
+    }).then(this, [this](std::deque<HistoryEntry> &&recentItems){
+        onRecentItemsLoaded(std::move(recentItems));
         emit historyCleared();
     });
 
-    auto visitRemover = [&range](VisitEntry v){
-        return v >= range.first && v <= range.second;
+    const qint64 rangeStart = range.first.toMSecsSinceEpoch();
+    const qint64 rangeEnd = range.second.toMSecsSinceEpoch();
+    auto visitRemover = [rangeStart, rangeEnd](qint64 v){
+        return v >= rangeStart && v <= rangeEnd;
     };
 
     for (auto it = m_historyItems.begin(); it != m_historyItems.end();)
     {
-        URLRecord &record = it->second;
-        std::vector<VisitEntry> &visits = record.m_visits;
+        LocalHistoryEntry &entry = it->second;
+        std::vector<qint64> &visits = entry.Visits;
         visits.erase(std::remove_if(visits.begin(), visits.end(), visitRemover), visits.end());
 
-        VisitEntry lastVisit = record.getLastVisit();
-        if (visits.empty() &&
-                (!lastVisit.isValid() || (lastVisit >= range.first && lastVisit <= range.second)))
+        if (visits.empty())
         {
             it = m_historyItems.erase(it);
             continue;
         }
 
-        if (!visits.empty())
-        {
-            record.m_historyEntry.NumVisits = static_cast<int>(visits.size());
-            record.m_historyEntry.LastVisit = visits.at(visits.size() - 1);
-        }
-
+        entry.LastVisit = *std::max_element(visits.begin(), visits.end());
         ++it;
     }
 }
@@ -115,7 +136,7 @@ void HistoryManager::addVisit(const QUrl &url, const QString &title, const QDate
             || url.toString(QUrl::FullyEncoded).startsWith(QLatin1String("data:"), Qt::CaseInsensitive))
         return;
 
-    m_taskScheduler.post(&HistoryStore::addVisit, std::ref(m_historyStore), QUrl(url), QString(title),
+    m_taskScheduler.post("HistoryStore", &HistoryStore::addVisit, std::ref(m_historyStore), QUrl(url), QString(title),
                          QDateTime(visitTime), QUrl(requestedUrl), wasTypedByUser);
 
     if (!CommonUtil::doUrlsMatch(requestedUrl, url))
@@ -134,71 +155,83 @@ void HistoryManager::addVisit(const QUrl &url, const QString &title, const QDate
 
 void HistoryManager::addVisitToLocalStore(const QUrl &url, const QString &title, const QDateTime &visitTime, bool wasTypedByUser)
 {
-    VisitEntry visit = visitTime;
+    const qint64 visit = visitTime.toMSecsSinceEpoch();
 
-    auto it = m_historyItems.find(url.toString().toUpper());
-    if (it != m_historyItems.end())
+    HistoryUrlKey key(url);
+    auto it = m_historyItems.find(key);
+    if (it == m_historyItems.end())
     {
-        URLRecord &record = it->second;
-        if (wasTypedByUser)
-            record.m_historyEntry.URLTypedCount++;
-
-        record.addVisit(visit);
-
-        m_recentItems.push_front(record.m_historyEntry);
-    }
-    else
-    {
-        HistoryEntry entry;
+        LocalHistoryEntry entry;
         entry.VisitID = static_cast<int>(++m_lastVisitId);
-        entry.NumVisits = 1;
-        entry.LastVisit = visitTime;
         entry.Title = title;
-        entry.URL = url;
-        entry.URLTypedCount = wasTypedByUser ? 1 : 0;
-        std::vector<VisitEntry> visits {visit};
-
-        m_historyItems.insert(std::make_pair(url.toString().toUpper(), URLRecord(std::move(entry), std::move(visits))));
-        m_recentItems.push_front(entry);
+        entry.LastVisit = visit;
+        it = m_historyItems.emplace(std::move(key), std::move(entry)).first;
     }
+
+    LocalHistoryEntry &entry = it->second;
+    if (wasTypedByUser)
+        entry.URLTypedCount++;
+
+    entry.Visits.push_back(visit);
+    entry.LastVisit = std::max(entry.LastVisit, visit);
+
+    // The recent item shares the URL and title of the in-memory entry
+    m_recentItems.push_front(toHistoryEntry(it->first, entry));
+}
+
+HistoryEntry HistoryManager::toHistoryEntry(const HistoryUrlKey &key, const LocalHistoryEntry &entry)
+{
+    HistoryEntry result;
+    result.URL = key.URL;
+    result.Title = entry.Title;
+    result.VisitID = entry.VisitID;
+    result.LastVisit = QDateTime::fromMSecsSinceEpoch(entry.LastVisit);
+    result.NumVisits = static_cast<int>(entry.Visits.size());
+    result.URLTypedCount = entry.URLTypedCount;
+    return result;
 }
 
-void HistoryManager::getHistoryBetween(const QDateTime &startDate, const QDateTime &endDate, std::function<void(std::vector<URLRecord>)> callback)
+DatabaseFuture<std::vector<URLRecord>> HistoryManager::getHistoryBetween(const QDateTime &startDate, const QDateTime &endDate)
 {
-    m_taskScheduler.post([this, startDate, endDate, callback](){
-        callback(m_historyStore->getHistoryBetween(startDate, endDate));
+    return m_taskScheduler.postReadTask("HistoryStore", [startDate, endDate](DatabaseWorker *worker){
+        return static_cast<HistoryStore*>(worker)->getHistoryBetween(startDate, endDate);
     });
 }
 
-void HistoryManager::getHistoryFrom(const QDateTime &startDate, std::function<void(std::vector<URLRecord>)> callback)
+DatabaseFuture<std::vector<URLRecord>> HistoryManager::getHistoryFrom(const QDateTime &startDate)
 {
-    m_taskScheduler.post([this, startDate, callback](){
-        callback(m_historyStore->getHistoryFrom(startDate));
+    return m_taskScheduler.postReadTask("HistoryStore", [startDate](DatabaseWorker *worker){
+        return static_cast<HistoryStore*>(worker)->getHistoryFrom(startDate);
     });
 }
 
-void HistoryManager::contains(const QUrl &url, std::function<void(bool)> callback)
+DatabaseFuture<HistoryPage> HistoryManager::getHistoryPage(const HistoryCursor &after, int limit)
 {
-    m_taskScheduler.post([this, url, callback](){
-        callback(m_historyStore->contains(url));
+    return m_taskScheduler.postReadTask("HistoryStore", [after, limit](DatabaseWorker *worker){
+        return static_cast<HistoryStore*>(worker)->getHistoryPage(after, limit);
     });
 }
 
-HistoryEntry HistoryManager::getEntry(const QUrl &url) const
+DatabaseFuture<bool> HistoryManager::contains(const QUrl &url)
 {
-    HistoryEntry result;
+    return m_taskScheduler.postReadTask("HistoryStore", [url](DatabaseWorker *worker){
+        return static_cast<HistoryStore*>(worker)->contains(url);
+    });
+}
 
-    auto it = m_historyItems.find(url.toString().toUpper());
+HistoryEntry HistoryManager::getEntry(const QUrl &url) const
+{
+    auto it = m_historyItems.find(HistoryUrlKey(url));
     if (it != m_historyItems.end())
-        result = it->second.m_historyEntry;
+        return toHistoryEntry(it->first, it->second);
 
-    return result;
+    return HistoryEntry();
 }
 
-void HistoryManager::getTimesVisitedHost(const QUrl &host, std::function<void(int)> callback)
+DatabaseFuture<int> HistoryManager::getTimesVisitedHost(const QUrl &host)
 {
-    m_taskScheduler.post([this, host, callback](){
-        callback(m_historyStore->getTimesVisitedHost(host));
+    return m_taskScheduler.postReadTask("HistoryStore", [host](DatabaseWorker *worker){
+        return static_cast<HistoryStore*>(worker)->getTimesVisitedHost(host);
     });
 }
 
@@ -229,30 +262,42 @@ void HistoryManager::onRecentItemsLoaded(std::deque<HistoryEntry> &&entries)
 void HistoryManager::onHistoryRecordsLoaded(std::vector<URLRecord> &&records)
 {
     m_historyItems.clear();
+    m_historyItems.reserve(records.size());
 
-    for (auto &&record : records)
+    for (const URLRecord &record : records)
     {
-        m_historyItems.insert(std::make_pair(record.getUrl().toString().toUpper(), record));
+        LocalHistoryEntry entry;
+        entry.Title = record.getTitle();
+        entry.VisitID = record.getVisitId();
+        entry.URLTypedCount = record.getUrlTypedCount();
+        entry.LastVisit = record.getLastVisit().toMSecsSinceEpoch();
+
+        const std::vector<VisitEntry> &visits = record.getVisits();
+        entry.Visits.reserve(visits.size());
+        for (const VisitEntry &visit : visits)
+            entry.Visits.push_back(visit.toMSecsSinceEpoch());
+
+        m_historyItems.emplace(HistoryUrlKey(record.getUrl()), std::move(entry));
     }
 }
 
-void HistoryManager::loadMostVisitedEntries(int limit, std::function<void(std::vector<WebPageInformation>)> callback)
+DatabaseFuture<std::vector<WebPageInformation>> HistoryManager::loadMostVisitedEntries(int limit)
 {
-    m_taskScheduler.post([this, limit, callback](){
-        callback(m_historyStore->loadMostVisitedEntries(limit));
+    return m_taskScheduler.postReadTask("HistoryStore", [limit](DatabaseWorker *worker){
+        return static_cast<HistoryStore*>(worker)->loadMostVisitedEntries(limit);
     });
 }
 
-void HistoryManager::loadWordDatabase(std::function<void(std::map<int, QString>)> callback)
+DatabaseFuture<std::map<int, QString>> HistoryManager::loadWordDatabase()
 {
-    m_taskScheduler.post([this, callback](){
-        callback(m_historyStore->getWords());
-    });
+    return m_taskScheduler.postReadTask("HistoryStore", [](DatabaseWorker *worker){
+        return static_cast<HistoryStore*>(worker)->getWords();
+    }, DatabaseTaskPriority::Background);
 }
 
-void HistoryManager::loadHistoryWordMapping(std::function<void(std::map<int, std::vector<int>>)> callback)
+DatabaseFuture<std::map<int, std::vector<int>>> HistoryManager::loadHistoryWordMapping()
 {
-    m_taskScheduler.post([this, callback](){
-        callback(m_historyStore->getEntryWordMapping());
-    });
+    return m_taskScheduler.postReadTask("HistoryStore", [](DatabaseWorker *worker){
+        return static_cast<HistoryStore*>(worker)->getEntryWordMapping();
+    }, DatabaseTaskPriority::Background);
 }
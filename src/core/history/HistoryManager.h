@@ -5,6 +5,7 @@
 #include "ClearHistoryOptions.h"
 #include "DatabaseTaskScheduler.h"
 #include "FavoritePagesManager.h"
+#include "IResourceReporter.h"
 #include "ServiceLocator.h"
 #include "ISettingsObserver.h"
 #include "URLRecord.h"
@@ -14,9 +15,12 @@
 #include <QIcon>
 #include <QList>
 #include <QMetaType>
+#include <QString>
+#include <QStringView>
 #include <QUrl>
 
 #include <deque>
+#include <map>
 #include <unordered_map>
 #include <vector>
 
@@ -32,18 +36,90 @@ enum class HistoryStoragePolicy
 
 Q_DECLARE_METATYPE(HistoryStoragePolicy)
 
+/**
+ * @struct HistoryUrlKey
+ * @brief Key of an entry in the in-memory history. The URL is converted to a string once, when the key is
+ *        constructed, and its hash is computed from that string while folding its case, so no upper case copy
+ *        is made. URLs are compared without regard to case, as they are in the history database
+ */
+struct HistoryUrlKey
+{
+    /// URL of the entry
+    QUrl URL;
+
+    /// The URL in string form, used to compare keys
+    QString Text;
+
+    /// Precomputed hash of the URL's string form, ignoring case
+    std::size_t Hash;
+
+    /// Constructs the key of the given URL
+    explicit HistoryUrlKey(const QUrl &url) : URL(url), Text(url.toString()), Hash(hashIgnoringCase(Text)) {}
+
+    /// Returns true if both keys refer to the same URL, ignoring case
+    bool operator ==(const HistoryUrlKey &other) const
+    {
+        return Hash == other.Hash && Text.compare(other.Text, Qt::CaseInsensitive) == 0;
+    }
+
+    /// Returns the hash of the given string, folding the case of each character as it is hashed
+    static std::size_t hashIgnoringCase(QStringView text) noexcept
+    {
+        // FNV-1a over the case folded UTF-16 code units
+        std::size_t hash = static_cast<std::size_t>(14695981039346656037ULL);
+        for (QChar c : text)
+        {
+            hash ^= c.toCaseFolded().unicode();
+            hash *= static_cast<std::size_t>(1099511628211ULL);
+        }
+        return hash;
+    }
+};
+
+/// Hash function of a \ref HistoryUrlKey, which returns the precomputed hash
+struct HistoryUrlKeyHasher
+{
+    std::size_t operator()(const HistoryUrlKey &key) const noexcept
+    {
+        return key.Hash;
+    }
+};
+
+/**
+ * @struct LocalHistoryEntry
+ * @brief Compact in-memory record of a URL visited during the current session. Visits are stored
+ *        as milliseconds since the epoch, in a single array per entry
+ */
+struct LocalHistoryEntry
+{
+    /// Title of the web page
+    QString Title;
+
+    /// Unique visit ID of the history entry
+    int VisitID { 0 };
+
+    /// The number of times the URL was typed by the user in the URL bar
+    int URLTypedCount { 0 };
+
+    /// The most recent visit, in milliseconds since the epoch
+    qint64 LastVisit { 0 };
+
+    /// Every visit to the URL, in milliseconds since the epoch
+    std::vector<qint64> Visits;
+};
+
 /**
  * @class HistoryManager
  * @brief Maintains the state of the browsing history that belongs to a user profile
  */
-class HistoryManager : public QObject, public ISettingsObserver
+class HistoryManager : public QObject, public ISettingsObserver, public IResourceReporter
 {
     friend class DatabaseFactory;
 
     Q_OBJECT
 
 public:
-    using const_iterator = std::unordered_map<QString, URLRecord>::const_iterator;
+    using const_iterator = std::unordered_map<HistoryUrlKey, LocalHistoryEntry, HistoryUrlKeyHasher>::const_iterator;
 
     /// Constructs the history manager, given the path to the history database
     explicit HistoryManager(const ViperServiceLocator &serviceLocator, DatabaseTaskScheduler &taskScheduler);
@@ -51,6 +127,9 @@ class HistoryManager : public QObject, public ISettingsObserver
     /// Destructor
     ~HistoryManager();
 
+    /// Returns the memory held by the in-memory history
+    std::vector<ResourceUsage> getResourceUsage() const override;
+
     /// Returns a const_iterator to the first element in the history hash map
     const_iterator begin() const { return m_historyItems.cbegin(); }
 
@@ -69,28 +148,30 @@ class HistoryManager : public QObject, public ISettingsObserver
     /// Adds an entry to the history data store, given the URL, page title, time of visit, and the requested URL
     void addVisit(const QUrl &url, const QString &title, const QDateTime &visitTime, const QUrl &requestedUrl, bool wasTypedByUser);
 
-    /// Loads a list of all \ref URLRecord visited between the given start date and end dates, passing them on to
-    /// the callback once the data has been fetched
-    void getHistoryBetween(const QDateTime &startDate, const QDateTime &endDate, std::function<void(std::vector<URLRecord>)> callback);
+    /// Loads a list of all \ref URLRecord visited between the given start date and end dates, returning a future
+    /// that receives the records once the data has been fetched
+    DatabaseFuture<std::vector<URLRecord>> getHistoryBetween(const QDateTime &startDate, const QDateTime &endDate);
 
-    /// Loads a list of all \ref URLRecord visited from the given start date to the present, passing them on to
-    /// the callback once the data has been fetched
-    void getHistoryFrom(const QDateTime &startDate, std::function<void(std::vector<URLRecord>)> callback);
+    /// Loads a list of all \ref URLRecord visited from the given start date to the present, returning a future
+    /// that receives the records once the data has been fetched
+    DatabaseFuture<std::vector<URLRecord>> getHistoryFrom(const QDateTime &startDate);
 
-    /// Checks if the given URL is contained in the history database, passing the result as a boolean
-    /// in the given callback function
-    void contains(const QUrl &url, std::function<void(bool)> callback);
+    /// Loads a page of up to limit visits that are older than the given cursor, from the most to the least recent,
+    /// returning a future that receives the page once it has been fetched
+    DatabaseFuture<HistoryPage> getHistoryPage(const HistoryCursor &after, int limit);
 
-    /// Returns a history record corresponding to the given URL, or an empty record if it was not found in the
-    /// database
+    /// Checks if the given URL is contained in the history database, returning a future that receives the result
+    DatabaseFuture<bool> contains(const QUrl &url);
+
+    /// Returns a history record corresponding to the given URL, or an empty record if the URL has not been
+    /// visited during the current session. The URL and title of the record are shared with the in-memory history
     HistoryEntry getEntry(const QUrl &url) const;
 
     /// Returns a queue of recently visited items, with the most recent visits being at the front of the queue
     const std::deque<HistoryEntry> &getRecentItems() const { return m_recentItems; }
 
-    /// Fetches the number of times the host was visited, passing it to the given callback when the
-    /// result has been retrieved
-    void getTimesVisitedHost(const QUrl &host, std::function<void(int)> callback);
+    /// Fetches the number of times the host was visited, returning a future that receives the result
+    DatabaseFuture<int> getTimesVisitedHost(const QUrl &host);
 
     /// Returns the history manager's storage policy
     HistoryStoragePolicy getStoragePolicy() const;
@@ -100,14 +181,14 @@ class HistoryManager : public QObject, public ISettingsObserver
 
     /// Fetches the set of most frequently visited web pages, up to the given limit. This is used to
     /// determine which web pages' thumbnails to retrieve for the "New Tab" page
-    void loadMostVisitedEntries(int limit, std::function<void(std::vector<WebPageInformation>)> callback);
+    DatabaseFuture<std::vector<WebPageInformation>> loadMostVisitedEntries(int limit);
 
-    /// Loads the word table into a map, returning the data in the callback function. Used by the
+    /// Loads the word table into a map, returning a future that receives the data. Used by the
     /// URL suggestion worker when recommending matches based on user input
-    void loadWordDatabase(std::function<void(std::map<int, QString>)> callback);
+    DatabaseFuture<std::map<int, QString>> loadWordDatabase();
 
     /// Loads a mapping of history entries to the lists of their corresponding words
-    void loadHistoryWordMapping(std::function<void(std::map<int, std::vector<int>>)> callback);
+    DatabaseFuture<std::map<int, std::vector<int>>> loadHistoryWordMapping();
 
 Q_SIGNALS:
     /// Emitted when a page has been visited
@@ -124,6 +205,9 @@ private Q_SLOTS:
     /// Adds the history visit to the in-memory history store.
     void addVisitToLocalStore(const QUrl &url, const QString &title, const QDateTime &visitTime, bool wasTypedByUser);
 
+    /// Returns a history record built from an entry of the in-memory history store
+    static HistoryEntry toHistoryEntry(const HistoryUrlKey &key, const LocalHistoryEntry &entry);
+
     /// Handles the recent history record load event - called during instantiation of the \ref HistoryStore
     void onRecentItemsLoaded(std::deque<HistoryEntry> &&entries);
 
@@ -134,8 +218,8 @@ private Q_SLOTS:
     /// Reference to the task scheduler. Needed to queue work for the \ref HistoryStore
     DatabaseTaskScheduler &m_taskScheduler;
 
-    /// Hash map of history URL strings to their corresponding data structure
-    std::unordered_map<QString, URLRecord> m_historyItems;
+    /// Hash map of visited URLs to their corresponding compact records
+    std::unordered_map<HistoryUrlKey, LocalHistoryEntry, HistoryUrlKeyHasher> m_historyItems;
 
     /// Queue of recently visited items
     std::deque<HistoryEntry> m_recentItems;
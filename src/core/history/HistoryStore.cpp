@@ -1,13 +1,20 @@
 #include "CommonUtil.h"
 #include "HistoryStore.h"
 
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
 #include <QDateTime>
 #include <QUrl>
 #include <QDebug>
 
-HistoryStore::HistoryStore(const QString &databaseFile) :
-    DatabaseWorker(databaseFile),
+HistoryStore::HistoryStore(const QString &databaseFile, sqlite::Database::OpenMode openMode) :
+    DatabaseWorker(databaseFile, openMode),
     m_lastVisitID(0),
+    m_hasFullTextIndex(false),
+    m_lastWordID(0),
+    m_wordIds(),
     m_statements()
 {
     m_database.execute("PRAGMA foreign_keys=\"0\"");
@@ -31,6 +38,12 @@ void HistoryStore::clearAllHistory()
 
     if (!exec(QLatin1String("DELETE FROM Visits")))
         qWarning() << "In HistoryStore::clearAllHistory - Unable to clear Visits table.";
+
+    if (m_hasFullTextIndex && !exec(QLatin1String("DELETE FROM HistoryText")))
+        qWarning() << "In HistoryStore::clearAllHistory - Unable to clear History text index.";
+
+    m_wordIds.clear();
+    m_lastWordID = 0;
 }
 
 void HistoryStore::clearHistoryFrom(const QDateTime &start)
@@ -42,6 +55,8 @@ void HistoryStore::clearHistoryFrom(const QDateTime &start)
 
     if (!m_database.execute("DELETE FROM History WHERE VisitID NOT IN (SELECT DISTINCT VisitID FROM Visits)"))
         qWarning() << "In HistoryStore::clearHistoryFrom - Unable to clear history.";
+
+    removeOrphanedText();
 }
 
 void HistoryStore::clearHistoryInRange(std::pair<QDateTime, QDateTime> range)
@@ -54,6 +69,8 @@ void HistoryStore::clearHistoryInRange(std::pair<QDateTime, QDateTime> range)
 
     if (!m_database.execute("DELETE FROM History WHERE VisitID NOT IN (SELECT DISTINCT VisitID FROM Visits)"))
         qWarning() << "In HistoryStore::clearHistoryInRange - Unable to clear history. ";
+
+    removeOrphanedText();
 }
 
 bool HistoryStore::contains(const QUrl &url) const
@@ -125,48 +142,49 @@ std::vector<URLRecord> HistoryStore::getHistoryBetween(const QDateTime &startDat
     if (!startDate.isValid() || !endDate.isValid())
         return result;
 
-    auto queryVisitIds = m_database.prepare(R"(SELECT DISTINCT VisitID FROM Visits WHERE Date >= ? AND Date <= ?
-                                            ORDER BY Date ASC)");
-    auto queryHistoryItem = m_database.prepare(R"(SELECT URL, Title, URLTypedCount FROM History WHERE VisitID = ?)");
-    auto queryVisitDates = m_database.prepare(R"(SELECT Date FROM Visits WHERE VisitID = ?
-                                              AND Date >= ? AND Date <= ? ORDER BY Date ASC)");
-
-    queryVisitIds << startDate
-                  << endDate;
-    while (queryVisitIds.next())
-    {
-        int visitId = 0;
-        queryVisitIds >> visitId;
+    auto stmt = m_database.prepare(R"(SELECT V.VisitID, V.Date, H.URL, H.Title, H.URLTypedCount
+                                   FROM Visits AS V
+                                   INNER JOIN History AS H ON H.VisitID = V.VisitID
+                                   WHERE V.Date >= ? AND V.Date <= ?
+                                   ORDER BY V.Date ASC, V.VisitID ASC)");
+    stmt << startDate
+         << endDate;
 
-        queryHistoryItem.reset();
-        queryHistoryItem << visitId;
-        if (!queryHistoryItem.execute() || !queryHistoryItem.next())
-            continue;
+    readVisitRecords(stmt, result);
+    return result;
+}
 
-        HistoryEntry entry;
-        entry.VisitID = visitId;
-        queryHistoryItem >> entry.URL
-                         >> entry.Title
-                         >> entry.URLTypedCount;
-
-        std::vector<VisitEntry> visits;
-        queryVisitDates.reset();
-        queryVisitDates << visitId
-                        << startDate
-                        << endDate;
-        while (queryVisitDates.next())
-        {
-            QDateTime temp = QDateTime();
-            queryVisitDates >> temp;
-            visits.push_back(temp);
-        }
+HistoryPage HistoryStore::getHistoryPage(const HistoryCursor &after, int limit) const
+{
+    HistoryPage page;
+    page.Next = after;
 
-        entry.LastVisit = visits.at(visits.size() - 1);
-        entry.NumVisits = static_cast<int>(visits.size());
-        result.push_back( URLRecord{ std::move(entry), std::move(visits) } );
+    if (limit <= 0)
+        return page;
+
+    // Keyset pagination over the (Date, VisitID) index, so each page costs the same regardless of how far back it is
+    sqlite::PreparedStatement stmt = after.Date.isValid()
+            ? m_database.prepare(R"(SELECT V.VisitID, V.Date, H.URL, H.Title, H.URLTypedCount
+                                 FROM Visits AS V
+                                 INNER JOIN History AS H ON H.VisitID = V.VisitID
+                                 WHERE V.Date <= ? AND (V.Date < ? OR V.VisitID < ?)
+                                 ORDER BY V.Date DESC, V.VisitID DESC LIMIT ?)")
+            : m_database.prepare(R"(SELECT V.VisitID, V.Date, H.URL, H.Title, H.URLTypedCount
+                                 FROM Visits AS V
+                                 INNER JOIN History AS H ON H.VisitID = V.VisitID
+                                 ORDER BY V.Date DESC, V.VisitID DESC LIMIT ?)");
+
+    if (after.Date.isValid())
+    {
+        stmt << after.Date
+             << after.Date
+             << after.VisitID;
     }
+    stmt << limit;
 
-    return result;
+    const int numRows = readVisitRecords(stmt, page.Records, &page.Next);
+    page.HasMore = numRows == limit;
+    return page;
 }
 
 int HistoryStore::getTimesVisitedHost(const QUrl &url) const
@@ -230,34 +248,53 @@ std::map<int, std::vector<int>> HistoryStore::getEntryWordMapping() const
 {
     std::map<int, std::vector<int>> result;
 
-    auto queryDistinctHistoryId = m_database.prepare(R"(SELECT DISTINCT(HistoryID) FROM URLWords ORDER BY HistoryID ASC)");
-    auto queryHistoryWordMapping =
-            m_database.prepare(R"(SELECT WordID FROM URLWords WHERE HistoryID = ?)");
+    // The primary key orders the rows by history entry, so the words of each entry are read in one pass
+    auto stmt = m_database.prepare(R"(SELECT HistoryID, WordID FROM URLWords ORDER BY HistoryID ASC)");
 
-    while (queryDistinctHistoryId.next())
+    auto entryIt = result.end();
+    while (stmt.next())
     {
-        int historyId = 0;
-        queryDistinctHistoryId >> historyId;
-        //queryDistinctHistoryId.value(0).toInt();
-
-        std::vector<int> wordIds;
-        queryHistoryWordMapping.reset();
-        queryHistoryWordMapping << historyId;
-        while (queryHistoryWordMapping.next())
-        {
-            int wordId = 0;
-            queryHistoryWordMapping >> wordId;
-            wordIds.push_back(wordId);
-        }
+        int historyId = 0, wordId = 0;
+        stmt >> historyId
+             >> wordId;
+
+        if (entryIt == result.end() || entryIt->first != historyId)
+            entryIt = result.emplace_hint(result.end(), historyId, std::vector<int>());
 
-        if (!wordIds.empty())
-            result.insert(std::make_pair(historyId, wordIds));
+        entryIt->second.push_back(wordId);
     }
 
     return result;
 }
 
+bool HistoryStore::hasFullTextIndex() const
+{
+    return m_hasFullTextIndex;
+}
+
 void HistoryStore::addVisit(const QUrl &url, const QString &title, const QDateTime &visitTime, const QUrl &requestedUrl, bool wasTypedByUser)
+{
+    if (url.toString(QUrl::FullyEncoded).startsWith(QStringLiteral("data:")))
+        return;
+
+    // Commit the entry, its visits and its words together, rather than one statement at a time
+    if (!m_database.beginTransaction())
+    {
+        qWarning() << "HistoryStore::addVisit - could not start transaction";
+        saveVisit(url, title, visitTime, requestedUrl, wasTypedByUser);
+        return;
+    }
+
+    saveVisit(url, title, visitTime, requestedUrl, wasTypedByUser);
+
+    if (!m_database.commitTransaction())
+    {
+        qWarning() << "HistoryStore::addVisit - could not commit transaction";
+        m_database.rollbackTransaction();
+    }
+}
+
+void HistoryStore::saveVisit(const QUrl &url, const QString &title, const QDateTime &visitTime, const QUrl &requestedUrl, bool wasTypedByUser)
 {
     if (url.toString(QUrl::FullyEncoded).startsWith(QStringLiteral("data:")))
         return;
@@ -269,6 +306,8 @@ void HistoryStore::addVisit(const QUrl &url, const QString &title, const QDateTi
         if (wasTypedByUser)
             existingEntry.URLTypedCount++;
 
+        // The words of the URL are already indexed, so they only need to be updated when the title changes
+        const bool titleChanged = existingEntry.Title != title;
         existingEntry.Title = title;
 
         sqlite::PreparedStatement &stmtUpdate = m_statements.at(Statement::UpdateHistoryRecord);
@@ -277,8 +316,8 @@ void HistoryStore::addVisit(const QUrl &url, const QString &title, const QDateTi
 
         if (!stmtUpdate.execute())
             qWarning() << "HistoryStore::addVisit - could not save entry to database.";
-
-        tokenizeAndSaveUrl(static_cast<int>(visitId), url, title);
+        else if (titleChanged)
+            tokenizeAndSaveUrl(static_cast<int>(visitId), url, title);
     }
     else
     {
@@ -313,7 +352,7 @@ void HistoryStore::addVisit(const QUrl &url, const QString &title, const QDateTi
         if (!requestDateTime.isValid())
             requestDateTime = visitTime;
 
-        addVisit(requestedUrl, title, requestDateTime, requestedUrl, wasTypedByUser);
+        saveVisit(requestedUrl, title, requestDateTime, requestedUrl, wasTypedByUser);
     }
 }
 
@@ -322,30 +361,160 @@ uint64_t HistoryStore::getLastVisitId() const
     return m_lastVisitID;
 }
 
+int HistoryStore::readVisitRecords(sqlite::PreparedStatement &stmt, std::vector<URLRecord> &result, HistoryCursor *lastVisit)
+{
+    // Rows arrive ordered by date, and the visits of each entry are appended to it in that order
+    std::vector<std::pair<HistoryEntry, std::vector<VisitEntry>>> entries;
+    std::unordered_map<int, std::size_t> entryIndices;
+
+    int numRows = 0;
+    int visitId = 0;
+    VisitEntry visit;
+    while (stmt.next())
+    {
+        stmt >> visitId
+             >> visit;
+
+        ++numRows;
+
+        auto it = entryIndices.find(visitId);
+        if (it == entryIndices.end())
+        {
+            it = entryIndices.emplace(visitId, entries.size()).first;
+            entries.emplace_back();
+
+            HistoryEntry &entry = entries.back().first;
+            entry.VisitID = visitId;
+            stmt >> entry.URL
+                 >> entry.Title
+                 >> entry.URLTypedCount;
+        }
+
+        entries[it->second].second.push_back(visit);
+    }
+
+    if (lastVisit != nullptr && numRows > 0)
+    {
+        lastVisit->Date = visit;
+        lastVisit->VisitID = visitId;
+    }
+
+    result.reserve(result.size() + entries.size());
+    for (auto &item : entries)
+    {
+        HistoryEntry &entry = item.first;
+        std::vector<VisitEntry> &visits = item.second;
+
+        entry.LastVisit = std::max(visits.front(), visits.back());
+        entry.NumVisits = static_cast<int>(visits.size());
+        result.emplace_back(std::move(entry), std::move(visits));
+    }
+
+    return numRows;
+}
+
 void HistoryStore::tokenizeAndSaveUrl(int visitId, const QUrl &url, const QString &title)
 {
+    if (m_hasFullTextIndex)
+    {
+        // The FTS5 tokenizer splits the URL and title into words on its own
+        sqlite::PreparedStatement &stmtText = m_statements.at(Statement::CreateTextRecord);
+        stmtText.reset();
+        stmtText << visitId
+                 << url
+                 << title;
+
+        if (!stmtText.execute())
+            qWarning() << "HistoryStore::tokenizeAndSaveUrl - could not index history entry.";
+        return;
+    }
+
     QStringList urlWords = CommonUtil::tokenizePossibleUrl(url.toString().toUpper());
 
     if (!title.startsWith(QLatin1String("http"), Qt::CaseInsensitive))
         urlWords = urlWords + title.toUpper().split(QLatin1Char(' '), QStringSplitFlag::SkipEmptyParts);
 
+    urlWords.removeDuplicates();
+
     sqlite::PreparedStatement &stmtInsertWord = m_statements.at(Statement::CreateWordRecord);
     sqlite::PreparedStatement &stmtAssociateWord = m_statements.at(Statement::CreateUrlWordRecord);
 
     for (const QString &word : qAsConst(urlWords))
     {
-        stmtInsertWord.reset();
-        stmtAssociateWord.reset();
-
-        stmtInsertWord << word;
-        stmtInsertWord.execute();
+        int wordId = m_wordIds.value(word, 0);
+        if (wordId == 0)
+        {
+            wordId = m_lastWordID + 1;
+
+            stmtInsertWord.reset();
+            stmtInsertWord << wordId
+                           << word;
+            if (!stmtInsertWord.execute())
+            {
+                qWarning() << "HistoryStore::tokenizeAndSaveUrl - could not save word " << word;
+                continue;
+            }
+
+            m_lastWordID = wordId;
+            m_wordIds.insert(word, wordId);
+        }
 
+        stmtAssociateWord.reset();
         stmtAssociateWord << visitId
-                          << word;
+                          << wordId;
         stmtAssociateWord.execute();
     }
 }
 
+void HistoryStore::setupWordIndex()
+{
+    const bool hadFullTextIndex = hasTable(QLatin1String("HistoryText"));
+
+    // The table creation fails if SQLite was built without FTS5, and the query fails if the
+    // table was created by a build of SQLite that had FTS5
+    m_hasFullTextIndex = exec(QLatin1String("CREATE VIRTUAL TABLE IF NOT EXISTS HistoryText USING fts5(URL, Title, prefix='2 3')"))
+            && m_database.prepare(R"(SELECT rowid FROM HistoryText LIMIT 1)").isValid();
+
+    if (m_hasFullTextIndex)
+    {
+        if (hadFullTextIndex)
+            return;
+
+        // Move the existing history into the full-text index, which replaces the word tables
+        if (!exec(QLatin1String("INSERT INTO HistoryText(rowid, URL, Title) SELECT VisitID, URL, Title FROM History")))
+            qWarning() << "In HistoryStore::setupWordIndex - unable to fill the history text index.";
+
+        if (!exec(QLatin1String("DELETE FROM URLWords")) || !exec(QLatin1String("DELETE FROM Words")))
+            qWarning() << "In HistoryStore::setupWordIndex - unable to clear the word tables.";
+
+        return;
+    }
+
+    if (!exec(QLatin1String("CREATE INDEX IF NOT EXISTS URL_Word_Index ON URLWords(WordID)")))
+        qWarning() << "In HistoryStore::setupWordIndex - unable to create index on the word column of the url-word table.";
+
+    auto stmt = m_database.prepare(R"(SELECT WordID, Word FROM Words)");
+    while (stmt.next())
+    {
+        int wordId = 0;
+        QString word;
+
+        stmt >> wordId
+             >> word;
+        m_wordIds.insert(word, wordId);
+        m_lastWordID = std::max(m_lastWordID, wordId);
+    }
+}
+
+void HistoryStore::removeOrphanedText()
+{
+    if (!m_hasFullTextIndex)
+        return;
+
+    if (!exec(QLatin1String("DELETE FROM HistoryText WHERE rowid NOT IN (SELECT VisitID FROM History)")))
+        qWarning() << "In HistoryStore::removeOrphanedText - unable to remove text of deleted history entries.";
+}
+
 bool HistoryStore::hasProperStructure()
 {
     // Verify existence of Visits and History tables
@@ -381,13 +550,18 @@ void HistoryStore::setup()
 
 void HistoryStore::load()
 {
-    purgeOldEntries();
     checkForUpdate();
+    setupWordIndex();
+    purgeOldEntries();
 
     if (!exec(QLatin1String("CREATE INDEX IF NOT EXISTS Visit_ID_Index ON Visits(VisitID)")))
         qWarning() << "In HistoryStore::load - unable to create index on the visit ID column of the visit table.";
 
-    if (!exec(QLatin1String("CREATE INDEX IF NOT EXISTS Visit_Date_Index ON Visits(Date)")))
+    // The date index also covers the visit ID, which is used to page through history in a stable order
+    if (!exec(QLatin1String("DROP INDEX IF EXISTS Visit_Date_Index")))
+        qWarning() << "In HistoryStore::load - unable to remove the old index on the date column of the visit table.";
+
+    if (!exec(QLatin1String("CREATE INDEX IF NOT EXISTS Visit_Date_ID_Index ON Visits(Date, VisitID)")))
         qWarning() << "In HistoryStore::load - unable to create index on the date column of the visit table.";
 
     if (!exec(QLatin1String("CREATE INDEX IF NOT EXISTS Word_Index ON Words(Word)")))
@@ -401,8 +575,15 @@ void HistoryStore::load()
     cacheStatement(Statement::CreateHistoryRecord, R"(INSERT INTO History(VisitID, URL, Title, URLTypedCount) VALUES(?, ?, ?, ?))");
     cacheStatement(Statement::UpdateHistoryRecord, R"(INSERT OR REPLACE INTO History(VisitID, URL, Title, URLTypedCount) VALUES(?, ?, ?, ?))");
     cacheStatement(Statement::CreateVisitRecord, R"(INSERT INTO Visits(VisitID, Date) VALUES (?, ?))");
-    cacheStatement(Statement::CreateWordRecord, R"(INSERT OR IGNORE INTO Words(Word) VALUES (?))");
-    cacheStatement(Statement::CreateUrlWordRecord, R"(INSERT OR IGNORE INTO URLWords(HistoryID, WordID) VALUES (?, (SELECT WordID FROM Words WHERE Word = ?)))");
+    if (m_hasFullTextIndex)
+    {
+        cacheStatement(Statement::CreateTextRecord, R"(INSERT OR REPLACE INTO HistoryText(rowid, URL, Title) VALUES (?, ?, ?))");
+    }
+    else
+    {
+        cacheStatement(Statement::CreateWordRecord, R"(INSERT INTO Words(WordID, Word) VALUES (?, ?))");
+        cacheStatement(Statement::CreateUrlWordRecord, R"(INSERT OR IGNORE INTO URLWords(HistoryID, WordID) VALUES (?, ?))");
+    }
     cacheStatement(Statement::GetHistoryRecord, "SELECT History.VisitID, History.URL, History.Title, History.URLTypedCount, V.NumVisits, "
                                                 " V.RecentVisit FROM History INNER JOIN"
                                                 " (SELECT VisitID, MAX(Date) AS RecentVisit, COUNT(Date) AS NumVisits "
@@ -465,6 +646,8 @@ void HistoryStore::purgeOldEntries()
 
         if (!m_database.execute(R"(DELETE FROM History WHERE VisitID NOT IN (SELECT VisitID FROM Visits);)"))
             qWarning() << "HistoryStore - Error purging unused history entries. Message: " << QString::fromStdString(m_database.getLastError());
+
+        removeOrphanedText();
     }
 }
 
@@ -31,14 +31,16 @@ class HistoryStore : public DatabaseWorker
         CreateHistoryRecord,  /// INSERT OR REPLACE INTO History(VisitID, URL, Title, URLTypedCount) VALUES(?, ?, ?, ?)
         UpdateHistoryRecord,  /// UPDATE History SET Title = ?, URLTypedCount = ? WHERE VisitID = ?
         CreateVisitRecord,    /// INSERT INTO Visits(VisitID, Date) VALUES (?, ?)
-        CreateWordRecord,     /// INSERT OR IGNORE INTO Words(Word) VALUES(?)
-        CreateUrlWordRecord,  /// INSERT OR IGNORE INTO URLWords(HistoryID, WordID) VALUES(?, (SELECT WordID FROM Words WHERE Word = ?))
+        CreateWordRecord,     /// INSERT INTO Words(WordID, Word) VALUES(?, ?)
+        CreateUrlWordRecord,  /// INSERT OR IGNORE INTO URLWords(HistoryID, WordID) VALUES(?, ?)
+        CreateTextRecord,     /// INSERT OR REPLACE INTO HistoryText(rowid, URL, Title) VALUES(?, ?, ?)
         GetHistoryRecord      /// SELECT History.VisitID, History.URL, History.Title, History.URLTypedCount, V.NumVisits, ...
     };
 
 public:
-    /// Constructs the history manager, given the path to the history database
-    explicit HistoryStore(const QString &databaseFile);
+    /// Constructs the history manager, given the path to the history database. A read-only history
+    /// store can only be used to run the const queries, such as \ref getHistoryBetween
+    explicit HistoryStore(const QString &databaseFile, sqlite::Database::OpenMode openMode = sqlite::Database::OpenMode::ReadWrite);
 
     /// Destructor 
     ~HistoryStore();
@@ -72,6 +74,14 @@ class HistoryStore : public DatabaseWorker
     /// Loads and returns a list of all \ref HistoryEntry items visited between the given start date and end dates
     std::vector<URLRecord> getHistoryBetween(const QDateTime &startDate, const QDateTime &endDate) const;
 
+    /**
+     * @brief Loads a page of visits, from the most to the least recent
+     * @param after Position of the last visit from the previous page, or a default-constructed cursor to load the first page
+     * @param limit Maximum number of visits in the page
+     * @return Page containing up to limit visits that are older than the given cursor
+     */
+    HistoryPage getHistoryPage(const HistoryCursor &after, int limit) const;
+
     /// Returns the number of times the user has visited the given website by its hostname
     int getTimesVisitedHost(const QUrl &url) const;
 
@@ -84,6 +94,10 @@ class HistoryStore : public DatabaseWorker
     /// Returns a mapping of history entries to the list of word IDs associated with them
     std::map<int, std::vector<int>> getEntryWordMapping() const;
 
+    /// Returns true if the URLs and titles of history entries are indexed in the full-text search table
+    /// (HistoryText), rather than in the Words and URLWords tables
+    bool hasFullTextIndex() const;
+
     /// Fetches the set of most frequently visited web pages, up to the given limit. This is used to
     /// determine which web pages' thumbnails to retrieve for the "New Tab" page
     std::vector<WebPageInformation> loadMostVisitedEntries(int limit = 10);
@@ -106,9 +120,32 @@ class HistoryStore : public DatabaseWorker
     void load() override;
 
 private:
-    /// Splits the given URL into distinct words, saving the association in the database
+    /**
+     * @brief Steps through a query of visits, which returns the VisitID, Date, URL, Title and URLTypedCount
+     *        columns, grouping the visits of each history entry into a single record
+     * @param stmt Query of visits
+     * @param result Records in the order of the first row of each history entry
+     * @param lastVisit Set to the position of the last row of the query, if not null
+     * @return Number of rows in the query
+     */
+    static int readVisitRecords(sqlite::PreparedStatement &stmt, std::vector<URLRecord> &result, HistoryCursor *lastVisit = nullptr);
+
+    /// Saves the history entry and visit for the given URL, as well as a visit for the requested URL if
+    /// it differs. Called by \ref addVisit within a transaction
+    void saveVisit(const QUrl &url, const QString &title, const QDateTime &visitTime, const QUrl &requestedUrl, bool wasTypedByUser);
+
+    /// Indexes the words of the given URL and title, either in the full-text search table or in the
+    /// Words and URLWords tables
     void tokenizeAndSaveUrl(int visitId, const QUrl &url, const QString &title);
 
+    /// Creates the FTS5 table that indexes history entries, if the SQLite library supports it. When the table
+    /// is first created, it is filled from the history table and the Words and URLWords tables are cleared.
+    /// Otherwise, the word IDs are loaded into memory
+    void setupWordIndex();
+
+    /// Removes entries of the full-text search table that no longer belong to a history entry
+    void removeOrphanedText();
+
     /// Called during the load() routine, this checks if any of the table structures need to be updated
     void checkForUpdate();
 
@@ -119,6 +156,16 @@ class HistoryStore : public DatabaseWorker
     /// Stores the last visit ID that has been used to record browsing history. Auto increments for each new history item
     uint64_t m_lastVisitID;
 
+    /// True if history entries are indexed in the FTS5 table
+    bool m_hasFullTextIndex;
+
+    /// Last word ID that has been assigned to a word in the Words table. Only used without the FTS5 table
+    int m_lastWordID;
+
+    /// Maps each word in the Words table to its ID, so that words can be associated with
+    /// history entries without looking up their IDs in the database
+    QHash<QString, int> m_wordIds;
+
     /// Cache of prepared statements
     std::map<Statement, sqlite::PreparedStatement> m_statements;
 };
@@ -2,6 +2,7 @@
 #include "HistoryManager.h"
 #include "FaviconManager.h"
 
+#include <algorithm>
 #include <utility>
 
 HistoryTableModel::HistoryTableModel(const ViperServiceLocator &serviceLocator, QObject *parent) :
@@ -9,10 +10,21 @@ HistoryTableModel::HistoryTableModel(const ViperServiceLocator &serviceLocator,
     m_historyManager(serviceLocator.getServiceAs<HistoryManager>("HistoryManager")),
     m_faviconManager(serviceLocator.getServiceAs<FaviconManager>("FaviconManager")),
     m_targetDate(),
-    m_loadedDate(),
+    m_cursor(),
+    m_hasMore(false),
+    m_pendingFetch(),
+    m_isFetching(false),
     m_commonData(),
-    m_history()
+    m_history(),
+    m_itemsWithoutIcon()
 {
+    if (m_faviconManager)
+        connect(m_faviconManager, &FaviconManager::pageIconLoaded, this, &HistoryTableModel::onPageIconLoaded);
+}
+
+HistoryTableModel::~HistoryTableModel()
+{
+    m_pendingFetch.cancel();
 }
 
 QVariant HistoryTableModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -52,65 +64,99 @@ int HistoryTableModel::columnCount(const QModelIndex &parent) const
 
 bool HistoryTableModel::canFetchMore(const QModelIndex &/*parent*/) const
 {
-    return m_targetDate < m_loadedDate;
+    return m_hasMore;
 }
 
 void HistoryTableModel::fetchMore(const QModelIndex &/*parent*/)
 {
-    qint64 daysLeft = m_targetDate.daysTo(m_loadedDate);
-    if (daysLeft <= 0)
-    {
-        m_loadedDate = m_targetDate;
+    // Only one page is fetched at a time, the next page is fetched after the view asks for more
+    if (!m_hasMore || m_isFetching)
         return;
-    }
-    m_historyManager->getHistoryBetween(m_loadedDate.addDays(-1), m_loadedDate,
-                                    std::bind(&HistoryTableModel::onHistoryFetched, this, std::placeholders::_1));
+
+    m_isFetching = true;
+    m_pendingFetch = m_historyManager->getHistoryPage(m_cursor, PageSize);
+    m_pendingFetch.then(this, [this](HistoryPage &&page){
+        m_isFetching = false;
+        onHistoryFetched(std::move(page));
+    });
 }
 
-void HistoryTableModel::onHistoryFetched(std::vector<URLRecord> &&entries)
+void HistoryTableModel::onHistoryFetched(HistoryPage &&page)
 {
-    QDateTime nextLoadedDate = m_loadedDate.addDays(-1);
+    m_cursor = page.Next;
+    m_hasMore = page.HasMore;
 
-    QMap<qint64, int> tmpVisitInfo; // Used to sort visits by date
-    for (auto &it : entries)
+    // Pairs of visit times and the index of their item in the common data list, used to sort visits by date
+    std::vector<std::pair<qint64, int>> visits;
+    for (auto &it : page.Records)
     {
-        // Load entry into common entry list, then specific visits into a temporary map for sorting
+        const std::size_t numVisits = visits.size();
+        const int itemIndex = static_cast<int>(m_commonData.size());
+        for (const auto &visit : it.getVisits())
+        {
+            // Visits are loaded from the most to the least recent, so the rest of the history is outside of the range
+            if (visit < m_targetDate)
+            {
+                m_hasMore = false;
+                continue;
+            }
+
+            visits.emplace_back(visit.toMSecsSinceEpoch(), itemIndex);
+        }
+
+        if (visits.size() == numVisits)
+            continue;
+
+        // Load entry into common entry list
         HistoryTableItem tableItem;
         tableItem.Title = it.getTitle();
         tableItem.URL = it.getUrl().toString();
         tableItem.Favicon = m_faviconManager->getFavicon(it.getUrl()).pixmap(16, 16);
         m_commonData.push_back(tableItem);
 
-        int itemIndex = static_cast<int>(m_commonData.size()) - 1;
-        for (const auto &visit : it.getVisits())
-        {
-            auto time = visit.toMSecsSinceEpoch();
-            if (!tmpVisitInfo.contains(time))
-                tmpVisitInfo.insert(time, itemIndex);
-        }
+        // Favicons that are not cached are loaded in the background
+        m_itemsWithoutIcon[FaviconManager::getPageKey(it.getUrl())].push_back(itemIndex);
     }
 
-    int currentRowCount = rowCount();
-    beginInsertRows(QModelIndex(), currentRowCount, currentRowCount + tmpVisitInfo.size() - 1);
+    if (visits.empty())
+        return;
+
+    std::stable_sort(visits.begin(), visits.end(), [](const std::pair<qint64, int> &a, const std::pair<qint64, int> &b) {
+        return a.first > b.first;
+    });
+
+    const int currentRowCount = rowCount();
+    beginInsertRows(QModelIndex(), currentRowCount, currentRowCount + static_cast<int>(visits.size()) - 1);
 
     // Insert history entries into m_history sorted by most recently visited
-    QMapIterator<qint64, int> mapIt(tmpVisitInfo);
-    mapIt.toBack();
-    while (mapIt.hasPrevious())
+    m_history.reserve(m_history.size() + visits.size());
+    for (const auto &visit : visits)
     {
-        mapIt.previous();
-        QDateTime dateTime = QDateTime::fromMSecsSinceEpoch(mapIt.key());
-
         HistoryTableRow row;
-        row.ItemIndex = mapIt.value();
-        row.VisitString = dateTime.toString(QStringLiteral("MMMM d yyyy, h:mm ap"));
+        row.ItemIndex = visit.second;
+        row.VisitString = QDateTime::fromMSecsSinceEpoch(visit.first).toString(QStringLiteral("MMMM d yyyy, h:mm ap"));
         m_history.push_back(row);
     }
 
-    m_loadedDate = nextLoadedDate;
     endInsertRows();
 }
 
+void HistoryTableModel::onPageIconLoaded(const QUrl &pageUrl, const QIcon &icon)
+{
+    auto it = m_itemsWithoutIcon.find(pageUrl);
+    if (it == m_itemsWithoutIcon.end())
+        return;
+
+    const QPixmap favicon = icon.pixmap(16, 16);
+    for (int itemIndex : it.value())
+        m_commonData[itemIndex].Favicon = favicon;
+
+    m_itemsWithoutIcon.erase(it);
+
+    if (!m_history.empty())
+        emit dataChanged(index(0, 0), index(rowCount() - 1, 0), { Qt::DecorationRole });
+}
+
 QVariant HistoryTableModel::data(const QModelIndex &index, int role) const
 {
     if (!index.isValid() || index.row() >= static_cast<int>(m_history.size()))
@@ -149,15 +195,21 @@ void HistoryTableModel::loadFromDate(const QDateTime &date)
         return;
 
     beginResetModel();
+
+    // Results of a fetch started before the reset would be inserted in the wrong place
+    m_pendingFetch.cancel();
+    m_isFetching = false;
+
     m_targetDate = date;
 
-    // Set loaded date to a time in the future, as fetchMore() will grab history items one day at a time
-    QDateTime tomorrow = QDateTime(QDate::currentDate(), QTime(0, 0));
-    m_loadedDate = tomorrow.addDays(1);
+    // Start paging from the most recent visit, fetchMore() will grab history items one page at a time
+    m_cursor = HistoryCursor();
+    m_hasMore = true;
 
     // Clear old model data
     m_commonData.clear();
     m_history.clear();
+    m_itemsWithoutIcon.clear();
 
     endResetModel();
 }
@@ -1,13 +1,15 @@
 #ifndef HISTORYTABLEMODEL_H
 #define HISTORYTABLEMODEL_H
 
+#include "DatabaseFuture.h"
 #include "HistoryStore.h"
 #include "ServiceLocator.h"
 
 #include <vector>
 #include <QAbstractTableModel>
 #include <QDateTime>
-#include <QMap>
+#include <QHash>
+#include <QIcon>
 #include <QPixmap>
 #include <QUrl>
 
@@ -56,10 +58,16 @@ class HistoryTableModel : public QAbstractTableModel
 
     friend class HistoryWidget;
 
+    /// Number of visits loaded with each call to fetchMore()
+    static constexpr int PageSize = 250;
+
 public:
     /// Constructs the table model given a reference to the service locator, and an optional parent object pointer
     explicit HistoryTableModel(const ViperServiceLocator &serviceLocator, QObject *parent = nullptr);
 
+    /// Cancels any history fetch that is in progress
+    ~HistoryTableModel();
+
     // Header:
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
 
@@ -82,7 +90,10 @@ class HistoryTableModel : public QAbstractTableModel
 
 private:
     /// Callback registered in fetchMore(..) - this handles the result of fetching more history entries
-    void onHistoryFetched(std::vector<URLRecord> &&entries);
+    void onHistoryFetched(HistoryPage &&page);
+
+    /// Called when the favicon of a page has been loaded, updating the icons of the items that link to the page
+    void onPageIconLoaded(const QUrl &pageUrl, const QIcon &icon);
 
 private:
     /// History manager
@@ -91,17 +102,29 @@ class HistoryTableModel : public QAbstractTableModel
     /// Favicon manager
     FaviconManager *m_faviconManager;
 
-    /// Date-time requested from the last call to loadFromDate(..) - when the date is older than 24 hours, it is loaded incrementially
+    /// Date-time requested from the last call to loadFromDate(..) - history is loaded incrementally, one page at a time, up to this date
     QDateTime m_targetDate;
 
-    /// Date of the most recently loaded history item
-    QDateTime m_loadedDate;
+    /// Position of the last visit that has been loaded
+    HistoryCursor m_cursor;
+
+    /// True if there may be more visits to load between the cursor and the target date
+    bool m_hasMore;
+
+    /// Result of the history fetch that is in progress, if any
+    DatabaseFuture<HistoryPage> m_pendingFetch;
+
+    /// True while a page of history is being fetched
+    bool m_isFetching;
 
     /// Common history data
     std::vector<HistoryTableItem> m_commonData;
 
     /// List of visited history items, ordered by most to least recent visit
     std::vector<HistoryTableRow> m_history;
+
+    /// Indices of the items in \ref m_commonData whose favicons have not been loaded, keyed by page URL
+    QHash<QUrl, std::vector<int>> m_itemsWithoutIcon;
 };
 
 #endif // HISTORYTABLEMODEL_H
@@ -53,10 +53,10 @@ struct HistoryEntry final : public sqlite::Row
 
     /// Move constructor
     HistoryEntry(HistoryEntry &&other) noexcept :
-        URL(other.URL),
-        Title(other.Title),
+        URL(std::move(other.URL)),
+        Title(std::move(other.Title)),
         VisitID(other.VisitID),
-        LastVisit(other.LastVisit),
+        LastVisit(std::move(other.LastVisit)),
         NumVisits(other.NumVisits),
         URLTypedCount(other.URLTypedCount)
     {
@@ -85,10 +85,10 @@ struct HistoryEntry final : public sqlite::Row
     {
         if (this != &other)
         {
-            URL = other.URL;
-            Title = other.Title;
+            URL = std::move(other.URL);
+            Title = std::move(other.Title);
             VisitID = other.VisitID;
-            LastVisit = other.LastVisit;
+            LastVisit = std::move(other.LastVisit);
             NumVisits = other.NumVisits;
             URLTypedCount = other.URLTypedCount;
         }
@@ -128,8 +128,6 @@ struct HistoryEntry final : public sqlite::Row
  */
 class URLRecord
 {
-    friend class HistoryManager;
-
 public:
     /// Constructs the URL record given the associated history entry and a list of visits
     explicit URLRecord(HistoryEntry &&entry, std::vector<VisitEntry> &&visits) noexcept;
@@ -169,4 +167,35 @@ class URLRecord
     std::vector<VisitEntry> m_visits;
 };
 
+/**
+ * @struct HistoryCursor
+ * @brief Position of a single visit in the browsing history. Used to page through
+ *        visits from the most to the least recent
+ */
+struct HistoryCursor
+{
+    /// Date of the visit. When invalid, the cursor points before the most recent visit
+    QDateTime Date;
+
+    /// Unique visit ID of the history entry that was visited
+    int VisitID { 0 };
+};
+
+/**
+ * @struct HistoryPage
+ * @brief Contains a page of visits loaded with \ref HistoryManager::getHistoryPage
+ */
+struct HistoryPage
+{
+    /// Records of the pages that were visited, ordered by their most recent visit in the page. The
+    /// visits of each record are limited to those in the page, from the most to the least recent
+    std::vector<URLRecord> Records;
+
+    /// Cursor pointing to the last visit in the page, which is used to request the next page
+    HistoryCursor Next;
+
+    /// True if the page was full, in which case there may be more visits after it
+    bool HasMore { false };
+};
+
 #endif // URLRECORD_H
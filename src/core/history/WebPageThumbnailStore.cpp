@@ -1,6 +1,7 @@
 #include "BookmarkNode.h"
 #include "BookmarkManager.h"
 #include "CommonUtil.h"
+#include "DatabaseTaskScheduler.h"
 #include "FavoritePagesManager.h"
 #include "HistoryManager.h"
 #include "WebPageThumbnailStore.h"
@@ -21,56 +22,76 @@
 
 #include <QDebug>
 
-WebPageThumbnailStore::WebPageThumbnailStore(const ViperServiceLocator &serviceLocator, const QString &databaseFile, QObject *parent) :
+WebPageThumbnailStore::WebPageThumbnailStore(const QString &databaseFile, DatabaseTaskScheduler &taskScheduler, BookmarkManager *bookmarkManager,
+                                             HistoryManager *historyManager, QObject *parent) :
     QObject(parent),
     DatabaseWorker(databaseFile),
     m_timerId(0),
-    m_thumbnails(),
-    m_bookmarkManager(serviceLocator.getServiceAs<BookmarkManager>("BookmarkManager")),
-    m_historyManager(serviceLocator.getServiceAs<HistoryManager>("HistoryManager")),
+    m_taskScheduler(taskScheduler),
+    m_thumbnails(MaxCacheSize),
+    m_dirtyHosts(),
+    m_databaseMutex(),
+    m_pendingWrites(std::make_shared<PendingWrites>()),
+    m_bookmarkManager(bookmarkManager),
+    m_historyManager(historyManager),
     m_mimeDatabase()
 {
     setObjectName(QStringLiteral("WebPageThumbnailStore"));
 
-    // Save thumbnails every 10 minutes
-    using namespace std::chrono_literals;
-    m_timerId = startTimer(10min);
+    m_pendingWrites->Store = this;
+
+    // Save thumbnails every 10 minutes. The timer is started by a queued call, which is delivered in the
+    // thread the store lives in once that thread's event loop runs, as timers cannot be started on a database thread
+    QMetaObject::invokeMethod(this, [this](){
+        using namespace std::chrono_literals;
+        m_timerId = startTimer(10min);
+    }, Qt::QueuedConnection);
 }
 
 WebPageThumbnailStore::~WebPageThumbnailStore()
 {
-    killTimer(m_timerId);
+    if (m_timerId != 0)
+        killTimer(m_timerId);
+
+    // A write task that is still queued finds no store and returns, so its thumbnails are written here
+    std::lock_guard<std::mutex> lock{m_pendingWrites->WriteMutex};
+    writePendingThumbnails();
+    m_pendingWrites->Store = nullptr;
+}
+
+std::vector<ResourceUsage> WebPageThumbnailStore::getResourceUsage() const
+{
+    return {
+        ResourceUsage { QStringLiteral("Page thumbnails"), m_thumbnails.count(), static_cast<qint64>(m_thumbnails.totalSize()) }
+    };
 }
 
 QImage WebPageThumbnailStore::getThumbnail(const QUrl &url)
 {
-    const QString host = url.host().toLower();
-    if (host.isEmpty())
+    const std::string host = url.host().toLower().toStdString();
+    if (host.empty())
         return QImage();
 
     // First, check in-memory storage. Then check the database for a thumbnail.
-    auto it = m_thumbnails.find(host);
-    if (it != m_thumbnails.end())
-        return it.value();
+    if (m_thumbnails.has(host))
+        return m_thumbnails.get(host);
 
-    auto stmt = m_database.prepare(R"(SELECT Thumbnail FROM Thumbnails WHERE Host = ?)");
-    stmt << host;
-    if (stmt.next())
+    QByteArray data;
     {
-        QByteArray data;
-        stmt >> data;
-        QByteArray decoded = QByteArray::fromBase64(data);
-
-        QBuffer buffer(&decoded);
-        QImage image;
-        image.load(&buffer, "PNG");
+        std::lock_guard<std::mutex> lock{m_databaseMutex};
+        auto stmt = m_database.prepare(R"(SELECT Thumbnail FROM Thumbnails WHERE Host = ?)");
+        stmt << host;
+        if (!stmt.next())
+            return QImage();
 
-        m_thumbnails.insert(host, image);
-
-        return image;
+        stmt >> data;
     }
 
-    return QImage();
+    const QImage image = QImage::fromData(data);
+    if (!image.isNull())
+        cacheThumbnail(host, image);
+
+    return image;
 }
 
 void WebPageThumbnailStore::onPageLoaded(bool ok)
@@ -120,20 +141,141 @@ void WebPageThumbnailStore::onPageLoaded(bool ok)
             if (pixmap.isNull())
                 return;
 
-            const QImage image = pixmap.toImage();
+            const QImage image = scaleThumbnail(pixmap.toImage());
             if (image.allGray())
                 return;
 
             for (const QUrl &url : urls)
             {
-                const QString host = url.host().toLower();
-                if (!host.isEmpty())
-                    m_thumbnails.insert(host, image);
+                const std::string host = url.host().toLower().toStdString();
+                if (host.empty())
+                    continue;
+
+                cacheThumbnail(host, image);
+                m_dirtyHosts.insert(host);
             }
         }
     });
 }
 
+void WebPageThumbnailStore::migrateThumbnailsToBinary()
+{
+    if (!m_database.beginTransaction())
+        qWarning() << "WebPageThumbnailStore - could not begin transaction";
+
+    std::vector<std::pair<int, QByteArray>> thumbnails;
+    auto query = m_database.prepare(R"(SELECT Id, Thumbnail FROM Thumbnails)");
+    while (query.next())
+    {
+        int id = 0;
+        QByteArray data;
+        query >> id
+              >> data;
+        thumbnails.emplace_back(id, data);
+    }
+
+    auto updateStmt = m_database.prepare(R"(UPDATE Thumbnails SET Thumbnail = ? WHERE Id = ?)");
+    auto deleteStmt = m_database.prepare(R"(DELETE FROM Thumbnails WHERE Id = ?)");
+    for (const auto &thumbnail : thumbnails)
+    {
+        QImage image;
+        image.loadFromData(QByteArray::fromBase64(thumbnail.second), "PNG");
+
+        // Thumbnails that cannot be decoded are removed, and will be replaced the next time the page is visited
+        sqlite::PreparedStatement &stmt = image.isNull() ? deleteStmt : updateStmt;
+        stmt.reset();
+        if (!image.isNull())
+            stmt << encodeThumbnail(image);
+        stmt << thumbnail.first;
+
+        if (!stmt.execute())
+            qWarning() << "WebPageThumbnailStore - could not migrate thumbnail.";
+    }
+
+    if (!setSchemaVersion(1))
+        qWarning() << "WebPageThumbnailStore - could not update schema version";
+
+    if (!m_database.commitTransaction())
+    {
+        qWarning() << "WebPageThumbnailStore - could not commit transaction";
+        m_database.rollbackTransaction();
+    }
+}
+
+QByteArray WebPageThumbnailStore::encodeThumbnail(const QImage &image)
+{
+    QByteArray data;
+    {
+        QBuffer buffer(&data);
+        if (image.convertToFormat(QImage::Format_RGB32).save(&buffer, "JPG", 85))
+            return data;
+    }
+
+    // Fall back to lossless compression if the JPEG image plugin is not available
+    data.clear();
+    QBuffer buffer(&data);
+    image.save(&buffer, "PNG");
+    return data;
+}
+
+QImage WebPageThumbnailStore::scaleThumbnail(const QImage &image)
+{
+    // The new tab page stretches each thumbnail to fill its tile, so the aspect ratio is not kept
+    QImage thumbnail = image.convertToFormat(QImage::Format_RGB32);
+    if (thumbnail.width() > ThumbnailWidth || thumbnail.height() > ThumbnailHeight)
+        thumbnail = thumbnail.scaled(ThumbnailWidth, ThumbnailHeight, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    return thumbnail;
+}
+
+void WebPageThumbnailStore::cacheThumbnail(const std::string &host, const QImage &image)
+{
+    m_thumbnails.put(host, image, static_cast<std::size_t>(image.sizeInBytes()));
+}
+
+void WebPageThumbnailStore::writePendingThumbnails()
+{
+    std::vector<std::pair<std::string, QImage>> thumbnails;
+    {
+        std::lock_guard<std::mutex> lock{m_pendingWrites->Mutex};
+        thumbnails.swap(m_pendingWrites->Thumbnails);
+    }
+
+    if (!thumbnails.empty())
+        writeThumbnails(thumbnails);
+}
+
+void WebPageThumbnailStore::writeThumbnails(const std::vector<std::pair<std::string, QImage>> &thumbnails)
+{
+    // Encode the thumbnails before locking the database, so that the GUI thread is not kept
+    // waiting on the database while the images are compressed
+    std::vector<std::pair<std::string, QByteArray>> encodedThumbnails;
+    encodedThumbnails.reserve(thumbnails.size());
+    for (const auto &thumbnail : thumbnails)
+        encodedThumbnails.emplace_back(thumbnail.first, encodeThumbnail(thumbnail.second));
+
+    std::lock_guard<std::mutex> lock{m_databaseMutex};
+
+    if (!m_database.beginTransaction())
+        qWarning() << "WebPageThumbnailStore - could not begin transaction";
+
+    auto stmt = m_database.prepare(R"(INSERT OR REPLACE INTO Thumbnails(Host, Thumbnail) VALUES (?, ?))");
+    for (const auto &thumbnail : encodedThumbnails)
+    {
+        stmt.reset();
+        stmt << thumbnail.first
+             << thumbnail.second;
+
+        if (!stmt.execute())
+            qWarning() << "WebPageThumbnailStore - could not save thumbnail to database.";
+    }
+
+    if (!m_database.commitTransaction())
+    {
+        qWarning() << "WebPageThumbnailStore - could not commit transaction";
+        m_database.rollbackTransaction();
+    }
+}
+
 void WebPageThumbnailStore::timerEvent(QTimerEvent *event)
 {
     if (event->timerId() == m_timerId)
@@ -161,6 +303,10 @@ void WebPageThumbnailStore::setup()
 
 void WebPageThumbnailStore::load()
 {
+    // Thumbnails used to be stored as base64-encoded PNG images
+    if (getSchemaVersion() < 1)
+        migrateThumbnailsToBinary();
+
     // load only when needed, not during instantiation
 }
 
@@ -177,40 +323,62 @@ void WebPageThumbnailStore::onMostVisitedPagesLoaded(std::vector<WebPageInformat
     }
 
     // Load all bookmarks into set
-    for (auto it : *m_bookmarkManager)
+    if (m_bookmarkManager)
     {
-        if (it->getType() == BookmarkNode::Bookmark)
+        const BookmarkManager::Snapshot bookmarks = m_bookmarkManager->getSnapshot();
+        for (auto it : *bookmarks)
         {
-            const std::string host = it->getURL().host().toLower().toStdString();
-            if (!host.empty())
-                mostVisitedHosts.insert(host);
+            if (it->getType() == BookmarkNode::Bookmark)
+            {
+                const std::string host = it->getURL().host().toLower().toStdString();
+                if (!host.empty())
+                    mostVisitedHosts.insert(host);
+            }
         }
     }
 
-    // Save applicable thumbnails
-    auto stmt = m_database.prepare(R"(INSERT OR REPLACE INTO Thumbnails(Host, Thumbnail) VALUES (?, ?))");
-
-    for (auto it = m_thumbnails.begin(); it != m_thumbnails.end(); ++it)
+    // Collect the applicable thumbnails that have changed since the last save. Thumbnails of hosts that are
+    // not yet applicable stay marked, in case the host is bookmarked or visited more often before the next save
+    std::vector<std::pair<std::string, QImage>> thumbnails;
+    for (auto it = m_dirtyHosts.begin(); it != m_dirtyHosts.end();)
     {
-        const std::string host = it.key().toStdString();
-        if (mostVisitedHosts.find(host) == mostVisitedHosts.end())
+        const std::string &host = *it;
+        if (!m_thumbnails.has(host))
+        {
+            it = m_dirtyHosts.erase(it);
             continue;
+        }
 
-        const QImage &image = it.value();
-        if (image.isNull())
+        if (mostVisitedHosts.find(host) == mostVisitedHosts.end())
+        {
+            ++it;
             continue;
+        }
 
-        QByteArray data;
-        QBuffer buffer(&data);
-        image.save(&buffer, "PNG");
+        thumbnails.emplace_back(host, m_thumbnails.get(host));
+        it = m_dirtyHosts.erase(it);
+    }
 
-        data = data.toBase64();
-        stmt << host
-             << data;
+    if (thumbnails.empty())
+        return;
 
-        if (!stmt.execute())
-            qWarning() << "WebPageThumbnailStore - could not save thumbnail to database.";
+    // A write task is only posted when the list was empty, otherwise the queued task also writes these thumbnails
+    bool isWritePending = false;
+    {
+        std::lock_guard<std::mutex> lock{m_pendingWrites->Mutex};
+        isWritePending = !m_pendingWrites->Thumbnails.empty();
+        for (auto &thumbnail : thumbnails)
+            m_pendingWrites->Thumbnails.push_back(std::move(thumbnail));
     }
+
+    if (isWritePending)
+        return;
+
+    m_taskScheduler.post(DatabaseTaskPriority::Background, "WebPageThumbnailStore", [pendingWrites = m_pendingWrites](){
+        std::lock_guard<std::mutex> lock{pendingWrites->WriteMutex};
+        if (pendingWrites->Store)
+            pendingWrites->Store->writePendingThumbnails();
+    });
 }
 
 void WebPageThumbnailStore::save()
@@ -218,9 +386,11 @@ void WebPageThumbnailStore::save()
     // iterate through the in-memory collection, and if any of the hostnames of a page's thumbnail
     // is (1) in the top 100 most visited web pages (see HistoryManager), or (2) is favorited by
     // the user, or (3) is bookmarked, then save to the DB
-    if (!m_historyManager || !m_bookmarkManager)
+    if (!m_historyManager || !m_bookmarkManager || m_dirtyHosts.empty())
         return;
 
-    int historyLimit = std::min(static_cast<int>(m_thumbnails.size()), 100);
-    m_historyManager->loadMostVisitedEntries(historyLimit, std::bind(&WebPageThumbnailStore::onMostVisitedPagesLoaded, this, std::placeholders::_1));
+    int historyLimit = std::min(static_cast<int>(m_thumbnails.count()), 100);
+    m_historyManager->loadMostVisitedEntries(historyLimit).then(this, [this](std::vector<WebPageInformation> &&results){
+        onMostVisitedPagesLoaded(std::move(results));
+    });
 }
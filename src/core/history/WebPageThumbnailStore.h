@@ -3,11 +3,16 @@
 
 #include "DatabaseWorker.h"
 #include "HistoryManager.h"
-#include "ServiceLocator.h"
-
+#include "IResourceReporter.h"
+#include "SizedLRUCache.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
-#include <QHash>
 #include <QImage>
 #include <QMimeDatabase>
 #include <QObject>
@@ -16,6 +21,7 @@
 #include <QUrl>
 
 class BookmarkManager;
+class DatabaseTaskScheduler;
 class HistoryManager;
 
 /**
@@ -23,21 +29,34 @@ class HistoryManager;
  * @brief A data store that contains thumbnails of web pages that are
  *        either commonly visited, bookmarked or otherwise favorited by
  *        the user.
+ *
+ *        Thumbnails are downscaled to the size of a tile on the new tab page when they are captured, and
+ *        kept in a cache that is bounded by the number of bytes used by its images. Thumbnails that were
+ *        captured since the last save are encoded and written to the database on the store's database
+ *        strand, in a single transaction. Thumbnails that are still waiting for the strand when the store is
+ *        destroyed are written by the destructor.
  */
-class WebPageThumbnailStore : public QObject, private DatabaseWorker
+class WebPageThumbnailStore : public QObject, public IResourceReporter, private DatabaseWorker
 {
     friend class BrowserApplication;
     friend class DatabaseFactory;
+    friend class WebPageThumbnailStoreTest;
 
     Q_OBJECT
 
 public:
-    /// Constructs the thumbnail storage manager, given a reference to the service locator, the path to the database file and an optional parent object
-    explicit WebPageThumbnailStore(const ViperServiceLocator &serviceLocator, const QString &databaseFile, QObject *parent = nullptr);
+    /// Constructs the thumbnail storage manager, given the path to the database file, the task scheduler that runs the
+    /// store's database strand, the bookmark and history managers, and an optional parent object. The store may be
+    /// constructed on its database strand and then moved to the GUI thread
+    WebPageThumbnailStore(const QString &databaseFile, DatabaseTaskScheduler &taskScheduler, BookmarkManager *bookmarkManager,
+                          HistoryManager *historyManager, QObject *parent = nullptr);
 
-    /// Destructor
+    /// Writes any thumbnails that are waiting for the database strand, after waiting for a write in progress to finish
     ~WebPageThumbnailStore();
 
+    /// Returns the memory held by the thumbnail cache
+    std::vector<ResourceUsage> getResourceUsage() const override;
+
     /// Attempts to find a thumbnail associated with the given URL, returning said thumbnail
     /// as a QImage if found, or returning a null pixmap if it could not be found.
     QImage getThumbnail(const QUrl &url);
@@ -57,8 +76,8 @@ public Q_SLOTS:
     /// Creates the table structure if it has not already been created
     void setup() override;
 
-    /// This would load thumbnails from the database into memory, but instead
-    /// the thumbnails are loaded as needed and so this does nothing
+    /// This would load thumbnails from the database into memory, but instead the thumbnails
+    /// are loaded as needed, and so this only migrates thumbnails stored in an older format
     void load() override;
 
 private:
@@ -66,15 +85,74 @@ public Q_SLOTS:
     /// visited web pages
     void onMostVisitedPagesLoaded(std::vector<WebPageInformation> &&results);
 
-    /// Saves thumbnails of web pages into the database
+    /// Saves thumbnails of web pages that have changed since the last save into the database
     void save();
 
+    /// Writes the thumbnails that are waiting in \ref m_pendingWrites to the database. Called on the store's
+    /// database strand, or by the destructor, with the write mutex held
+    void writePendingThumbnails();
+
+    /// Encodes the given thumbnails and writes them to the database in a single transaction
+    void writeThumbnails(const std::vector<std::pair<std::string, QImage>> &thumbnails);
+
+    /// Places the given thumbnail of a host into the cache
+    void cacheThumbnail(const std::string &host, const QImage &image);
+
+    /// Converts thumbnails stored as base64-encoded PNG images into the format of \ref encodeThumbnail
+    void migrateThumbnailsToBinary();
+
+    /// Returns the binary encoding of the given thumbnail, as it is stored in the database. Thumbnails are
+    /// compressed as JPEG images, since they are opaque and only shown at a small size
+    static QByteArray encodeThumbnail(const QImage &image);
+
+    /// Returns a copy of the given capture of a web page, scaled to the size of a thumbnail
+    static QImage scaleThumbnail(const QImage &image);
+
 private:
+    /// Thumbnails waiting to be written to the database. Shared with the tasks posted to the database strand, which
+    /// may run after the store has been destroyed
+    struct PendingWrites
+    {
+        /// Held while thumbnails are written, so the store is not destroyed during a write
+        std::mutex WriteMutex;
+
+        /// Store that writes the thumbnails, or a nullptr once it has been destroyed. Guarded by the write mutex
+        WebPageThumbnailStore *Store { nullptr };
+
+        /// Guards the list of thumbnails
+        std::mutex Mutex;
+
+        /// Hosts and thumbnails that have not been written yet
+        std::vector<std::pair<std::string, QImage>> Thumbnails;
+    };
+
+    /// Width of a thumbnail, which is twice the width of a tile on the new tab page so that it remains sharp on high-DPI screens
+    static constexpr int ThumbnailWidth = 400;
+
+    /// Height of a thumbnail, which is twice the height of a tile on the new tab page
+    static constexpr int ThumbnailHeight = 360;
+
+    /// Maximum number of bytes used by the thumbnails in memory
+    static constexpr std::size_t MaxCacheSize = 16 * 1024 * 1024;
+
     /// Identifier of the timer that is periodically invoked to call the save() method
     int m_timerId;
 
-    /// Hashmap of web hostnames to their corresponding thumbnails
-    QHash<QString, QImage> m_thumbnails;
+    /// Task scheduler that runs the store's database strand, where thumbnails are written to the database
+    DatabaseTaskScheduler &m_taskScheduler;
+
+    /// Cache of web hostnames to their corresponding thumbnails, bounded by the size of the images in bytes
+    SizedLRUCache<std::string, QImage> m_thumbnails;
+
+    /// Hostnames whose thumbnails have been captured since they were last saved. A thumbnail that is
+    /// evicted from the cache before it is saved is dropped, and captured again on the next visit
+    std::unordered_set<std::string> m_dirtyHosts;
+
+    /// Guards the database connection, which is read on the GUI thread and written to on the database strand
+    std::mutex m_databaseMutex;
+
+    /// Thumbnails waiting to be written on the database strand
+    std::shared_ptr<PendingWrites> m_pendingWrites;
 
     /// Pointer to the \ref BookmarkManager
     BookmarkManager *m_bookmarkManager;
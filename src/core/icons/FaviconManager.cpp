@@ -2,30 +2,157 @@
 #include "DatabaseFactory.h"
 #include "FaviconManager.h"
 #include "NetworkAccessManager.h"
+#include "TraceLog.h"
 #include "URL.h"
 
 #include <functional>
 #include <stdexcept>
+#include <utility>
 
 #include <QBuffer>
 #include <QDebug>
 #include <QFileInfo>
+#include <QFutureWatcher>
+#include <QIconEngine>
 #include <QNetworkRequest>
 #include <QNetworkReply>
 #include <QPainter>
+#include <QPixmap>
 #include <QSvgRenderer>
+#include <QThread>
 #include <QtConcurrent>
 
-FaviconManager::FaviconManager(const QString &databaseFile) :
+namespace
+{
+    /// Icon engine that holds the decoded images of a favicon, so the icon can be built on any thread.
+    /// Pixmaps are only created from the images when the icon is first drawn, which happens on the GUI thread
+    class FaviconImageEngine : public QIconEngine
+    {
+    public:
+        /// Constructs the engine with the images of the icon
+        explicit FaviconImageEngine(const QList<QImage> &images) :
+            QIconEngine(),
+            m_images(images),
+            m_pixmaps()
+        {
+        }
+
+        /// Draws the icon into the given rectangle
+        void paint(QPainter *painter, const QRect &rect, QIcon::Mode mode, QIcon::State state) override
+        {
+            painter->drawPixmap(rect, pixmap(rect.size(), mode, state));
+        }
+
+        /// Returns a pixmap of the icon at the given size, created from the closest image
+        QPixmap pixmap(const QSize &size, QIcon::Mode mode, QIcon::State state) override
+        {
+            Q_UNUSED(mode);
+            Q_UNUSED(state);
+
+            if (m_images.isEmpty())
+                return QPixmap();
+
+            if (m_pixmaps.isEmpty())
+            {
+                for (const QImage &image : qAsConst(m_images))
+                    m_pixmaps.append(QPixmap::fromImage(image));
+            }
+
+            // Use the smallest pixmap that covers the requested size, or the largest pixmap if none do
+            const QPixmap *best = &m_pixmaps.constLast();
+            for (const QPixmap &pixmap : qAsConst(m_pixmaps))
+            {
+                if (pixmap.width() >= size.width() && pixmap.height() >= size.height()
+                        && pixmap.width() < best->width())
+                    best = &pixmap;
+            }
+
+            if (best->size() == size)
+                return *best;
+            return best->scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+
+        /// Returns the sizes of the images
+        QList<QSize> availableSizes(QIcon::Mode mode, QIcon::State state) override
+        {
+            Q_UNUSED(mode);
+            Q_UNUSED(state);
+
+            QList<QSize> sizes;
+            for (const QImage &image : qAsConst(m_images))
+                sizes.append(image.size());
+            return sizes;
+        }
+
+        /// Returns a copy of the engine
+        QIconEngine *clone() const override
+        {
+            return new FaviconImageEngine(m_images);
+        }
+
+    private:
+        /// Decoded images of the icon, in order of increasing size
+        QList<QImage> m_images;
+
+        /// Pixmaps created from the images when the icon is first drawn
+        QList<QPixmap> m_pixmaps;
+    };
+}
+
+FaviconManager::FaviconManager(DatabaseTaskScheduler &taskScheduler, const QString &databaseFile) :
     QObject(nullptr),
+    m_taskScheduler(taskScheduler),
     m_faviconStore(nullptr),
+    m_isStoreReady(false),
+    m_pendingUpdates(),
     m_networkAccessManager(nullptr),
-    m_iconMap(),
+    m_pendingFetches(),
+    m_pendingLookups(),
+    m_iconMap(4 * 1024 * 1024),
     m_iconCache(64),
     m_mutex()
 {
+    VIPER_TRACE_SCOPE("startup", "FaviconManager");
+
     setObjectName(QStringLiteral("FaviconManager"));
-    m_faviconStore = DatabaseFactory::createWorker<FaviconStore>(databaseFile);
+
+    // Loading the store reads every favicon from the database, which would otherwise delay the first window
+    auto storeFuture = taskScheduler.postTask("FaviconStore", [databaseFile](){
+        return DatabaseFactory::createWorker<FaviconStore>(databaseFile);
+    }, DatabaseTaskPriority::Interactive);
+    storeFuture.then(this, [this](std::unique_ptr<FaviconStore> &&faviconStore){
+        onStoreLoaded(std::move(faviconStore));
+    });
+}
+
+bool FaviconManager::isReady() const
+{
+    return m_isStoreReady.load(std::memory_order_acquire);
+}
+
+std::vector<ResourceUsage> FaviconManager::getResourceUsage() const
+{
+    std::lock_guard<std::mutex> _(m_mutex);
+    return {
+        ResourceUsage { QStringLiteral("Favicons"), m_iconMap.count(), static_cast<qint64>(m_iconMap.totalSize()) },
+        ResourceUsage { QStringLiteral("Favicon URL cache"), m_iconCache.size(), -1 }
+    };
+}
+
+void FaviconManager::onStoreLoaded(std::unique_ptr<FaviconStore> &&faviconStore)
+{
+    if (!faviconStore)
+        return;
+
+    m_faviconStore = std::move(faviconStore);
+    m_isStoreReady.store(true, std::memory_order_release);
+
+    std::vector<PendingIconUpdate> pendingUpdates;
+    pendingUpdates.swap(m_pendingUpdates);
+    for (const PendingIconUpdate &update : pendingUpdates)
+        updateIcon(update.iconUrl, update.pageUrl, update.icon);
+
+    emit storeReady();
 }
 
 void FaviconManager::setNetworkAccessManager(NetworkAccessManager *networkAccessManager)
@@ -36,7 +163,7 @@ void FaviconManager::setNetworkAccessManager(NetworkAccessManager *networkAccess
 QIcon FaviconManager::getFavicon(const QUrl &url)
 {
     QString pageUrl = getUrlAsString(url);
-    if (!m_faviconStore || pageUrl.isEmpty())
+    if (!isReady() || pageUrl.isEmpty())
         return QIcon(QStringLiteral(":/blank_favicon.png"));
 
     const std::string urlStdStr = pageUrl.toStdString();
@@ -44,6 +171,7 @@ QIcon FaviconManager::getFavicon(const QUrl &url)
     // Check for cache hit
     try
     {
+        std::lock_guard<std::mutex> _(m_mutex);
         if (m_iconCache.has(urlStdStr))
         {
             return m_iconCache.get(urlStdStr);
@@ -54,56 +182,85 @@ QIcon FaviconManager::getFavicon(const QUrl &url)
         qDebug() << "FaviconManager::getFavicon - caught error while fetching icon from cache. Error: " << err.what();
     }
 
+    if (QThread::currentThread() == thread())
+    {
+        lookupFavicon(url, pageUrl);
+        return QIcon(QStringLiteral(":/blank_favicon.png"));
+    }
+
     int iconId = m_faviconStore->getFaviconId(url);
     if (iconId < 0)
         return QIcon(QStringLiteral(":/blank_favicon.png"));
 
-    auto it = m_iconMap.find(iconId);
-    if (it == m_iconMap.end())
-    {
-        auto &record = m_faviconStore->getDataRecord(iconId);
-        if (record.iconData.isEmpty())
-            return QIcon(QStringLiteral(":/blank_favicon.png"));
-
-        QIcon icon = CommonUtil::iconFromBase64(record.iconData);
-        auto result = m_iconMap.emplace(std::make_pair(iconId, icon));
-        if (result.second)
-            it = result.first;
-        else
-            return icon;
-    }
+    QIcon icon = getCachedIcon(iconId);
+    if (icon.isNull())
+        icon = loadFaviconById(iconId);
+    if (icon.isNull())
+        return QIcon(QStringLiteral(":/blank_favicon.png"));
 
     try
     {
         std::lock_guard<std::mutex> _(m_mutex);
-        m_iconCache.put(urlStdStr, it->second);
+        m_iconCache.put(urlStdStr, icon);
     }
     catch (std::out_of_range &err)
     {
         qDebug() << "FaviconManager::getFavicon - caught error while updating icon cache. Error: " << err.what();
     }
 
-    return it->second;
+    return icon;
+}
+
+int FaviconManager::getFaviconId(const QUrl &url)
+{
+    if (!isReady() || getUrlAsString(url).isEmpty())
+        return -1;
+
+    return m_faviconStore->getFaviconId(url);
+}
+
+QIcon FaviconManager::getFaviconById(int iconId)
+{
+    if (!isReady() || iconId < 0)
+        return QIcon();
+
+    QIcon icon = getCachedIcon(iconId);
+    if (icon.isNull() && QThread::currentThread() != thread())
+        icon = loadFaviconById(iconId);
+
+    return icon;
+}
+
+QUrl FaviconManager::getPageKey(const QUrl &url)
+{
+    return url.adjusted(QUrl::RemoveUserInfo | QUrl::RemoveQuery | QUrl::RemoveFragment);
 }
 
 void FaviconManager::updateIcon(const QUrl &iconUrl, const QUrl &pageUrl, const QIcon &pageIcon)
 {
-    if (!m_faviconStore
-            || iconUrl.isEmpty()
+    if (iconUrl.isEmpty()
             || iconUrl.scheme().startsWith(QStringLiteral("data")))
         return;
 
+    if (!isReady())
+    {
+        m_pendingUpdates.push_back(PendingIconUpdate { iconUrl, pageUrl, pageIcon });
+        return;
+    }
+
     const QString pageUrlStr = getUrlAsString(pageUrl);
     const std::string urlStdStr = pageUrlStr.toStdString();
 
-    QByteArray pageIconData = CommonUtil::iconToBase64(pageIcon);
+    // Pixmaps can only be used on the GUI thread, the image is encoded and saved on the database thread
+    const QImage pageImage = pageIcon.isNull() ? QImage() : pageIcon.pixmap(32, 32).toImage();
 
-    if (!pageIconData.isEmpty() && m_iconCache.has(urlStdStr))
+    if (!pageImage.isNull())
     {
         try
         {
             std::lock_guard<std::mutex> _(m_mutex);
-            m_iconCache.put(urlStdStr, pageIcon);
+            if (m_iconCache.has(urlStdStr))
+                m_iconCache.put(urlStdStr, pageIcon);
         }
         catch (std::out_of_range &err)
         {
@@ -111,56 +268,160 @@ void FaviconManager::updateIcon(const QUrl &iconUrl, const QUrl &pageUrl, const
         }
     }
 
-    const int iconId = m_faviconStore->getFaviconIdForIconUrl(iconUrl);
-    FaviconData &dataRecord = m_faviconStore->getDataRecord(iconId);
-    if (dataRecord.iconData.isEmpty() || !pageIconData.isEmpty())
-        dataRecord.iconData = pageIconData;
+    std::shared_ptr<FaviconStore> faviconStore = m_faviconStore;
+    auto saveFuture = m_taskScheduler.postTask("FaviconStore", [faviconStore, iconUrl, pageUrl, pageImage](){
+        const int iconId = faviconStore->getFaviconIdForIconUrl(iconUrl);
+        FaviconData dataRecord = faviconStore->getDataRecord(iconId);
 
-    // add page url -> icon mapping to favicon store
-    m_faviconStore->addPageMapping(pageUrl, iconId);
+        // add page url -> icon mapping to favicon store
+        faviconStore->addPageMapping(pageUrl, iconId);
 
-    if (!dataRecord.iconData.isEmpty())
-    {
-        m_faviconStore->saveDataRecord(dataRecord);
+        if (!pageImage.isNull())
+        {
+            dataRecord.iconData = CommonUtil::iconImageToBinary(pageImage);
+            faviconStore->saveDataRecord(dataRecord);
+        }
 
-        QIcon icon = CommonUtil::iconFromBase64(dataRecord.iconData);
-        auto it = m_iconMap.find(iconId);
-        if (it != m_iconMap.end())
-            it->second = icon;
-        else
-            m_iconMap.emplace(std::make_pair(iconId, icon));
+        return std::make_pair(iconId, !dataRecord.iconData.isEmpty());
+    });
+    saveFuture.then(this, [this, iconUrl, pageIcon](std::pair<int, bool> &&result){
+        if (!pageIcon.isNull())
+            cacheIcon(result.first, pageIcon);
+        else if (!result.second)
+            fetchIcon(iconUrl);
+    });
+}
 
+void FaviconManager::lookupFavicon(const QUrl &url, const QString &pageUrl)
+{
+    if (m_pendingLookups.contains(pageUrl))
         return;
-    }
 
+    m_pendingLookups.insert(pageUrl);
+
+    std::shared_ptr<FaviconStore> faviconStore = m_faviconStore;
+    auto lookupFuture = m_taskScheduler.postTask("FaviconStore", [faviconStore, url](){
+        const int iconId = faviconStore->getFaviconId(url);
+        if (iconId < 0)
+            return std::make_pair(iconId, QByteArray());
+
+        return std::make_pair(iconId, faviconStore->getIconData(iconId));
+    }, DatabaseTaskPriority::Interactive);
+    lookupFuture.then(this, [this, pageUrl, pageKey = getPageKey(url)](std::pair<int, QByteArray> &&result){
+        m_pendingLookups.remove(pageUrl);
+
+        if (result.first < 0)
+            return;
+
+        QIcon icon = getCachedIcon(result.first);
+        if (icon.isNull() && !result.second.isEmpty())
+        {
+            icon = CommonUtil::iconFromBinary(result.second);
+            cacheIcon(result.first, icon);
+        }
+
+        if (icon.isNull())
+            return;
+
+        try
+        {
+            std::lock_guard<std::mutex> _(m_mutex);
+            m_iconCache.put(pageUrl.toStdString(), icon);
+        }
+        catch (std::out_of_range &err)
+        {
+            qDebug() << "FaviconManager::lookupFavicon - caught error while updating icon cache. Error: " << err.what();
+        }
+
+        emit pageIconLoaded(pageKey, icon);
+    });
+}
+
+QIcon FaviconManager::loadFaviconById(int iconId)
+{
+    // Icons are read from the database and decoded when they are first needed. This is called off the GUI thread,
+    // so the icon is built from the decoded images, and its pixmaps are created once it is drawn
+    const QList<QImage> images = CommonUtil::iconImagesFromBinary(m_faviconStore->getIconData(iconId));
+    if (images.isEmpty())
+        return QIcon();
+
+    QIcon icon(new FaviconImageEngine(images));
+    cacheIcon(iconId, icon);
+    return icon;
+}
+
+void FaviconManager::fetchIcon(const QUrl &iconUrl)
+{
     if (!m_networkAccessManager)
         return;
 
+    // Pages that share an icon request it at the same time, only the first request is sent
+    if (m_pendingFetches.contains(iconUrl))
+        return;
+
+    m_pendingFetches.insert(iconUrl);
+
     QNetworkRequest request(iconUrl);
     QNetworkReply *reply = m_networkAccessManager->get(request);
     if (reply->isFinished())
-        onReplyFinished(reply);
+        onReplyFinished(iconUrl, reply);
     else
     {
-        connect(reply, &QNetworkReply::finished, this, [this, reply](){
-            onReplyFinished(reply);
+        connect(reply, &QNetworkReply::finished, this, [this, iconUrl, reply](){
+            onReplyFinished(iconUrl, reply);
         });
     }
 }
 
-void FaviconManager::onReplyFinished(QNetworkReply *reply)
+void FaviconManager::onReplyFinished(const QUrl &iconUrl, QNetworkReply *reply)
 {
-    QString format = QFileInfo(getUrlAsString(reply->url())).suffix();
-    QByteArray data = reply->readAll();
+    const QString format = QFileInfo(getUrlAsString(reply->url())).suffix();
+    const QByteArray data = reply->readAll();
+    reply->deleteLater();
+
     if (data.isNull())
     {
-        reply->deleteLater();
+        m_pendingFetches.remove(iconUrl);
         return;
     }
 
-    QImage img;
-    bool success = false;
+    QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, iconUrl, format, watcher](){
+        onIconDecoded(iconUrl, watcher->result(), format);
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run(&FaviconManager::decodeIcon, data, format));
+}
+
+void FaviconManager::onIconDecoded(const QUrl &iconUrl, const QImage &image, const QString &format)
+{
+    m_pendingFetches.remove(iconUrl);
+
+    if (image.isNull())
+    {
+        qDebug() << "FaviconManager::onReplyFinished - failed to load image from response. Format was " << format;
+        return;
+    }
 
+    const QIcon icon(QPixmap::fromImage(image));
+
+    std::shared_ptr<FaviconStore> faviconStore = m_faviconStore;
+    auto saveFuture = m_taskScheduler.postTask("FaviconStore", [faviconStore, iconUrl, image](){
+        const int iconId = faviconStore->getFaviconIdForIconUrl(iconUrl);
+        FaviconData record = faviconStore->getDataRecord(iconId);
+        record.iconData = CommonUtil::iconImageToBinary(image);
+
+        faviconStore->saveDataRecord(record);
+        return iconId;
+    });
+    saveFuture.then(this, [this, iconUrl, icon](int &&iconId){
+        cacheIcon(iconId, icon);
+        emit faviconLoaded(iconUrl, icon);
+    });
+}
+
+QImage FaviconManager::decodeIcon(QByteArray data, QString format)
+{
     // Handle compressed data
     if (format.compare(QStringLiteral("gzip")) == 0)
     {
@@ -168,45 +429,67 @@ void FaviconManager::onReplyFinished(QNetworkReply *reply)
         format.clear();
     }
 
+    QImage img;
+
     // Handle SVG favicons
     if (format.compare(QStringLiteral("svg")) == 0)
     {
         QSvgRenderer svgRenderer(data);
+        if (!svgRenderer.isValid())
+            return QImage();
+
         img = QImage(32, 32, QImage::Format_ARGB32);
+        img.fill(Qt::transparent);
         QPainter painter(&img);
         svgRenderer.render(&painter);
-        success = !img.isNull();
-    }
-    // Default handler
-    else
-    {
-        QBuffer buffer(&data);
-        const std::string imageFormat = format.isEmpty() ? R"()" : format.toStdString();
-        success = img.load(&buffer, imageFormat.c_str());
+        return img;
     }
 
-    if (success)
-    {
-        QIcon icon(QPixmap::fromImage(img));
-        const int iconId = m_faviconStore->getFaviconIdForIconUrl(reply->url());
-        FaviconData &record = m_faviconStore->getDataRecord(iconId);
-        record.iconData = CommonUtil::iconToBase64(icon);
-
-        m_faviconStore->saveDataRecord(record);
-
-        auto it = m_iconMap.find(iconId);
-        if (it != m_iconMap.end())
-            it->second = icon;
-        else
-            m_iconMap.emplace(std::make_pair(iconId, icon));
-    }
-    else
-        qDebug() << "FaviconManager::onReplyFinished - failed to load image from response. Format was " << format;
+    // Default handler
+    QBuffer buffer(&data);
+    const std::string imageFormat = format.isEmpty() ? R"()" : format.toStdString();
+    if (!img.load(&buffer, imageFormat.c_str()))
+        return QImage();
 
-    reply->deleteLater();
+    return img;
 }
 
 QString FaviconManager::getUrlAsString(const QUrl &url) const
 {
-    return url.toString(QUrl::RemoveUserInfo | QUrl::RemoveQuery | QUrl::RemoveFragment);
+    return getPageKey(url).toString();
+}
+
+QIcon FaviconManager::getCachedIcon(int iconId)
+{
+    std::lock_guard<std::mutex> _(m_mutex);
+    if (m_iconMap.has(iconId))
+        return m_iconMap.get(iconId);
+
+    return QIcon();
+}
+
+void FaviconManager::cacheIcon(int iconId, const QIcon &icon)
+{
+    if (icon.isNull())
+        return;
+
+    const std::size_t iconSize = getIconSize(icon);
+
+    std::lock_guard<std::mutex> _(m_mutex);
+    m_iconMap.put(iconId, icon, iconSize);
+}
+
+std::size_t FaviconManager::getIconSize(const QIcon &icon)
+{
+    // Each pixmap is stored with 32 bits per pixel
+    std::size_t size = 0;
+    const QList<QSize> sizes = icon.availableSizes();
+    for (const QSize &pixmapSize : sizes)
+        size += static_cast<std::size_t>(pixmapSize.width()) * static_cast<std::size_t>(pixmapSize.height()) * 4;
+
+    // Icons without a fixed size, such as those rendered from SVG data, are counted as a 32x32 pixmap
+    if (size == 0)
+        size = 32 * 32 * 4;
+
+    return size;
 }
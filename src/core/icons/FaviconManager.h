@@ -5,15 +5,21 @@
 #include "DatabaseWorker.h"
 #include "FaviconStore.h"
 #include "FaviconTypes.h"
+#include "IResourceReporter.h"
 #include "LRUCache.h"
+#include "SizedLRUCache.h"
 
-#include <unordered_map>
+#include <atomic>
+#include <cstddef>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include <QHash>
 #include <QIcon>
+#include <QImage>
 #include <QObject>
+#include <QSet>
 #include <QString>
 #include <QUrl>
 
@@ -24,23 +30,51 @@ class QNetworkReply;
  * @class FaviconManager
  * @brief Acts as an interface between the \ref FaviconStore and the components
  *        of the web browser that require a favicon for any given URL
+ *
+ *        Icons are saved to the favicon store on its database thread, and downloaded icons
+ *        are decoded on the global thread pool. Only the finished QIcon is handled on the
+ *        GUI thread, which never queries the store itself: icons that are not cached are looked
+ *        up on the database thread, and announced with the \ref pageIconLoaded signal.
+ *        Icons loaded for callers on other threads hold the decoded images, and only create
+ *        their pixmaps once they are drawn on the GUI thread.
  */
-class FaviconManager : public QObject
+class FaviconManager : public QObject, public IResourceReporter
 {
     Q_OBJECT
 
 public:
-    /// Constructs the favicon manager
-    explicit FaviconManager(const QString &databaseFile);
+    /// Constructs the favicon manager. The favicon store is loaded from the given database file on
+    /// a database thread, so the manager is ready for use once \ref isReady returns true
+    FaviconManager(DatabaseTaskScheduler &taskScheduler, const QString &databaseFile);
+
+    /// Returns true if the favicon store has been loaded. Until then, \ref getFavicon returns a blank
+    /// icon and calls to \ref updateIcon are deferred. The \ref storeReady signal is emitted once loaded
+    bool isReady() const;
+
+    /// Returns the memory held by the icon caches
+    std::vector<ResourceUsage> getResourceUsage() const override;
 
     /// Passes the instance of the network access manager, so the favicon manager can download
     /// new icons as they are referenced by a web page.
     void setNetworkAccessManager(NetworkAccessManager *networkAccessManager);
 
     /// Searches for a favicon associated with the given URL, returning either the favicon
-    /// or an empty favicon if it could not be found
+    /// or an empty favicon if it could not be found. When called on the GUI thread, only the
+    /// cache is searched. If the icon is not cached, it is looked up on the database thread, and
+    /// the \ref pageIconLoaded signal is emitted if it is found
     QIcon getFavicon(const QUrl &url);
 
+    /// Returns the identifier of the favicon associated with the given URL in the favicon store, or -1 if
+    /// the store is not ready or has no favicon for the URL. Must not be called on the GUI thread
+    int getFaviconId(const QUrl &url);
+
+    /// Returns the favicon with the given identifier, or a null icon if it could not be found.
+    /// When called on the GUI thread, only the cache is searched
+    QIcon getFaviconById(int iconId);
+
+    /// Returns the given page URL without the parts that are ignored when looking up its favicon
+    static QUrl getPageKey(const QUrl &url);
+
     /**
      * @brief Attempts to update favicon for a specific URL in the database.
      * @param iconUrl The location in which the favicon is stored.
@@ -49,28 +83,97 @@ class FaviconManager : public QObject
      */
     void updateIcon(const QUrl &iconUrl, const QUrl &pageUrl, const QIcon &pageIcon);
 
-private Q_SLOTS:
-    /// Called after the request for a favicon has been completed
-    void onReplyFinished(QNetworkReply *reply);
+Q_SIGNALS:
+    /// Emitted on the GUI thread once a favicon has been downloaded, decoded and saved
+    void faviconLoaded(const QUrl &iconUrl, const QIcon &icon);
+
+    /// Emitted on the GUI thread once the favicon store has been loaded. Components that requested icons
+    /// before then should request them again
+    void storeReady();
+
+    /// Emitted on the GUI thread once the favicon of a page that was not cached has been found. The page URL is
+    /// given in the form returned by \ref getPageKey
+    void pageIconLoaded(const QUrl &pageUrl, const QIcon &icon);
 
 private:
+    /// Looks up the favicon of the given page on the database thread, unless it is already being looked up
+    void lookupFavicon(const QUrl &url, const QString &pageUrl);
+
+    /// Reads the favicon with the given identifier from the store and decodes its images, returning a null icon if
+    /// it could not be found. Called off the GUI thread, so the icon does not create its pixmaps until it is drawn
+    QIcon loadFaviconById(int iconId);
+
+    /// Downloads the icon at the given URL, unless it is already being downloaded
+    void fetchIcon(const QUrl &iconUrl);
+
+    /// Called after the request for a favicon has been completed. Decodes the response on the thread pool
+    void onReplyFinished(const QUrl &iconUrl, QNetworkReply *reply);
+
+    /// Called on the GUI thread once a downloaded favicon has been decoded, or failed to decode
+    void onIconDecoded(const QUrl &iconUrl, const QImage &image, const QString &format);
+
+    /// Decodes the data of a favicon, given the file extension of its URL. Called on the thread pool
+    static QImage decodeIcon(QByteArray data, QString format);
+
+    /// Called on the manager's thread once the favicon store has been loaded
+    void onStoreLoaded(std::unique_ptr<FaviconStore> &&faviconStore);
+
     /// Returns the given URL in string form
     QString getUrlAsString(const QUrl &url) const;
 
+    /// Returns the icon with the given favicon ID from the decoded icon cache, or a null icon if it is not cached
+    QIcon getCachedIcon(int iconId);
+
+    /// Places the given icon into the decoded icon cache
+    void cacheIcon(int iconId, const QIcon &icon);
+
+    /// Returns the approximate number of bytes used by the pixmaps of the given icon
+    static std::size_t getIconSize(const QIcon &icon);
+
 private:
-    /// Favicon data store
-    std::unique_ptr<FaviconStore> m_faviconStore;
+    /// Arguments of a call to \ref updateIcon made before the favicon store was loaded
+    struct PendingIconUpdate
+    {
+        /// The location in which the favicon is stored
+        QUrl iconUrl;
+
+        /// The URL of the page displaying the favicon
+        QUrl pageUrl;
+
+        /// The favicon on the page
+        QIcon icon;
+    };
+
+    /// Runs the tasks that read from and write to the favicon store
+    DatabaseTaskScheduler &m_taskScheduler;
+
+    /// Favicon data store. Shared with the tasks that save icons on the database thread
+    std::shared_ptr<FaviconStore> m_faviconStore;
+
+    /// Set once the favicon store has been loaded. Checked instead of \ref m_faviconStore by
+    /// \ref getFavicon, which can be called from other threads
+    std::atomic_bool m_isStoreReady;
+
+    /// Icon updates that were requested before the favicon store was loaded
+    std::vector<PendingIconUpdate> m_pendingUpdates;
 
     /// Used to download icons when a new one is referenced
     NetworkAccessManager *m_networkAccessManager;
 
-    /// Mapping of favicon IDs (as stored in \ref FaviconStore ) to their corresponding QIcons
-    std::unordered_map<int, QIcon> m_iconMap;
+    /// URLs of the icons that are being downloaded or decoded
+    QSet<QUrl> m_pendingFetches;
+
+    /// Pages whose favicons are being looked up on the database thread, in the form returned by \ref getUrlAsString
+    QSet<QString> m_pendingLookups;
+
+    /// Cache of decoded icons, keyed by their favicon IDs (as stored in \ref FaviconStore ),
+    /// which is bounded by the size of the icons' pixmaps
+    SizedLRUCache<int, QIcon> m_iconMap;
 
     /// Cache of most recently visited URLs and the icons associated with those pages
     LRUCache<std::string, QIcon> m_iconCache;
 
-    /// Used when updating the LRU cache for thread safety
+    /// Used when updating the LRU caches for thread safety
     mutable std::mutex m_mutex;
 };
 
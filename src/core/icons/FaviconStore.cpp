@@ -2,17 +2,20 @@
 #include "FaviconStore.h"
 #include "URL.h"
 
-#include <array>
+#include <mutex>
+#include <utility>
+#include <vector>
 #include <QDebug>
+#include <QImage>
 
 FaviconStore::FaviconStore(const QString &databaseFile) :
     DatabaseWorker(databaseFile),
-    m_originMap(),
-    m_iconDataMap(),
-    m_webPageMap(),
+    m_iconUrlIds(),
+    m_domainIconCache(256),
     m_newFaviconID(1),
     m_newDataID(1),
-    m_queryMap()
+    m_queryMap(),
+    m_mutex()
 {
 }
 
@@ -22,53 +25,42 @@ FaviconStore::~FaviconStore()
 
 int FaviconStore::getFaviconId(const QUrl &url)
 {
+    std::lock_guard<std::mutex> lock{m_mutex};
+
     if (url.isEmpty())
         return -1;
 
-    auto it = m_webPageMap.find(url);
-    if (it != m_webPageMap.end())
-        return *it;
-
-    auto iconQuery = m_database.prepare(R"(SELECT FaviconID FROM FaviconMap WHERE PageURL LIKE ?)");
+    // Search for the page itself, then any page on the same host. Pages on the same registrable domain
+    // may use a different icon, so the domain is only searched when neither has a mapping
+    int iconId = findFaviconId(StoredQuery::FindIconIdExactURL, url.toString(QUrl::FullyEncoded));
+    if (iconId < 0)
+        iconId = findFaviconId(StoredQuery::FindIconIdByHost, url.host().toLower());
+    if (iconId >= 0)
+        return iconId;
 
-    QString searchTemplate(QStringLiteral("%%1%"));
-    std::array<QString, 2> searchTerms = { searchTemplate.arg(url.host()),
-                                           searchTemplate.arg(URL(url).getSecondLevelDomain()) };
-    for (size_t i = 0; i < searchTerms.size(); ++i)
-    {
-        iconQuery << searchTerms.at(i);
+    const QString domain = getDomain(url);
+    const std::string domainKey = domain.toStdString();
+    if (domainKey.empty())
+        return -1;
 
-        if (iconQuery.next())
-        {
-            int iconId = 0;
-            iconQuery >> iconId;
-            return iconId;
-        }
+    if (m_domainIconCache.has(domainKey))
+        return m_domainIconCache.get(domainKey);
 
-        iconQuery.reset();
-    }
+    iconId = findFaviconId(StoredQuery::FindIconIdByDomain, domain);
+    if (iconId >= 0)
+        m_domainIconCache.put(domainKey, iconId);
 
-    return -1;
+    return iconId;
 }
 
 int FaviconStore::getFaviconIdForIconUrl(const QUrl &url)
 {
-    for (const auto &it : m_originMap)
-    {
-        if (CommonUtil::doUrlsMatch(url, it.second, true))
-            return it.first;
-        if (url.matches(it.second, QUrl::RemoveScheme | QUrl::RemoveQuery | QUrl::RemoveFragment))
-            return it.first;
-    }
+    std::lock_guard<std::mutex> lock{m_mutex};
 
-    auto idQuery = m_database.prepare(R"(SELECT FaviconID FROM Favicons WHERE URL = ?)");
-    idQuery << url;
-    if (idQuery.next())
-    {
-        int iconId = 0;
-        idQuery >> iconId;
-        return iconId;
-    }
+    const std::string urlKey = getIconUrlKey(url);
+    auto it = m_iconUrlIds.find(urlKey);
+    if (it != m_iconUrlIds.end())
+        return it->second;
 
     int id = m_newFaviconID++;
     sqlite::PreparedStatement &insertStmt = m_queryMap.at(StoredQuery::InsertFavicon);
@@ -79,25 +71,29 @@ int FaviconStore::getFaviconIdForIconUrl(const QUrl &url)
     if (!insertStmt.execute())
         qWarning() << "In FaviconStore::getFaviconIdForIconUrl - could not add favicon metadata to Favicons table.";
 
+    m_iconUrlIds.emplace(urlKey, id);
     return id;
 }
 
-QByteArray FaviconStore::getIconData(int faviconId) const
+QByteArray FaviconStore::getIconData(int faviconId)
 {
-    auto it = m_iconDataMap.find(faviconId);
-    if (it != m_iconDataMap.end())
-        return it->second.iconData;
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    FaviconData dataRecord;
+    if (loadDataRecord(faviconId, dataRecord))
+        return dataRecord.iconData;
 
     return QByteArray();
 }
 
-FaviconData &FaviconStore::getDataRecord(int faviconId)
+FaviconData FaviconStore::getDataRecord(int faviconId)
 {
-    auto it = m_iconDataMap.find(faviconId);
-    if (it != m_iconDataMap.end())
-        return it->second;
+    std::lock_guard<std::mutex> lock{m_mutex};
 
     FaviconData iconData;
+    if (loadDataRecord(faviconId, iconData))
+        return iconData;
+
     iconData.faviconId = faviconId;
     iconData.id = m_newDataID++;
 
@@ -107,13 +103,15 @@ FaviconData &FaviconStore::getDataRecord(int faviconId)
     if (!stmt.execute())
         qWarning() << "In FaviconStore::getDataRecord - could not add favicon icon data to FaviconData table";
 
-    auto result = m_iconDataMap.emplace(std::make_pair(faviconId, iconData));
-    return result.first->second;
+    return iconData;
 }
 
-void FaviconStore::saveDataRecord(FaviconData &dataRecord)
+void FaviconStore::saveDataRecord(const FaviconData &dataRecord)
 {
-    auto stmt = m_database.prepare(R"(UPDATE FaviconData SET Data = ? WHERE DataID = ?)");
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    sqlite::PreparedStatement &stmt = m_queryMap.at(StoredQuery::UpdateIconData);
+    stmt.reset();
     stmt << dataRecord.iconData
          << dataRecord.id;
     if (!stmt.execute())
@@ -122,25 +120,168 @@ void FaviconStore::saveDataRecord(FaviconData &dataRecord)
 
 void FaviconStore::addPageMapping(const QUrl &webPageUrl, int faviconId)
 {
-    auto it = m_webPageMap.find(webPageUrl);
-    if (it != m_webPageMap.end())
-    {
-        if (it.value() == faviconId)
-            return;
+    std::lock_guard<std::mutex> lock{m_mutex};
 
-        *it = faviconId;
-    }
-    else
-        m_webPageMap.insert(webPageUrl, faviconId);
+    const QString domain = getDomain(webPageUrl);
+    if (!domain.isEmpty())
+        m_domainIconCache.put(domain.toStdString(), faviconId);
 
-    auto stmt = m_database.prepare(R"(INSERT OR REPLACE INTO FaviconMap(PageURL, FaviconID) VALUES (?, ?))");
+    sqlite::PreparedStatement &stmt = m_queryMap.at(StoredQuery::InsertPageMapping);
+    stmt.reset();
     stmt << webPageUrl
-         << faviconId;
+         << faviconId
+         << webPageUrl.host().toLower()
+         << domain;
 
     if (!stmt.execute())
         qDebug() << "In FaviconStore::addPageMapping - could not update webpage mapping.";
 }
 
+int FaviconStore::findFaviconId(StoredQuery queryType, const QString &value)
+{
+    if (value.isEmpty())
+        return -1;
+
+    sqlite::PreparedStatement &query = m_queryMap.at(queryType);
+    query.reset();
+    query << value;
+
+    int iconId = -1;
+    if (query.next())
+        query >> iconId;
+
+    query.reset();
+    return iconId;
+}
+
+bool FaviconStore::loadDataRecord(int faviconId, FaviconData &dataRecord)
+{
+    sqlite::PreparedStatement &stmt = m_queryMap.at(StoredQuery::GetIconData);
+    stmt.reset();
+    stmt << faviconId;
+
+    const bool found = stmt.next();
+    if (found)
+        stmt >> dataRecord;
+
+    stmt.reset();
+    return found;
+}
+
+void FaviconStore::migrateIconDataToBinary()
+{
+    if (!m_database.beginTransaction())
+        qWarning() << "In FaviconStore::migrateIconDataToBinary - could not begin transaction";
+
+    std::vector<std::pair<int, QByteArray>> records;
+    auto query = m_database.prepare(R"(SELECT DataID, Data FROM FaviconData WHERE Data IS NOT NULL)");
+    while (query.next())
+    {
+        int dataId = 0;
+        QByteArray iconData;
+        query >> dataId
+              >> iconData;
+        records.emplace_back(dataId, iconData);
+    }
+
+    auto stmt = m_database.prepare(R"(UPDATE FaviconData SET Data = ? WHERE DataID = ?)");
+    for (auto &record : records)
+    {
+        QImage image;
+        image.loadFromData(QByteArray::fromBase64(record.second), "PNG");
+
+        // Records that cannot be decoded are cleared, so the icon is downloaded again
+        stmt.reset();
+        stmt << CommonUtil::iconImageToBinary(image)
+             << record.first;
+        if (!stmt.execute())
+            qWarning() << "In FaviconStore::migrateIconDataToBinary - could not update favicon data.";
+    }
+
+    if (!setSchemaVersion(1))
+        qWarning() << "In FaviconStore::migrateIconDataToBinary - could not update schema version";
+
+    if (!m_database.commitTransaction())
+    {
+        qWarning() << "In FaviconStore::migrateIconDataToBinary - could not commit transaction";
+        m_database.rollbackTransaction();
+    }
+}
+
+void FaviconStore::migratePageMappingHosts()
+{
+    if (!m_database.beginTransaction())
+        qWarning() << "In FaviconStore::migratePageMappingHosts - could not begin transaction";
+
+    // Databases created by setup() already have the columns
+    bool hasHostColumn = false;
+    auto tableInfo = m_database.prepare(R"(PRAGMA table_info(FaviconMap))");
+    while (tableInfo.next())
+    {
+        int cid = 0;
+        QString colName;
+        tableInfo >> cid
+                  >> colName;
+
+        if (colName.compare(QLatin1String("Host")) == 0)
+            hasHostColumn = true;
+    }
+
+    if (!hasHostColumn
+            && (!exec(QStringLiteral("ALTER TABLE FaviconMap ADD Host TEXT"))
+                || !exec(QStringLiteral("ALTER TABLE FaviconMap ADD Domain TEXT"))))
+        qWarning() << "In FaviconStore::migratePageMappingHosts - could not add host columns to FaviconMap table";
+
+    std::vector<std::pair<int, QUrl>> mappings;
+    auto query = m_database.prepare(R"(SELECT MapID, PageURL FROM FaviconMap WHERE Host IS NULL)");
+    while (query.next())
+    {
+        int mapId = 0;
+        QUrl pageUrl;
+        query >> mapId
+              >> pageUrl;
+        mappings.emplace_back(mapId, pageUrl);
+    }
+
+    auto updateStmt = m_database.prepare(R"(UPDATE FaviconMap SET Host = ?, Domain = ? WHERE MapID = ?)");
+    for (const auto &mapping : mappings)
+    {
+        updateStmt.reset();
+        updateStmt << mapping.second.host().toLower()
+                   << getDomain(mapping.second)
+                   << mapping.first;
+        if (!updateStmt.execute())
+            qWarning() << "In FaviconStore::migratePageMappingHosts - could not update page mapping.";
+    }
+
+    exec(QStringLiteral("CREATE INDEX IF NOT EXISTS favicon_map_host ON FaviconMap(Host)"));
+    exec(QStringLiteral("CREATE INDEX IF NOT EXISTS favicon_map_domain ON FaviconMap(Domain)"));
+
+    if (!setSchemaVersion(2))
+        qWarning() << "In FaviconStore::migratePageMappingHosts - could not update schema version";
+
+    if (!m_database.commitTransaction())
+    {
+        qWarning() << "In FaviconStore::migratePageMappingHosts - could not commit transaction";
+        m_database.rollbackTransaction();
+    }
+}
+
+QString FaviconStore::getDomain(const QUrl &url) const
+{
+    QString domain = URL(url).getSecondLevelDomain();
+    if (domain.isEmpty())
+        domain = url.host();
+
+    return domain.toLower();
+}
+
+std::string FaviconStore::getIconUrlKey(const QUrl &url)
+{
+    // The scheme and query can select a different icon, so only the parts that never do are removed
+    return url.adjusted(QUrl::RemoveUserInfo | QUrl::RemoveFragment).toString(QUrl::FullyEncoded).toStdString();
+}
+
 void FaviconStore::setupQueries()
 {
     m_queryMap.clear();
@@ -152,11 +293,26 @@ void FaviconStore::setupQueries()
                 std::make_pair(StoredQuery::InsertIconData,
                                m_database.prepare(R"(INSERT OR REPLACE INTO FaviconData(DataID, FaviconID, Data) VALUES (?, ?, ?))")));
     m_queryMap.insert(
-                std::make_pair(StoredQuery::FindIconExactURL,
-                               m_database.prepare(R"(SELECT URL FROM Favicons WHERE FaviconID = (SELECT m.FaviconID FROM FaviconMap m WHERE m.PageURL = ?))")));
+                std::make_pair(StoredQuery::UpdateIconData,
+                               m_database.prepare(R"(UPDATE FaviconData SET Data = ? WHERE DataID = ?)")));
     m_queryMap.insert(
-                std::make_pair(StoredQuery::FindIconLikeURL,
-                               m_database.prepare(R"(SELECT URL FROM Favicons WHERE FaviconID IN (SELECT m.FaviconID FROM FaviconMap m WHERE m.PageURL LIKE ?))")));
+                std::make_pair(StoredQuery::GetIconData,
+                               m_database.prepare(R"(SELECT DataID, FaviconID, Data FROM FaviconData WHERE FaviconID = ? ORDER BY DataID DESC LIMIT 1)")));
+    // Only rewrite the mapping of a page when its favicon has changed
+    m_queryMap.insert(
+                std::make_pair(StoredQuery::InsertPageMapping,
+                               m_database.prepare(R"(INSERT INTO FaviconMap(PageURL, FaviconID, Host, Domain) VALUES (?, ?, ?, ?) )"
+                                                  R"(ON CONFLICT(PageURL) DO UPDATE SET FaviconID = excluded.FaviconID )"
+                                                  R"(WHERE FaviconID != excluded.FaviconID)")));
+    m_queryMap.insert(
+                std::make_pair(StoredQuery::FindIconIdExactURL,
+                               m_database.prepare(R"(SELECT FaviconID FROM FaviconMap WHERE PageURL = ?)")));
+    m_queryMap.insert(
+                std::make_pair(StoredQuery::FindIconIdByHost,
+                               m_database.prepare(R"(SELECT FaviconID FROM FaviconMap WHERE Host = ? ORDER BY MapID DESC LIMIT 1)")));
+    m_queryMap.insert(
+                std::make_pair(StoredQuery::FindIconIdByDomain,
+                               m_database.prepare(R"(SELECT FaviconID FROM FaviconMap WHERE Domain = ? ORDER BY MapID DESC LIMIT 1)")));
 }
 
 bool FaviconStore::hasProperStructure()
@@ -173,7 +329,7 @@ void FaviconStore::setup()
     exec(QStringLiteral("CREATE TABLE IF NOT EXISTS FaviconData(DataID INTEGER PRIMARY KEY, FaviconID INTEGER NOT NULL, Data BLOB, "
                "FOREIGN KEY(FaviconID) REFERENCES Favicons(FaviconID))"));
     exec(QStringLiteral("CREATE TABLE IF NOT EXISTS FaviconMap(MapID INTEGER PRIMARY KEY, PageURL TEXT UNIQUE, FaviconID INTEGER NOT NULL, "
-               "FOREIGN KEY(FaviconID) REFERENCES Favicons(FaviconID))"));
+               "Host TEXT, Domain TEXT, FOREIGN KEY(FaviconID) REFERENCES Favicons(FaviconID))"));
 
     // Create indices
     exec(QStringLiteral("CREATE INDEX IF NOT EXISTS favicons_url ON Favicons(URL)"));
@@ -181,10 +337,21 @@ void FaviconStore::setup()
     exec(QStringLiteral("CREATE INDEX IF NOT EXISTS favicon_data_foreign_id ON FaviconData(FaviconID)"));
     exec(QStringLiteral("CREATE INDEX IF NOT EXISTS favicon_map_url ON FaviconMap(PageURL)"));
     exec(QStringLiteral("CREATE INDEX IF NOT EXISTS favicon_map_data_id ON FaviconMap(FaviconID)"));
+    exec(QStringLiteral("CREATE INDEX IF NOT EXISTS favicon_map_host ON FaviconMap(Host)"));
+    exec(QStringLiteral("CREATE INDEX IF NOT EXISTS favicon_map_domain ON FaviconMap(Domain)"));
 }
 
 void FaviconStore::load()
 {
+    // Icon data used to be stored as base64-encoded PNG images
+    const int schemaVersion = getSchemaVersion();
+    if (schemaVersion < 1)
+        migrateIconDataToBinary();
+
+    // Page mappings used to be searched with LIKE patterns rather than by their host
+    if (schemaVersion < 2)
+        migratePageMappingHosts();
+
     setupQueries();
 
     auto query = m_database.prepare(R"(SELECT FaviconID, URL FROM Favicons)");
@@ -194,29 +361,10 @@ void FaviconStore::load()
         QUrl iconUrl;
         query >> iconId
               >> iconUrl;
-        m_originMap.emplace(std::make_pair(iconId, iconUrl));
-    }
-
-    query = m_database.prepare(R"(SELECT DataID, FaviconID, Data FROM FaviconData)");
-    while (query.next())
-    {
-        FaviconData data;
-        query >> data;
-
-        m_iconDataMap.emplace(std::make_pair(data.faviconId, data));
+        m_iconUrlIds.emplace(getIconUrlKey(iconUrl), iconId);
     }
 
-    query = m_database.prepare(R"(SELECT PageURL, FaviconID FROM FaviconMap)");
-    while (query.next())
-    {
-        QUrl pageUrl;
-        int faviconId = 0;
-
-        query >> pageUrl
-              >> faviconId;
-
-        m_webPageMap.insert(pageUrl, faviconId);
-    }
+    // Icon data and page mappings are loaded on demand
 
     // Fetch maximum favicon ID and data ID values so new entry IDs can be calculated with more ease
     query = m_database.prepare(R"(SELECT MAX(FaviconID) FROM Favicons)");
@@ -7,6 +7,8 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <QHash>
 #include <QIcon>
 #include <QSet>
@@ -16,6 +18,13 @@
 /**
  * @class FaviconStore
  * @brief Maintains a record of favicons from websites frequented by the user
+ *
+ *        Icon data is read from the database when it is requested, rather than being held in memory.
+ *        The icon of a web page is looked up by its URL, then by its host and registrable domain,
+ *        which are indexed columns of the page mapping table. The most recent lookups that fell back
+ *        to the registrable domain are cached.
+ *
+ *        The public methods of the store may be called from any thread.
  */
 class FaviconStore : public DatabaseWorker
 {
@@ -31,7 +40,8 @@ class FaviconStore : public DatabaseWorker
     /// Destroys the favicon storage object, saving data to the favicon database
     ~FaviconStore();
 
-    /// Returns the Id of the favicon associated with the given URL
+    /// Returns the Id of the favicon associated with the given URL, or -1 if no favicon is associated with the
+    /// URL or any other page on its registrable domain
     int getFaviconId(const QUrl &url);
 
     /// Returns the identifier of the favicon associated with the given data URL (ie the URL of the icon itself)
@@ -39,22 +49,61 @@ class FaviconStore : public DatabaseWorker
 
     /// Returns the icon data for the favicon with the given identifier, or an empty
     /// byte array if it could not be found
-    QByteArray getIconData(int faviconId) const;
+    QByteArray getIconData(int faviconId);
 
-    /// Returns a reference to the icon data structure associated with the given favicon ID,
-    /// inserting a new record if it was not found.
-    FaviconData &getDataRecord(int faviconId);
+    /// Returns the icon data record associated with the given favicon ID, inserting a new
+    /// record into the database if it was not found.
+    FaviconData getDataRecord(int faviconId);
 
     /// Saves the given record to the database
-    void saveDataRecord(FaviconData &dataRecord);
+    void saveDataRecord(const FaviconData &dataRecord);
 
     /// Maps the given web page to a favicon, referenced by its unique ID
     void addPageMapping(const QUrl &webPageUrl, int faviconId);
 
+private:
+    /// Used to access prepared database queries
+    enum class StoredQuery
+    {
+        InsertFavicon,
+        InsertIconData,
+        UpdateIconData,
+        GetIconData,
+        InsertPageMapping,
+        FindIconIdExactURL,
+        FindIconIdByHost,
+        FindIconIdByDomain
+    };
+
 private:
     /// Instantiates the stored query objects
     void setupQueries();
 
+    /// Runs one of the page mapping search queries with the given value, returning the favicon ID of the most recent
+    /// match or -1 if there is none
+    int findFaviconId(StoredQuery queryType, const QString &value);
+
+    /// Reads the icon data record associated with the given favicon ID into the given structure,
+    /// returning true if it was found
+    bool loadDataRecord(int faviconId, FaviconData &dataRecord);
+
+    /// Converts the icon data of each record from base64-encoded PNG images into the binary
+    /// format of \ref CommonUtil::iconToBinary
+    void migrateIconDataToBinary();
+
+    /// Adds the Host and Domain columns to the page mapping table of databases created by older versions,
+    /// filling them in for the existing mappings
+    void migratePageMappingHosts();
+
+    /// Returns the registrable domain of the given URL in lower case, or its host if it does not
+    /// have a registrable domain. This is stored in the Domain column of the page mapping table,
+    /// and is the key of the domain icon cache
+    QString getDomain(const QUrl &url) const;
+
+    /// Returns the normalized form of a favicon URL, which ignores its user information and fragment,
+    /// so that equivalent icon URLs share an ID
+    static std::string getIconUrlKey(const QUrl &url);
+
 protected:
     /// Returns true if the favicon database contains the table structure(s) needed for it to function properly,
     /// false if else.
@@ -67,24 +116,11 @@ class FaviconStore : public DatabaseWorker
     void load() override;
 
 private:
-    /// Used to access prepared database queries
-    enum class StoredQuery
-    {
-        InsertFavicon,
-        InsertIconData,
-        FindIconExactURL,
-        FindIconLikeURL
-    };
-
-private:
-    /// Mapping of unique favicon IDs to their respective data URLs
-    FaviconOriginMap m_originMap;
-
-    /// Mapping of unique favicon IDs to their icon data containers
-    FaviconDataMap m_iconDataMap;
+    /// Mapping of normalized favicon URLs to their unique IDs
+    FaviconUrlMap m_iconUrlIds;
 
-    /// Mapping of visited URLs to their corresponding favicon IDs
-    WebPageIconMap m_webPageMap;
+    /// Cache of the favicon IDs of recently looked up registrable domains, used when a page has no mapping for its URL or host
+    LRUCache<std::string, int> m_domainIconCache;
 
     /// Used when adding new records to the favicon table
     int m_newFaviconID;
@@ -94,6 +130,9 @@ class FaviconStore : public DatabaseWorker
 
     /// Cache of frequently-executed sql statements
     std::map<StoredQuery, sqlite::PreparedStatement> m_queryMap;
+
+    /// Guards the statements and caches, as icons are looked up on the GUI thread while they are saved on the database thread
+    mutable std::mutex m_mutex;
 };
 
 #endif // FAVICONSTORAGE_H
@@ -6,6 +6,7 @@
 
 #include <QIcon>
 
+#include <string>
 #include <unordered_map>
 
 #include <QByteArray>
@@ -71,17 +72,17 @@ struct FaviconMap
     /// Page that referred to a favicon
     QUrl pageUrl;
 
-    /// Default constructor
-    FaviconMap() : id(0), faviconId(0), pageUrl() {}
-};
+    /// Host of the page, in lower case
+    QString host;
 
-/// Represents the \ref FaviconOrigin structure as a map. Key = favicon Id, value = URL of icon
-using FaviconOriginMap = std::unordered_map<int, QUrl>;
+    /// Registrable domain of the page, in lower case
+    QString domain;
 
-/// Represents the \ref FaviconData structure as a map. Key = favicon Id (same as FaviconOriginMap), value = FaviconData structure
-using FaviconDataMap = std::unordered_map<int, FaviconData>;
+    /// Default constructor
+    FaviconMap() : id(0), faviconId(0), pageUrl(), host(), domain() {}
+};
 
-/// Represents the \ref FaviconMap as a hash map. Key = URL of the web page, value = unique identifier of the favicon.
-using WebPageIconMap = QHash<QUrl, int>;
+/// Maps the URLs of favicons to their IDs. Key = normalized URL of icon (see \ref FaviconStore ), value = favicon Id
+using FaviconUrlMap = std::unordered_map<std::string, int>;
 
 #endif // FAVICONTYPES_H
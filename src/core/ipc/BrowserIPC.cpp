@@ -1,51 +1,48 @@
 #include "BrowserIPC.h"
 
-#include <QString>
+#include <QCryptographicHash>
+#include <QDeadlineTimer>
+#include <QDir>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QThread>
 #include <QDebug>
 
 #include <cstring>
 
-BrowserIPC::BrowserIPC() :
-    m_buffer(QStringLiteral("_Viper_Browser_IPC_")),
-    m_semaphore(QStringLiteral("_Viper_Browser_Sem_"), 1),
-    m_hasPreExistingInstance(false)
+namespace
 {
-    m_semaphore.acquire();
+    /// Time to wait for the existing instance to accept a connection or a message, in milliseconds
+    constexpr int ConnectionTimeout = 1000;
 
-    // Fix for linux and perhaps other *nix systems (see: https://habr.com/ru/post/173281/)
-    {
-        QSharedMemory sharedMemTemp(QStringLiteral("_Viper_Browser_IPC_"));
-        sharedMemTemp.attach();
-    }
+    /// Time to wait for an existing instance that is still starting up to listen for messages, in milliseconds
+    constexpr int StartupTimeout = 10000;
+}
 
-    // Attach to or create the shared memory region
-    if (m_buffer.attach())
-    {
-        m_hasPreExistingInstance = true;
-    }
-    else
-    {
-        m_buffer.create(BufferLength);
-        memset(m_buffer.data(), 0, BufferLength);
-        m_hasPreExistingInstance = false;
-    }
+BrowserIPC::BrowserIPC() :
+    QObject(nullptr),
+    m_lockFile(getLockFilePath()),
+    m_server(nullptr),
+    m_socket(nullptr),
+    m_pendingData(),
+    m_messages(),
+    m_hasPreExistingInstance(false)
+{
+    // The lock is only considered stale once the process that held it has exited. Claiming it right away, rather than
+    // once the server is listening, keeps two instances that start at the same time from both becoming the first
+    m_lockFile.setStaleLockTime(0);
+    if (m_lockFile.tryLock(0))
+        return;
 
-    m_semaphore.release();
+    m_hasPreExistingInstance = (m_lockFile.error() == QLockFile::LockFailedError);
+    if (!m_hasPreExistingInstance)
+        qWarning() << "BrowserIPC - could not create lock file" << getLockFilePath();
 }
 
 BrowserIPC::~BrowserIPC()
 {
-    release();
-}
-
-void BrowserIPC::release()
-{
-    m_semaphore.acquire();
-
-    if (m_buffer.isAttached())
-        m_buffer.detach();
-
-    m_semaphore.release();
+    if (m_server)
+        m_server->close();
 }
 
 bool BrowserIPC::hasExistingInstance() const
@@ -53,94 +50,146 @@ bool BrowserIPC::hasExistingInstance() const
     return m_hasPreExistingInstance;
 }
 
-bool BrowserIPC::hasMessage()
+void BrowserIPC::listen()
 {
-    if (!m_buffer.isAttached())
-        return false;
+    if (m_hasPreExistingInstance || m_server)
+        return;
+
+    const QString serverName = getServerName();
 
-    m_semaphore.acquire();
-    const char *data = static_cast<const char*>(m_buffer.constData());
-    m_semaphore.release();
+    m_server = new QLocalServer(this);
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_server, &QLocalServer::newConnection, this, &BrowserIPC::onNewConnection);
+
+    if (m_server->listen(serverName))
+        return;
+
+    // This instance holds the lock file, so a socket that is in use was left behind by a previous instance
+    // that did not exit cleanly
+    if (m_server->serverError() == QAbstractSocket::AddressInUseError)
+    {
+        QLocalServer::removeServer(serverName);
+        if (m_server->listen(serverName))
+            return;
+    }
 
-    if (data[sizeof(int)] == '\0')
-        return false;
+    qWarning() << "BrowserIPC - could not listen for messages from other instances:" << m_server->errorString();
+}
 
-    const int messageLen = *(reinterpret_cast<const int*>(data));
-    return messageLen > 0 && messageLen < BufferLength;
+bool BrowserIPC::hasMessage()
+{
+    return !m_messages.empty();
 }
 
 std::vector<char> BrowserIPC::getMessage()
 {
-    if (!m_buffer.isAttached())
+    if (m_messages.empty())
         return std::vector<char>();
 
-    // Read from buffer
-    m_semaphore.acquire();
-    const char *data = reinterpret_cast<const char*>(m_buffer.constData());
-    int length = m_buffer.size();
+    std::vector<char> result = std::move(m_messages.front());
+    m_messages.pop_front();
+    return result;
+}
 
-    // Sanity checks
-    if (length < 1)
+void BrowserIPC::sendMessage(const char *data, int length)
+{
+    if (data == nullptr || length < 1 || length > BufferLength)
     {
-        qDebug() << "BrowserIPC::getMessage() - invalid message (length < 1 or data is null)";
-        m_semaphore.release();
-        return std::vector<char>();
+        qDebug() << "BrowserIPC:: failed to send message";
+        return;
     }
 
-    const int expectedLength = *(reinterpret_cast<const int*>(data));
-    if (expectedLength < 1 || expectedLength > BufferLength)
+    if (!m_socket)
+        m_socket = new QLocalSocket(this);
+
+    // The existing instance may still be starting up, in which case it is not listening yet
+    QDeadlineTimer deadline(StartupTimeout);
+    while (m_socket->state() != QLocalSocket::ConnectedState && !deadline.hasExpired())
     {
-        qDebug() << "BrowserIPC::getMessage() - invalid expected length";
-        m_semaphore.release();
-        return std::vector<char>();
+        m_socket->connectToServer(getServerName());
+        if (!m_socket->waitForConnected(ConnectionTimeout))
+        {
+            m_socket->abort();
+            QThread::msleep(100);
+        }
     }
 
-    // Validate the expected length against the actual
-    const int offset = sizeof(int);
-    int actualLength = 0;
-    while (actualLength < BufferLength)
+    if (m_socket->state() != QLocalSocket::ConnectedState)
     {
-        if (*(data + offset + actualLength) == '\0')
-            break;
-
-        actualLength++;
+        qDebug() << "BrowserIPC:: failed to send message, no connection to the existing instance";
+        return;
     }
 
-    if (actualLength != expectedLength)
+    // Messages are written to a stream, so a message sent right after another one is queued rather than replacing it
+    if (m_socket->write(data, length) != length || !m_socket->waitForBytesWritten(ConnectionTimeout))
+        qDebug() << "BrowserIPC:: failed to send message:" << m_socket->errorString();
+}
+
+void BrowserIPC::onNewConnection()
+{
+    while (QLocalSocket *socket = m_server->nextPendingConnection())
     {
-        qDebug() << "BrowserIPC::getMessage() - actual length: " << actualLength << ", expected: " << expectedLength;
-        m_semaphore.release();
-        return std::vector<char>();
+        connect(socket, &QLocalSocket::readyRead, this, &BrowserIPC::onReadyRead);
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket](){
+            m_pendingData.erase(socket);
+            socket->deleteLater();
+        });
     }
+}
+
+void BrowserIPC::onReadyRead()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket*>(sender());
+    if (!socket)
+        return;
 
-    // Copy buffer and clear the shared memory region
-    std::vector<char> result(static_cast<size_t>(actualLength), '\0');
+    QByteArray &buffer = m_pendingData[socket];
+    buffer.append(socket->readAll());
 
-    char *resultPtr = result.data();
-    memcpy(resultPtr, &data[offset], static_cast<size_t>(actualLength));
+    const std::size_t numMessages = m_messages.size();
+    if (!readMessages(buffer))
+    {
+        qDebug() << "BrowserIPC::onReadyRead() - invalid message, closing connection";
+        m_pendingData.erase(socket);
+        socket->abort();
+    }
 
-    // Clear shared memory
-    memset(m_buffer.data(), 0, static_cast<size_t>(offset + actualLength));
+    if (m_messages.size() > numMessages)
+        emit messageReceived();
+}
 
-    m_semaphore.release();
+QString BrowserIPC::getServerName()
+{
+    // Local sockets may share a directory between users, so the name is specific to the user's home directory
+    const QByteArray userHash = QCryptographicHash::hash(QDir::homePath().toUtf8(), QCryptographicHash::Sha1).toHex().left(16);
+    return QStringLiteral("Viper_Browser_IPC_%1").arg(QString::fromLatin1(userHash));
+}
 
-    return result;
+QString BrowserIPC::getLockFilePath()
+{
+    return QDir::temp().absoluteFilePath(getServerName() + QLatin1String(".lock"));
 }
 
-void BrowserIPC::sendMessage(const char *data, int length)
+bool BrowserIPC::readMessages(QByteArray &buffer)
 {
-    if (data == nullptr || length < 1 || length > BufferLength)
+    constexpr int headerLength = static_cast<int>(sizeof(int));
+
+    qsizetype offset = 0;
+    while (buffer.size() - offset >= headerLength)
     {
-        qDebug() << "BrowserIPC:: failed to send message";
-        return;
-    }
+        int messageLength = 0;
+        memcpy(&messageLength, buffer.constData() + offset, sizeof(int));
+        if (messageLength < 1 || messageLength + headerLength > BufferLength)
+            return false;
 
-    // If there are pending messages, they will be overwritten, but that is acceptable for
-    // our use case.
-    m_semaphore.acquire();
+        if (buffer.size() - offset - headerLength < messageLength)
+            break;
 
-    char *dest = reinterpret_cast<char*>(m_buffer.data());
-    memcpy(dest, data, static_cast<size_t>(length));
+        const char *messageData = buffer.constData() + offset + headerLength;
+        m_messages.emplace_back(messageData, messageData + messageLength);
+        offset += headerLength + messageLength;
+    }
 
-    m_semaphore.release();
+    buffer.remove(0, offset);
+    return true;
 }
@@ -1,8 +1,17 @@
 #ifndef BROWSERIPC_H
 #define BROWSERIPC_H
 
-#include <QSharedMemory>
-#include <QSystemSemaphore>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include <QByteArray>
+#include <QLockFile>
+#include <QObject>
+#include <QString>
+
+class QLocalServer;
+class QLocalSocket;
 
 /**
  * @class BrowserIPC
@@ -11,14 +20,21 @@
  *        only be one active instance of the application at a time,
  *        so if a second application is spawned to open a URL for example,
  *        it can ask the existing instance to do so in its stead.
+ *
+ *        The first instance claims a lock file as soon as it starts, and later listens on a local socket.
+ *        Other instances fail to claim the lock, then connect to the socket and write their messages, which
+ *        are queued and announced through \ref messageReceived as soon as they arrive.
  */
-class BrowserIPC
+class BrowserIPC : public QObject
 {
+    Q_OBJECT
+
 public:
-    /// Size of the shared memory buffer
+    /// Maximum size of a message, including its length header
     static constexpr int BufferLength = 2048;
 
-    /// Constructs the browser IPC instance
+    /// Constructs the browser IPC instance, claiming the lock that makes this the first instance of the browser
+    /// unless another instance already holds it. May be called before the application object exists
     BrowserIPC();
 
     /// Class destructor
@@ -33,30 +49,61 @@ class BrowserIPC
     /// Returns true if there is already an instance of the browser application, false otherwise.
     bool hasExistingInstance() const;
 
+    /// Starts listening for messages from other instances of the application. Must be called once the
+    /// application object exists, and only if there is no existing instance
+    void listen();
+
     /// Returns true if a message has been posted by another instance of the application.
     /// Otherwise returns false.
     bool hasMessage();
 
-    /// Returns any messages that have been sent to the browser, in the form of a char array
+    /// Returns the oldest message that has been sent to the browser and not read yet, in the form of a char array
     std::vector<char> getMessage();
 
-    /// Attempts to send the given message (format of data param is length immediately followed by data) through this channel.
+    /// Attempts to send the given message (format of data param is length immediately followed by data) to the existing
+    /// instance, waiting for it to start listening if needed. Must be called once the application object exists
     void sendMessage(const char *data, int length);
 
+Q_SIGNALS:
+    /// Emitted when a message from another instance of the application has been received
+    void messageReceived();
+
+private Q_SLOTS:
+    /// Accepts the pending connections from other instances of the application
+    void onNewConnection();
+
+    /// Reads the messages that are available on the socket that emitted the signal
+    void onReadyRead();
+
 private:
-    /// Releases the shared memory connection. If this is the only application & class
-    /// instance connected to the shared memory, it will then be freed.
-    void release();
+    /// Returns the name of the local socket used by the current user's browser instance
+    static QString getServerName();
+
+    /// Returns the path of the lock file that is held by the current user's browser instance
+    static QString getLockFilePath();
+
+    /// Reads the complete messages in the given buffer into the message queue, removing them from the
+    /// buffer. Returns false if the buffer contains an invalid message
+    bool readMessages(QByteArray &buffer);
 
 private:
-    /// Shared memory segment.
-    QSharedMemory m_buffer;
+    /// Lock file held by the first instance of the application
+    QLockFile m_lockFile;
+
+    /// Listens for connections from other instances, if this is the first instance of the application
+    QLocalServer *m_server;
+
+    /// Connection to the existing instance of the application, if there is one
+    QLocalSocket *m_socket;
+
+    /// Data received from each connected instance that does not form a complete message yet
+    std::unordered_map<QLocalSocket*, QByteArray> m_pendingData;
 
-    /// Semaphore for cross-process and thread synchronization
-    QSystemSemaphore m_semaphore;
+    /// Messages that were received and not read yet, in the order they were received
+    std::deque<std::vector<char>> m_messages;
 
-    /// Flag set to true if there is another IPC that owns the shared memory, false if this is the first
-    /// instance of the application.
+    /// Flag set to true if there is another instance of the application that holds the lock file,
+    /// false if this is the first instance of the application.
     bool m_hasPreExistingInstance;
 };
 
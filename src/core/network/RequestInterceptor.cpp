@@ -1,5 +1,6 @@
 #include "AdBlockManager.h"
 #include "RequestInterceptor.h"
+#include "TraceLog.h"
 #include "UserAgentManager.h"
 #include "WebPage.h"
 
@@ -43,6 +44,8 @@ void RequestInterceptor::fetchServices()
 
 void RequestInterceptor::interceptRequest(QWebEngineUrlRequestInfo &info)
 {
+    VIPER_TRACE_SCOPE("network", "RequestInterceptor::interceptRequest");
+
     if (!m_adBlockManager)
         fetchServices();
 
@@ -1,5 +1,6 @@
 #include "ViperSchemeHandler.h"
 
+#include <QBuffer>
 #include <QFile>
 #include <QMimeDatabase>
 #include <QMimeType>
@@ -7,12 +8,30 @@
 #include <QWebEngineUrlRequestJob>
 
 ViperSchemeHandler::ViperSchemeHandler(QObject *parent) :
-    QWebEngineUrlSchemeHandler(parent)
+    QWebEngineUrlSchemeHandler(parent),
+    m_generatedPages()
 {
 }
 
+void ViperSchemeHandler::registerPage(const QString &path, const QByteArray &mimeType, PageGenerator generator)
+{
+    m_generatedPages[path] = GeneratedPage { mimeType, std::move(generator) };
+}
+
 void ViperSchemeHandler::requestStarted(QWebEngineUrlRequestJob *request)
 {
+    auto pageIt = m_generatedPages.find(getRequestPath(request));
+    if (pageIt != m_generatedPages.end())
+    {
+        QBuffer *buffer = new QBuffer;
+        buffer->setData(pageIt->second.Generator());
+        buffer->open(QIODevice::ReadOnly);
+
+        connect(request, &QObject::destroyed, buffer, &QBuffer::deleteLater);
+        request->reply(pageIt->second.MimeType, buffer);
+        return;
+    }
+
     QIODevice *contents = loadFile(request);
     if (!contents)
     {
@@ -28,20 +47,25 @@ void ViperSchemeHandler::requestStarted(QWebEngineUrlRequestJob *request)
     request->reply(mimeType, contents);
 }
 
-QIODevice *ViperSchemeHandler::loadFile(QWebEngineUrlRequestJob *request)
+QString ViperSchemeHandler::getRequestPath(QWebEngineUrlRequestJob *request) const
 {
     // Extract file name from URL
-    QString qrcPath = request->requestUrl().toString();
-    qrcPath = qrcPath.mid(6);
-    if (qrcPath.startsWith(QLatin1String("//")))
-        qrcPath = qrcPath.mid(2);
+    QString path = request->requestUrl().toString();
+    path = path.mid(6);
+    if (path.startsWith(QLatin1String("//")))
+        path = path.mid(2);
 
-    int paramPos = qrcPath.indexOf("?");
+    int paramPos = path.indexOf("?");
     if (paramPos >= 0)
-        qrcPath = qrcPath.left(paramPos);
+        path = path.left(paramPos);
+
+    return path;
+}
 
+QIODevice *ViperSchemeHandler::loadFile(QWebEngineUrlRequestJob *request)
+{
     // Attempt to load the qrc file
-    QFile *f = new QFile(QString(":/%1").arg(qrcPath));
+    QFile *f = new QFile(QString(":/%1").arg(getRequestPath(request)));
     if (!f->open(QIODevice::ReadOnly))
     {
         delete f;
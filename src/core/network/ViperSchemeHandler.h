@@ -1,6 +1,11 @@
 #ifndef VIPERSCHEMEHANDLER_H
 #define VIPERSCHEMEHANDLER_H
 
+#include <functional>
+#include <unordered_map>
+
+#include <QByteArray>
+#include <QString>
 #include <QWebEngineUrlSchemeHandler>
 
 class QIODevice;
@@ -8,22 +13,53 @@ class QWebEngineUrlRequestJob;
 
 /**
  * @class ViperSchemeHandler
- * @brief Implements the viper scheme (wrapper for qrc) for the QtWebEngine backend
+ * @brief Implements the viper scheme (wrapper for qrc) for the QtWebEngine backend.
+ *
+ *        Besides the files in qrc, the handler serves pages whose contents are generated each time they are
+ *        requested, such as viper://resources.
  */
 class ViperSchemeHandler : public QWebEngineUrlSchemeHandler
 {
     Q_OBJECT
 
 public:
+    /// Generates the contents of a page when it is requested
+    using PageGenerator = std::function<QByteArray()>;
+
     /// Constructs the viper scheme handler with an optional parent
     ViperSchemeHandler(QObject *parent = nullptr);
 
+    /**
+     * @brief Registers a page that is generated each time it is requested, rather than loaded from qrc
+     * @param path Path of the page, such as "resources" for viper://resources
+     * @param mimeType MIME type of the page
+     * @param generator Function returning the contents of the page. Called on the GUI thread
+     */
+    void registerPage(const QString &path, const QByteArray &mimeType, PageGenerator generator);
+
     /// Called whenever a request for the viper scheme is started
     void requestStarted(QWebEngineUrlRequestJob *request) override;
 
 private:
+    /// A page that is generated each time it is requested
+    struct GeneratedPage
+    {
+        /// MIME type of the page
+        QByteArray MimeType;
+
+        /// Generates the contents of the page
+        PageGenerator Generator;
+    };
+
+    /// Returns the path of the file or page requested by the viper scheme request, without the scheme or any query
+    QString getRequestPath(QWebEngineUrlRequestJob *request) const;
+
     /// Loads the qrc file associated with the viper scheme request
     QIODevice *loadFile(QWebEngineUrlRequestJob *request);
+
+private:
+    /// Pages that are generated when requested, keyed by their path
+    std::unordered_map<QString, GeneratedPage> m_generatedPages;
 };
 
 #endif // VIPERSCHEMEHANDLER_H
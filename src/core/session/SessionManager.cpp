@@ -2,25 +2,62 @@
 #include "BrowserApplication.h"
 #include "BrowserTabWidget.h"
 #include "CommonUtil.h"
+#include "DatabaseTaskScheduler.h"
+#include "FaviconManager.h"
 #include "MainWindow.h"
+#include "SessionStore.h"
+#include "SessionWarmUpQueue.h"
 #include "WebHistory.h"
 #include "WebWidget.h"
 
 #include <QByteArray>
 #include <QFile>
+#include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonValue>
 #include <QString>
 #include <QUrl>
+#include <QVariant>
 
-SessionManager::SessionManager() :
+namespace
+{
+    /// Number of the most recently used background tabs that are loaded after a session is restored
+    constexpr int WarmUpTabCount = 4;
+
+    /// Maximum number of background tabs that are loaded at the same time after a session is restored
+    constexpr int MaxConcurrentWarmUps = 2;
+
+    /// Name of the dynamic property that holds the session identifier of a window or tab
+    constexpr const char *SessionIdProperty = "viperSessionId";
+
+    /// Sets the favicon identifier of the given tab. Called on the session store's strand, as the favicon store is queried
+    void resolveFaviconId(FaviconManager *faviconManager, SessionTab &tab)
+    {
+        if (faviconManager && tab.FaviconId < 0)
+            tab.FaviconId = faviconManager->getFaviconId(tab.URL);
+    }
+}
+
+SessionManager::SessionManager(DatabaseTaskScheduler &taskScheduler) :
+    m_taskScheduler(taskScheduler),
+    m_store(),
+    m_faviconManager(nullptr),
     m_dataFile(),
+    m_snapshotFile(),
+    m_logFile(),
+    m_lastState(),
+    m_lastSessionId(0),
+    m_hasCheckpoint(false),
     m_savedSession(false)
 {
 }
 
+SessionManager::~SessionManager()
+{
+}
+
 bool SessionManager::alreadySaved() const
 {
     return m_savedSession;
@@ -29,79 +66,167 @@ bool SessionManager::alreadySaved() const
 void SessionManager::setSessionFile(const QString &fullPath)
 {
     m_dataFile = fullPath;
+
+    const QFileInfo fileInfo(fullPath);
+    const QString basePath = fileInfo.path() + QLatin1Char('/') + fileInfo.completeBaseName();
+    m_snapshotFile = basePath + QLatin1String(".snapshot");
+    m_logFile = basePath + QLatin1String(".log");
+
+    m_store = std::make_shared<SessionStore>(m_snapshotFile, m_logFile);
 }
 
-void SessionManager::saveState(std::vector<MainWindow*> &windows)
+void SessionManager::setFaviconManager(FaviconManager *faviconManager)
 {
-    QFile dataFile(m_dataFile);
-    if (!dataFile.open(QIODevice::WriteOnly))
+    m_faviconManager = faviconManager;
+}
+
+void SessionManager::checkpoint(const std::vector<MainWindow*> &windows)
+{
+    // Once the session has been saved, the windows are closing and must not be removed from the session
+    if (m_savedSession || windows.empty() || !m_store)
         return;
 
-    // Construct a QJsonDocument containing an array of windows corresponding to the container passed to this method
-    QJsonObject sessionObj;
-    QJsonArray windowArray;
+    SessionState state;
+    std::vector<SessionRecord> records;
+
     for (MainWindow *win : windows)
     {
-        QJsonObject winObj;
-        QJsonArray tabArray;
-
-        // Add each tab's URL to the array
         BrowserTabWidget *tabWidget = win->getTabWidget();
-        int numTabs = tabWidget->count();
+
+        SessionWindow window;
+        window.WindowId = getSessionId(win);
+        window.Geometry = win->geometry();
+        window.IsMaximized = win->isMaximized();
+        window.CurrentTab = tabWidget->currentIndex();
+
+        auto lastWindow = m_lastState.Windows.find(window.WindowId);
+        if (lastWindow == m_lastState.Windows.end() || !(lastWindow->second == window))
+        {
+            SessionRecord record;
+            record.Type = SessionRecordType::WindowChanged;
+            record.Window = window;
+            records.push_back(std::move(record));
+        }
+
+        state.Windows[window.WindowId] = window;
+
+        int index = 0;
+        const int numTabs = tabWidget->count();
         for (int i = 0; i < numTabs; ++i)
         {
             WebWidget *ww = tabWidget->getWebWidget(i);
             if (!ww)
                 continue;
 
-            QJsonObject tabInfoObj;
-            tabInfoObj.insert(QLatin1String("url"), QJsonValue(ww->url().toString()));
-            tabInfoObj.insert(QLatin1String("is_pinned"), QJsonValue(tabWidget->isTabPinned(i)));
-            tabInfoObj.insert(QLatin1String("is_hibernating"), QJsonValue(ww->isHibernating()));
-            tabInfoObj.insert(QLatin1String("title"), QJsonValue(ww->getTitle()));
+            SessionTab tab;
+            tab.TabId = getSessionId(ww);
+            tab.WindowId = window.WindowId;
+            tab.Index = index++;
+            tab.IsPinned = tabWidget->isTabPinned(i);
+            // Placeholders that were never shown are restored as placeholders again, rather than as hibernating tabs
+            tab.IsHibernating = ww->isHibernating() && !ww->isPlaceholder();
+            tab.URL = ww->url();
+            tab.Title = ww->getTitle();
+            tab.IconUrl = ww->getIconUrl();
+            tab.LastActive = ww->getLastActiveTime();
+
+            // The navigation history of a tab is only fetched again when its state has changed. The icon
+            // identifier is looked up on the session store's strand, when the change is written
+            auto lastTab = m_lastState.Tabs.find(tab.TabId);
+            if (lastTab != m_lastState.Tabs.end() && lastTab->second.hasSameState(tab))
+            {
+                tab.History = lastTab->second.History;
+            }
+            else
+            {
+                tab.History = ww->getEncodedHistory();
 
-            QIcon icon = ww->getIcon();
-            if (icon.isNull())
-                icon = tabWidget->tabIcon(i);
+                SessionRecord record;
+                record.Type = (lastTab == m_lastState.Tabs.end()) ? SessionRecordType::TabOpened : SessionRecordType::TabNavigated;
+                record.Tab = tab;
+                records.push_back(std::move(record));
+            }
 
-            QByteArray faviconB64 = CommonUtil::iconToBase64(icon);
-            auto faviconEncoded = QLatin1String(faviconB64.data());
-            tabInfoObj.insert(QLatin1String("icon"), QJsonValue(faviconEncoded));
-            tabInfoObj.insert(QLatin1String("icon_url"), QJsonValue(ww->getIconUrl().toString()));
+            state.Tabs[tab.TabId] = tab;
+        }
+    }
 
-            QByteArray tabHistoryB64 = ww->getEncodedHistory().toBase64();
-            auto tabHistoryEncoded = QLatin1String(tabHistoryB64.data());
-            tabInfoObj.insert(QLatin1String("history"), QJsonValue(tabHistoryEncoded));
+    for (const auto &it : m_lastState.Tabs)
+    {
+        if (state.Tabs.find(it.first) == state.Tabs.end())
+        {
+            SessionRecord record;
+            record.Type = SessionRecordType::TabClosed;
+            record.Tab.TabId = it.first;
+            records.push_back(std::move(record));
+        }
+    }
 
-            tabArray.append(QJsonValue(tabInfoObj));
+    for (const auto &it : m_lastState.Windows)
+    {
+        if (state.Windows.find(it.first) == state.Windows.end())
+        {
+            SessionRecord record;
+            record.Type = SessionRecordType::WindowClosed;
+            record.Window.WindowId = it.first;
+            records.push_back(std::move(record));
         }
+    }
 
-        winObj.insert(QLatin1String("tabs"), QJsonValue(tabArray));
-        winObj.insert(QLatin1String("current_tab"), QJsonValue(tabWidget->currentIndex()));
+    m_lastState = std::move(state);
 
-        // Store geometry of window
-        const QRect &winGeom = win->geometry();
-        winObj.insert(QLatin1String("geom_x"), QJsonValue(winGeom.x()));
-        winObj.insert(QLatin1String("geom_y"), QJsonValue(winGeom.y()));
-        winObj.insert(QLatin1String("geom_width"), QJsonValue(winGeom.width()));
-        winObj.insert(QLatin1String("geom_height"), QJsonValue(winGeom.height()));
+    // The first checkpoint replaces the session of the previous run, which has been restored by now.
+    // All session tasks share a priority, so that they are written in the order they were posted
+    std::shared_ptr<SessionStore> store = m_store;
+    FaviconManager *faviconManager = m_faviconManager;
+    if (!m_hasCheckpoint)
+    {
+        m_hasCheckpoint = true;
+        m_taskScheduler.post(DatabaseTaskPriority::Background, "SessionStore", [store, faviconManager, state = m_lastState]() mutable {
+            for (auto &it : state.Tabs)
+                resolveFaviconId(faviconManager, it.second);
 
-        winObj.insert(QLatin1String("is_maximized"), QJsonValue(win->isMaximized()));
+            store->reset(std::move(state));
+        });
+    }
+    else if (!records.empty())
+    {
+        m_taskScheduler.post(DatabaseTaskPriority::Background, "SessionStore", [store, faviconManager, records = std::move(records)]() mutable {
+            for (SessionRecord &record : records)
+            {
+                if (record.Type == SessionRecordType::TabOpened || record.Type == SessionRecordType::TabNavigated)
+                    resolveFaviconId(faviconManager, record.Tab);
+            }
 
-        windowArray.append(QJsonValue(winObj));
+            store->append(records);
+        });
     }
-    sessionObj.insert(QLatin1String("windows"), QJsonValue(windowArray));
+}
 
-    // Save to file
-    QJsonDocument sessionDoc(sessionObj);
-    dataFile.write(sessionDoc.toJson());
-    dataFile.close();
+void SessionManager::saveState(std::vector<MainWindow*> &windows)
+{
+    checkpoint(windows);
+
+    if (m_store)
+    {
+        std::shared_ptr<SessionStore> store = m_store;
+        m_taskScheduler.post(DatabaseTaskPriority::Background, "SessionStore", [store](){
+            store->compact();
+        });
+    }
 
     m_savedSession = true;
 }
 
 void SessionManager::restoreSession(MainWindow *firstWindow, BrowserApplication *browserApplication)
 {
+    SessionState state;
+    if (!m_snapshotFile.isEmpty() && SessionStore::readSession(m_snapshotFile, m_logFile, state))
+    {
+        restoreState(state, firstWindow, browserApplication);
+        return;
+    }
+
     QFile dataFile(m_dataFile);
     if (!dataFile.exists() || !dataFile.open(QIODevice::ReadOnly))
         return;
@@ -114,7 +239,97 @@ void SessionManager::restoreSession(MainWindow *firstWindow, BrowserApplication
     if (!sessionDoc.isObject())
         return;
 
-    QJsonObject sessionObj = sessionDoc.object();
+    restoreLegacySession(sessionDoc.object(), firstWindow, browserApplication);
+}
+
+void SessionManager::restoreState(const SessionState &state, MainWindow *firstWindow, BrowserApplication *browserApplication)
+{
+    FaviconManager *faviconManager = browserApplication->getFaviconManager();
+
+    SessionWarmUpQueue *warmUpQueue = new SessionWarmUpQueue(WarmUpTabCount, MaxConcurrentWarmUps, browserApplication);
+
+    bool isFirstWindow = true;
+    MainWindow *currentWindow = firstWindow;
+
+    for (const auto &it : state.Windows)
+    {
+        const SessionWindow &window = it.second;
+
+        if (!isFirstWindow)
+            currentWindow = browserApplication->getNewWindow();
+
+        isFirstWindow = false;
+
+        // Restore window properties
+        if (window.IsMaximized)
+            currentWindow->showMaximized();
+        else if (window.Geometry.isValid())
+            currentWindow->setGeometry(window.Geometry);
+
+        // Restore tabs belonging to the window
+        BrowserTabWidget *tabWidget = currentWindow->getTabWidget();
+
+        int i = 0;
+        for (const SessionTab &tab : state.getTabsOfWindow(window.WindowId))
+        {
+            WebState webState;
+            webState.title = tab.Title;
+            webState.iconUrl = tab.IconUrl;
+            webState.url = tab.URL;
+            webState.pageHistory = tab.History;
+
+            // Icons that are not cached are left empty, and are looked up by the tab from its URL
+            if (faviconManager && tab.FaviconId >= 0)
+                webState.icon = faviconManager->getFaviconById(tab.FaviconId);
+
+            // Only the active tab of each window is loaded right away. The other tabs are restored as placeholders,
+            // which load their page once they are activated. The first tab of a window already has a web view
+            const bool isPlaceholder = (i != window.CurrentTab && !tab.IsHibernating);
+
+            WebWidget *ww = nullptr;
+            if (i == 0)
+            {
+                ww = qobject_cast<WebWidget*>(tabWidget->widget(0));
+                if (isPlaceholder)
+                    ww->setPlaceholderState(std::move(webState));
+                else
+                {
+                    ww->setHibernation(tab.IsHibernating);
+                    ww->setWebState(std::move(webState));
+                }
+            }
+            else if (isPlaceholder || tab.IsHibernating)
+            {
+                ww = tabWidget->newPlaceholderTabAtIndex(i, std::move(webState));
+
+                // A hibernating tab stays asleep until it is clicked, like any other hibernating tab
+                if (tab.IsHibernating)
+                    ww->setHibernation(true);
+            }
+            else
+            {
+                ww = tabWidget->newBackgroundTabAtIndex(i, std::move(webState));
+            }
+
+            tabWidget->setTabPinned(i, tab.IsPinned);
+
+            if (i != window.CurrentTab)
+                ww->setLastActiveTime(tab.LastActive);
+            if (isPlaceholder)
+                warmUpQueue->addTab(ww, tab.LastActive);
+
+            ++i;
+        }
+
+        // Set current tab to the last active tab
+        tabWidget->setCurrentIndex(window.CurrentTab);
+    }
+
+    warmUpQueue->start();
+}
+
+void SessionManager::restoreLegacySession(const QJsonObject &sessionObj, MainWindow *firstWindow, BrowserApplication *browserApplication)
+{
     auto it = sessionObj.find(QLatin1String("windows"));
     if (it == sessionObj.end())
         return;
@@ -166,8 +381,9 @@ void SessionManager::restoreSession(MainWindow *firstWindow, BrowserApplication
                 webState.iconUrl = QUrl::fromUserInput(tabInfoObj.value(QLatin1String("icon_url")).toString());
                 webState.url = QUrl::fromUserInput(tabInfoObj.value(QLatin1String("url")).toString());
 
+                // Session files written by older versions embed the icon of each tab
                 const QByteArray faviconData = tabInfoObj.value(QLatin1String("icon")).toString().toLatin1();
-                if (!faviconData.isNull())
+                if (!faviconData.isEmpty())
                     webState.icon = CommonUtil::iconFromBase64(faviconData);
 
                 const QByteArray encodedHistory = tabInfoObj.value(QLatin1String("history")).toString().toLatin1();
@@ -191,3 +407,16 @@ void SessionManager::restoreSession(MainWindow *firstWindow, BrowserApplication
         tabWidget->setCurrentIndex(currentTab);
     }
 }
+
+quint32 SessionManager::getSessionId(QObject *object)
+{
+    // The identifier is kept on the object itself, so that it is not inherited by an object that is later
+    // allocated at the same address
+    const QVariant sessionId = object->property(SessionIdProperty);
+    if (sessionId.isValid())
+        return sessionId.value<quint32>();
+
+    const quint32 newId = ++m_lastSessionId;
+    object->setProperty(SessionIdProperty, newId);
+    return newId;
+}
@@ -1,30 +1,52 @@
 #ifndef SESSIONMANAGER_H
 #define SESSIONMANAGER_H
 
-#include <QString>
+#include "SessionState.h"
+
+#include <memory>
 #include <vector>
 
+#include <QString>
+
 class BrowserApplication;
+class DatabaseTaskScheduler;
+class FaviconManager;
 class MainWindow;
+class QJsonObject;
+class QObject;
+class SessionStore;
 
 /**
  * @class SessionManager
- * @brief Handles the serialization of active browsing sessions when the application is being closed, and the
- *        deserialization of a saved browsing session when the application is being initialized
+ * @brief Handles the serialization of active browsing sessions while the application is running and when it is
+ *        being closed, and the deserialization of a saved browsing session when the application is being initialized.
+ *
+ *        Each checkpoint compares the windows and tabs with the state from the previous checkpoint, and only the
+ *        changes are sent to the \ref SessionStore, which writes them on its own database strand.
  */
 class SessionManager
 {
 public:
-    /// Default constructor
-    SessionManager();
+    /// Constructs the session manager, given the task scheduler that runs the strand on which the session is written
+    explicit SessionManager(DatabaseTaskScheduler &taskScheduler);
+
+    /// Destructor
+    ~SessionManager();
 
     /// Returns true if the session has already been saved, false if else
     bool alreadySaved() const;
 
-    /// Sets the path of the data file in which session information is stored
+    /// Sets the path of the data file in which session information is stored. The session snapshot and log are
+    /// stored next to it, with the same base name
     void setSessionFile(const QString &fullPath);
 
-    /// Saves the state of each window in the container
+    /// Sets the favicon manager, which is used to reference the icon of each tab by its identifier
+    void setFaviconManager(FaviconManager *faviconManager);
+
+    /// Writes the changes made to the given windows since the last checkpoint to the session log
+    void checkpoint(const std::vector<MainWindow*> &windows);
+
+    /// Saves the state of each window in the container, and compacts the session log into a new snapshot
     void saveState(std::vector<MainWindow*> &windows);
 
     /**
@@ -37,9 +59,43 @@ class SessionManager
     void restoreSession(MainWindow *firstWindow, BrowserApplication *browserApplication);
 
 private:
-    /// Path of the file in which session data is stored
+    /// Restores the windows and tabs of a session that was read from the session snapshot and log
+    void restoreState(const SessionState &state, MainWindow *firstWindow, BrowserApplication *browserApplication);
+
+    /// Restores a session from the JSON file that was written by older versions of the browser
+    void restoreLegacySession(const QJsonObject &sessionObj, MainWindow *firstWindow, BrowserApplication *browserApplication);
+
+    /// Returns the session identifier of the given window or tab, assigning one if it does not have an identifier yet
+    quint32 getSessionId(QObject *object);
+
+private:
+    /// Task scheduler that runs the strand of the session store
+    DatabaseTaskScheduler &m_taskScheduler;
+
+    /// Writes the session to disk. Only accessed on the session store's strand after it is created
+    std::shared_ptr<SessionStore> m_store;
+
+    /// Favicon manager
+    FaviconManager *m_faviconManager;
+
+    /// Path of the JSON file in which older versions of the browser stored the session
     QString m_dataFile;
 
+    /// Path of the session snapshot
+    QString m_snapshotFile;
+
+    /// Path of the session log
+    QString m_logFile;
+
+    /// State of the session as of the last checkpoint
+    SessionState m_lastState;
+
+    /// Last session identifier that was assigned to a window or tab
+    quint32 m_lastSessionId;
+
+    /// True once the first checkpoint, which replaces the session from the previous run, has been written
+    bool m_hasCheckpoint;
+
     /// True if session has already been saved, false if else
     bool m_savedSession;
 };
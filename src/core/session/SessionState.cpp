@@ -0,0 +1,173 @@
+#include "SessionState.h"
+
+#include <algorithm>
+
+bool SessionTab::hasSameState(const SessionTab &other) const
+{
+    return WindowId == other.WindowId
+            && Index == other.Index
+            && IsPinned == other.IsPinned
+            && IsHibernating == other.IsHibernating
+            && URL == other.URL
+            && Title == other.Title
+            && IconUrl == other.IconUrl
+            && LastActive == other.LastActive;
+}
+
+bool SessionWindow::operator ==(const SessionWindow &other) const
+{
+    return WindowId == other.WindowId
+            && Geometry == other.Geometry
+            && IsMaximized == other.IsMaximized
+            && CurrentTab == other.CurrentTab;
+}
+
+void SessionState::apply(const SessionRecord &record)
+{
+    switch (record.Type)
+    {
+        case SessionRecordType::TabOpened:
+        case SessionRecordType::TabNavigated:
+            Tabs[record.Tab.TabId] = record.Tab;
+            break;
+        case SessionRecordType::TabClosed:
+            Tabs.erase(record.Tab.TabId);
+            break;
+        case SessionRecordType::WindowChanged:
+            Windows[record.Window.WindowId] = record.Window;
+            break;
+        case SessionRecordType::WindowClosed:
+        {
+            Windows.erase(record.Window.WindowId);
+
+            // Tabs are closed along with their window
+            for (auto it = Tabs.begin(); it != Tabs.end();)
+            {
+                if (it->second.WindowId == record.Window.WindowId)
+                    it = Tabs.erase(it);
+                else
+                    ++it;
+            }
+            break;
+        }
+    }
+}
+
+std::vector<SessionTab> SessionState::getTabsOfWindow(quint32 windowId) const
+{
+    std::vector<SessionTab> result;
+    for (const auto &it : Tabs)
+    {
+        if (it.second.WindowId == windowId)
+            result.push_back(it.second);
+    }
+
+    std::stable_sort(result.begin(), result.end(), [](const SessionTab &a, const SessionTab &b) {
+        return a.Index < b.Index;
+    });
+    return result;
+}
+
+QDataStream &operator<<(QDataStream &out, const SessionTab &tab)
+{
+    out << tab.TabId
+        << tab.WindowId
+        << static_cast<qint32>(tab.Index)
+        << tab.IsPinned
+        << tab.IsHibernating
+        << tab.URL
+        << tab.Title
+        << tab.IconUrl
+        << static_cast<qint32>(tab.FaviconId)
+        << tab.History
+        << tab.LastActive;
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, SessionTab &tab)
+{
+    qint32 index = 0, faviconId = -1;
+    in >> tab.TabId
+       >> tab.WindowId
+       >> index
+       >> tab.IsPinned
+       >> tab.IsHibernating
+       >> tab.URL
+       >> tab.Title
+       >> tab.IconUrl
+       >> faviconId
+       >> tab.History
+       >> tab.LastActive;
+    tab.Index = index;
+    tab.FaviconId = faviconId;
+    return in;
+}
+
+QDataStream &operator<<(QDataStream &out, const SessionWindow &window)
+{
+    out << window.WindowId
+        << window.Geometry
+        << window.IsMaximized
+        << static_cast<qint32>(window.CurrentTab);
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, SessionWindow &window)
+{
+    qint32 currentTab = 0;
+    in >> window.WindowId
+       >> window.Geometry
+       >> window.IsMaximized
+       >> currentTab;
+    window.CurrentTab = currentTab;
+    return in;
+}
+
+QDataStream &operator<<(QDataStream &out, const SessionRecord &record)
+{
+    out << static_cast<quint8>(record.Type);
+    switch (record.Type)
+    {
+        case SessionRecordType::TabOpened:
+        case SessionRecordType::TabNavigated:
+            out << record.Tab;
+            break;
+        case SessionRecordType::TabClosed:
+            out << record.Tab.TabId;
+            break;
+        case SessionRecordType::WindowChanged:
+            out << record.Window;
+            break;
+        case SessionRecordType::WindowClosed:
+            out << record.Window.WindowId;
+            break;
+    }
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, SessionRecord &record)
+{
+    quint8 type = 0;
+    in >> type;
+    record.Type = static_cast<SessionRecordType>(type);
+    switch (record.Type)
+    {
+        case SessionRecordType::TabOpened:
+        case SessionRecordType::TabNavigated:
+            in >> record.Tab;
+            break;
+        case SessionRecordType::TabClosed:
+            in >> record.Tab.TabId;
+            break;
+        case SessionRecordType::WindowChanged:
+            in >> record.Window;
+            break;
+        case SessionRecordType::WindowClosed:
+            in >> record.Window.WindowId;
+            break;
+        default:
+            in.setStatus(QDataStream::ReadCorruptData);
+            break;
+    }
+    return in;
+}
@@ -0,0 +1,134 @@
+#ifndef SESSIONSTATE_H
+#define SESSIONSTATE_H
+
+#include <map>
+#include <vector>
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QRect>
+#include <QString>
+#include <QUrl>
+
+/**
+ * @struct SessionTab
+ * @brief Contains the state of a single tab in a browsing session
+ */
+struct SessionTab
+{
+    /// Identifier of the tab, unique within the session
+    quint32 TabId { 0 };
+
+    /// Identifier of the window that contains the tab
+    quint32 WindowId { 0 };
+
+    /// Index of the tab in its window
+    int Index { 0 };
+
+    /// True if the tab is pinned
+    bool IsPinned { false };
+
+    /// True if the tab's web page is hibernating
+    bool IsHibernating { false };
+
+    /// URL of the tab's web page
+    QUrl URL;
+
+    /// Title of the tab's web page
+    QString Title;
+
+    /// URL of the web page's icon
+    QUrl IconUrl;
+
+    /// Identifier of the web page's icon in the favicon store, or -1 if the icon was not known
+    int FaviconId { -1 };
+
+    /// Serialized navigation history of the tab
+    QByteArray History;
+
+    /// Last time the tab was shown, in milliseconds since the epoch, or 0 if it has not been shown
+    qint64 LastActive { 0 };
+
+    /// Returns true if the state of the tab that is compared between checkpoints, which excludes its
+    /// navigation history and icon identifier, is the same in both tabs
+    bool hasSameState(const SessionTab &other) const;
+};
+
+/**
+ * @struct SessionWindow
+ * @brief Contains the state of a browser window in a browsing session, not including its tabs
+ */
+struct SessionWindow
+{
+    /// Identifier of the window, unique within the session
+    quint32 WindowId { 0 };
+
+    /// Geometry of the window
+    QRect Geometry;
+
+    /// True if the window is maximized
+    bool IsMaximized { false };
+
+    /// Index of the active tab in the window
+    int CurrentTab { 0 };
+
+    /// Returns true if both windows have the same state
+    bool operator ==(const SessionWindow &other) const;
+};
+
+/// Types of the changes to a browsing session that are recorded in the session log
+enum class SessionRecordType : quint8
+{
+    TabOpened     = 1,
+    TabNavigated  = 2,
+    TabClosed     = 3,
+    WindowChanged = 4,
+    WindowClosed  = 5
+};
+
+/**
+ * @struct SessionRecord
+ * @brief A single change to a browsing session. Tabs that are opened or navigated carry their full
+ *        state, while tabs and windows that are closed only carry their identifier
+ */
+struct SessionRecord
+{
+    /// Type of the change
+    SessionRecordType Type { SessionRecordType::TabOpened };
+
+    /// State of the tab, for tab records
+    SessionTab Tab;
+
+    /// State of the window, for window records
+    SessionWindow Window;
+};
+
+/**
+ * @struct SessionState
+ * @brief Contains the windows and tabs of a browsing session
+ */
+struct SessionState
+{
+    /// Windows of the session, ordered by their identifiers, which follow the order in which the windows were opened
+    std::map<quint32, SessionWindow> Windows;
+
+    /// Tabs of the session, by their identifiers
+    std::map<quint32, SessionTab> Tabs;
+
+    /// Applies the given change to the session
+    void apply(const SessionRecord &record);
+
+    /// Returns the tabs of the given window, ordered by their index
+    std::vector<SessionTab> getTabsOfWindow(quint32 windowId) const;
+};
+
+QDataStream &operator<<(QDataStream &out, const SessionTab &tab);
+QDataStream &operator>>(QDataStream &in, SessionTab &tab);
+
+QDataStream &operator<<(QDataStream &out, const SessionWindow &window);
+QDataStream &operator>>(QDataStream &in, SessionWindow &window);
+
+QDataStream &operator<<(QDataStream &out, const SessionRecord &record);
+QDataStream &operator>>(QDataStream &in, SessionRecord &record);
+
+#endif // SESSIONSTATE_H
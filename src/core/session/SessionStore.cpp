@@ -0,0 +1,303 @@
+#include "SessionStore.h"
+
+#include <algorithm>
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QSaveFile>
+#include <QtGlobal>
+
+#include <QDebug>
+
+#if defined(Q_OS_WIN)
+#  include <io.h>
+#else
+#  include <unistd.h>
+#endif
+
+namespace
+{
+    /// Identifies a session snapshot file ("VSS1")
+    constexpr quint32 SnapshotMagic = 0x56535331;
+
+    /// Identifies a session log file ("VSL1")
+    constexpr quint32 LogMagic = 0x56534C31;
+
+    /// Version of the snapshot and log formats
+    constexpr quint32 FormatVersion = 2;
+
+    /// Size of the log file at which it is compacted into a new snapshot
+    constexpr qint64 MaxLogSize = 1024 * 1024;
+
+    /// Number of records in the log at which it is compacted into a new snapshot
+    constexpr int MaxLogRecords = 1000;
+
+    /// Reads the header of a snapshot or log, returning true if it has the given magic number and a supported version
+    bool readHeader(QDataStream &stream, quint32 magic, quint64 &generation)
+    {
+        quint32 fileMagic = 0, version = 0;
+        stream >> fileMagic
+               >> version
+               >> generation;
+        return stream.status() == QDataStream::Ok && fileMagic == magic && version == FormatVersion;
+    }
+
+    /// Writes the header of a snapshot or log
+    void writeHeader(QDataStream &stream, quint32 magic, quint64 generation)
+    {
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream << magic
+               << FormatVersion
+               << generation;
+    }
+}
+
+SessionStore::SessionStore(const QString &snapshotFile, const QString &logFile) :
+    m_state(),
+    m_snapshotFile(snapshotFile),
+    m_logFile(logFile),
+    m_log(),
+    m_generation(0),
+    m_numLogRecords(0)
+{
+}
+
+SessionStore::~SessionStore()
+{
+}
+
+bool SessionStore::readSession(const QString &snapshotFile, const QString &logFile, SessionState &state)
+{
+    QFile snapshot(snapshotFile);
+    if (!snapshot.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream snapshotStream(&snapshot);
+    snapshotStream.setVersion(QDataStream::Qt_6_0);
+
+    quint64 generation = 0;
+    if (!readHeader(snapshotStream, SnapshotMagic, generation))
+    {
+        qWarning() << "SessionStore - session snapshot is not in a supported format";
+        return false;
+    }
+
+    SessionState result;
+
+    quint32 numWindows = 0;
+    snapshotStream >> numWindows;
+    for (quint32 i = 0; i < numWindows && snapshotStream.status() == QDataStream::Ok; ++i)
+    {
+        SessionWindow window;
+        snapshotStream >> window;
+        result.Windows[window.WindowId] = window;
+    }
+
+    quint32 numTabs = 0;
+    snapshotStream >> numTabs;
+    for (quint32 i = 0; i < numTabs && snapshotStream.status() == QDataStream::Ok; ++i)
+    {
+        SessionTab tab;
+        snapshotStream >> tab;
+        result.Tabs[tab.TabId] = tab;
+    }
+
+    if (snapshotStream.status() != QDataStream::Ok)
+    {
+        qWarning() << "SessionStore - could not read session snapshot";
+        return false;
+    }
+
+    // Replay the changes that were made after the snapshot was written, stopping at the first record that
+    // was only partially written or is corrupt
+    QFile log(logFile);
+    if (log.open(QIODevice::ReadOnly))
+    {
+        QDataStream logStream(&log);
+        logStream.setVersion(QDataStream::Qt_6_0);
+
+        quint64 logGeneration = 0;
+        if (readHeader(logStream, LogMagic, logGeneration) && logGeneration == generation)
+        {
+            for (;;)
+            {
+                quint32 length = 0;
+                quint16 checksum = 0;
+                logStream >> length
+                          >> checksum;
+                if (logStream.status() != QDataStream::Ok || length > log.bytesAvailable())
+                    break;
+
+                QByteArray payload(static_cast<qsizetype>(length), Qt::Uninitialized);
+                if (logStream.readRawData(payload.data(), static_cast<int>(length)) != static_cast<int>(length)
+                        || qChecksum(payload) != checksum)
+                    break;
+
+                QDataStream recordStream(payload);
+                recordStream.setVersion(QDataStream::Qt_6_0);
+
+                SessionRecord record;
+                recordStream >> record;
+                if (recordStream.status() != QDataStream::Ok)
+                    break;
+
+                result.apply(record);
+            }
+        }
+    }
+
+    state = std::move(result);
+    return true;
+}
+
+void SessionStore::reset(SessionState state)
+{
+    m_state = std::move(state);
+    compact();
+}
+
+void SessionStore::append(const std::vector<SessionRecord> &records)
+{
+    if (records.empty())
+        return;
+
+    for (const SessionRecord &record : records)
+        m_state.apply(record);
+
+    // The log is opened once the session has a snapshot to which its records apply
+    if (!m_log)
+    {
+        compact();
+        return;
+    }
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+    for (const SessionRecord &record : records)
+    {
+        QByteArray payload;
+        QDataStream recordStream(&payload, QIODevice::WriteOnly);
+        recordStream.setVersion(QDataStream::Qt_6_0);
+        recordStream << record;
+
+        stream << static_cast<quint32>(payload.size())
+               << qChecksum(payload);
+        stream.writeRawData(payload.constData(), static_cast<int>(payload.size()));
+    }
+
+    if (m_log->write(data) != data.size() || !syncFile(*m_log))
+    {
+        qWarning() << "SessionStore - could not append to the session log";
+
+        // Start over from a complete snapshot, in case the log now ends with a partial record
+        compact();
+        return;
+    }
+
+    m_numLogRecords += static_cast<int>(records.size());
+    if (m_numLogRecords >= MaxLogRecords || m_log->size() >= MaxLogSize)
+        compact();
+}
+
+void SessionStore::compact()
+{
+    if (!writeSnapshot())
+        return;
+
+    resetLog();
+}
+
+bool SessionStore::writeSnapshot()
+{
+    // The generation of the first snapshot follows that of the snapshot left by the previous run
+    if (m_generation == 0)
+    {
+        QFile previousSnapshot(m_snapshotFile);
+        if (previousSnapshot.open(QIODevice::ReadOnly))
+        {
+            QDataStream stream(&previousSnapshot);
+            stream.setVersion(QDataStream::Qt_6_0);
+
+            quint64 previousGeneration = 0;
+            if (readHeader(stream, SnapshotMagic, previousGeneration))
+                m_generation = previousGeneration;
+        }
+    }
+
+    const quint64 generation = std::max(static_cast<quint64>(QDateTime::currentMSecsSinceEpoch()), m_generation + 1);
+
+    // QSaveFile writes to a temporary file, which is synced to disk before it is renamed over the snapshot
+    QSaveFile snapshot(m_snapshotFile);
+    if (!snapshot.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "SessionStore - could not open session snapshot for writing";
+        return false;
+    }
+
+    QDataStream stream(&snapshot);
+    writeHeader(stream, SnapshotMagic, generation);
+
+    stream << static_cast<quint32>(m_state.Windows.size());
+    for (const auto &it : m_state.Windows)
+        stream << it.second;
+
+    stream << static_cast<quint32>(m_state.Tabs.size());
+    for (const auto &it : m_state.Tabs)
+        stream << it.second;
+
+    if (stream.status() != QDataStream::Ok || !snapshot.commit())
+    {
+        qWarning() << "SessionStore - could not write session snapshot";
+        return false;
+    }
+
+    m_generation = generation;
+    return true;
+}
+
+bool SessionStore::resetLog()
+{
+    m_log.reset();
+    m_numLogRecords = 0;
+
+    {
+        QSaveFile log(m_logFile);
+        if (!log.open(QIODevice::WriteOnly))
+        {
+            qWarning() << "SessionStore - could not open session log for writing";
+            return false;
+        }
+
+        QDataStream stream(&log);
+        writeHeader(stream, LogMagic, m_generation);
+        if (stream.status() != QDataStream::Ok || !log.commit())
+        {
+            qWarning() << "SessionStore - could not write session log";
+            return false;
+        }
+    }
+
+    auto logFile = std::make_unique<QFile>(m_logFile);
+    if (!logFile->open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        qWarning() << "SessionStore - could not open session log for appending";
+        return false;
+    }
+
+    m_log = std::move(logFile);
+    return true;
+}
+
+bool SessionStore::syncFile(QFile &file)
+{
+    if (!file.flush())
+        return false;
+
+#if defined(Q_OS_WIN)
+    return _commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
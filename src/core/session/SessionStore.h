@@ -0,0 +1,83 @@
+#ifndef SESSIONSTORE_H
+#define SESSIONSTORE_H
+
+#include "SessionState.h"
+
+#include <memory>
+#include <vector>
+
+#include <QString>
+
+class QFile;
+
+/**
+ * @class SessionStore
+ * @brief Persists a browsing session as a binary snapshot, along with a log of the changes that were made
+ *        to the session after the snapshot was written.
+ *
+ *        Changes are appended to the log and synced to disk as they are received, so a checkpoint only writes
+ *        the tabs that changed. Once the log grows past a limit, it is compacted into a new snapshot. Snapshots
+ *        are written to a temporary file that is synced and then renamed over the previous snapshot. Each snapshot
+ *        and log carries a generation number, and a log is only replayed onto the snapshot of its generation, so
+ *        a crash between writing a snapshot and emptying the log cannot replay stale changes.
+ *
+ *        Apart from \ref readSession, the methods of the store must all be called from the same thread.
+ */
+class SessionStore
+{
+public:
+    /// Constructs the session store, given the paths of the snapshot and log files
+    SessionStore(const QString &snapshotFile, const QString &logFile);
+
+    /// Destructor
+    ~SessionStore();
+
+    /**
+     * @brief Reads the session that was stored in the given files
+     * @param snapshotFile Path of the snapshot file
+     * @param logFile Path of the log file. Changes that were only partially written are ignored
+     * @param state Set to the stored session
+     * @return True if the snapshot could be read, false if else
+     */
+    static bool readSession(const QString &snapshotFile, const QString &logFile, SessionState &state);
+
+    /// Replaces the stored session with the given state, writing a new snapshot and an empty log
+    void reset(SessionState state);
+
+    /// Appends the given changes to the log and syncs it to disk. The log is compacted if it has grown too large
+    void append(const std::vector<SessionRecord> &records);
+
+    /// Writes a snapshot of the session and empties the log
+    void compact();
+
+private:
+    /// Writes a snapshot of the session with a new generation number. Returns true on success
+    bool writeSnapshot();
+
+    /// Replaces the log with an empty log of the current generation, and opens it for appending. Returns true on success
+    bool resetLog();
+
+    /// Flushes the given file and syncs it to disk. Returns true on success
+    static bool syncFile(QFile &file);
+
+private:
+    /// The session, as it is stored on disk
+    SessionState m_state;
+
+    /// Path of the snapshot file
+    QString m_snapshotFile;
+
+    /// Path of the log file
+    QString m_logFile;
+
+    /// Log file, opened for appending once the first snapshot has been written
+    std::unique_ptr<QFile> m_log;
+
+    /// Generation number of the current snapshot and log
+    quint64 m_generation;
+
+    /// Number of records in the log
+    int m_numLogRecords;
+};
+
+#endif // SESSIONSTORE_H
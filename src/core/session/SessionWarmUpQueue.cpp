@@ -0,0 +1,66 @@
+#include "SessionWarmUpQueue.h"
+#include "WebWidget.h"
+
+#include <algorithm>
+
+SessionWarmUpQueue::SessionWarmUpQueue(int maxTabs, int maxConcurrentLoads, QObject *parent) :
+    QObject(parent),
+    m_maxTabs(maxTabs),
+    m_maxConcurrentLoads(std::max(maxConcurrentLoads, 1)),
+    m_candidates(),
+    m_pending(),
+    m_loading()
+{
+}
+
+void SessionWarmUpQueue::addTab(WebWidget *webWidget, qint64 lastActiveTime)
+{
+    if (webWidget)
+        m_candidates.emplace_back(webWidget, lastActiveTime);
+}
+
+void SessionWarmUpQueue::start()
+{
+    std::stable_sort(m_candidates.begin(), m_candidates.end(), [](const auto &a, const auto &b) {
+        return a.second > b.second;
+    });
+
+    const std::size_t numTabs = std::min(m_candidates.size(), static_cast<std::size_t>(std::max(m_maxTabs, 0)));
+    for (std::size_t i = 0; i < numTabs; ++i)
+        m_pending.push_back(m_candidates.at(i).first);
+
+    m_candidates.clear();
+    loadNextTabs();
+}
+
+void SessionWarmUpQueue::onTabDone(QObject *tab)
+{
+    if (m_loading.erase(tab) == 0)
+        return;
+
+    disconnect(tab, nullptr, this, nullptr);
+    loadNextTabs();
+}
+
+void SessionWarmUpQueue::loadNextTabs()
+{
+    while (static_cast<int>(m_loading.size()) < m_maxConcurrentLoads && !m_pending.empty())
+    {
+        QPointer<WebWidget> webWidget = m_pending.front();
+        m_pending.pop_front();
+
+        // Skip tabs that were closed, or that were activated or hibernated since they were restored
+        if (webWidget.isNull() || !webWidget->isPlaceholder())
+            continue;
+
+        WebWidget *ww = webWidget.data();
+        m_loading.insert(ww);
+        connect(ww, &WebWidget::loadFinished, this, [this, ww](){ onTabDone(ww); });
+        connect(ww, &QObject::destroyed, this, &SessionWarmUpQueue::onTabDone);
+
+        ww->setHibernation(false);
+    }
+
+    if (m_loading.empty() && m_pending.empty())
+        deleteLater();
+}
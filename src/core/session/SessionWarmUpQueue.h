@@ -0,0 +1,64 @@
+#ifndef SESSIONWARMUPQUEUE_H
+#define SESSIONWARMUPQUEUE_H
+
+#include <deque>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <QObject>
+#include <QPointer>
+
+class WebWidget;
+
+/**
+ * @class SessionWarmUpQueue
+ * @brief Loads the most recently used background tabs of a restored session, which are otherwise only loaded
+ *        once they are activated. At most a fixed number of tabs are loaded at the same time, and the queue
+ *        deletes itself once all of its tabs have been loaded.
+ */
+class SessionWarmUpQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructs the warm-up queue
+     * @param maxTabs Maximum number of tabs that are loaded by the queue
+     * @param maxConcurrentLoads Maximum number of tabs that are loaded at the same time
+     * @param parent Pointer to the parent object
+     */
+    SessionWarmUpQueue(int maxTabs, int maxConcurrentLoads, QObject *parent = nullptr);
+
+    /// Adds the placeholder of a restored tab to the queue, along with the last time it was shown
+    void addTab(WebWidget *webWidget, qint64 lastActiveTime);
+
+    /// Starts loading the most recently used tabs in the queue
+    void start();
+
+private Q_SLOTS:
+    /// Called when a tab that was being loaded has finished loading or has been closed
+    void onTabDone(QObject *tab);
+
+private:
+    /// Loads the next tabs in the queue, until the concurrency limit is reached
+    void loadNextTabs();
+
+private:
+    /// Maximum number of tabs that are loaded by the queue
+    int m_maxTabs;
+
+    /// Maximum number of tabs that are loaded at the same time
+    int m_maxConcurrentLoads;
+
+    /// Tabs that were added to the queue, paired with the last time they were shown
+    std::vector<std::pair<QPointer<WebWidget>, qint64>> m_candidates;
+
+    /// Tabs waiting to be loaded, ordered from the most to the least recently used
+    std::deque<QPointer<WebWidget>> m_pending;
+
+    /// Tabs that are currently loading
+    std::unordered_set<QObject*> m_loading;
+};
+
+#endif // SESSIONWARMUPQUEUE_H
@@ -130,6 +130,12 @@ enum class BrowserSetting
     /// Determines whether or not all new tabs should be opened in the background, without switching from the current tab
     OpenAllTabsInBackground,
 
+    /// Memory budget of the browser and its web pages in MiB, above which background tabs are unloaded (0 for no limit)
+    TabMemoryBudget,
+
+    /// Maximum number of tabs with a loaded web page, above which background tabs are unloaded (0 for no limit)
+    MaxLiveTabs,
+
     /// Standard font
     StandardFont,
 
@@ -1,13 +1,14 @@
 #include "Settings.h"
 
 #include "HistoryManager.h"
+#include "TraceLog.h"
 
 #include <QDir>
 #include <QFileInfo>
 #include <QWebEngineSettings>
 #include <QtWebEngineCoreVersion>
 
-const QString Settings::Version = QStringLiteral("1.0");
+const QString Settings::Version = QStringLiteral("1.1");
 
 Settings::Settings(QWebEngineSettings *webSettings) :
     QObject(nullptr),
@@ -38,10 +39,13 @@ Settings::Settings(QWebEngineSettings *webSettings) :
         { BrowserSetting::FantasyFont, QStringLiteral("FantasyFont") },                { BrowserSetting::FixedFont, QStringLiteral("FixedFont") },
         { BrowserSetting::StandardFontSize, QStringLiteral("StandardFontSize") },      { BrowserSetting::EnableAutoFill, QStringLiteral("EnableAutoFill") },
         { BrowserSetting::CachePath, QStringLiteral("CachePath") },                    { BrowserSetting::ThumbnailPath, QStringLiteral("ThumbnailPath") },
-        { BrowserSetting::FavoritePagesFile, QStringLiteral("FavoritePagesFile") },    { BrowserSetting::Version, QStringLiteral("Version") }
+        { BrowserSetting::FavoritePagesFile, QStringLiteral("FavoritePagesFile") },    { BrowserSetting::TabMemoryBudget, QStringLiteral("TabMemoryBudget") },
+        { BrowserSetting::MaxLiveTabs, QStringLiteral("MaxLiveTabs") },                { BrowserSetting::Version, QStringLiteral("Version") }
     },
     m_webSettings(webSettings)
 {
+    VIPER_TRACE_SCOPE("startup", "Settings");
+
     setObjectName(QStringLiteral("Settings"));
 
     // Check if defaults need to be set
@@ -138,6 +142,8 @@ void Settings::setDefaults()
     m_settings.setValue(QStringLiteral("HistoryStoragePolicy"), static_cast<int>(HistoryStoragePolicy::Remember));
     m_settings.setValue(QStringLiteral("ScrollAnimatorEnabled"), false);
     m_settings.setValue(QStringLiteral("OpenAllTabsInBackground"), false);
+    m_settings.setValue(QStringLiteral("TabMemoryBudget"), 4096);
+    m_settings.setValue(QStringLiteral("MaxLiveTabs"), 50);
 
     m_settings.setValue(QStringLiteral("StandardFont"), m_webSettings->fontFamily(QWebEngineSettings::StandardFont));
     m_settings.setValue(QStringLiteral("SerifFont"), m_webSettings->fontFamily(QWebEngineSettings::SerifFont));
@@ -172,6 +178,14 @@ void Settings::updateSettings()
         m_settings.setValue(QStringLiteral("NewTabPage"), static_cast<int>(NewTabType::BlankPage));
         m_settings.setValue(QStringLiteral("FavoritePagesFile"), QStringLiteral("favorite_pages.json"));
     }
+    if (!ok || versionNumber < 1.1f)
+    {
+        // Existing profiles keep all of their tabs loaded, as they did before, unless the limits were already set
+        if (!m_settings.contains(QStringLiteral("TabMemoryBudget")))
+            m_settings.setValue(QStringLiteral("TabMemoryBudget"), 0);
+        if (!m_settings.contains(QStringLiteral("MaxLiveTabs")))
+            m_settings.setValue(QStringLiteral("MaxLiveTabs"), 0);
+    }
 
     m_settings.setValue(QStringLiteral("Version"), Version);
 }
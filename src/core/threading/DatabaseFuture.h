@@ -0,0 +1,165 @@
+#ifndef DATABASEFUTURE_H
+#define DATABASEFUTURE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include <QMetaObject>
+#include <QObject>
+#include <QPointer>
+
+class DatabaseTaskScheduler;
+
+/**
+ * @class DatabaseFuture
+ * @brief Holds the result of a task posted to the \ref DatabaseTaskScheduler.
+ *
+ *        A continuation can be attached with then(), which is invoked on the thread of a
+ *        given context object once the result is available. The result is moved into the
+ *        continuation, and is never copied. The task can be cancelled at any time, in which
+ *        case the database query is skipped if it has not started yet, and the continuation
+ *        is never invoked. The continuation is also dropped if its context object is destroyed.
+ *
+ *        Copies of a future share the same state.
+ */
+template <typename T>
+class DatabaseFuture
+{
+    friend class DatabaseTaskScheduler;
+
+    /// Shared state of the future
+    struct State
+    {
+        /// Guards the result and the continuation
+        std::mutex mutex;
+
+        /// Signalled when the result is set or the task is cancelled
+        std::condition_variable cv;
+
+        /// Result of the task
+        std::optional<T> value;
+
+        /// Invoked once the result is set
+        std::function<void(const std::shared_ptr<State>&)> continuation;
+
+        /// Set when the result is available, or the task has been cancelled
+        bool ready { false };
+
+        /// Set when the task has been cancelled
+        std::atomic_bool cancelled { false };
+    };
+
+public:
+    /// Constructs a future with no result
+    DatabaseFuture() :
+        m_state(std::make_shared<State>())
+    {
+    }
+
+    /// Cancels the task. If the task has not started yet, it will not be run, and a continuation
+    /// will not be invoked if it has not been invoked already
+    void cancel()
+    {
+        m_state->cancelled = true;
+
+        std::lock_guard<std::mutex> lock{m_state->mutex};
+        m_state->ready = true;
+        m_state->continuation = nullptr;
+        m_state->cv.notify_all();
+    }
+
+    /// Returns true if the task has been cancelled
+    bool isCancelled() const
+    {
+        return m_state->cancelled.load();
+    }
+
+    /// Returns true if the result of the task is available, or the task was cancelled
+    bool isReady() const
+    {
+        std::lock_guard<std::mutex> lock{m_state->mutex};
+        return m_state->ready;
+    }
+
+    /// Blocks until the task has finished, and moves the result out of the future. Returns a default-constructed
+    /// value if the task was cancelled. Must not be called on the thread that runs the task, or if a continuation
+    /// has been attached to the future
+    T get()
+    {
+        std::unique_lock<std::mutex> lock{m_state->mutex};
+        m_state->cv.wait(lock, [this](){ return m_state->ready; });
+
+        if (m_state->cancelled.load() || !m_state->value.has_value())
+            return T();
+
+        return std::move(*m_state->value);
+    }
+
+    /**
+     * @brief Attaches a continuation to the future, which is invoked on the thread of the context object
+     *        once the result is available. Only one continuation may be attached to a future.
+     * @param context Object whose thread will invoke the continuation. If the object is destroyed before the
+     *                result is delivered, the continuation is not invoked
+     * @param fn Function that accepts the result of the task as an rvalue reference
+     */
+    template <typename Fn>
+    void then(QObject *context, Fn &&fn)
+    {
+        QPointer<QObject> contextPtr(context);
+        std::function<void(T&&)> callback(std::forward<Fn>(fn));
+
+        auto continuation = [contextPtr, callback](const std::shared_ptr<State> &state) {
+            if (contextPtr.isNull())
+                return;
+
+            QMetaObject::invokeMethod(contextPtr.data(), [state, callback](){
+                if (!state->cancelled.load() && state->value.has_value())
+                    callback(std::move(*state->value));
+            }, Qt::QueuedConnection);
+        };
+
+        std::unique_lock<std::mutex> lock{m_state->mutex};
+        if (m_state->cancelled.load())
+            return;
+
+        if (!m_state->ready)
+        {
+            m_state->continuation = std::move(continuation);
+            return;
+        }
+
+        lock.unlock();
+        continuation(m_state);
+    }
+
+private:
+    /// Sets the result of the task, invoking the continuation if one has been attached. Called by the task scheduler
+    void setValue(T &&value)
+    {
+        std::function<void(const std::shared_ptr<State>&)> continuation;
+        {
+            std::lock_guard<std::mutex> lock{m_state->mutex};
+            if (m_state->cancelled.load())
+                return;
+
+            m_state->value.emplace(std::move(value));
+            m_state->ready = true;
+            continuation = std::move(m_state->continuation);
+            m_state->cv.notify_all();
+        }
+
+        if (continuation)
+            continuation(m_state);
+    }
+
+private:
+    /// Shared state of the future
+    std::shared_ptr<State> m_state;
+};
+
+#endif // DATABASEFUTURE_H
@@ -1,15 +1,19 @@
 #include "DatabaseFactory.h"
 #include "DatabaseTaskScheduler.h"
 
+#include <algorithm>
+#include <QDebug>
+
 DatabaseTaskScheduler::DatabaseTaskScheduler() :
-    m_registry(),
-    m_workersToCreate(),
+    m_strands(),
     m_mutex(),
-    m_cv(),
-    m_thread(nullptr),
-    m_tasks(),
-    m_initCallbacks(),
-    m_working(false)
+    m_numReaderThreads(2),
+    m_readerThreads(),
+    m_readTasks(),
+    m_readMutex(),
+    m_readCv(),
+    m_readersWorking(false),
+    m_running(false)
 {
 }
 
@@ -20,82 +24,271 @@ DatabaseTaskScheduler::~DatabaseTaskScheduler()
 
 DatabaseWorker *DatabaseTaskScheduler::getWorker(const std::string &name) const
 {
-    const auto it = m_registry.find(name);
-    if (it != m_registry.end())
-        return it->second.get();
+    std::lock_guard<std::mutex> lock{m_mutex};
+    const auto it = m_strands.find(name);
+    if (it != m_strands.end())
+        return it->second->worker.get();
     return nullptr;
 }
 
-void DatabaseTaskScheduler::onInit(std::function<void()> &&callback)
+void DatabaseTaskScheduler::onInit(const std::string &workerName, std::function<void()> &&callback)
 {
-    m_initCallbacks.push_back(std::move(callback));
+    Strand *strand = getOrCreateStrand(workerName);
+
+    std::lock_guard<std::mutex> lock{strand->mutex};
+    if (strand->ready.load())
+    {
+        // Worker has already been initialized, so the callback runs before any task that is posted after this call
+        strand->tasks.push(DatabaseTaskPriority::Interactive, std::move(callback));
+        strand->cv.notify_one();
+        return;
+    }
+
+    strand->initCallbacks.push_back(std::move(callback));
 }
 
-void DatabaseTaskScheduler::post(std::function<void()> &&work)
+void DatabaseTaskScheduler::post(const std::string &workerName, std::function<void()> &&work)
 {
-    std::lock_guard<std::mutex> lock{m_mutex};
-    m_tasks.push_back(std::move(work));
-    m_cv.notify_one();
+    post(DatabaseTaskPriority::Normal, workerName, std::move(work));
+}
+
+void DatabaseTaskScheduler::post(DatabaseTaskPriority priority, const std::string &workerName, std::function<void()> &&work)
+{
+    Strand *strand = getOrCreateStrand(workerName);
+
+    std::lock_guard<std::mutex> lock{strand->mutex};
+    strand->tasks.push(priority, std::move(work));
+    strand->cv.notify_one();
+}
+
+void DatabaseTaskScheduler::postRead(const std::string &workerName, std::function<void(DatabaseWorker*)> &&work, DatabaseTaskPriority priority)
+{
+    Strand *strand = getOrCreateStrand(workerName);
+
+    // Readers are only used once the primary worker has created or migrated the database schema
+    if (strand->readerConstruction && strand->ready.load())
+    {
+        std::lock_guard<std::mutex> lock{m_readMutex};
+        if (m_readersWorking)
+        {
+            m_readTasks.push(priority, ReadTask{ strand, std::move(work) });
+            m_readCv.notify_one();
+            return;
+        }
+    }
+
+    post(priority, workerName, [strand, work = std::move(work)](){
+        work(strand->worker.get());
+    });
 }
 
 void DatabaseTaskScheduler::addWorker(const std::string &name, std::function<std::unique_ptr<DatabaseWorker>()> construction)
 {
-    m_workersToCreate.push_back({name, construction});
+    addWorker(name, std::move(construction), nullptr);
+}
+
+void DatabaseTaskScheduler::addWorker(const std::string &name, std::function<std::unique_ptr<DatabaseWorker>()> construction,
+                                      std::function<std::unique_ptr<DatabaseWorker>()> readerConstruction)
+{
+    if (m_running.load())
+    {
+        qWarning() << "DatabaseTaskScheduler::addWorker - cannot add worker " << QString::fromStdString(name)
+                   << " after the scheduler has started";
+        return;
+    }
+
+    Strand *strand = getOrCreateStrand(name);
+    strand->construction = std::move(construction);
+    strand->readerConstruction = std::move(readerConstruction);
+}
+
+void DatabaseTaskScheduler::setNumReaderThreads(int numThreads)
+{
+    if (m_running.load())
+        return;
+
+    m_numReaderThreads = std::max(0, numThreads);
 }
 
 void DatabaseTaskScheduler::run()
 {
-    if (m_thread != nullptr || m_working)
+    if (m_running.load())
+        return;
+
+    std::vector<Strand*> strands;
+    {
+        // Strands that are created after this point are started by getOrCreateStrand()
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_running = true;
+
+        strands.reserve(m_strands.size());
+        for (const auto &it : m_strands)
+            strands.push_back(it.second.get());
+    }
+
+    bool hasReaders = false;
+    for (Strand *strand : strands)
+    {
+        startStrand(strand);
+        hasReaders |= static_cast<bool>(strand->readerConstruction);
+    }
+
+    if (!hasReaders || m_numReaderThreads <= 0)
         return;
 
-    m_working = true;
-    m_thread = new std::thread(&DatabaseTaskScheduler::workerThread, this);
+    {
+        std::lock_guard<std::mutex> lock{m_readMutex};
+        m_readersWorking = true;
+    }
+
+    for (int i = 0; i < m_numReaderThreads; ++i)
+        m_readerThreads.emplace_back(&DatabaseTaskScheduler::readerThread, this);
 }
 
 void DatabaseTaskScheduler::stop()
 {
-    if (m_thread != nullptr)
     {
-        m_working = false;
-        m_cv.notify_all();
+        std::lock_guard<std::mutex> lock{m_mutex};
+        if (!m_running.load())
+            return;
+
+        m_running = false;
+    }
+
+    // Stop the reader pool first, as read tasks that cannot be run by a reader are moved to the strands
+    {
+        std::lock_guard<std::mutex> lock{m_readMutex};
+        m_readersWorking = false;
+        m_readCv.notify_all();
+    }
+
+    for (auto &thread : m_readerThreads)
+    {
+        if (thread.joinable())
+            thread.join();
+    }
+    m_readerThreads.clear();
+
+    for (Strand *strand : getStrands())
+    {
+        {
+            std::lock_guard<std::mutex> lock{strand->mutex};
+            strand->working = false;
+            strand->cv.notify_all();
+        }
+
+        if (strand->thread.joinable())
+            strand->thread.join();
+    }
+}
+
+std::vector<DatabaseTaskScheduler::Strand*> DatabaseTaskScheduler::getStrands() const
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    std::vector<Strand*> result;
+    result.reserve(m_strands.size());
+    for (const auto &it : m_strands)
+        result.push_back(it.second.get());
+
+    return result;
+}
+
+DatabaseTaskScheduler::Strand *DatabaseTaskScheduler::getOrCreateStrand(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    std::unique_ptr<Strand> &strand = m_strands[name];
+    if (!strand)
+    {
+        strand = std::make_unique<Strand>();
+        strand->name = name;
+
+        // A strand that is created after the scheduler has started, by posting a task to a name that was not
+        // registered with addWorker(), has no worker and is started right away
+        if (m_running.load())
+            startStrand(strand.get());
+    }
 
-        if (m_thread->joinable())
-            m_thread->join();
+    return strand.get();
+}
 
-        delete m_thread;
-        m_thread = nullptr;
+void DatabaseTaskScheduler::startStrand(Strand *strand)
+{
+    {
+        std::lock_guard<std::mutex> lock{strand->mutex};
+        strand->working = true;
     }
+
+    strand->thread = std::thread(&DatabaseTaskScheduler::strandThread, this, strand);
 }
 
-void DatabaseTaskScheduler::workerThread()
+void DatabaseTaskScheduler::strandThread(Strand *strand)
 {
-    for (auto &&workerInfo : m_workersToCreate)
+    if (strand->construction)
+        strand->worker = strand->construction();
+
+    std::vector<std::function<void()>> initCallbacks;
     {
-        m_registry[workerInfo.first] = workerInfo.second();
+        std::lock_guard<std::mutex> lock{strand->mutex};
+        initCallbacks.swap(strand->initCallbacks);
+        strand->ready = true;
     }
 
-    for (auto &initCallback : m_initCallbacks)
+    for (auto &initCallback : initCallbacks)
         initCallback();
 
-    m_initCallbacks.clear();
-
+    std::function<void()> task;
     for (;;)
     {
-        std::unique_lock<std::mutex> lock{m_mutex};
-        m_cv.wait(lock, [this](){
-            return !m_tasks.empty() || !m_working;
+        std::unique_lock<std::mutex> lock{strand->mutex};
+        strand->cv.wait(lock, [strand](){
+            return !strand->tasks.empty() || !strand->working;
         });
 
-        if (!m_working && m_tasks.empty())
+        if (!strand->tasks.pop(task))
             break;
 
-        std::function<void()> task = std::move(m_tasks.front());
-        m_tasks.pop_front();
         lock.unlock();
 
         task();
+        task = nullptr;
+    }
+}
 
-        if (!m_working && m_tasks.empty())
+void DatabaseTaskScheduler::readerThread()
+{
+    // Each reader thread has its own read-only connection to every database it is asked to query
+    std::unordered_map<Strand*, std::unique_ptr<DatabaseWorker>> readers;
+
+    ReadTask task;
+    for (;;)
+    {
+        std::unique_lock<std::mutex> lock{m_readMutex};
+        m_readCv.wait(lock, [this](){
+            return !m_readTasks.empty() || !m_readersWorking;
+        });
+
+        if (!m_readTasks.pop(task))
             break;
+
+        lock.unlock();
+
+        std::unique_ptr<DatabaseWorker> &reader = readers[task.strand];
+        if (!reader)
+            reader = task.strand->readerConstruction();
+
+        if (reader)
+            task.work(reader.get());
+        else
+        {
+            // Could not open a read-only connection, fall back to the primary worker
+            Strand *strand = task.strand;
+            post(DatabaseTaskPriority::Interactive, strand->name, [strand, work = std::move(task.work)](){
+                work(strand->worker.get());
+            });
+        }
+
+        task = ReadTask{};
     }
 }
@@ -1,12 +1,18 @@
 #ifndef DATABASETASKSCHEDULER_H
 #define DATABASETASKSCHEDULER_H
 
+#include "DatabaseFuture.h"
+
+#include <array>
+#include <atomic>
 #include <condition_variable>
 #include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
@@ -14,15 +20,121 @@
 
 class DatabaseWorker;
 
+/// Priorities of database tasks. Within a queue, tasks of a higher priority run before any tasks of
+/// a lower priority, and tasks of the same priority run in the order they were posted.
+enum class DatabaseTaskPriority
+{
+    Interactive = 0, /// Reads that the user is waiting on, such as loading the history window or the new tab page
+    Normal      = 1, /// Default priority. Used for writes, which must run in the order they are posted
+    Background  = 2  /// Work that nothing is waiting on, such as maintenance or preloading data
+};
+
 /**
  * @class DatabaseTaskScheduler
- * @brief Manages a collection of DatabaseWorkers
- *        that operate outside of the main thread
+ * @brief Manages a collection of DatabaseWorkers that operate outside of the main thread.
+ *
+ *        Each registered worker is given its own strand - a thread with a queue of tasks that
+ *        run serially - so that work on one database never waits behind work on another.
+ *        Workers that provide a read-only constructor can also have read-only queries run on
+ *        a shared pool of threads, each with their own read-only connection to the database.
+ *        Tasks can also be posted to a name that has no registered worker, such as to create
+ *        an object that opens its own database, in which case they run on a strand of their own.
  */
 class DatabaseTaskScheduler
 {
+    /// Queue of tasks, ordered by priority and then by the order in which they were posted
+    template <typename Task>
+    class TaskQueue
+    {
+    public:
+        /// Adds a task to the end of the queue for its priority
+        void push(DatabaseTaskPriority priority, Task &&task)
+        {
+            m_queues[static_cast<std::size_t>(priority)].push_back(std::move(task));
+        }
+
+        /// Removes the next task from the queue and moves it into the output, returning true if there was a task
+        bool pop(Task &output)
+        {
+            for (auto &queue : m_queues)
+            {
+                if (!queue.empty())
+                {
+                    output = std::move(queue.front());
+                    queue.pop_front();
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        /// Returns true if there are no tasks in the queue
+        bool empty() const
+        {
+            for (const auto &queue : m_queues)
+            {
+                if (!queue.empty())
+                    return false;
+            }
+
+            return true;
+        }
+
+    private:
+        /// One FIFO queue per priority level
+        std::array<std::deque<Task>, 3> m_queues;
+    };
+
+    /// Serial task queue and thread of a single database worker
+    struct Strand
+    {
+        /// Name of the database worker
+        std::string name;
+
+        /// Constructs the database worker
+        std::function<std::unique_ptr<DatabaseWorker>()> construction;
+
+        /// Constructs a read-only instance of the database worker. May be empty
+        std::function<std::unique_ptr<DatabaseWorker>()> readerConstruction;
+
+        /// Database worker instance, created on the strand's thread
+        std::unique_ptr<DatabaseWorker> worker;
+
+        /// Callbacks to be executed on the strand after its worker is created, before any task
+        std::vector<std::function<void()>> initCallbacks;
+
+        /// Pending tasks
+        TaskQueue<std::function<void()>> tasks;
+
+        /// Guards the task queue and init callbacks
+        std::mutex mutex;
+
+        /// Signalled when a task is posted or the strand is stopped
+        std::condition_variable cv;
+
+        /// Strand thread
+        std::thread thread;
+
+        /// Worker flag - when set to false, the strand will halt once its queue is empty
+        bool working { false };
+
+        /// Set once the worker has been created and the init callbacks have run
+        std::atomic_bool ready { false };
+    };
+
+    /// Read-only task waiting for a thread in the reader pool
+    struct ReadTask
+    {
+        /// Strand of the database being read
+        Strand *strand { nullptr };
+
+        /// Query to run against a read-only instance of the strand's worker
+        std::function<void(DatabaseWorker*)> work;
+    };
+
 public:
-    /// Constructs the task schedulerr
+    /// Constructs the task scheduler
     DatabaseTaskScheduler();
 
     /// Destructor
@@ -30,67 +142,146 @@ class DatabaseTaskScheduler
 
     /// Returns a database worker that has been registered with the given name
     /// Note: this function should *only* be called in a callback registered with
-    /// the onInit() method
+    /// the onInit() method, or in a task posted to the worker
     DatabaseWorker *getWorker(const std::string &name) const;
 
-    /// Registers a callback to be executed when the worker thread has started
-    void onInit(std::function<void()> &&callback);
+    /// Registers a callback to be executed on the strand of the given worker, after the worker
+    /// has been created and before any of the tasks posted to it are executed
+    void onInit(const std::string &workerName, std::function<void()> &&callback);
 
     /**
-     * @brief Posts a task to the end of the work queue
+     * @brief Posts a task to the end of the given worker's queue, with normal priority
+     * @param workerName Name of the database worker whose strand will run the task
      * @param f Member function to be invoked
      * @param args Function arguments
      */
     template<class Fn, class ...Args>
-    void post(Fn &&f, Args &&...args)
+    void post(const std::string &workerName, Fn &&f, Args &&...args)
+    {
+        post(DatabaseTaskPriority::Normal, workerName, std::bind(std::forward<Fn>(f), std::forward<Args>(args)...));
+    }
+
+    /// Posts a task to the end of the given worker's queue, with normal priority
+    void post(const std::string &workerName, std::function<void()> &&work);
+
+    /// Posts a task with the given priority to the given worker's queue
+    void post(DatabaseTaskPriority priority, const std::string &workerName, std::function<void()> &&work);
+
+    /**
+     * @brief Posts a read-only query to the reader pool. The task is given a read-only instance of
+     *        the worker, which may run in parallel with the worker's strand and other readers. If the
+     *        worker has no read-only constructor, or the worker is not yet ready, the task is run on
+     *        the worker's strand and given the primary instance instead. Reads are not ordered
+     *        with respect to tasks posted to the strand, so a read may not observe a write that
+     *        was posted before it but has not yet been committed.
+     * @param workerName Name of the database worker to be queried
+     * @param work Task to be executed
+     * @param priority Priority of the task
+     */
+    void postRead(const std::string &workerName, std::function<void(DatabaseWorker*)> &&work,
+                  DatabaseTaskPriority priority = DatabaseTaskPriority::Interactive);
+
+    /**
+     * @brief Posts a task that produces a result to the given worker's queue
+     * @param workerName Name of the database worker whose strand will run the task
+     * @param fn Function to be invoked, returning the result of the task
+     * @param priority Priority of the task
+     * @return Future that receives the result of the task. If the future is cancelled before the task
+     *         starts, the task is skipped
+     */
+    template <typename Fn>
+    auto postTask(const std::string &workerName, Fn &&fn, DatabaseTaskPriority priority = DatabaseTaskPriority::Normal)
+        -> DatabaseFuture<std::invoke_result_t<Fn>>
     {
-        std::lock_guard<std::mutex> lock{m_mutex};
-        m_tasks.push_back(std::bind(std::forward<Fn>(f), std::forward<Args>(args)...));
-        m_cv.notify_one();
+        DatabaseFuture<std::invoke_result_t<Fn>> future;
+        post(priority, workerName, [future, fn = std::forward<Fn>(fn)]() mutable {
+            if (!future.isCancelled())
+                future.setValue(fn());
+        });
+        return future;
     }
 
-    /// Posts a task to the end of the work queue
-    void post(std::function<void()> &&work);
+    /**
+     * @brief Posts a read-only query that produces a result, as in \ref postRead
+     * @param workerName Name of the database worker to be queried
+     * @param fn Function to be invoked with a read-only instance of the worker, returning the result of the query
+     * @param priority Priority of the task
+     * @return Future that receives the result of the query. If the future is cancelled before the query
+     *         starts, the query is skipped
+     */
+    template <typename Fn>
+    auto postReadTask(const std::string &workerName, Fn &&fn, DatabaseTaskPriority priority = DatabaseTaskPriority::Interactive)
+        -> DatabaseFuture<std::invoke_result_t<Fn, DatabaseWorker*>>
+    {
+        DatabaseFuture<std::invoke_result_t<Fn, DatabaseWorker*>> future;
+        postRead(workerName, [future, fn = std::forward<Fn>(fn)](DatabaseWorker *worker) mutable {
+            if (!future.isCancelled())
+                future.setValue(fn(worker));
+        }, priority);
+        return future;
+    }
 
-    /// Adds a database worker to the pool of workers. It will be constructed after calling the run() method.
-    /// Anything registered with this method after calling run() will not be instantiated
+    /// Adds a database worker to the pool of workers. It will be constructed on its own strand after calling the
+    /// run() method. Anything registered with this method after calling run() will not be instantiated
     void addWorker(const std::string &name, std::function<std::unique_ptr<DatabaseWorker>()> construction);
 
-    /// Starts the worker thread
+    /// Adds a database worker to the pool of workers, along with a constructor of read-only instances of the worker
+    /// that are used by the reader pool. The database should use write-ahead logging, so readers do not block the writer
+    void addWorker(const std::string &name, std::function<std::unique_ptr<DatabaseWorker>()> construction,
+                   std::function<std::unique_ptr<DatabaseWorker>()> readerConstruction);
+
+    /// Sets the number of threads in the read-only query pool. Must be called before run(). Defaults to 2
+    void setNumReaderThreads(int numThreads);
+
+    /// Starts the strand of every registered worker, as well as the reader pool
     void run();
 
-    /// Stops the worker thread
+    /// Stops all threads after their pending tasks have been executed
     void stop();
 
 private:
-    /// Main loop of the worker thread
-    void workerThread();
+    /// Returns the strand of the given worker, creating it if it does not exist yet
+    Strand *getOrCreateStrand(const std::string &name);
 
-private:
-    /// Hashmap of database worker names to their corresponding instances
-    std::unordered_map<std::string, std::unique_ptr<DatabaseWorker>> m_registry;
+    /// Returns the strands of all workers. Strands are never removed, so the pointers remain valid
+    std::vector<Strand*> getStrands() const;
 
-    /// Vector of callbacks waiting to be executed in the run() method
-    std::vector<std::pair<std::string, 
-        std::function<std::unique_ptr<DatabaseWorker>()>>> m_workersToCreate;
+    /// Starts the thread of the given strand
+    void startStrand(Strand *strand);
 
-    /// Mutex
+    /// Main loop of a strand
+    void strandThread(Strand *strand);
+
+    /// Main loop of a thread in the reader pool
+    void readerThread();
+
+private:
+    /// Hashmap of database worker names to their strands
+    std::unordered_map<std::string, std::unique_ptr<Strand>> m_strands;
+
+    /// Guards the strand map
     mutable std::mutex m_mutex;
 
-    /// Condition variable
-    std::condition_variable m_cv;
+    /// Number of threads to start in the reader pool
+    int m_numReaderThreads;
+
+    /// Threads of the reader pool
+    std::vector<std::thread> m_readerThreads;
+
+    /// Pending read-only tasks
+    TaskQueue<ReadTask> m_readTasks;
 
-    /// Worker thread
-    std::thread *m_thread;
+    /// Guards the read task queue
+    std::mutex m_readMutex;
 
-    /// Pending tasks
-    std::deque<std::function<void()>> m_tasks;
+    /// Signalled when a read task is posted or the reader pool is stopped
+    std::condition_variable m_readCv;
 
-    /// Callbacks to be executed after insantiating all of the database workers in the worker thread
-    std::vector<std::function<void()>> m_initCallbacks;
+    /// Reader pool flag - when set to false, reader threads will halt once the read queue is empty
+    bool m_readersWorking;
 
-    /// Worker flag - when set to false, the worker thread will halt
-    bool m_working;
+    /// Set while the scheduler is running
+    std::atomic_bool m_running;
 };
 
 #endif // DATABASETASKSCHEDULER_H
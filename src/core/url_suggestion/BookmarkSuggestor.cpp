@@ -34,7 +34,8 @@ std::vector<URLSuggestion> BookmarkSuggestor::getSuggestions(const std::atomic_b
     const QRegularExpression prefixExpr = QRegularExpression(QLatin1String("^WWW\\."));
     const bool inputStartsWithWww = searchTerm.size() >= 3 && searchTerm.startsWith(QLatin1String("WWW"));
 
-    for (const auto &it : *m_bookmarkManager)
+    const BookmarkManager::Snapshot bookmarks = m_bookmarkManager->getSnapshot();
+    for (const auto &it : *bookmarks)
     {
         if (!working.load())
             return result;
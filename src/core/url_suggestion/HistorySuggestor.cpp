@@ -18,6 +18,17 @@
 
 #include <QDebug>
 
+HistorySuggestor::HistorySuggestor() :
+    IURLSuggestor(),
+    m_bookmarkManager(nullptr),
+    m_faviconManager(nullptr),
+    m_historyDb(nullptr),
+    m_historyDatabaseFile(),
+    m_statements(),
+    m_hasFullTextIndex(false)
+{
+}
+
 void HistorySuggestor::setServiceLocator(const ViperServiceLocator &serviceLocator)
 {
     m_bookmarkManager = serviceLocator.getServiceAs<BookmarkManager>("BookmarkManager");
@@ -84,12 +95,12 @@ std::vector<URLSuggestion> HistorySuggestor::getSuggestions(const std::atomic_bo
         if (!working.load())
             return result;
 
-        QString wordTemp = word.size() < 4 ? QString("%%1%") : QString("%1%");
-        wordTemp = wordTemp.arg(word.trimmed().toUpper());
-        const std::string wordStdBinding = wordTemp.toStdString();
+        const QString searchWord = word.trimmed().toUpper();
+        if (searchWord.isEmpty())
+            continue;
 
         stmtWords.reset();
-        stmtWords << wordStdBinding;
+        bindWordPrefix(stmtWords, searchWord);
 
         if (!stmtWords.execute())
             continue;
@@ -195,9 +206,30 @@ std::vector<URLSuggestion> HistorySuggestor::getSuggestionsFromQuery(const std::
     return result;
 }
 
+void HistorySuggestor::bindWordPrefix(sqlite::PreparedStatement &stmt, const QString &word) const
+{
+    if (m_hasFullTextIndex)
+    {
+        // Quote the word so that FTS5 treats it as a string rather than as query syntax
+        QString phrase = word;
+        phrase.replace(QLatin1Char('"'), QLatin1String("\"\""));
+        stmt << QString("\"%1\"*").arg(phrase);
+        return;
+    }
+
+    // Words that start with the prefix sort between the prefix and the prefix with its last byte incremented.
+    // UTF-8 never contains the byte 0xFF, so the last byte can always be incremented
+    const std::string lowerBound = word.toStdString();
+    std::string upperBound = lowerBound;
+    upperBound.back() = static_cast<char>(static_cast<unsigned char>(upperBound.back()) + 1);
+
+    stmt << lowerBound
+         << upperBound;
+}
+
 void HistorySuggestor::setupConnection()
 {
-    m_historyDb = std::make_unique<sqlite::Database>(m_historyDatabaseFile.toStdString());
+    m_historyDb = std::make_unique<sqlite::Database>(m_historyDatabaseFile.toStdString(), sqlite::Database::OpenMode::ReadOnly);
     m_statements.insert(std::make_pair(Statement::SearchByWholeInput,
                                        m_historyDb->prepare(R"(SELECT H.VisitID, H.URL, H.Title, H.URLTypedCount, V.VisitCount, V.RecentVisit
                                                             FROM History AS H INNER JOIN
@@ -205,14 +237,31 @@ void HistorySuggestor::setupConnection()
                                                             ON H.VisitID = V.VisitID
                                                             WHERE H.Title LIKE ? OR H.URL LIKE ?
                                                             ORDER BY V.VisitCount DESC, H.URLTypedCount DESC LIMIT 25)")));
+
+    // Word searches are prefix queries on an index, either of the FTS5 table or of the Words table, and
+    // only the visits of the matching entries are counted
+    sqlite::PreparedStatement stmtFullText =
+            m_historyDb->prepare(R"(SELECT H.VisitID, H.URL, H.Title, H.URLTypedCount, COUNT(V.Date) AS VisitCount, MAX(V.Date) AS RecentVisit
+                                 FROM History AS H INNER JOIN Visits AS V
+                                   ON H.VisitID = V.VisitID
+                                 WHERE H.VisitID IN (SELECT rowid FROM HistoryText WHERE HistoryText MATCH ?)
+                                 GROUP BY H.VisitID
+                                 ORDER BY VisitCount DESC, RecentVisit DESC, H.URLTypedCount DESC LIMIT 5)");
+
+    m_hasFullTextIndex = stmtFullText.isValid();
+    if (m_hasFullTextIndex)
+    {
+        m_statements.insert(std::make_pair(Statement::SearchBySingleWord, std::move(stmtFullText)));
+        return;
+    }
+
     m_statements.insert(std::make_pair(Statement::SearchBySingleWord,
-                                       m_historyDb->prepare(R"(SELECT U.HistoryID, H.URL, H.Title, H.URLTypedCount, V.VisitCount, V.RecentVisit
-                                                            FROM URLWords AS U INNER JOIN Words
-                                                              ON U.WordID = Words.WordID
-                                                            INNER JOIN History AS H
-                                                              ON U.HistoryID = H.VisitID
-                                                            INNER JOIN (SELECT VisitID, MAX(Date) AS RecentVisit, COUNT(Date) AS VisitCount FROM Visits INDEXED BY Visit_ID_Index GROUP BY VisitID) AS V
+                                       m_historyDb->prepare(R"(SELECT H.VisitID, H.URL, H.Title, H.URLTypedCount, COUNT(V.Date) AS VisitCount, MAX(V.Date) AS RecentVisit
+                                                            FROM History AS H INNER JOIN Visits AS V
                                                               ON H.VisitID = V.VisitID
-                                                            WHERE Words.Word LIKE ?
-                                                            ORDER BY V.VisitCount DESC, V.RecentVisit DESC, H.URLTypedCount DESC LIMIT 5)")));
+                                                            WHERE H.VisitID IN (SELECT U.HistoryID FROM Words AS W INNER JOIN URLWords AS U
+                                                                                  ON U.WordID = W.WordID
+                                                                                WHERE W.Word >= ? AND W.Word < ?)
+                                                            GROUP BY H.VisitID
+                                                            ORDER BY VisitCount DESC, RecentVisit DESC, H.URLTypedCount DESC LIMIT 5)")));
 }
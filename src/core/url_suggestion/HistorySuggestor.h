@@ -31,8 +31,8 @@ class HistorySuggestor final : public IURLSuggestor
     };
 
 public:
-    /// Default constructor
-    HistorySuggestor() = default;
+    /// Constructs the history suggestor
+    HistorySuggestor();
 
     /// Default destructor
     ~HistorySuggestor() = default;
@@ -57,6 +57,9 @@ class HistorySuggestor final : public IURLSuggestor
                                                        MatchType queryMatchType,
                                                        sqlite::PreparedStatement &query);
 
+    /// Binds a single search word to the SearchBySingleWord statement, as a prefix of the indexed words
+    void bindWordPrefix(sqlite::PreparedStatement &stmt, const QString &word) const;
+
     /// Connects to the history database and creates the prepared statement cache
     void setupConnection();
 
@@ -75,6 +78,10 @@ class HistorySuggestor final : public IURLSuggestor
 
     /// Prepared statements used by the suggestor
     std::map<Statement, sqlite::PreparedStatement> m_statements;
+
+    /// True if words are searched in the FTS5 table of the history database, false if they
+    /// are searched in the Words table
+    bool m_hasFullTextIndex;
 };
 
 #endif // HISTORYSUGGESTOR_H
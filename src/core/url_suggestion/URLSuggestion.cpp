@@ -1,8 +1,8 @@
-#include "BookmarkNode.h"
+#include "BookmarkSnapshot.h"
 #include "URLRecord.h"
 #include "URLSuggestion.h"
 
-URLSuggestion::URLSuggestion(const BookmarkNode *bookmark, const HistoryEntry &historyEntry, MatchType matchType) :
+URLSuggestion::URLSuggestion(const BookmarkSnapshotNode *bookmark, const HistoryEntry &historyEntry, MatchType matchType) :
     Favicon(bookmark->getIcon()),
     Title(bookmark->getName()),
     URL(bookmark->getURL().toString()),
@@ -6,7 +6,7 @@
 #include <QMetaType>
 #include <QString>
 
-class BookmarkNode;
+class BookmarkSnapshotNode;
 struct HistoryEntry;
 class URLRecord;
 
@@ -38,7 +38,7 @@ struct URLSuggestion
     URLSuggestion() = default;
 
     /// Constructs the URL suggestion given a bookmark node, its corresponding history entry and the type of search term match
-    URLSuggestion(const BookmarkNode *bookmark, const HistoryEntry &historyEntry, MatchType matchType);
+    URLSuggestion(const BookmarkSnapshotNode *bookmark, const HistoryEntry &historyEntry, MatchType matchType);
 
     /// Constructs the URL suggestion from a history record, an icon and the type of search term match
     URLSuggestion(const URLRecord &record, const QIcon &icon, MatchType matchType);
@@ -13,6 +13,7 @@ UserScript::UserScript() :
     m_isEnabled(true),
     m_injectionTime(ScriptInjectionTime::DocumentEnd),
     m_includes(),
+    m_includeRules(),
     m_excludes(),
     m_dependencies(),
     m_scriptData(),
@@ -72,6 +73,10 @@ bool UserScript::load(const QString &file, const QString &templateData)
         return false;
 
     m_dependencyData.clear();
+    m_includes.clear();
+    m_includeRules.clear();
+    m_excludes.clear();
+    m_dependencies.clear();
     m_fileName = file;
 
     // Read file line by line, adding contents to local data buffer and initially parsing the metadata block
@@ -105,11 +110,17 @@ bool UserScript::load(const QString &file, const QString &templateData)
                 else if (key.compare("noframes") == 0)
                     m_noSubFrames = true;
                 else if (key.compare("include") == 0)
+                {
                     m_includes.push_back(getRegExp(value));
+                    m_includeRules.push_back(value);
+                }
                 else if (key.compare("exclude") == 0)
                     m_excludes.push_back(getRegExp(value));
                 else if (key.compare("match") == 0)
+                {
                     m_includes.push_back(CommonUtil::getRegExpForMatchPattern(value));
+                    m_includeRules.push_back(value);
+                }
                 else if (key.compare("require") == 0)
                     m_dependencies.push_back(value);
                 else if (key.compare("run-at") == 0)
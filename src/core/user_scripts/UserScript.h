@@ -94,6 +94,9 @@ class UserScript
     /// Container of url include and matching rules, where the script will be injected
     std::vector<QRegularExpression> m_includes;
 
+    /// The include and matching rules as written in the script metadata, used to index the script by host
+    std::vector<QString> m_includeRules;
+
     /// Container of url excluding rules, where the script will never be injected
     std::vector<QRegularExpression> m_excludes;
 
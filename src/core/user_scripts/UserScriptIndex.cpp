@@ -0,0 +1,128 @@
+#include "UserScriptIndex.h"
+
+#include <algorithm>
+
+#include <QLatin1Char>
+#include <QLatin1String>
+
+namespace
+{
+    /// Returns true if the given string only contains characters that are valid in a host name
+    bool isPlainHost(const QString &host)
+    {
+        if (host.isEmpty())
+            return false;
+
+        for (const QChar c : host)
+        {
+            if (!c.isLetterOrNumber() && c != QLatin1Char('.') && c != QLatin1Char('-') && c != QLatin1Char('_'))
+                return false;
+        }
+        return true;
+    }
+
+    /// Appends the script identifier to the bucket, unless it was the last identifier added to the bucket
+    void addToBucket(std::vector<std::size_t> &bucket, std::size_t scriptId)
+    {
+        if (bucket.empty() || bucket.back() != scriptId)
+            bucket.push_back(scriptId);
+    }
+}
+
+void UserScriptIndex::clear()
+{
+    m_exactHosts.clear();
+    m_domainHosts.clear();
+    m_anyHost.clear();
+}
+
+void UserScriptIndex::addScript(std::size_t scriptId, const std::vector<QString> &includeRules)
+{
+    if (includeRules.empty())
+    {
+        addToBucket(m_anyHost, scriptId);
+        return;
+    }
+
+    for (const QString &rule : includeRules)
+    {
+        QString host;
+        bool matchesSubdomains = false;
+        if (!getRuleHost(rule, host, matchesSubdomains))
+            addToBucket(m_anyHost, scriptId);
+        else if (matchesSubdomains)
+            addToBucket(m_domainHosts[host], scriptId);
+        else
+            addToBucket(m_exactHosts[host], scriptId);
+    }
+}
+
+std::vector<std::size_t> UserScriptIndex::getCandidates(const QString &host) const
+{
+    std::vector<std::size_t> result = m_anyHost;
+
+    const QString lowerHost = host.toLower();
+    if (!lowerHost.isEmpty())
+    {
+        auto it = m_exactHosts.find(lowerHost);
+        if (it != m_exactHosts.end())
+            result.insert(result.end(), it->second.begin(), it->second.end());
+
+        // Check the host itself and each of its parent domains against the domain buckets
+        if (!m_domainHosts.empty())
+        {
+            qsizetype pos = 0;
+            while (pos >= 0)
+            {
+                const QString domain = lowerHost.mid(pos);
+                auto domainIt = m_domainHosts.find(domain);
+                if (domainIt != m_domainHosts.end())
+                    result.insert(result.end(), domainIt->second.begin(), domainIt->second.end());
+
+                pos = lowerHost.indexOf(QLatin1Char('.'), pos);
+                if (pos >= 0)
+                    ++pos;
+            }
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+bool UserScriptIndex::getRuleHost(const QString &rule, QString &host, bool &matchesSubdomains)
+{
+    matchesSubdomains = false;
+
+    // Regular expressions and rules without a scheme may match anything
+    if (rule.startsWith(QLatin1Char('/')))
+        return false;
+
+    const qsizetype schemeEnd = rule.indexOf(QLatin1String("://"));
+    if (schemeEnd <= 0)
+        return false;
+
+    const qsizetype hostStart = schemeEnd + 3;
+    qsizetype hostEnd = rule.indexOf(QLatin1Char('/'), hostStart);
+    if (hostEnd < 0)
+        hostEnd = rule.size();
+
+    QString ruleHost = rule.mid(hostStart, hostEnd - hostStart).toLower();
+
+    const qsizetype portPos = ruleHost.indexOf(QLatin1Char(':'));
+    if (portPos >= 0)
+        ruleHost.truncate(portPos);
+
+    if (ruleHost.startsWith(QLatin1String("*.")))
+    {
+        ruleHost.remove(0, 2);
+        matchesSubdomains = true;
+    }
+
+    if (!isPlainHost(ruleHost))
+        return false;
+
+    host = ruleHost;
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef USERSCRIPTINDEX_H
+#define USERSCRIPTINDEX_H
+
+#include <unordered_map>
+#include <vector>
+
+#include <QString>
+
+/**
+ * @class UserScriptIndex
+ * @brief Indexes the @include and @match rules of user scripts by the host that each rule names, so the
+ *        scripts that may run on a page can be found without evaluating the rules of every script.
+ *
+ *        Rules naming a single host are stored in an exact host bucket, rules of the form "*.example.com"
+ *        are stored in a bucket for the domain and its subdomains, and any other rule (regular expressions,
+ *        wildcard hosts, etc.) places its script in a list of candidates for every host. The index returns
+ *        candidates only, which must still be checked against the script's rules.
+ */
+class UserScriptIndex
+{
+public:
+    /// Constructs an empty index
+    UserScriptIndex() = default;
+
+    /// Removes all scripts from the index
+    void clear();
+
+    /// Adds the script with the given identifier to the index, given its @include and @match rules
+    void addScript(std::size_t scriptId, const std::vector<QString> &includeRules);
+
+    /// Returns the identifiers of the scripts that may run on a page of the given host, in ascending order
+    std::vector<std::size_t> getCandidates(const QString &host) const;
+
+private:
+    /**
+     * @brief Extracts the host named by an @include or @match rule
+     * @param rule The include or match rule
+     * @param host Set to the host named by the rule, in lower case
+     * @param matchesSubdomains Set to true if the rule also matches the subdomains of the host
+     * @return True if the rule names a host, false if it may match pages of any host
+     */
+    static bool getRuleHost(const QString &rule, QString &host, bool &matchesSubdomains);
+
+private:
+    /// Scripts with a rule that names a single host
+    std::unordered_map<QString, std::vector<std::size_t>> m_exactHosts;
+
+    /// Scripts with a rule that names a domain and its subdomains
+    std::unordered_map<QString, std::vector<std::size_t>> m_domainHosts;
+
+    /// Scripts with a rule that may match any host
+    std::vector<std::size_t> m_anyHost;
+};
+
+#endif // USERSCRIPTINDEX_H
@@ -1,9 +1,12 @@
 #include "DownloadManager.h"
+#include "TraceLog.h"
 #include "UserScriptManager.h"
 #include "UserScriptModel.h"
 #include "InternalDownloadItem.h"
 #include "WebEngineScriptAdapter.h"
 
+#include <algorithm>
+
 #include <QDir>
 #include <QFile>
 #include <QRegularExpression>
@@ -13,10 +16,20 @@
 UserScriptManager::UserScriptManager(DownloadManager *downloadManager, Settings *settings) :
     QObject(nullptr),
     m_downloadManager(downloadManager),
-    m_model(new UserScriptModel(downloadManager, settings, this))
+    m_model(new UserScriptModel(downloadManager, settings, this)),
+    m_index(),
+    m_indexDirty(true),
+    m_bundleCache(64)
 {
+    VIPER_TRACE_SCOPE("startup", "UserScriptManager");
+
     setObjectName(QLatin1String("UserScriptManager"));
     connect(settings, &Settings::settingChanged, this, &UserScriptManager::onSettingChanged);
+
+    connect(m_model, &UserScriptModel::rowsInserted, this, &UserScriptManager::onScriptsChanged);
+    connect(m_model, &UserScriptModel::rowsRemoved,  this, &UserScriptManager::onScriptsChanged);
+    connect(m_model, &UserScriptModel::dataChanged,  this, &UserScriptManager::onScriptsChanged);
+    connect(m_model, &UserScriptModel::modelReset,   this, &UserScriptManager::onScriptsChanged);
 }
 
 UserScriptManager::~UserScriptManager()
@@ -35,93 +48,113 @@ UserScriptModel *UserScriptManager::getModel()
 
 QString UserScriptManager::getScriptsFor(const QUrl &url, ScriptInjectionTime injectionTime, bool isMainFrame)
 {
+    VIPER_TRACE_SCOPE("user_scripts", "UserScriptManager::getScriptsFor");
+
     if (!m_model->m_enabled)
         return QString();
 
-    QByteArray resultBuffer;
-    QString urlStr = url.toString(QUrl::FullyEncoded);
+    std::vector<std::size_t> scriptIds = getMatchingScripts(url);
+    scriptIds.erase(std::remove_if(scriptIds.begin(), scriptIds.end(), [&](std::size_t scriptId) {
+        const UserScript &script = m_model->m_scripts.at(scriptId);
+        return injectionTime != script.m_injectionTime || (script.m_noSubFrames && !isMainFrame);
+    }), scriptIds.end());
 
-    for (const UserScript &script : m_model->m_scripts)
-    {
-        if (!script.m_isEnabled
-                || (injectionTime != script.m_injectionTime)
-                || (script.m_noSubFrames && !isMainFrame))
-            continue;
-
-        bool isExclude = false, isInclude = false;
-        for (const QRegularExpression &expr : script.m_excludes)
-        {
-            if (expr.match(urlStr).hasMatch())
-            {
-                isExclude = true;
-                break;
-            }
-        }
-
-        if (isExclude)
-            continue;
+    if (scriptIds.empty())
+        return QString();
 
-        for (const QRegularExpression &expr : script.m_includes)
-        {
-            if (expr.match(urlStr).hasMatch())
-            {
-                isInclude = true;
-                break;
-            }
-        }
+    // Pages of the same host usually inject the same scripts, so the concatenated bundle is reused
+    // as long as the set of matching scripts has not changed
+    const QString cacheKey = QString("%1|%2|%3").arg(url.host().toLower())
+                                                .arg(static_cast<int>(injectionTime))
+                                                .arg(isMainFrame ? 1 : 0);
+    if (m_bundleCache.has(cacheKey))
+    {
+        const ScriptBundle &bundle = m_bundleCache.get(cacheKey);
+        if (bundle.ScriptIds == scriptIds)
+            return bundle.Data;
+    }
 
-        if (isInclude)
-        {
-            resultBuffer.append(script.m_dependencyData);
-            resultBuffer.append('\n');
-            resultBuffer.append(script.m_scriptData.toUtf8());
-        }
+    QByteArray resultBuffer;
+    for (std::size_t scriptId : scriptIds)
+    {
+        const UserScript &script = m_model->m_scripts.at(scriptId);
+        resultBuffer.append(script.m_dependencyData);
+        resultBuffer.append('\n');
+        resultBuffer.append(script.m_scriptData.toUtf8());
     }
 
-    return QString(resultBuffer);
+    ScriptBundle bundle;
+    bundle.ScriptIds = std::move(scriptIds);
+    bundle.Data = QString(resultBuffer);
+    m_bundleCache.put(cacheKey, bundle);
+
+    return bundle.Data;
 }
 
 std::vector<QWebEngineScript> UserScriptManager::getAllScriptsFor(const QUrl &url)
 {
+    VIPER_TRACE_SCOPE("user_scripts", "UserScriptManager::getAllScriptsFor");
+
     std::vector<QWebEngineScript> result;
     if (!m_model->m_enabled)
         return result;
 
-    QString urlStr = url.toString(QUrl::FullyEncoded);
-    for (const UserScript &script : m_model->m_scripts)
+    for (std::size_t scriptId : getMatchingScripts(url))
     {
-        if (!script.m_isEnabled)
-            continue;
+        WebEngineScriptAdapter scriptAdapter(m_model->m_scripts.at(scriptId));
+        result.push_back(scriptAdapter.getScript());
+    }
+    return result;
+}
+
+std::vector<std::size_t> UserScriptManager::getMatchingScripts(const QUrl &url)
+{
+    const std::vector<UserScript> &scripts = m_model->m_scripts;
 
-        bool isExclude = false, isInclude = false;
-        for (const QRegularExpression &expr : script.m_excludes)
+    if (m_indexDirty)
+    {
+        m_index.clear();
+        for (std::size_t i = 0; i < scripts.size(); ++i)
         {
-            if (expr.match(urlStr).hasMatch())
-            {
-                isExclude = true;
-                break;
-            }
+            if (scripts.at(i).m_isEnabled)
+                m_index.addScript(i, scripts.at(i).m_includeRules);
         }
+        m_indexDirty = false;
+    }
 
-        if (isExclude)
-            continue;
+    std::vector<std::size_t> result = m_index.getCandidates(url.host());
+    if (result.empty())
+        return result;
 
-        for (const QRegularExpression &expr : script.m_includes)
-        {
-            if (expr.match(urlStr).hasMatch())
-            {
-                isInclude = true;
-                break;
-            }
-        }
+    const QString urlStr = url.toString(QUrl::FullyEncoded);
+    result.erase(std::remove_if(result.begin(), result.end(), [&](std::size_t scriptId) {
+        return !matchesUrl(scripts.at(scriptId), urlStr);
+    }), result.end());
+    return result;
+}
 
-        if (isInclude)
+bool UserScriptManager::matchesUrl(const UserScript &script, const QString &urlStr) const
+{
+    bool isInclude = false;
+    for (const QRegularExpression &expr : script.m_includes)
+    {
+        if (expr.match(urlStr).hasMatch())
         {
-            WebEngineScriptAdapter scriptAdapter(script);
-            result.push_back(scriptAdapter.getScript());
+            isInclude = true;
+            break;
         }
     }
-    return result;
+
+    if (!isInclude)
+        return false;
+
+    for (const QRegularExpression &expr : script.m_excludes)
+    {
+        if (expr.match(urlStr).hasMatch())
+            return false;
+    }
+
+    return true;
 }
 
 void UserScriptManager::installScript(const QUrl &url)
@@ -186,3 +219,9 @@ void UserScriptManager::onSettingChanged(BrowserSetting setting, const QVariant
     if (setting == BrowserSetting::UserScriptsEnabled)
         setEnabled(value.toBool());
 }
+
+void UserScriptManager::onScriptsChanged()
+{
+    m_indexDirty = true;
+    m_bundleCache.clear();
+}
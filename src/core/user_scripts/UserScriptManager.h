@@ -4,7 +4,9 @@
 #include "Settings.h"
 #include "ISettingsObserver.h"
 
+#include "LRUCache.h"
 #include "UserScript.h"
+#include "UserScriptIndex.h"
 
 #include <memory>
 #include <vector>
@@ -19,6 +21,10 @@ class UserScriptModel;
 /**
  * @class UserScriptManager
  * @brief Manages a collection of GreaseMonkey-style user scripts
+ *
+ *        Scripts are looked up through a \ref UserScriptIndex of their include rules, so only the scripts
+ *        that may run on the host of a page have their rules evaluated. The index and the cache of script
+ *        bundles are rebuilt whenever the scripts are changed.
  */
 class UserScriptManager : public QObject, public ISettingsObserver
 {
@@ -78,12 +84,41 @@ private Q_SLOTS:
     /// Listens for any settings changes that affect the user script system
     void onSettingChanged(BrowserSetting setting, const QVariant &value) override;
 
+    /// Called when a script is added, removed or modified, invalidating the script index and bundle cache
+    void onScriptsChanged();
+
+private:
+    /// Concatenated data of the scripts that are injected onto a page
+    struct ScriptBundle
+    {
+        /// Indices of the scripts in the bundle
+        std::vector<std::size_t> ScriptIds;
+
+        /// Dependencies and source code of the scripts
+        QString Data;
+    };
+
+    /// Returns the indices of the enabled scripts that match the given URL, rebuilding the script index if needed
+    std::vector<std::size_t> getMatchingScripts(const QUrl &url);
+
+    /// Returns true if the given URL is matched by one of the include rules and none of the exclude rules of the script
+    bool matchesUrl(const UserScript &script, const QString &urlStr) const;
+
 private:
     /// Network download manager
     DownloadManager *m_downloadManager;
 
     /// Pointer to the user scripts model
     UserScriptModel *m_model;
+
+    /// Index of the scripts by the hosts named in their include rules
+    UserScriptIndex m_index;
+
+    /// True if the scripts have changed since the index was built
+    bool m_indexDirty;
+
+    /// Cache of script bundles, keyed by host, injection time and frame type
+    LRUCache<QString, ScriptBundle> m_bundleCache;
 };
 
 #endif // USERSCRIPTMANAGER_H
@@ -181,7 +181,10 @@ void UserScriptModel::reloadScript(int indexRow)
 
     UserScript &script = m_scripts.at(indexRow);
     if (script.load(script.m_fileName, m_scriptTemplate))
+    {
         loadDependencies(indexRow);
+        emit dataChanged(index(indexRow, 0), index(indexRow, columnCount() - 1));
+    }
 }
 
 void UserScriptModel::load()
@@ -281,6 +284,7 @@ void UserScriptModel::loadDependencies(int scriptIdx)
                     tmpData = tmp.readAll();
                     m_scripts[scriptIdx].m_dependencyData.append(tmpData);
                     tmp.close();
+                    emit dataChanged(index(scriptIdx, 0), index(scriptIdx, columnCount() - 1));
                 }
                 item->deleteLater();
             });
@@ -1,7 +1,24 @@
 #include "CommonUtil.h"
 
 #include <array>
+#include <cstring>
+#include <utility>
 #include <QBuffer>
+#include <QDataStream>
+#include <QPixmap>
+
+namespace
+{
+    /// Identifies data in the binary favicon format
+    const QByteArray BinaryIconMagic = QByteArrayLiteral("VIC1");
+
+    /// Encoding of a single image in the binary favicon format
+    enum class BinaryIconEncoding : quint8
+    {
+        RawARGB32 = 0,  /// Premultiplied ARGB32 pixels, copied into the image without decoding
+        PNG       = 1   /// PNG-compressed image
+    };
+}
 
 namespace CommonUtil
 {
@@ -66,6 +83,103 @@ namespace CommonUtil
         return data.toBase64();
     }
 
+    QByteArray iconToBinary(const QIcon &icon)
+    {
+        if (icon.isNull())
+            return QByteArray();
+
+        return iconImageToBinary(icon.pixmap(32, 32).toImage());
+    }
+
+    QByteArray iconImageToBinary(const QImage &image)
+    {
+        if (image.isNull())
+            return QByteArray();
+
+        const std::array<std::pair<int, BinaryIconEncoding>, 2> sizes {
+            std::make_pair(16, BinaryIconEncoding::RawARGB32),
+            std::make_pair(32, BinaryIconEncoding::PNG)
+        };
+
+        QByteArray result;
+        QDataStream stream(&result, QIODevice::WriteOnly);
+        stream.writeRawData(BinaryIconMagic.constData(), BinaryIconMagic.size());
+        stream << static_cast<quint8>(sizes.size());
+
+        for (const auto &size : sizes)
+        {
+            QImage scaled = image;
+            if (image.width() != size.first || image.height() != size.first)
+                scaled = image.scaled(size.first, size.first, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+            scaled = scaled.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+            QByteArray imageData;
+            if (size.second == BinaryIconEncoding::RawARGB32)
+                imageData = QByteArray(reinterpret_cast<const char*>(scaled.constBits()), static_cast<int>(scaled.sizeInBytes()));
+            else
+            {
+                QBuffer buffer(&imageData);
+                scaled.save(&buffer, "PNG");
+            }
+
+            stream << static_cast<quint8>(size.second)
+                   << static_cast<quint16>(scaled.width())
+                   << static_cast<quint16>(scaled.height())
+                   << imageData;
+        }
+
+        return result;
+    }
+
+    QList<QImage> iconImagesFromBinary(const QByteArray &data)
+    {
+        QList<QImage> images;
+        if (!data.startsWith(BinaryIconMagic))
+            return images;
+
+        QDataStream stream(data);
+        stream.skipRawData(BinaryIconMagic.size());
+
+        quint8 numImages = 0;
+        stream >> numImages;
+        for (quint8 i = 0; i < numImages; ++i)
+        {
+            quint8 encoding = 0;
+            quint16 width = 0, height = 0;
+            QByteArray imageData;
+            stream >> encoding >> width >> height >> imageData;
+            if (stream.status() != QDataStream::Ok)
+                break;
+
+            QImage image;
+            if (encoding == static_cast<quint8>(BinaryIconEncoding::RawARGB32))
+            {
+                image = QImage(width, height, QImage::Format_ARGB32_Premultiplied);
+                if (image.isNull() || image.sizeInBytes() != imageData.size())
+                    continue;
+
+                std::memcpy(image.bits(), imageData.constData(), static_cast<std::size_t>(imageData.size()));
+            }
+            else if (encoding == static_cast<quint8>(BinaryIconEncoding::PNG))
+                image.loadFromData(imageData, "PNG");
+
+            if (!image.isNull())
+                images.append(image);
+        }
+
+        return images;
+    }
+
+    QIcon iconFromBinary(const QByteArray &data)
+    {
+        QIcon icon;
+        const QList<QImage> images = iconImagesFromBinary(data);
+        for (const QImage &image : images)
+            icon.addPixmap(QPixmap::fromImage(image));
+
+        return icon;
+    }
+
     quint64 quPow(quint64 base, quint64 exp)
     {
         quint64 result = 1;
@@ -5,6 +5,8 @@
 #include <functional>
 
 #include <QIcon>
+#include <QImage>
+#include <QList>
 #include <QRegularExpression>
 #include <QString>
 #include <QtGlobal>
@@ -44,6 +46,21 @@ namespace CommonUtil
     /// Returns the base64 encoding of the given icon
     QByteArray iconToBase64(QIcon icon);
 
+    /// Encodes the given icon into the binary format used to store favicons. The icon is stored at 16x16
+    /// pixels as raw ARGB32 data, which is used without decoding, and at 32x32 pixels as PNG data
+    QByteArray iconToBinary(const QIcon &icon);
+
+    /// Encodes the given image into the binary favicon format, as in \ref iconToBinary. Unlike the
+    /// QIcon overload, this is safe to call from threads other than the GUI thread
+    QByteArray iconImageToBinary(const QImage &image);
+
+    /// Decodes the images of an icon that was encoded with \ref iconToBinary. Safe to call from any thread
+    QList<QImage> iconImagesFromBinary(const QByteArray &data);
+
+    /// Decodes an icon that was encoded with \ref iconToBinary, returning a null icon if the data is invalid.
+    /// Creates pixmaps, so it must be called on the GUI thread
+    QIcon iconFromBinary(const QByteArray &data);
+
     /// Computes and returns base^exp
     quint64 quPow(quint64 base, quint64 exp);
 
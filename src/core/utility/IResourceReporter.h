@@ -0,0 +1,37 @@
+#ifndef IRESOURCEREPORTER_H
+#define IRESOURCEREPORTER_H
+
+#include <vector>
+
+#include <QString>
+#include <QtGlobal>
+
+/// Amount of memory held by one part of a browser subsystem, such as a cache or an in-memory index
+struct ResourceUsage
+{
+    /// Name of the part of the subsystem
+    QString Name;
+
+    /// Number of items held in memory
+    quint64 NumItems;
+
+    /// Estimated size of the items held in memory, in bytes, or -1 if it is not known
+    qint64 EstimatedSize;
+};
+
+/**
+ * @class IResourceReporter
+ * @brief Defines an interface for browser subsystems that report the memory they hold,
+ *        which is shown on the viper://resources page
+ */
+class IResourceReporter
+{
+public:
+    /// Destructor
+    virtual ~IResourceReporter() = default;
+
+    /// Returns the memory held by each part of the subsystem. Called from the GUI thread
+    virtual std::vector<ResourceUsage> getResourceUsage() const = 0;
+};
+
+#endif // IRESOURCEREPORTER_H
@@ -0,0 +1,164 @@
+#include "ProcessMemory.h"
+
+#include <unordered_map>
+#include <vector>
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#if defined(Q_OS_LINUX)
+#  include <unistd.h>
+#endif
+
+namespace
+{
+#if defined(Q_OS_LINUX)
+    /// Returns the contents of the given file in the /proc directory of a process, or an empty array if it could not be read
+    QByteArray readProcFile(const QString &pid, const QString &fileName, qint64 maxSize)
+    {
+        QFile file(QStringLiteral("/proc/%1/%2").arg(pid, fileName));
+        if (!file.open(QIODevice::ReadOnly))
+            return QByteArray();
+
+        return file.read(maxSize);
+    }
+#endif
+}
+
+namespace ProcessMemory
+{
+    QList<QByteArray> parseStatFields(const QByteArray &stat)
+    {
+        // The process name is enclosed in parentheses and may contain spaces, so the remaining
+        // fields ("state ppid ...") are read after the last closing parenthesis
+        const qsizetype nameEnd = stat.lastIndexOf(')');
+        if (nameEnd < 0 || nameEnd + 2 >= stat.size())
+            return QList<QByteArray>();
+
+        return stat.mid(nameEnd + 2).trimmed().split(' ');
+    }
+
+    qint64 parseParentPid(const QByteArray &stat)
+    {
+        const QList<QByteArray> fields = parseStatFields(stat);
+        if (fields.size() < 2)
+            return -1;
+
+        bool ok = false;
+        const qint64 parentPid = fields.at(1).toLongLong(&ok);
+        return ok ? parentPid : -1;
+    }
+
+    qint64 parseCpuTicks(const QByteArray &stat)
+    {
+        // utime and stime are the 14th and 15th fields of the stat file, measured in clock ticks
+        const QList<QByteArray> fields = parseStatFields(stat);
+        if (fields.size() < 13)
+            return -1;
+
+        bool userOk = false, systemOk = false;
+        const qint64 userTicks = fields.at(11).toLongLong(&userOk);
+        const qint64 systemTicks = fields.at(12).toLongLong(&systemOk);
+        if (!userOk || !systemOk)
+            return -1;
+
+        return userTicks + systemTicks;
+    }
+
+    qint64 parseResidentPages(const QByteArray &statm)
+    {
+        // The second field of statm is the number of resident pages
+        const QList<QByteArray> fields = statm.trimmed().split(' ');
+        if (fields.size() < 2)
+            return -1;
+
+        bool ok = false;
+        const qint64 residentPages = fields.at(1).toLongLong(&ok);
+        return ok ? residentPages : -1;
+    }
+
+    qint64 getResidentSize(qint64 pid)
+    {
+#if defined(Q_OS_LINUX)
+        const qint64 residentPages = parseResidentPages(readProcFile(QString::number(pid), QStringLiteral("statm"), 256));
+        if (residentPages < 0)
+            return -1;
+
+        static const qint64 pageSize = static_cast<qint64>(sysconf(_SC_PAGESIZE));
+        return residentPages * pageSize;
+#else
+        Q_UNUSED(pid);
+        return -1;
+#endif
+    }
+
+    qint64 getCpuTime(qint64 pid)
+    {
+#if defined(Q_OS_LINUX)
+        const qint64 ticks = parseCpuTicks(readProcFile(QString::number(pid), QStringLiteral("stat"), 512));
+        if (ticks < 0)
+            return -1;
+
+        static const qint64 ticksPerSecond = static_cast<qint64>(sysconf(_SC_CLK_TCK));
+        return ticks * 1000 / ticksPerSecond;
+#else
+        Q_UNUSED(pid);
+        return -1;
+#endif
+    }
+
+    qint64 getBrowserResidentSize()
+    {
+#if defined(Q_OS_LINUX)
+        const qint64 browserPid = QCoreApplication::applicationPid();
+
+        qint64 total = getResidentSize(browserPid);
+        if (total < 0)
+            return -1;
+
+        std::unordered_map<qint64, std::vector<qint64>> children;
+
+        const QStringList entries = QDir(QStringLiteral("/proc")).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+        for (const QString &entry : entries)
+        {
+            bool isPid = false;
+            const qint64 pid = entry.toLongLong(&isPid);
+            if (!isPid || pid == browserPid)
+                continue;
+
+            const qint64 parentPid = parseParentPid(readProcFile(entry, QStringLiteral("stat"), 512));
+            if (parentPid > 0)
+                children[parentPid].push_back(pid);
+        }
+
+        // The renderer processes are started by the web engine's zygote process, so all descendants are counted
+        std::vector<qint64> pending { browserPid };
+        while (!pending.empty())
+        {
+            const qint64 pid = pending.back();
+            pending.pop_back();
+
+            auto it = children.find(pid);
+            if (it == children.end())
+                continue;
+
+            for (qint64 childPid : it->second)
+            {
+                const qint64 residentSize = getResidentSize(childPid);
+                if (residentSize > 0)
+                    total += residentSize;
+                pending.push_back(childPid);
+            }
+        }
+
+        return total;
+#else
+        return -1;
+#endif
+    }
+}
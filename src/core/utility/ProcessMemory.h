@@ -0,0 +1,39 @@
+#ifndef PROCESSMEMORY_H
+#define PROCESSMEMORY_H
+
+#include <QByteArray>
+#include <QList>
+#include <QtGlobal>
+
+/// Functions that measure the memory and CPU time used by the browser's processes
+namespace ProcessMemory
+{
+    /// Returns the fields of the given contents of a /proc/<pid>/stat file that follow the process name,
+    /// starting with the process state, or an empty list if the contents are malformed
+    QList<QByteArray> parseStatFields(const QByteArray &stat);
+
+    /// Returns the identifier of the parent process, given the contents of a /proc/<pid>/stat file, or -1 if
+    /// it could not be parsed
+    qint64 parseParentPid(const QByteArray &stat);
+
+    /// Returns the number of clock ticks the process has spent in user and kernel mode, given the contents of a
+    /// /proc/<pid>/stat file, or -1 if they could not be parsed
+    qint64 parseCpuTicks(const QByteArray &stat);
+
+    /// Returns the number of resident pages, given the contents of a /proc/<pid>/statm file, or -1 if it could
+    /// not be parsed
+    qint64 parseResidentPages(const QByteArray &statm);
+
+    /// Returns the resident set size of the process with the given identifier in bytes, or -1 if it is not known
+    qint64 getResidentSize(qint64 pid);
+
+    /// Returns the CPU time, in milliseconds, that the process with the given identifier has spent in user and
+    /// kernel mode since it was started, or -1 if it is not known
+    qint64 getCpuTime(qint64 pid);
+
+    /// Returns the total resident set size of the browser process and all of its descendants, which include the
+    /// web engine's renderer processes, in bytes. Returns -1 if memory usage cannot be measured on this platform
+    qint64 getBrowserResidentSize();
+}
+
+#endif // PROCESSMEMORY_H
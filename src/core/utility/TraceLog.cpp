@@ -0,0 +1,282 @@
+#include "TraceLog.h"
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QThread>
+
+#include <QDebug>
+
+namespace
+{
+    /// Number of spans in each chunk of a thread's buffer
+    constexpr std::size_t ChunkSize = 4096;
+
+    /// Maximum number of chunks in a thread's buffer. Spans recorded after the buffer is full are dropped
+    constexpr std::size_t MaxChunks = 64;
+
+    /// A recorded span
+    struct TraceSpan
+    {
+        /// Category of the span
+        const char *Category;
+
+        /// Name of the span
+        const char *Name;
+
+        /// Time at which the span began
+        TraceLog::Clock::time_point StartTime;
+
+        /// Time at which the span ended
+        TraceLog::Clock::time_point EndTime;
+    };
+
+    /// A fixed size block of spans. Only the owning thread writes to a chunk, publishing each span by incrementing
+    /// the count, and publishing the next chunk once this one is full
+    struct TraceChunk
+    {
+        /// Spans in the chunk
+        std::array<TraceSpan, ChunkSize> Spans;
+
+        /// Number of spans that have been written to the chunk
+        std::atomic<std::size_t> Count { 0 };
+
+        /// Chunk that follows this one, once it is full
+        std::atomic<TraceChunk*> Next { nullptr };
+    };
+
+    /// Spans recorded by a single thread
+    struct ThreadBuffer
+    {
+        /// Constructs the buffer with its first chunk
+        ThreadBuffer(int threadId, const QString &threadName) :
+            ThreadId(threadId),
+            ThreadName(threadName),
+            Head(std::make_unique<TraceChunk>()),
+            Tail(Head.get()),
+            NumChunks(1),
+            NumDropped(0)
+        {
+        }
+
+        /// Frees the chunks that follow the first
+        ~ThreadBuffer()
+        {
+            TraceChunk *chunk = Head->Next.load(std::memory_order_acquire);
+            while (chunk)
+            {
+                TraceChunk *next = chunk->Next.load(std::memory_order_acquire);
+                delete chunk;
+                chunk = next;
+            }
+        }
+
+        /// Identifier of the thread in the trace
+        const int ThreadId;
+
+        /// Name of the thread in the trace
+        const QString ThreadName;
+
+        /// First chunk of the buffer
+        std::unique_ptr<TraceChunk> Head;
+
+        /// Chunk to which spans are being written. Only accessed by the owning thread
+        TraceChunk *Tail;
+
+        /// Number of chunks in the buffer. Only accessed by the owning thread
+        std::size_t NumChunks;
+
+        /// Number of spans that were dropped because the buffer was full
+        std::atomic<quint64> NumDropped;
+    };
+
+    /// Buffers of every thread that has recorded a span
+    struct TraceRegistry
+    {
+        /// Guards the list of buffers and the output file, but not the contents of the buffers
+        std::mutex Mutex;
+
+        /// Buffer of each thread. Buffers are kept after their thread exits, so their spans are still exported
+        std::vector<std::unique_ptr<ThreadBuffer>> Buffers;
+
+        /// Path of the file to which the trace is written on exit
+        QString OutputFile;
+    };
+
+    /// Returns the registry of thread buffers. It is never destroyed, as threads may still record spans while
+    /// static objects are being destroyed
+    TraceRegistry &getRegistry()
+    {
+        static TraceRegistry *registry = new TraceRegistry;
+        return *registry;
+    }
+
+    /// Buffer of the calling thread, created when the thread records its first span
+    thread_local ThreadBuffer *t_threadBuffer = nullptr;
+
+    /// Returns the buffer of the calling thread, registering a new buffer if needed
+    ThreadBuffer *getThreadBuffer()
+    {
+        if (t_threadBuffer)
+            return t_threadBuffer;
+
+        QString threadName = QThread::currentThread()->objectName();
+        QCoreApplication *app = QCoreApplication::instance();
+        if (app && app->thread() == QThread::currentThread())
+            threadName = QStringLiteral("GUI");
+
+        TraceRegistry &registry = getRegistry();
+        std::lock_guard<std::mutex> lock{registry.Mutex};
+
+        const int threadId = static_cast<int>(registry.Buffers.size()) + 1;
+        if (threadName.isEmpty())
+            threadName = QString("Thread %1").arg(threadId);
+
+        registry.Buffers.push_back(std::make_unique<ThreadBuffer>(threadId, threadName));
+        t_threadBuffer = registry.Buffers.back().get();
+        return t_threadBuffer;
+    }
+
+    /// Converts a duration to the microsecond units used by the trace event format
+    double toMicroseconds(TraceLog::Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    }
+}
+
+std::atomic_bool TraceLog::s_enabled { false };
+
+void TraceLog::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void TraceLog::initFromEnvironment()
+{
+    const QString outputFile = qEnvironmentVariable("VIPER_TRACE_FILE");
+    if (outputFile.isEmpty())
+        return;
+
+    {
+        TraceRegistry &registry = getRegistry();
+        std::lock_guard<std::mutex> lock{registry.Mutex};
+        registry.OutputFile = outputFile;
+    }
+
+    setEnabled(true);
+}
+
+void TraceLog::addSpan(const char *category, const char *name, Clock::time_point startTime, Clock::time_point endTime)
+{
+    ThreadBuffer *buffer = getThreadBuffer();
+
+    TraceChunk *chunk = buffer->Tail;
+    std::size_t count = chunk->Count.load(std::memory_order_relaxed);
+    if (count == ChunkSize)
+    {
+        if (buffer->NumChunks == MaxChunks)
+        {
+            buffer->NumDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        TraceChunk *nextChunk = new TraceChunk;
+        chunk->Next.store(nextChunk, std::memory_order_release);
+        buffer->Tail = nextChunk;
+        ++buffer->NumChunks;
+
+        chunk = nextChunk;
+        count = 0;
+    }
+
+    chunk->Spans[count] = TraceSpan { category, name, startTime, endTime };
+    chunk->Count.store(count + 1, std::memory_order_release);
+}
+
+QByteArray TraceLog::toJson()
+{
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray events;
+    quint64 numDropped = 0;
+
+    TraceRegistry &registry = getRegistry();
+    std::lock_guard<std::mutex> lock{registry.Mutex};
+    for (const std::unique_ptr<ThreadBuffer> &buffer : registry.Buffers)
+    {
+        QJsonObject threadName;
+        threadName.insert(QLatin1String("name"), QLatin1String("thread_name"));
+        threadName.insert(QLatin1String("ph"), QLatin1String("M"));
+        threadName.insert(QLatin1String("pid"), pid);
+        threadName.insert(QLatin1String("tid"), buffer->ThreadId);
+        threadName.insert(QLatin1String("args"), QJsonObject{ { QLatin1String("name"), buffer->ThreadName } });
+        events.append(threadName);
+
+        // Only the spans published before the count was read are exported, as the thread may still be recording
+        for (const TraceChunk *chunk = buffer->Head.get(); chunk != nullptr; chunk = chunk->Next.load(std::memory_order_acquire))
+        {
+            const std::size_t count = chunk->Count.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const TraceSpan &span = chunk->Spans[i];
+
+                QJsonObject event;
+                event.insert(QLatin1String("name"), QLatin1String(span.Name));
+                event.insert(QLatin1String("cat"), QLatin1String(span.Category));
+                event.insert(QLatin1String("ph"), QLatin1String("X"));
+                event.insert(QLatin1String("ts"), toMicroseconds(span.StartTime.time_since_epoch()));
+                event.insert(QLatin1String("dur"), toMicroseconds(span.EndTime - span.StartTime));
+                event.insert(QLatin1String("pid"), pid);
+                event.insert(QLatin1String("tid"), buffer->ThreadId);
+                events.append(event);
+            }
+        }
+
+        numDropped += buffer->NumDropped.load(std::memory_order_relaxed);
+    }
+
+    QJsonObject trace;
+    trace.insert(QLatin1String("traceEvents"), events);
+    trace.insert(QLatin1String("displayTimeUnit"), QLatin1String("ms"));
+    trace.insert(QLatin1String("otherData"), QJsonObject{ { QLatin1String("droppedSpans"), static_cast<qint64>(numDropped) } });
+    return QJsonDocument(trace).toJson(QJsonDocument::Compact);
+}
+
+bool TraceLog::writeOutputFile()
+{
+    if (!isEnabled())
+        return false;
+
+    QString outputFile;
+    {
+        TraceRegistry &registry = getRegistry();
+        std::lock_guard<std::mutex> lock{registry.Mutex};
+        outputFile = registry.OutputFile;
+    }
+
+    if (outputFile.isEmpty())
+        return false;
+
+    QSaveFile file(outputFile);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "TraceLog - could not open trace file " << outputFile;
+        return false;
+    }
+
+    file.write(toJson());
+    if (!file.commit())
+    {
+        qWarning() << "TraceLog - could not write trace file " << outputFile;
+        return false;
+    }
+
+    return true;
+}
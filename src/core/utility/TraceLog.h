@@ -0,0 +1,109 @@
+#ifndef TRACELOG_H
+#define TRACELOG_H
+
+#include <atomic>
+#include <chrono>
+
+#include <QByteArray>
+#include <QString>
+
+/**
+ * @class TraceLog
+ * @brief Records the time spent in spans of code, such as the stages of the browser's startup or the handling
+ *        of a navigation, and exports them in the Chrome trace event format, which can be opened in
+ *        chrome://tracing or the Perfetto UI.
+ *
+ *        Tracing is disabled by default, in which case recording a span costs a single atomic load. When enabled,
+ *        each thread appends its spans to its own buffer without taking a lock. The buffers are read when the trace
+ *        is exported, which may happen on any thread while the others are still recording.
+ *
+ *        Tracing is enabled by setting the VIPER_TRACE_FILE environment variable to the path of the file to which
+ *        the trace is written when the browser exits. While enabled, the trace can also be viewed at viper://trace.json
+ */
+class TraceLog
+{
+public:
+    /// Clock used to time each span
+    using Clock = std::chrono::steady_clock;
+
+    /// Returns true if spans are being recorded, false if else
+    static bool isEnabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    /// Starts or stops recording spans
+    static void setEnabled(bool enabled);
+
+    /// Enables tracing if the VIPER_TRACE_FILE environment variable is set, and remembers the file to which the trace is written
+    static void initFromEnvironment();
+
+    /**
+     * @brief Records a span on the calling thread
+     * @param category Category of the span. Must point to a string that outlives the trace, such as a literal
+     * @param name Name of the span. Must point to a string that outlives the trace, such as a literal
+     * @param startTime Time at which the span began
+     * @param endTime Time at which the span ended
+     */
+    static void addSpan(const char *category, const char *name, Clock::time_point startTime, Clock::time_point endTime);
+
+    /// Returns the spans recorded so far, as a JSON document in the Chrome trace event format
+    static QByteArray toJson();
+
+    /// Writes the trace to the file named by the VIPER_TRACE_FILE environment variable, if tracing is enabled
+    /// and the variable was set. Returns true on success
+    static bool writeOutputFile();
+
+private:
+    /// Set while spans are being recorded
+    static std::atomic_bool s_enabled;
+};
+
+/**
+ * @class TraceScope
+ * @brief Records a span from the construction of the scope to its destruction, if tracing was enabled
+ *        when the scope was entered. Usually declared through the VIPER_TRACE_SCOPE macro.
+ */
+class TraceScope
+{
+public:
+    /// Begins a span with the given category and name, which must both be string literals
+    TraceScope(const char *category, const char *name) :
+        m_category(category),
+        m_name(name),
+        m_enabled(TraceLog::isEnabled()),
+        m_startTime(m_enabled ? TraceLog::Clock::now() : TraceLog::Clock::time_point())
+    {
+    }
+
+    /// Ends the span
+    ~TraceScope()
+    {
+        if (m_enabled)
+            TraceLog::addSpan(m_category, m_name, m_startTime, TraceLog::Clock::now());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope &operator=(const TraceScope&) = delete;
+
+private:
+    /// Category of the span
+    const char *m_category;
+
+    /// Name of the span
+    const char *m_name;
+
+    /// True if the span is being recorded
+    const bool m_enabled;
+
+    /// Time at which the span began
+    const TraceLog::Clock::time_point m_startTime;
+};
+
+#define VIPER_TRACE_CONCAT_IMPL(a, b) a##b
+#define VIPER_TRACE_CONCAT(a, b) VIPER_TRACE_CONCAT_IMPL(a, b)
+
+/// Records the time spent in the enclosing scope under the given category and name
+#define VIPER_TRACE_SCOPE(category, name) TraceScope VIPER_TRACE_CONCAT(traceScope_, __LINE__)(category, name)
+
+#endif // TRACELOG_H
@@ -96,7 +96,7 @@ class TreeNode
 
 protected:
     /// Pointer to the node's parent
-    T *m_parent;
+    T *m_parent { nullptr };
 
     /// Vector of child nodes belonging to this node
     std::vector< std::unique_ptr<T> > m_children;
@@ -46,18 +46,24 @@ WebHistory::~WebHistory()
 {
 }
 
-void WebHistory::load(QByteArray &data)
+bool WebHistory::load(QByteArray &data)
 {
+    if (!m_impl || data.isEmpty())
+        return false;
+
     QString version;
 
     QDataStream stream(&data, QIODeviceBase::ReadOnly);
     stream >> version;
     if (version.compare(SerializationVersion) != 0)
-        return;
+        return false;
 
     stream >> *m_impl;
+    if (stream.status() != QDataStream::Ok || m_impl->count() == 0)
+        return false;
 
     emit historyChanged();
+    return true;
 }
 
 QByteArray WebHistory::save() const
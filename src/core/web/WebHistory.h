@@ -84,8 +84,9 @@ class WebHistory : public QObject
     /// Returns true if the page can go forward by one entry in its history, false if else
     bool canGoForward() const;
 
-    /// Loads the history from a byte array
-    void load(QByteArray &data);
+    /// Loads the history from a byte array, which also navigates the page to the current entry of the history.
+    /// Returns true if the history was restored, or false if the data was invalid or did not contain any entries
+    bool load(QByteArray &data);
 
     /// Saves the web page history, returning it as a byte array
     QByteArray save() const;
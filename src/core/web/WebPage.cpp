@@ -13,6 +13,7 @@
 #include "RequestInterceptor.h"
 #include "SecurityManager.h"
 #include "Settings.h"
+#include "TraceLog.h"
 #include "URL.h"
 #include "UserScriptManager.h"
 #include "WebDialog.h"
@@ -21,6 +22,7 @@
 #include "WebView.h"
 
 #include <QAuthenticator>
+#include <QCoreApplication>
 #include <QFile>
 #include <QMessageBox>
 #include <QTimer>
@@ -73,12 +75,17 @@ void WebPage::setupSlots(const ViperServiceLocator &serviceLocator)
 
     AutoFill *autoFillManager = serviceLocator.getServiceAs<AutoFill>("AutoFill");
 
-    QWebChannel *channel = new QWebChannel(this);
-    channel->registerObject(QLatin1String("extStorage"), serviceLocator.getServiceAs<ExtStorage>("storage"));
-    channel->registerObject(QLatin1String("favoritePageManager"), serviceLocator.getServiceAs<FavoritePagesManager>("favoritePageManager"));
-    channel->registerObject(QLatin1String("autofill"), new AutoFillBridge(autoFillManager, this));
-    channel->registerObject(QLatin1String("favicons"), new FaviconStoreBridge(serviceLocator.getServiceAs<FaviconManager>("FaviconManager"), this));
-    setWebChannel(channel, QWebEngineScript::ApplicationWorld);
+    // The extension storage and favorite pages manager are loaded on database threads during startup. Until they
+    // are registered, the page's scripts keep waiting for the web channel's transport
+    BrowserApplication *app = qobject_cast<BrowserApplication*>(QCoreApplication::instance());
+    if (app && !app->areDeferredServicesLoaded())
+    {
+        connect(app, &BrowserApplication::deferredServicesLoaded, this, [this, &serviceLocator, autoFillManager](){
+            setupWebChannel(serviceLocator, autoFillManager);
+        });
+    }
+    else
+        setupWebChannel(serviceLocator, autoFillManager);
 
     connect(this, &WebPage::authenticationRequired,      this, &WebPage::onAuthenticationRequired);
     connect(this, &WebPage::certificateError,            this, &WebPage::onCertificateError);
@@ -101,6 +108,16 @@ void WebPage::setupSlots(const ViperServiceLocator &serviceLocator)
     connect(this, &WebPage::registerProtocolHandlerRequested, this, &WebPage::onRegisterProtocolHandlerRequested);
 }
 
+void WebPage::setupWebChannel(const ViperServiceLocator &serviceLocator, AutoFill *autoFillManager)
+{
+    QWebChannel *channel = new QWebChannel(this);
+    channel->registerObject(QLatin1String("extStorage"), serviceLocator.getServiceAs<ExtStorage>("storage"));
+    channel->registerObject(QLatin1String("favoritePageManager"), serviceLocator.getServiceAs<FavoritePagesManager>("favoritePageManager"));
+    channel->registerObject(QLatin1String("autofill"), new AutoFillBridge(autoFillManager, this));
+    channel->registerObject(QLatin1String("favicons"), new FaviconStoreBridge(serviceLocator.getServiceAs<FaviconManager>("FaviconManager"), this));
+    setWebChannel(channel, QWebEngineScript::ApplicationWorld);
+}
+
 WebHistory *WebPage::getHistory() const
 {
     return m_history;
@@ -113,6 +130,8 @@ const QUrl &WebPage::getOriginalUrl() const
 
 bool WebPage::acceptNavigationRequest(const QUrl &url, QWebEnginePage::NavigationType type, bool isMainFrame)
 {
+    VIPER_TRACE_SCOPE("navigation", "WebPage::acceptNavigationRequest");
+
     // Check if special url such as "viper:print"
     if (url.scheme().compare(QLatin1String("viper")) == 0)
     {
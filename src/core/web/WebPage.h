@@ -18,6 +18,7 @@ namespace adblock {
     class AdBlockManager;
 }
 
+class AutoFill;
 class UserScriptManager;
 class WebHistory;
 
@@ -105,6 +106,9 @@ private Q_SLOTS:
     /// Connects web engine page signals to their handlers
     void setupSlots(const ViperServiceLocator &serviceLocator);
 
+    /// Publishes the browser's services to the page's scripts through a web channel
+    void setupWebChannel(const ViperServiceLocator &serviceLocator, AutoFill *autoFillManager);
+
     /// Returns true if the web feature is permitted for the given origin, false if not explicitly
     /// allowed (does not imply that a permission has been denied).
     bool isPermissionAllowed(const QUrl &securityOrigin, WebPage::Feature feature) const;
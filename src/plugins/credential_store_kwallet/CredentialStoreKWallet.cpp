@@ -37,6 +37,19 @@ std::vector<QString> CredentialStoreKWallet::getHostNames()
     return result;
 }
 
+std::vector<WebCredentialInfo> CredentialStoreKWallet::getCredentialInfo()
+{
+    std::vector<WebCredentialInfo> result;
+
+    for (auto it = m_credentials.cbegin(); it != m_credentials.cend(); ++it)
+    {
+        for (const WebCredentials &creds : it.value())
+            result.push_back(WebCredentialInfo { creds.Host, creds.LastLogin, creds.Username });
+    }
+
+    return result;
+}
+
 void CredentialStoreKWallet::addCredentials(const WebCredentials &credentials)
 {
     if (credentials.Host.isEmpty())
@@ -32,6 +32,9 @@ class CredentialStoreKWallet : public QObject, public CredentialStore
     /// Returns a list of the hosts which have at least one set of credentials in the store
     std::vector<QString> getHostNames() override;
 
+    /// Returns the host, username and last login time of every set of credentials in the store
+    std::vector<WebCredentialInfo> getCredentialInfo() override;
+
     /// Adds a set of credentials to the store
     void addCredentials(const WebCredentials &credentials) override;
 
@@ -10,10 +10,11 @@ static bool compareWebCredentials(const WebCredentials &a, const WebCredentials
 
 CredentialStoreSecret::CredentialStoreSecret() :
     QObject(),
-    m_credentials()
+    m_credentials(),
+    m_loadedPasswordHosts(),
+    m_loaded(false)
 {
     setObjectName(QStringLiteral("CredentialStoreSecret"));
-    loadCredentials();
 }
 
 CredentialStoreSecret::~CredentialStoreSecret()
@@ -22,6 +23,8 @@ CredentialStoreSecret::~CredentialStoreSecret()
 
 std::vector<QString> CredentialStoreSecret::getHostNames()
 {
+    loadCredentials();
+
     std::vector<QString> result;
 
     for (auto it = m_credentials.cbegin(); it != m_credentials.cend(); ++it)
@@ -30,11 +33,31 @@ std::vector<QString> CredentialStoreSecret::getHostNames()
     return result;
 }
 
+std::vector<WebCredentialInfo> CredentialStoreSecret::getCredentialInfo()
+{
+    loadCredentials();
+
+    std::vector<WebCredentialInfo> result;
+
+    for (auto it = m_credentials.cbegin(); it != m_credentials.cend(); ++it)
+    {
+        for (const WebCredentials &creds : it.value())
+            result.push_back(WebCredentialInfo { creds.Host, creds.LastLogin, creds.Username });
+    }
+
+    return result;
+}
+
 void CredentialStoreSecret::addCredentials(const WebCredentials &credentials)
 {
     if (credentials.Host.isEmpty())
         return;
 
+    // All of the host's credentials are written again, so their passwords must be known
+    loadCredentials();
+    if (!loadPasswordsFor(credentials.Host))
+        return;
+
     std::vector<WebCredentials> &creds = m_credentials[credentials.Host];
     creds.push_back(credentials);
 
@@ -45,16 +68,20 @@ void CredentialStoreSecret::addCredentials(const WebCredentials &credentials)
 
 std::vector<WebCredentials> CredentialStoreSecret::getCredentialsFor(const QUrl &url)
 {
+    loadCredentials();
+
     const QString host = url.host();
     if (!m_credentials.contains(host))
         return std::vector<WebCredentials>();
 
+    loadPasswordsFor(host);
     return m_credentials.value(host);
 }
 
 void CredentialStoreSecret::removeCredentials(const WebCredentials &credentials)
 {
-    if (!m_credentials.contains(credentials.Host))
+    loadCredentials();
+    if (!m_credentials.contains(credentials.Host) || !loadPasswordsFor(credentials.Host))
         return;
 
     std::vector<WebCredentials> &creds = m_credentials[credentials.Host];
@@ -73,7 +100,8 @@ void CredentialStoreSecret::removeCredentials(const WebCredentials &credentials)
 
 void CredentialStoreSecret::updateCredentials(const WebCredentials &credentials)
 {
-    if (!m_credentials.contains(credentials.Host))
+    loadCredentials();
+    if (!m_credentials.contains(credentials.Host) || !loadPasswordsFor(credentials.Host))
         return;
 
     std::vector<WebCredentials> &creds = m_credentials[credentials.Host];
@@ -173,9 +201,14 @@ void CredentialStoreSecret::saveCredentialsFor(const QString &host)
 
 void CredentialStoreSecret::loadCredentials()
 {
-    const SecretSearchFlags flags = SECRET_SEARCH_ALL;
+    if (m_loaded)
+        return;
+
+    m_loaded = true;
+
+    // Only the attributes of each item are read here, as retrieving a secret decrypts it
     GError *error = NULL;
-    GList *credentials = secret_password_search_sync(&schema, flags, NULL, &error, NULL);
+    GList *credentials = secret_password_search_sync(&schema, SECRET_SEARCH_ALL, NULL, &error, NULL);
 
     if (credentials == NULL)
     {
@@ -187,40 +220,23 @@ void CredentialStoreSecret::loadCredentials()
         return;
     }
 
-    for (; credentials != NULL; credentials = credentials->next)
+    for (GList *node = credentials; node != NULL; node = node->next)
     {
-        SecretRetrievable *credential = static_cast<SecretRetrievable *>(credentials->data);
-        SecretValue *secret = secret_retrievable_retrieve_secret_sync(credential, NULL, &error);
-
-        if (secret == NULL)
-        {
-            if (error == NULL)
-            {
-                qDebug() << "CredentialStoreSecret: could not load password";
-            }
-            else
-            {
-                qDebug() << "CredentialStoreSecret: could not load password: " << error->message;
-                g_error_free(error);
-                error = NULL;
-            }
-            continue;
-        }
+        SecretRetrievable *credential = static_cast<SecretRetrievable *>(node->data);
 
         GHashTable *attributes = secret_retrievable_get_attributes(credential);
-        const gchar *password = secret_value_get_text(secret);
         const gchar *host = static_cast<const gchar *>(g_hash_table_lookup(attributes, "host"));
         const gchar *lastlogin = static_cast<const gchar *>(g_hash_table_lookup(attributes, "lastlogin"));
         const gchar *username = static_cast<const gchar *>(g_hash_table_lookup(attributes, "username"));
         const gchar *formdata = static_cast<const gchar *>(g_hash_table_lookup(attributes, "formdata"));
 
-        if (password == NULL || host == NULL || lastlogin == NULL || username == NULL || formdata == NULL)
+        if (host == NULL || lastlogin == NULL || username == NULL || formdata == NULL)
         {
             qDebug() << "CredentialStoreSecret: could not load attributes";
         }
         else
         {
-            WebCredentials item = {host, QDateTime::fromString(lastlogin, Qt::ISODate), username, password, {}};
+            WebCredentials item = {host, QDateTime::fromString(lastlogin, Qt::ISODate), username, QString(), {}};
             QUrlQuery querystring(formdata);
             auto pairs = querystring.queryItems(QUrl::FullyDecoded);
 
@@ -232,12 +248,86 @@ void CredentialStoreSecret::loadCredentials()
             m_credentials[host].push_back(item);
         }
 
-        secret_value_unref(secret);
         g_hash_table_unref(attributes);
     }
 
+    g_list_free_full(credentials, g_object_unref);
+
     for (std::vector<WebCredentials> &creds : m_credentials)
     {
         std::sort(creds.begin(), creds.end(), compareWebCredentials);
     }
 }
+
+bool CredentialStoreSecret::loadPasswordsFor(const QString &host)
+{
+    if (m_loadedPasswordHosts.contains(host))
+        return true;
+
+    auto credsIt = m_credentials.find(host);
+    if (credsIt == m_credentials.end() || credsIt->empty())
+        return true;
+
+    const std::string hostString = host.toStdString();
+    GError *error = NULL;
+    GList *credentials = secret_password_search_sync(&schema, static_cast<SecretSearchFlags>(SECRET_SEARCH_ALL | SECRET_SEARCH_UNLOCK),
+                                                     NULL, &error, "host", hostString.c_str(), NULL);
+
+    if (credentials == NULL)
+    {
+        if (error != NULL)
+        {
+            qDebug() << "CredentialStoreSecret: could not load credentials for " << host << ": " << error->message;
+            g_error_free(error);
+        }
+        return false;
+    }
+
+    std::vector<WebCredentials> &creds = *credsIt;
+    bool loadedAll = true;
+
+    for (GList *node = credentials; node != NULL; node = node->next)
+    {
+        SecretRetrievable *credential = static_cast<SecretRetrievable *>(node->data);
+        SecretValue *secret = secret_retrievable_retrieve_secret_sync(credential, NULL, &error);
+
+        if (secret == NULL)
+        {
+            if (error == NULL)
+            {
+                qDebug() << "CredentialStoreSecret: could not load password";
+            }
+            else
+            {
+                qDebug() << "CredentialStoreSecret: could not load password: " << error->message;
+                g_error_free(error);
+                error = NULL;
+            }
+            loadedAll = false;
+            continue;
+        }
+
+        GHashTable *attributes = secret_retrievable_get_attributes(credential);
+        const gchar *password = secret_value_get_text(secret);
+        const gchar *username = static_cast<const gchar *>(g_hash_table_lookup(attributes, "username"));
+
+        if (password != NULL && username != NULL)
+        {
+            const QString usernameString = QString::fromUtf8(username);
+            for (WebCredentials &item : creds)
+            {
+                if (item.Username.compare(usernameString) == 0)
+                    item.Password = QString::fromUtf8(password);
+            }
+        }
+
+        secret_value_unref(secret);
+        g_hash_table_unref(attributes);
+    }
+
+    g_list_free_full(credentials, g_object_unref);
+
+    if (loadedAll)
+        m_loadedPasswordHosts.insert(host);
+    return loadedAll;
+}
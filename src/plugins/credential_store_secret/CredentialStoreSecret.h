@@ -3,9 +3,16 @@
 
 #include "CredentialStore.h"
 
+#include <QHash>
+#include <QSet>
+#include <QString>
+
 /**
  * @class CredentialStoreSecret
  * @brief Implementation of the credential store using libsecret as a backend storage system
+ *
+ *        The attributes of the saved credentials are read the first time the store is used. Passwords are only
+ *        decrypted when the credentials of their host are requested or changed.
  */
 class CredentialStoreSecret : public QObject, public CredentialStore
 {
@@ -14,7 +21,7 @@ class CredentialStoreSecret : public QObject, public CredentialStore
     Q_INTERFACES(CredentialStore)
 
 public:
-    /// Constructor. Opens the libsecret backend
+    /// Constructor. The libsecret backend is not read until the store is first used
     explicit CredentialStoreSecret();
 
     /// Credential store destructor, frees resources used by libsecret
@@ -23,6 +30,9 @@ class CredentialStoreSecret : public QObject, public CredentialStore
     /// Returns a list of the hosts which have at least one set of credentials in the store
     std::vector<QString> getHostNames() override;
 
+    /// Returns the host, username and last login time of every set of credentials in the store
+    std::vector<WebCredentialInfo> getCredentialInfo() override;
+
     /// Adds a set of credentials to the store
     void addCredentials(const WebCredentials &credentials) override;
 
@@ -36,15 +46,27 @@ class CredentialStoreSecret : public QObject, public CredentialStore
     void updateCredentials(const WebCredentials &credentials) override;
 
 private:
-    /// Loads credentials from the libsecret provider
+    /// Loads the attributes of every set of credentials from the libsecret provider, without their passwords,
+    /// if they have not been loaded yet
     void loadCredentials();
 
+    /// Loads the passwords of the credentials associated with the given host, if they have not been loaded yet.
+    /// Returns false if any of the passwords could not be read, in which case the host's credentials must not be saved
+    bool loadPasswordsFor(const QString &host);
+
     /// Saves the credentials associated with the given host into the libsecret provider
     void saveCredentialsFor(const QString &host);
 
 private:
-    /// Hashmap of host names to a container of the credentials associated with that host
+    /// Hashmap of host names to a container of the credentials associated with that host. The passwords are
+    /// empty until they are loaded for the host
     QHash<QString, std::vector<WebCredentials>> m_credentials;
+
+    /// Hosts whose passwords have been loaded from the libsecret provider
+    QSet<QString> m_loadedPasswordHosts;
+
+    /// True once the attributes of the credentials have been loaded
+    bool m_loaded;
 };
 
 #endif // CREDENTIALSTORESECRET_H
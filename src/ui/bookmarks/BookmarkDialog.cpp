@@ -8,6 +8,8 @@
 #include <QFuture>
 #include <QQueue>
 
+#include <vector>
+
 BookmarkDialog::BookmarkDialog(BookmarkManager *bookmarkMgr, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::BookmarkDialog),
@@ -23,12 +25,26 @@ BookmarkDialog::BookmarkDialog(BookmarkManager *bookmarkMgr, QWidget *parent) :
 
     const int maxTextWidth = std::max(width(), 290) * 3 / 4;
     QFontMetrics folderFontMetrics(font());
-    // Populate combo box with each folder in the bookmark collection
-    const BookmarkNode *rootNode = m_bookmarkManager->getRoot();
-    for (const auto it : *m_bookmarkManager)
+    // Populate combo box with each folder in the bookmark collection, in tree order. The folders are read from
+    // the tree itself, since the combo box refers to the nodes
+    std::vector<BookmarkNode*> folderStack;
+    if (BookmarkNode *rootNode = m_bookmarkManager->getRoot())
+    {
+        for (int i = rootNode->getNumChildren() - 1; i >= 0; --i)
+            folderStack.push_back(rootNode->getNode(i));
+    }
+    while (!folderStack.empty())
     {
-        if (it != rootNode && it->getType() == BookmarkNode::Folder)
-            ui->comboBoxFolder->addItem(folderFontMetrics.elidedText(it->getName(), Qt::ElideRight, maxTextWidth) , QVariant::fromValue((void *)it));
+        BookmarkNode *node = folderStack.back();
+        folderStack.pop_back();
+
+        if (node->getType() != BookmarkNode::Folder)
+            continue;
+
+        ui->comboBoxFolder->addItem(folderFontMetrics.elidedText(node->getName(), Qt::ElideRight, maxTextWidth) , QVariant::fromValue((void *)node));
+
+        for (int i = node->getNumChildren() - 1; i >= 0; --i)
+            folderStack.push_back(node->getNode(i));
     }
 
     ui->comboBoxFolder->setCurrentIndex(0);
@@ -241,7 +241,8 @@ void BookmarkWidget::onImportExportBoxChanged(int index)
                 if (!importer.import(fileName, importFolder))
                     qDebug() << "Error: In BookmarkWidget, could not import bookmarks from file " << fileName;
 
-                resetFolderModel();
+                // Queued behind the importer's update of the bookmark tree
+                QMetaObject::invokeMethod(this, &BookmarkWidget::resetFolderModel, Qt::QueuedConnection);
             });
 
             break;
@@ -42,6 +42,7 @@ void HistoryMenu::addHistoryItem(const QUrl &url, const QString &title, const QI
 {
     QAction *historyItem = new QAction(title);
     historyItem->setIcon(favicon);
+    historyItem->setData(url);
     connect(historyItem, &QAction::triggered, this, [this, url](){
         emit loadUrl(url);
     });
@@ -61,6 +62,7 @@ void HistoryMenu::prependHistoryItem(const QUrl &url, const QString &title, cons
 
     QAction *historyItem = new QAction(title);
     historyItem->setIcon(favicon);
+    historyItem->setData(url);
     connect(historyItem, &QAction::triggered, this, [this, url](){
         emit loadUrl(url);
     });
@@ -110,11 +112,29 @@ void HistoryMenu::onPageVisited(const QUrl &url, const QString &title)
     prependHistoryItem(url, title, m_faviconManager->getFavicon(url));
 }
 
+void HistoryMenu::onPageIconLoaded(const QUrl &pageUrl, const QIcon &icon)
+{
+    const QList<QAction*> menuActions = actions();
+    for (int i = 3; i < menuActions.size(); ++i)
+    {
+        QAction *historyItem = menuActions.at(i);
+        if (FaviconManager::getPageKey(historyItem->data().toUrl()) == pageUrl)
+            historyItem->setIcon(icon);
+    }
+}
+
 void HistoryMenu::setup()
 {
     connect(m_historyManager, &HistoryManager::pageVisited,    this, &HistoryMenu::onPageVisited);
     connect(m_historyManager, &HistoryManager::historyCleared, this, &HistoryMenu::resetItems, Qt::QueuedConnection);
 
+    // Items added before the favicon store was loaded have a blank icon
+    if (m_faviconManager)
+    {
+        connect(m_faviconManager, &FaviconManager::storeReady,     this, &HistoryMenu::resetItems);
+        connect(m_faviconManager, &FaviconManager::pageIconLoaded, this, &HistoryMenu::onPageIconLoaded);
+    }
+
     m_actionShowHistory = addAction(QLatin1String("&Show all History"));
     m_actionShowHistory->setShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_H));
 
@@ -54,6 +54,9 @@ private Q_SLOTS:
     /// Called when a page has been visited by the user
     void onPageVisited(const QUrl &url, const QString &title);
 
+    /// Called when the favicon of a page has been loaded, updating the icons of the menu items that link to the page
+    void onPageIconLoaded(const QUrl &pageUrl, const QIcon &icon);
+
 private:
     /// Binds the pageVisited signal from the \ref HistoryManager to a slot that adds the
     /// page to the top of the history menu. Also binds the reset menu signal to the reset items slot
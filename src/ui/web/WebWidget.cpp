@@ -1,4 +1,5 @@
 #include "AdBlockManager.h"
+#include "BrowserApplication.h"
 #include "BrowserTabWidget.h"
 #include "FaviconManager.h"
 #include "HistoryManager.h"
@@ -15,6 +16,8 @@
 
 #include <chrono>
 #include <QAction>
+#include <QCoreApplication>
+#include <QDateTime>
 #include <QHideEvent>
 #include <QMouseEvent>
 #include <QQuickWidget>
@@ -25,6 +28,16 @@
 #include <QDebug>
 
 WebWidget::WebWidget(const ViperServiceLocator &serviceLocator, bool privateMode, QWidget *parent) :
+    WebWidget(serviceLocator, privateMode, nullptr, parent)
+{
+}
+
+WebWidget::WebWidget(const ViperServiceLocator &serviceLocator, bool privateMode, WebState &&placeholderState, QWidget *parent) :
+    WebWidget(serviceLocator, privateMode, &placeholderState, parent)
+{
+}
+
+WebWidget::WebWidget(const ViperServiceLocator &serviceLocator, bool privateMode, WebState *placeholderState, QWidget *parent) :
     QWidget(parent),
     m_serviceLocator(serviceLocator),
     m_adBlockManager(serviceLocator.getServiceAs<adblock::AdBlockManager>("AdBlockManager")),
@@ -43,6 +56,10 @@ WebWidget::WebWidget(const ViperServiceLocator &serviceLocator, bool privateMode
     m_contextMenuPosRelative(),
     m_viewFocusProxy(nullptr),
     m_hibernating(false),
+    m_wakeOnShow(false),
+    m_lastActiveTime(0),
+    m_hasUserInput(false),
+    m_wakeNavigationCount(0),
     m_savedState(),
     m_lastTypedUrl()
 {
@@ -50,15 +67,27 @@ WebWidget::WebWidget(const ViperServiceLocator &serviceLocator, bool privateMode
 
     m_mainWindow = qobject_cast<MainWindow*>(window());
 
-    setupWebView();
-
     QVBoxLayout *vLayout = new QVBoxLayout(this);
     vLayout->setContentsMargins(0, 0, 0, 0);
     vLayout->setSpacing(0);
-    vLayout->addWidget(m_view);
     setLayout(vLayout);
 
-    setFocusProxy(m_view);
+    if (placeholderState != nullptr)
+    {
+        // A placeholder starts out in hibernation, without creating its web view
+        m_savedState = std::move(*placeholderState);
+        m_hibernating = true;
+        m_wakeOnShow = true;
+
+        setCursor(Qt::PointingHandCursor);
+        setAutoFillBackground(true);
+    }
+    else
+    {
+        setupWebView();
+        vLayout->addWidget(m_view);
+        setFocusProxy(m_view);
+    }
 
     if (BrowserTabWidget *tabWidget = qobject_cast<BrowserTabWidget*>(parentWidget()))
     {
@@ -70,7 +99,16 @@ WebWidget::WebWidget(const ViperServiceLocator &serviceLocator, bool privateMode
         if (HistoryManager *historyMgr = serviceLocator.getServiceAs<HistoryManager>("HistoryManager"))
             m_pageLoadObserver = new WebLoadObserver(historyMgr, this);
 
-        if (WebPageThumbnailStore *thumbnailStore = serviceLocator.getServiceAs<WebPageThumbnailStore>("WebPageThumbnailStore"))
+        // The thumbnail store is loaded on a database thread during startup, and may not be registered yet
+        BrowserApplication *app = qobject_cast<BrowserApplication*>(QCoreApplication::instance());
+        if (app && !app->areDeferredServicesLoaded())
+        {
+            connect(app, &BrowserApplication::deferredServicesLoaded, this, [this, &serviceLocator](){
+                if (WebPageThumbnailStore *thumbnailStore = serviceLocator.getServiceAs<WebPageThumbnailStore>("WebPageThumbnailStore"))
+                    connect(this, &WebWidget::loadFinished, thumbnailStore, &WebPageThumbnailStore::onPageLoaded);
+            });
+        }
+        else if (WebPageThumbnailStore *thumbnailStore = serviceLocator.getServiceAs<WebPageThumbnailStore>("WebPageThumbnailStore"))
             connect(this, &WebWidget::loadFinished, thumbnailStore, &WebPageThumbnailStore::onPageLoaded);
     }
 }
@@ -95,7 +133,10 @@ int WebWidget::getProgress() const
 void WebWidget::loadBlankPage()
 {
     if (!m_hibernating)
+    {
+        ++m_wakeNavigationCount;
         m_view->loadBlankPage();
+    }
 }
 
 bool WebWidget::isHibernating() const
@@ -114,7 +155,13 @@ bool WebWidget::isOnBlankPage() const
 QIcon WebWidget::getIcon() const
 {
     if (m_hibernating)
+    {
+        // Tabs restored before the favicon store was loaded are given their icon once it is ready
+        if (m_savedState.icon.isNull() && m_faviconManager != nullptr)
+            return m_faviconManager->getFavicon(m_savedState.url);
+
         return m_savedState.icon;
+    }
 
     QIcon icon { m_page->icon() };
 
@@ -156,6 +203,7 @@ void WebWidget::load(const QUrl &url, bool wasEnteredByUser)
     if (wasEnteredByUser)
         m_lastTypedUrl = url;
 
+    ++m_wakeNavigationCount;
     m_view->load(url);
 }
 
@@ -164,6 +212,7 @@ void WebWidget::load(const HttpRequest &request)
     if (m_hibernating)
         setHibernation(false);
 
+    ++m_wakeNavigationCount;
     m_view->load(request);
 }
 
@@ -175,6 +224,7 @@ void WebWidget::reload()
         return;
     }
 
+    ++m_wakeNavigationCount;
     m_page->triggerAction(WebPage::Reload);
 }
 
@@ -186,6 +236,9 @@ void WebWidget::stop()
 
 void WebWidget::setHibernation(bool on)
 {
+    // An explicit change of hibernation state overrides the wake-up of a placeholder when it is shown
+    m_wakeOnShow = false;
+
     if (m_hibernating == on)
         return;
 
@@ -206,6 +259,7 @@ void WebWidget::setHibernation(bool on)
         delete m_view;
         m_view = nullptr;
         m_page = nullptr;
+        m_hasUserInput = false;
 
         setCursor(Qt::PointingHandCursor);
         setAutoFillBackground(true);
@@ -220,8 +274,7 @@ void WebWidget::setHibernation(bool on)
         setFocusProxy(m_view);
 
         emit aboutToWake();
-        m_view->load(m_savedState.url);
-        getHistory()->load(m_savedState.pageHistory);
+        restorePage(m_savedState);
 
         unsetCursor();
 
@@ -236,13 +289,10 @@ void WebWidget::setHibernation(bool on)
 
 void WebWidget::setWebState(WebState &&state)
 {
-    m_savedState = state;
+    m_savedState = std::move(state);
 
     if (!m_hibernating)
-    {
-        load(state.url);
-        getHistory()->load(state.pageHistory);
-    }
+        restorePage(m_savedState);
     else
         emit loadFinished(false);
 }
@@ -257,6 +307,43 @@ void WebWidget::clearLastTypedUrl()
     m_lastTypedUrl = QUrl();
 }
 
+bool WebWidget::isPlaceholder() const
+{
+    return m_hibernating && m_wakeOnShow;
+}
+
+void WebWidget::setPlaceholderState(WebState &&state)
+{
+    setHibernation(true);
+    setWebState(std::move(state));
+    m_wakeOnShow = true;
+}
+
+bool WebWidget::isAudible() const
+{
+    return !m_hibernating && m_page && m_page->recentlyAudible();
+}
+
+bool WebWidget::hasUserInput() const
+{
+    return m_hasUserInput;
+}
+
+int WebWidget::getWakeNavigationCount() const
+{
+    return m_wakeNavigationCount;
+}
+
+qint64 WebWidget::getLastActiveTime() const
+{
+    return m_lastActiveTime;
+}
+
+void WebWidget::setLastActiveTime(qint64 msecs)
+{
+    m_lastActiveTime = msecs;
+}
+
 WebHistory *WebWidget::getHistory() const
 {
     if (m_hibernating)
@@ -360,6 +447,19 @@ void WebWidget::hideEvent(QHideEvent *event)
 
 void WebWidget::showEvent(QShowEvent *event)
 {
+    m_lastActiveTime = QDateTime::currentMSecsSinceEpoch();
+
+    // A placeholder for a restored tab creates its view once the tab is first activated. The view is
+    // created after the show event has been handled, since waking up changes the widget's layout
+    if (m_hibernating && m_wakeOnShow)
+    {
+        m_wakeOnShow = false;
+        QTimer::singleShot(0, this, [this](){
+            if (m_hibernating)
+                setHibernation(false);
+        });
+    }
+
     const bool updateWebContents = !m_hibernating && m_view && m_page;
     if (updateWebContents)
     {
@@ -391,6 +491,36 @@ void WebWidget::showEvent(QShowEvent *event)
     QWidget::showEvent(event);
 }
 
+QWebEnginePage::LifecycleState WebWidget::getLifecycleState() const
+{
+    if (m_hibernating || m_page == nullptr)
+        return QWebEnginePage::LifecycleState::Discarded;
+
+    return m_page->lifecycleState();
+}
+
+bool WebWidget::setLifecycleState(QWebEnginePage::LifecycleState state)
+{
+    if (!isHidden()
+            || m_hibernating
+            || m_view == nullptr
+            || m_page == nullptr)
+    {
+        return false;
+    }
+
+    if (m_inspector != nullptr
+            && m_inspector->page()->inspectedPage() == static_cast<QWebEnginePage*>(m_page))
+        return false;
+
+    // Pages only move down from active to frozen to discarded while they are hidden
+    if (static_cast<int>(m_page->lifecycleState()) >= static_cast<int>(state))
+        return false;
+
+    m_page->setLifecycleState(state);
+    return true;
+}
+
 void WebWidget::timerEvent(QTimerEvent *event)
 {
     const int timerId = event->timerId();
@@ -410,21 +540,12 @@ void WebWidget::timerEvent(QTimerEvent *event)
             m_lifecycleDiscardTimerId = -1;
         }
 
-        if (!isHidden()
-                || m_hibernating
-                || m_view == nullptr
-                || m_page == nullptr)
-        {
-            return;
-        }
+        setLifecycleState(targetState);
 
-        if (m_inspector != nullptr
-                && m_inspector->page()->inspectedPage() == static_cast<QWebEnginePage*>(m_page))
-            return;
-
-        m_page->setLifecycleState(targetState);
-
-        if (targetState == WebPage::LifecycleState::Frozen)
+        // The page may have been frozen by the tab lifecycle manager already, in which case it is discarded later on
+        if (targetState == WebPage::LifecycleState::Frozen
+                && isHidden()
+                && getLifecycleState() == WebPage::LifecycleState::Frozen)
         {
             using namespace std::chrono_literals;
             m_lifecycleDiscardTimerId = startTimer(45min);
@@ -457,6 +578,23 @@ void WebWidget::saveState()
     m_savedState = WebState(this, tabWidget);
 }
 
+void WebWidget::restorePage(WebState &state)
+{
+    // The history is restored as a history navigation, which lets the web engine serve the
+    // current entry from its cache instead of loading the URL a second time
+    if (getHistory()->load(state.pageHistory))
+    {
+        ++m_wakeNavigationCount;
+        return;
+    }
+
+    if (state.url.isEmpty())
+        return;
+
+    ++m_wakeNavigationCount;
+    m_view->load(state.url);
+}
+
 void WebWidget::setupWebView()
 {
 #if (QTWEBENGINECORE_VERSION >= QT_VERSION_CHECK(5, 14, 0))
@@ -474,6 +612,7 @@ void WebWidget::setupWebView()
 #endif
 
     m_viewFocusProxy = nullptr;
+    m_wakeNavigationCount = 0;
     m_view = new WebView(m_privateMode, this);
     m_view->setupPage(m_serviceLocator);
     m_view->installEventFilter(this);
@@ -488,6 +627,7 @@ void WebWidget::setupWebView()
     connect(m_page, &WebPage::urlChanged,           this, &WebWidget::urlChanged);
 
     connect(m_page, &WebPage::loadStarted, this, [this](){
+        m_hasUserInput = false;
         m_adBlockManager->loadStarted(m_page->url().adjusted(QUrl::RemoveFragment));
     });
 
@@ -577,6 +717,12 @@ bool WebWidget::eventFilter(QObject *watched, QEvent *event)
             }
             break;
         }
+        case QEvent::KeyPress:
+        {
+            if (watched == m_viewFocusProxy)
+                m_hasUserInput = true;
+            break;
+        }
         case QEvent::MouseButtonRelease:
         {
             if (watched == m_viewFocusProxy || watched == m_view->getViewFocusProxy())
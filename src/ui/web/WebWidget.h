@@ -8,6 +8,7 @@
 #include <QMetaType>
 #include <QPointer>
 #include <QUrl>
+#include <QWebEnginePage>
 #include <QWidget>
 
 #include <QtGlobal>
@@ -51,6 +52,16 @@ class WebWidget : public QWidget
      */
     explicit WebWidget(const ViperServiceLocator &serviceLocator, bool privateMode, QWidget *parent = nullptr);
 
+    /**
+     * @brief Constructs the WebWidget as a placeholder for a restored tab. The placeholder only holds the state of
+     *        the tab, and creates its web view and loads the page when it is first shown or woken up
+     * @param serviceLocator Web browser service registry / locator
+     * @param privateMode Set to true if the web view should be off-the-record, false if a regular web view
+     * @param placeholderState State of the restored tab
+     * @param parent Pointer to the parent widget
+     */
+    WebWidget(const ViperServiceLocator &serviceLocator, bool privateMode, WebState &&placeholderState, QWidget *parent = nullptr);
+
     /// WebWidget destructor
     ~WebWidget();
 
@@ -125,6 +136,42 @@ class WebWidget : public QWidget
     /// Clears the record of the last url that was manually typed by the user.
     void clearLastTypedUrl();
 
+    /// Returns true if the widget is a placeholder for a restored tab that has not been loaded yet
+    bool isPlaceholder() const;
+
+    /// Hibernates the widget and replaces its state with that of a restored tab, so that it acts as a placeholder
+    /// which loads the tab once it is shown or woken up
+    void setPlaceholderState(WebState &&state);
+
+    /// Returns the last time the widget was shown, in milliseconds since the epoch, or 0 if it has not been shown
+    qint64 getLastActiveTime() const;
+
+    /// Sets the last time the widget was shown, in milliseconds since the epoch. Used when a tab is restored
+    void setLastActiveTime(qint64 msecs);
+
+    /// Returns true if the web page has played audio recently, false if else or if the widget is hibernating
+    bool isAudible() const;
+
+    /// Returns true if the user has typed into the current web page since it started loading
+    bool hasUserInput() const;
+
+    /// Returns the number of navigations that the widget has started since its web view was created, which is when
+    /// the widget was constructed or last woke up from hibernation
+    int getWakeNavigationCount() const;
+
+#if (QTWEBENGINECORE_VERSION >= QT_VERSION_CHECK(5, 14, 0))
+    /// Returns the lifecycle state of the web page. A hibernating widget is treated as discarded
+    QWebEnginePage::LifecycleState getLifecycleState() const;
+
+    /**
+     * @brief Moves the web page to a lower lifecycle state (frozen or discarded) while the widget is hidden
+     * @param state Lifecycle state of the web page
+     * @return True if the state was applied. The state is not applied if the widget is visible or hibernating, if
+     *         the page is being inspected, or if the page is already in the given state or a lower one
+     */
+    bool setLifecycleState(QWebEnginePage::LifecycleState state);
+#endif
+
     /// Event filter
     bool eventFilter(QObject *watched, QEvent *event) override;
 
@@ -214,9 +261,16 @@ private Q_SLOTS:
     void onTabPinned(int index, bool value);
 
 private:
+    /// Constructs the WebWidget, either with a web view, or as a placeholder with the given state if it is not null
+    WebWidget(const ViperServiceLocator &serviceLocator, bool privateMode, WebState *placeholderState, QWidget *parent);
+
     /// Forces a repaint of the inner web page
     void forceRepaint();
 
+    /// Rebuilds the web page from the given state. Restoring the navigation history also loads its current entry,
+    /// so the URL is only loaded directly when there is no history to restore
+    void restorePage(WebState &state);
+
     /// Saves the state of the web widget before it is hibernated
     void saveState();
 
@@ -268,6 +322,19 @@ private Q_SLOTS:
     /// True if the widget is in hibernation mode, false if else
     bool m_hibernating;
 
+    /// True if the widget is a placeholder for a restored tab that has not been shown yet, in which
+    /// case it wakes up when it is shown
+    bool m_wakeOnShow;
+
+    /// Last time the widget was shown, in milliseconds since the epoch
+    qint64 m_lastActiveTime;
+
+    /// True if the user has typed into the current web page since it started loading
+    bool m_hasUserInput;
+
+    /// Number of navigations that the widget has started since its web view was created
+    int m_wakeNavigationCount;
+
     /// Current state of the web page (icon, page title, url, etc.) in order to transition in and out of hibernation mode, close and re-open a tab, etc
     WebState m_savedState;
 
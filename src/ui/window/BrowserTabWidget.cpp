@@ -41,6 +41,12 @@ BrowserTabWidget::BrowserTabWidget(const ViperServiceLocator &serviceLocator, bo
     connect(this, &BrowserTabWidget::tabCloseRequested,    this, &BrowserTabWidget::closeTab);
     connect(this, &BrowserTabWidget::currentChanged,       this, &BrowserTabWidget::onCurrentChanged);
 
+    if (m_faviconManager != nullptr)
+    {
+        connect(m_faviconManager, &FaviconManager::storeReady,     this, &BrowserTabWidget::onFaviconStoreReady);
+        connect(m_faviconManager, &FaviconManager::pageIconLoaded, this, &BrowserTabWidget::onPageIconLoaded);
+    }
+
     connect(m_tabBar, &BrowserTabBar::tabPinned,           this, &BrowserTabWidget::tabPinned);
     connect(m_tabBar, &BrowserTabBar::duplicateTabRequest, this, &BrowserTabWidget::duplicateTab);
     connect(m_tabBar, &BrowserTabBar::newTabRequest,       this, [this](){
@@ -123,13 +129,16 @@ void BrowserTabWidget::reopenLastTab()
         return;
 
     WebState tabInfo = m_closedTabs.front();
+    const int index = tabInfo.index;
+    const bool isPinned = tabInfo.isPinned;
+    const QString title = tabInfo.title;
+    const QIcon icon = tabInfo.icon;
 
-    WebWidget *ww = newBackgroundTabAtIndex(tabInfo.index);
-    m_tabBar->setTabPinned(tabInfo.index, tabInfo.isPinned);
-    setTabText(tabInfo.index, tabInfo.title);
-    setTabToolTip(tabInfo.index, tabInfo.title);
-    setTabIcon(tabInfo.index, tabInfo.icon);
-    ww->setWebState(std::move(tabInfo));
+    newBackgroundTabAtIndex(index, std::move(tabInfo));
+    m_tabBar->setTabPinned(index, isPinned);
+    setTabText(index, title);
+    setTabToolTip(index, title);
+    setTabIcon(index, icon);
 
     m_closedTabs.pop_front();
 }
@@ -197,13 +206,15 @@ void BrowserTabWidget::duplicateTab(int index)
         openLinkInNewBackgroundTab(ww->url());
 }
 
-WebWidget *BrowserTabWidget::createWebWidget()
+WebWidget *BrowserTabWidget::createWebWidget(WebState *placeholderState)
 {
-    WebWidget *ww = new WebWidget(m_serviceLocator, m_privateBrowsing, this);
+    WebWidget *ww = (placeholderState != nullptr) ? new WebWidget(m_serviceLocator, m_privateBrowsing, std::move(*placeholderState), this)
+                                                  : new WebWidget(m_serviceLocator, m_privateBrowsing, this);
     if (m_mainWindow)
     {
         ww->setMaximumWidth(m_mainWindow->maximumWidth());
-        ww->view()->setMaximumWidth(m_mainWindow->maximumWidth());
+        if (WebView *view = ww->view())
+            view->setMaximumWidth(m_mainWindow->maximumWidth());
     }
 
     // Connect web view signals to functionalty
@@ -238,6 +249,11 @@ WebWidget *BrowserTabWidget::createWebWidget()
         });
     }
 
+    return ww;
+}
+
+void BrowserTabWidget::loadNewTabPage(WebWidget *ww)
+{
     auto newTabPage = static_cast<NewTabType>(m_settings->getValue(BrowserSetting::NewTabPage).toInt());
     switch (newTabPage)
     {
@@ -251,8 +267,6 @@ WebWidget *BrowserTabWidget::createWebWidget()
             ww->load(QUrl(QLatin1String("viper://newtab")));
             break;
     }
-
-    return ww;
 }
 
 WebWidget *BrowserTabWidget::newTab()
@@ -263,6 +277,7 @@ WebWidget *BrowserTabWidget::newTab()
 WebWidget *BrowserTabWidget::newTabAtIndex(int index)
 {
     WebWidget *ww = createWebWidget();
+    loadNewTabPage(ww);
 
     if (index >= 0)
     {
@@ -294,7 +309,47 @@ WebWidget *BrowserTabWidget::newBackgroundTab()
 WebWidget *BrowserTabWidget::newBackgroundTabAtIndex(int index)
 {
     WebWidget *ww = createWebWidget();
+    loadNewTabPage(ww);
+    insertBackgroundTab(index, ww);
 
+    ww->view()->resize(ww->size());
+    //ww->show();
+
+    emit newTabCreated(ww);
+    return ww;
+}
+
+WebWidget *BrowserTabWidget::newBackgroundTabAtIndex(int index, WebState &&state)
+{
+    WebWidget *ww = createWebWidget();
+    insertBackgroundTab(index, ww);
+
+    ww->view()->resize(ww->size());
+
+    emit newTabCreated(ww);
+
+    // The page is only loaded from its state, so that restoring it starts a single navigation
+    ww->setWebState(std::move(state));
+    return ww;
+}
+
+WebWidget *BrowserTabWidget::newPlaceholderTabAtIndex(int index, WebState &&state)
+{
+    const QString title = state.title;
+
+    WebWidget *ww = createWebWidget(&state);
+    index = insertBackgroundTab(index, ww);
+
+    setTabText(index, title);
+    setTabToolTip(index, title);
+    setTabIcon(index, ww->getIcon());
+
+    emit newTabCreated(ww);
+    return ww;
+}
+
+int BrowserTabWidget::insertBackgroundTab(int index, WebWidget *ww)
+{
     if (index >= 0)
     {
         if (index > count())
@@ -305,14 +360,13 @@ WebWidget *BrowserTabWidget::newBackgroundTabAtIndex(int index)
             ++m_nextTabIndex;
     }
     else
-        m_nextTabIndex = insertTab(m_nextTabIndex, ww, QLatin1String("New Tab")) + 1;
+    {
+        index = insertTab(m_nextTabIndex, ww, QLatin1String("New Tab"));
+        m_nextTabIndex = index + 1;
+    }
 
     ww->resize(currentWidget()->size());
-    ww->view()->resize(ww->size());
-    //ww->show();
-
-    emit newTabCreated(ww);
-    return ww;
+    return index;
 }
 
 void BrowserTabWidget::onIconChanged(const QIcon &icon)
@@ -469,3 +523,23 @@ void BrowserTabWidget::onViewCloseRequested()
     WebWidget *ww = qobject_cast<WebWidget*>(sender());
     closeTab(indexOf(ww));
 }
+
+void BrowserTabWidget::onFaviconStoreReady()
+{
+    for (int i = 0; i < count(); ++i)
+    {
+        if (WebWidget *ww = getWebWidget(i))
+            setTabIcon(i, ww->getIcon());
+    }
+}
+
+void BrowserTabWidget::onPageIconLoaded(const QUrl &pageUrl, const QIcon &/*icon*/)
+{
+    // Pages that have an icon of their own keep it
+    for (int i = 0; i < count(); ++i)
+    {
+        WebWidget *ww = getWebWidget(i);
+        if (ww && FaviconManager::getPageKey(ww->url()) == pageUrl)
+            setTabIcon(i, ww->getIcon());
+    }
+}
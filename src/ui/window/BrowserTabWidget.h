@@ -113,6 +113,24 @@ public Q_SLOTS:
      */
     WebWidget *newBackgroundTabAtIndex(int index);
 
+    /**
+     * @brief Creates a new tab in the background, with a \ref WebWidget at the given index that restores the given
+     *        web page, such as a tab of a restored session or a reopened tab. The new tab page is not loaded
+     * @param index The index at which, if valid, the tab will be inserted.
+     * @param state State of the web page
+     * @return A pointer to the tab's WebWidget
+     */
+    WebWidget *newBackgroundTabAtIndex(int index, WebState &&state);
+
+    /**
+     * @brief Creates a new tab in the background for a restored web page. The tab's \ref WebWidget is a placeholder
+     *        that holds the given state, and only creates its web view when the tab is first activated
+     * @param index The index at which, if valid, the tab will be inserted.
+     * @param state State of the restored web page
+     * @return A pointer to the tab's WebWidget
+     */
+    WebWidget *newPlaceholderTabAtIndex(int index, WebState &&state);
+
     /// Called when the icon for a web view has changed
     void onIconChanged(const QIcon &icon);
 
@@ -162,10 +180,23 @@ private Q_SLOTS:
     /// Emitted when a view requests that it be closed
     void onViewCloseRequested();
 
+    /// Called once the favicon store has been loaded, updating the icons of tabs that were created before then
+    void onFaviconStoreReady();
+
+    /// Called when the favicon of a page has been loaded from the favicon store, updating the icons of the tabs showing the page
+    void onPageIconLoaded(const QUrl &pageUrl, const QIcon &icon);
+
 private:
     /// Creates a new \ref WebWidget, binding its signals to the appropriate handlers, setting up properties of the widget, etc.
-    /// and returning a pointer to the widget. Used during creation of a new tab
-    WebWidget *createWebWidget();
+    /// and returning a pointer to the widget. Used during creation of a new tab. If a placeholder state is given, the widget
+    /// is created as a placeholder for a restored web page
+    WebWidget *createWebWidget(WebState *placeholderState = nullptr);
+
+    /// Loads the page that the user has chosen to show in new tabs into the given web widget
+    void loadNewTabPage(WebWidget *ww);
+
+    /// Inserts the given web widget into a new tab in the background at the given index, returning the index of the tab
+    int insertBackgroundTab(int index, WebWidget *ww);
 
     /// Saves the tab at the given index before closing it
     void saveTab(int index);
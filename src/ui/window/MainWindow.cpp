@@ -565,6 +565,13 @@ void MainWindow::onNewTabCreated(WebWidget *ww)
 {
     // Connect signals to slots for UI updates (page title, icon changes)
     connect(ww, &WebWidget::aboutToWake, [this,ww](){
+        // A web view is created each time the widget wakes up, including placeholders for restored tabs
+        if (WebView *view = ww->view())
+        {
+            connect(view, &WebView::printRequested, this, &MainWindow::printTabContents);
+            connect(view, &WebView::printFinished,  this, &MainWindow::onPrintFinished);
+        }
+
         if (m_tabWidget->currentWebWidget() == ww)
         {
             ui->widgetFindText->clearLabels();
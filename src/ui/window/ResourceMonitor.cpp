@@ -0,0 +1,249 @@
+#include "ResourceMonitor.h"
+#include "BrowserTabWidget.h"
+#include "IResourceReporter.h"
+#include "MainWindow.h"
+#include "ProcessMemory.h"
+#include "TabLifecycleManager.h"
+#include "WebPage.h"
+#include "WebWidget.h"
+
+#include <algorithm>
+#include <array>
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QString>
+
+namespace
+{
+    /// Returns the name of the given lifecycle state of a tab
+    QString getTabStateName(WebWidget *ww)
+    {
+        if (ww->isHibernating())
+            return QStringLiteral("hibernated");
+
+        switch (ww->getLifecycleState())
+        {
+            case QWebEnginePage::LifecycleState::Active:
+                return QStringLiteral("active");
+            case QWebEnginePage::LifecycleState::Frozen:
+                return QStringLiteral("frozen");
+            case QWebEnginePage::LifecycleState::Discarded:
+                return QStringLiteral("discarded");
+        }
+        return QString();
+    }
+
+    /// Formats a size in bytes for display, or returns a dash if the size is not known
+    QString formatSize(qint64 bytes)
+    {
+        if (bytes < 0)
+            return QStringLiteral("&mdash;");
+
+        if (bytes < 1024)
+            return QStringLiteral("%1 B").arg(bytes);
+        if (bytes < 1024 * 1024)
+            return QStringLiteral("%1 KiB").arg(static_cast<double>(bytes) / 1024.0, 0, 'f', 1);
+        return QStringLiteral("%1 MiB").arg(static_cast<double>(bytes) / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+
+    /// Formats a CPU time in milliseconds for display, or returns a dash if the time is not known
+    QString formatCpuTime(qint64 msecs)
+    {
+        if (msecs < 0)
+            return QStringLiteral("&mdash;");
+
+        return QStringLiteral("%1 s").arg(static_cast<double>(msecs) / 1000.0, 0, 'f', 2);
+    }
+}
+
+ResourceMonitor::ResourceMonitor() :
+    m_reporters()
+{
+}
+
+void ResourceMonitor::addReporter(IResourceReporter *reporter)
+{
+    if (reporter && std::find(m_reporters.begin(), m_reporters.end(), reporter) == m_reporters.end())
+        m_reporters.push_back(reporter);
+}
+
+void ResourceMonitor::removeReporter(IResourceReporter *reporter)
+{
+    m_reporters.erase(std::remove(m_reporters.begin(), m_reporters.end(), reporter), m_reporters.end());
+}
+
+QJsonObject ResourceMonitor::getReport(const std::vector<MainWindow*> &windows, const TabLifecycleManager *lifecycleManager) const
+{
+    QJsonObject report;
+    report.insert(QStringLiteral("timestamp"), QDateTime::currentMSecsSinceEpoch());
+
+    const qint64 browserPid = QCoreApplication::applicationPid();
+    QJsonObject browser;
+    browser.insert(QStringLiteral("pid"), browserPid);
+    browser.insert(QStringLiteral("residentSize"), ProcessMemory::getResidentSize(browserPid));
+    browser.insert(QStringLiteral("cpuTime"), ProcessMemory::getCpuTime(browserPid));
+    browser.insert(QStringLiteral("totalResidentSize"), ProcessMemory::getBrowserResidentSize());
+    report.insert(QStringLiteral("browser"), browser);
+
+    QJsonArray subsystems;
+    for (const IResourceReporter *reporter : m_reporters)
+    {
+        for (const ResourceUsage &usage : reporter->getResourceUsage())
+        {
+            QJsonObject subsystem;
+            subsystem.insert(QStringLiteral("name"), usage.Name);
+            subsystem.insert(QStringLiteral("items"), static_cast<qint64>(usage.NumItems));
+            subsystem.insert(QStringLiteral("estimatedSize"), usage.EstimatedSize);
+            subsystems.append(subsystem);
+        }
+    }
+    report.insert(QStringLiteral("subsystems"), subsystems);
+
+    QJsonArray tabs;
+    for (std::size_t windowIdx = 0; windowIdx < windows.size(); ++windowIdx)
+    {
+        MainWindow *win = windows.at(windowIdx);
+        const bool isPrivate = win->isPrivate();
+
+        BrowserTabWidget *tabWidget = win->getTabWidget();
+        const int numTabs = tabWidget->count();
+        for (int i = 0; i < numTabs; ++i)
+        {
+            WebWidget *ww = tabWidget->getWebWidget(i);
+            if (!ww)
+                continue;
+
+            // Hibernated tabs have no page, and so no renderer process
+            qint64 rendererPid = -1;
+            if (WebPage *page = ww->page())
+                rendererPid = page->renderProcessPid();
+
+            QJsonObject tab;
+            tab.insert(QStringLiteral("window"), static_cast<int>(windowIdx));
+            tab.insert(QStringLiteral("index"), i);
+            tab.insert(QStringLiteral("private"), isPrivate);
+
+            // The pages visited in private windows are left out of the report
+            if (!isPrivate)
+            {
+                tab.insert(QStringLiteral("title"), ww->getTitle());
+                tab.insert(QStringLiteral("url"), ww->url().toString());
+            }
+
+            tab.insert(QStringLiteral("state"), getTabStateName(ww));
+            tab.insert(QStringLiteral("lastActive"), ww->getLastActiveTime());
+            tab.insert(QStringLiteral("rendererPid"), rendererPid);
+            tab.insert(QStringLiteral("rendererResidentSize"), rendererPid > 0 ? ProcessMemory::getResidentSize(rendererPid) : qint64{-1});
+            tab.insert(QStringLiteral("rendererCpuTime"), rendererPid > 0 ? ProcessMemory::getCpuTime(rendererPid) : qint64{-1});
+            tabs.append(tab);
+        }
+    }
+    report.insert(QStringLiteral("tabs"), tabs);
+
+    if (lifecycleManager)
+    {
+        const std::array<std::pair<TabLifecycleTransition, QString>, 3> transitions {
+            std::make_pair(TabLifecycleTransition::Freeze,    QStringLiteral("freeze")),
+            std::make_pair(TabLifecycleTransition::Discard,   QStringLiteral("discard")),
+            std::make_pair(TabLifecycleTransition::Hibernate, QStringLiteral("hibernate"))
+        };
+
+        QJsonObject transitionCounts;
+        for (const auto &transition : transitions)
+        {
+            QJsonObject counters;
+            counters.insert(QStringLiteral("count"), static_cast<qint64>(lifecycleManager->getTransitionCount(transition.first)));
+            counters.insert(QStringLiteral("reclaimedMemory"), lifecycleManager->getReclaimedMemory(transition.first));
+            transitionCounts.insert(transition.second, counters);
+        }
+
+        QJsonObject lifecycle;
+        lifecycle.insert(QStringLiteral("liveTabs"), lifecycleManager->getLastLiveTabCount());
+        lifecycle.insert(QStringLiteral("lastMemoryUsage"), lifecycleManager->getLastMemoryUsage());
+        lifecycle.insert(QStringLiteral("transitions"), transitionCounts);
+        report.insert(QStringLiteral("tabLifecycle"), lifecycle);
+    }
+
+    return report;
+}
+
+QByteArray ResourceMonitor::toHtml(const QJsonObject &report)
+{
+    QString html;
+    html.append(QStringLiteral("<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\">"
+                               "<meta http-equiv=\"refresh\" content=\"5\">"
+                               "<title>Resource Usage</title>"
+                               "<style>body { font-family: sans-serif; margin: 2em; } "
+                               "table { border-collapse: collapse; margin-bottom: 2em; } "
+                               "th, td { border: 1px solid #999; padding: 4px 8px; text-align: left; } "
+                               "td.num { text-align: right; }</style></head><body>\n"));
+
+    const QJsonObject browser = report.value(QStringLiteral("browser")).toObject();
+    html.append(QStringLiteral("<h1>Resource Usage</h1>\n<p>Browser process %1: %2 resident, %3 CPU time. "
+                               "Browser and all renderer processes: %4 resident. "
+                               "<a href=\"viper://resources.json\">JSON</a></p>\n")
+                .arg(QString::number(browser.value(QStringLiteral("pid")).toInteger()),
+                     formatSize(browser.value(QStringLiteral("residentSize")).toInteger(-1)),
+                     formatCpuTime(browser.value(QStringLiteral("cpuTime")).toInteger(-1)),
+                     formatSize(browser.value(QStringLiteral("totalResidentSize")).toInteger(-1))));
+
+    html.append(QStringLiteral("<h2>Subsystems</h2>\n<table><tr><th>Name</th><th>Items</th><th>Estimated size</th></tr>\n"));
+    const QJsonArray subsystems = report.value(QStringLiteral("subsystems")).toArray();
+    for (const QJsonValue &value : subsystems)
+    {
+        const QJsonObject subsystem = value.toObject();
+        html.append(QStringLiteral("<tr><td>%1</td><td class=\"num\">%2</td><td class=\"num\">%3</td></tr>\n")
+                    .arg(subsystem.value(QStringLiteral("name")).toString().toHtmlEscaped(),
+                         QString::number(subsystem.value(QStringLiteral("items")).toInteger()),
+                         formatSize(subsystem.value(QStringLiteral("estimatedSize")).toInteger(-1))));
+    }
+    html.append(QStringLiteral("</table>\n"));
+
+    html.append(QStringLiteral("<h2>Tabs</h2>\n<table><tr><th>Window</th><th>Tab</th><th>Title</th><th>State</th>"
+                               "<th>Renderer</th><th>Renderer memory</th><th>Renderer CPU time</th></tr>\n"));
+    const QJsonArray tabs = report.value(QStringLiteral("tabs")).toArray();
+    for (const QJsonValue &value : tabs)
+    {
+        const QJsonObject tab = value.toObject();
+        const qint64 rendererPid = tab.value(QStringLiteral("rendererPid")).toInteger(-1);
+        const QString title = tab.value(QStringLiteral("private")).toBool()
+                ? QStringLiteral("<i>Private tab</i>")
+                : tab.value(QStringLiteral("title")).toString().toHtmlEscaped();
+        html.append(QStringLiteral("<tr><td class=\"num\">%1</td><td class=\"num\">%2</td><td title=\"%3\">%4</td><td>%5</td>"
+                                   "<td class=\"num\">%6</td><td class=\"num\">%7</td><td class=\"num\">%8</td></tr>\n")
+                    .arg(QString::number(tab.value(QStringLiteral("window")).toInt() + 1),
+                         QString::number(tab.value(QStringLiteral("index")).toInt() + 1),
+                         tab.value(QStringLiteral("url")).toString().toHtmlEscaped(),
+                         title,
+                         tab.value(QStringLiteral("state")).toString(),
+                         rendererPid > 0 ? QString::number(rendererPid) : QStringLiteral("&mdash;"),
+                         formatSize(tab.value(QStringLiteral("rendererResidentSize")).toInteger(-1)),
+                         formatCpuTime(tab.value(QStringLiteral("rendererCpuTime")).toInteger(-1))));
+    }
+    html.append(QStringLiteral("</table>\n"));
+
+    if (report.contains(QStringLiteral("tabLifecycle")))
+    {
+        const QJsonObject lifecycle = report.value(QStringLiteral("tabLifecycle")).toObject();
+        html.append(QStringLiteral("<h2>Tab Lifecycle</h2>\n<p>%1 live tabs and %2 resident as of the last check.</p>\n"
+                                   "<table><tr><th>Transition</th><th>Count</th><th>Reclaimed memory</th></tr>\n")
+                    .arg(QString::number(lifecycle.value(QStringLiteral("liveTabs")).toInt()),
+                         formatSize(lifecycle.value(QStringLiteral("lastMemoryUsage")).toInteger(-1))));
+
+        const QJsonObject transitions = lifecycle.value(QStringLiteral("transitions")).toObject();
+        for (auto it = transitions.constBegin(); it != transitions.constEnd(); ++it)
+        {
+            const QJsonObject counters = it.value().toObject();
+            html.append(QStringLiteral("<tr><td>%1</td><td class=\"num\">%2</td><td class=\"num\">%3</td></tr>\n")
+                        .arg(it.key(),
+                             QString::number(counters.value(QStringLiteral("count")).toInteger()),
+                             formatSize(counters.value(QStringLiteral("reclaimedMemory")).toInteger(-1))));
+        }
+        html.append(QStringLiteral("</table>\n"));
+    }
+
+    html.append(QStringLiteral("</body></html>\n"));
+    return html.toUtf8();
+}
@@ -0,0 +1,50 @@
+#ifndef RESOURCEMONITOR_H
+#define RESOURCEMONITOR_H
+
+#include <vector>
+
+#include <QByteArray>
+#include <QJsonObject>
+
+class IResourceReporter;
+class MainWindow;
+class TabLifecycleManager;
+
+/**
+ * @class ResourceMonitor
+ * @brief Collects the memory held by each browser subsystem and the memory and CPU time used by the renderer
+ *        process of each tab into a report, which is served as the viper://resources page and, in JSON form,
+ *        as viper://resources.json.
+ *
+ *        Renderer processes may be shared by several tabs, in which case each of those tabs reports the same
+ *        process. The titles and URLs of tabs in private windows are not included. Memory and CPU time are read from /proc, and are reported as -1 on other platforms.
+ */
+class ResourceMonitor
+{
+public:
+    /// Constructs the resource monitor
+    ResourceMonitor();
+
+    /// Adds a subsystem to the report. The reporter must outlive the resource monitor, or be removed before it is destroyed
+    void addReporter(IResourceReporter *reporter);
+
+    /// Removes a subsystem from the report
+    void removeReporter(IResourceReporter *reporter);
+
+    /**
+     * @brief Collects a report of the resources used by the browser
+     * @param windows Browser windows, whose tabs are included in the report
+     * @param lifecycleManager Tab lifecycle manager, whose counters are included in the report. May be a nullptr
+     * @return JSON object containing the report
+     */
+    QJsonObject getReport(const std::vector<MainWindow*> &windows, const TabLifecycleManager *lifecycleManager) const;
+
+    /// Formats a report returned by \ref getReport as an HTML page
+    static QByteArray toHtml(const QJsonObject &report);
+
+private:
+    /// Subsystems that report the memory they hold
+    std::vector<IResourceReporter*> m_reporters;
+};
+
+#endif // RESOURCEMONITOR_H
@@ -59,6 +59,15 @@ void SearchEngineLineEdit::setFaviconManager(FaviconManager *faviconManager)
 {
     m_faviconManager = faviconManager;
     loadSearchEngines();
+
+    // The menu is loaded with blank icons when the favicon store has not been loaded yet, or the icons are not cached
+    if (m_faviconManager)
+    {
+        if (!m_faviconManager->isReady())
+            connect(m_faviconManager, &FaviconManager::storeReady, this, &SearchEngineLineEdit::loadSearchEngineIcons);
+
+        connect(m_faviconManager, &FaviconManager::pageIconLoaded, this, &SearchEngineLineEdit::onPageIconLoaded);
+    }
 }
 
 void SearchEngineLineEdit::loadSearchEngines()
@@ -85,6 +94,31 @@ void SearchEngineLineEdit::loadSearchEngines()
     setSearchEngine(manager.getDefaultSearchEngine());
 }
 
+void SearchEngineLineEdit::loadSearchEngineIcons()
+{
+    if (!m_faviconManager || !m_searchEngineMenu)
+        return;
+
+    SearchEngineManager &manager = SearchEngineManager::instance();
+    const QList<QAction*> menuActions = m_searchEngineMenu->actions();
+    for (QAction *action : menuActions)
+        action->setIcon(m_faviconManager->getFavicon(QUrl(manager.getQueryString(action->text()))));
+}
+
+void SearchEngineLineEdit::onPageIconLoaded(const QUrl &pageUrl, const QIcon &icon)
+{
+    if (!m_searchEngineMenu)
+        return;
+
+    SearchEngineManager &manager = SearchEngineManager::instance();
+    const QList<QAction*> menuActions = m_searchEngineMenu->actions();
+    for (QAction *action : menuActions)
+    {
+        if (FaviconManager::getPageKey(QUrl(manager.getQueryString(action->text()))) == pageUrl)
+            action->setIcon(icon);
+    }
+}
+
 void SearchEngineLineEdit::setSearchEngine(const QString &name)
 {
     SearchEngine engine = SearchEngineManager::instance().getSearchEngineInfo(name);
@@ -50,6 +50,12 @@ private Q_SLOTS:
      */
     void removeSearchEngine(const QString &name);
 
+    /// Sets the icon of each search engine in the menu from the favicon manager
+    void loadSearchEngineIcons();
+
+    /// Called when the favicon of a page has been loaded, updating the icons of the search engines whose query URL leads to the page
+    void onPageIconLoaded(const QUrl &pageUrl, const QIcon &icon);
+
 protected:
     /// Paints the line edit with the search icon shown on its leftmost end
     virtual void resizeEvent(QResizeEvent *event) override;
@@ -0,0 +1,201 @@
+#include "TabLifecycleManager.h"
+#include "BrowserSetting.h"
+#include "BrowserTabWidget.h"
+#include "MainWindow.h"
+#include "ProcessMemory.h"
+#include "Settings.h"
+#include "WebWidget.h"
+
+#include <algorithm>
+
+#include <QTimer>
+
+namespace
+{
+    /// Delay between applying transitions and measuring the memory they reclaimed, in milliseconds
+    constexpr int ReclaimMeasureDelay = 5000;
+
+    /// Interval between checks of the memory and tab budgets, in milliseconds
+    constexpr int CheckInterval = 30000;
+}
+
+TabLifecycleManager::TabLifecycleManager(Settings *settings, QObject *parent) :
+    QObject(parent),
+    m_settings(settings),
+    m_checkTimer(),
+    m_transitionCounts { 0, 0, 0 },
+    m_reclaimedMemory { 0, 0, 0 },
+    m_lastMemoryUsage(-1),
+    m_lastLiveTabCount(0),
+    m_measurePending(false)
+{
+    setObjectName(QLatin1String("TabLifecycleManager"));
+
+    m_checkTimer.setInterval(CheckInterval);
+    connect(&m_checkTimer, &QTimer::timeout, this, &TabLifecycleManager::checkRequested);
+    connect(settings, &Settings::settingChanged, this, &TabLifecycleManager::onSettingChanged);
+
+    updateCheckTimer();
+}
+
+bool TabLifecycleManager::isEnabled() const
+{
+    return m_settings->getValue(BrowserSetting::TabMemoryBudget).toLongLong() > 0
+            || m_settings->getValue(BrowserSetting::MaxLiveTabs).toInt() > 0;
+}
+
+void TabLifecycleManager::evaluate(const std::vector<MainWindow*> &windows)
+{
+    std::vector<TabLifecycleCandidate> candidates;
+    int numLiveTabs = 0;
+
+    for (MainWindow *win : windows)
+    {
+        BrowserTabWidget *tabWidget = win->getTabWidget();
+        const int currentIndex = tabWidget->currentIndex();
+
+        const int numTabs = tabWidget->count();
+        for (int i = 0; i < numTabs; ++i)
+        {
+            WebWidget *ww = tabWidget->getWebWidget(i);
+            if (!ww || ww->isHibernating())
+                continue;
+
+            ++numLiveTabs;
+
+            // Tabs that are visible, playing audio or holding the user's input are never unloaded
+            if (i == currentIndex || ww->isVisible() || ww->isAudible() || ww->hasUserInput())
+                continue;
+
+            candidates.push_back(TabLifecycleCandidate { ww, tabWidget->isTabPinned(i), ww->getLastActiveTime() });
+        }
+    }
+
+    const qint64 memoryBudget = m_settings->getValue(BrowserSetting::TabMemoryBudget).toLongLong() * 1024 * 1024;
+    const int maxLiveTabs = m_settings->getValue(BrowserSetting::MaxLiveTabs).toInt();
+
+    // Measuring the memory of every renderer process is only worth its cost when there is a memory budget
+    m_lastLiveTabCount = numLiveTabs;
+    m_lastMemoryUsage = memoryBudget > 0 ? ProcessMemory::getBrowserResidentSize() : qint64{-1};
+
+    int remainingTransitions = getTransitionLimit(m_lastMemoryUsage, memoryBudget, numLiveTabs, maxLiveTabs);
+    if (remainingTransitions <= 0)
+        return;
+
+    rankCandidates(candidates);
+
+    std::array<int, 3> numTransitions { 0, 0, 0 };
+
+    for (const TabLifecycleCandidate &candidate : candidates)
+    {
+        if (remainingTransitions <= 0)
+            break;
+
+        WebWidget *ww = candidate.Widget;
+
+        TabLifecycleTransition transition;
+        bool applied = false;
+        switch (ww->getLifecycleState())
+        {
+            case QWebEnginePage::LifecycleState::Active:
+                transition = TabLifecycleTransition::Freeze;
+                applied = ww->setLifecycleState(QWebEnginePage::LifecycleState::Frozen);
+                break;
+            case QWebEnginePage::LifecycleState::Frozen:
+                transition = TabLifecycleTransition::Discard;
+                applied = ww->setLifecycleState(QWebEnginePage::LifecycleState::Discarded);
+                break;
+            case QWebEnginePage::LifecycleState::Discarded:
+            default:
+                transition = TabLifecycleTransition::Hibernate;
+                ww->setHibernation(true);
+                applied = ww->isHibernating();
+                break;
+        }
+
+        if (!applied)
+            continue;
+
+        const std::size_t transitionIndex = static_cast<std::size_t>(transition);
+        ++m_transitionCounts[transitionIndex];
+        ++numTransitions[transitionIndex];
+        --remainingTransitions;
+    }
+
+    if (m_lastMemoryUsage > 0 && !m_measurePending && (numTransitions[0] + numTransitions[1] + numTransitions[2]) > 0)
+    {
+        m_measurePending = true;
+
+        const qint64 memoryBefore = m_lastMemoryUsage;
+        QTimer::singleShot(ReclaimMeasureDelay, this, [this, memoryBefore, numTransitions](){
+            measureReclaimedMemory(memoryBefore, numTransitions);
+        });
+    }
+}
+
+quint64 TabLifecycleManager::getTransitionCount(TabLifecycleTransition transition) const
+{
+    return m_transitionCounts.at(static_cast<std::size_t>(transition));
+}
+
+qint64 TabLifecycleManager::getReclaimedMemory(TabLifecycleTransition transition) const
+{
+    return m_reclaimedMemory.at(static_cast<std::size_t>(transition));
+}
+
+qint64 TabLifecycleManager::getLastMemoryUsage() const
+{
+    return m_lastMemoryUsage;
+}
+
+int TabLifecycleManager::getLastLiveTabCount() const
+{
+    return m_lastLiveTabCount;
+}
+
+void TabLifecycleManager::rankCandidates(std::vector<TabLifecycleCandidate> &candidates)
+{
+    std::stable_sort(candidates.begin(), candidates.end(), [](const TabLifecycleCandidate &a, const TabLifecycleCandidate &b) {
+        if (a.IsPinned != b.IsPinned)
+            return b.IsPinned;
+        return a.LastActive < b.LastActive;
+    });
+}
+
+int TabLifecycleManager::getTransitionLimit(qint64 memoryUsage, qint64 memoryBudget, int numLiveTabs, int maxLiveTabs)
+{
+    const bool isOverMemoryBudget = memoryBudget > 0 && memoryUsage > memoryBudget;
+    const int numExcessTabs = maxLiveTabs > 0 ? numLiveTabs - maxLiveTabs : 0;
+    return std::max(isOverMemoryBudget ? MaxTransitionsPerCheck : 0, numExcessTabs);
+}
+
+void TabLifecycleManager::onSettingChanged(BrowserSetting setting, const QVariant &value)
+{
+    Q_UNUSED(value);
+
+    if (setting == BrowserSetting::TabMemoryBudget || setting == BrowserSetting::MaxLiveTabs)
+        updateCheckTimer();
+}
+
+void TabLifecycleManager::updateCheckTimer()
+{
+    if (!isEnabled())
+        m_checkTimer.stop();
+    else if (!m_checkTimer.isActive())
+        m_checkTimer.start();
+}
+
+void TabLifecycleManager::measureReclaimedMemory(qint64 memoryBefore, const std::array<int, 3> &numTransitions)
+{
+    m_measurePending = false;
+
+    const qint64 memoryAfter = ProcessMemory::getBrowserResidentSize();
+    if (memoryAfter < 0 || memoryAfter >= memoryBefore)
+        return;
+
+    // Transitions of a single check take effect together, so the memory they reclaimed is split evenly between them
+    const int totalTransitions = numTransitions[0] + numTransitions[1] + numTransitions[2];
+    const qint64 reclaimedPerTransition = (memoryBefore - memoryAfter) / totalTransitions;
+    for (std::size_t i = 0; i < numTransitions.size(); ++i)
+        m_reclaimedMemory[i] += reclaimedPerTransition * numTransitions[i];
+}
@@ -0,0 +1,132 @@
+#ifndef TABLIFECYCLEMANAGER_H
+#define TABLIFECYCLEMANAGER_H
+
+#include "ISettingsObserver.h"
+
+#include <array>
+#include <vector>
+
+#include <QObject>
+#include <QTimer>
+#include <QtGlobal>
+
+class MainWindow;
+class Settings;
+class WebWidget;
+
+/// Transitions that the \ref TabLifecycleManager applies to background tabs, in order of escalation
+enum class TabLifecycleTransition
+{
+    Freeze    = 0,
+    Discard   = 1,
+    Hibernate = 2
+};
+
+/// A background tab that may be moved to its next lifecycle state
+struct TabLifecycleCandidate
+{
+    /// The tab's web widget
+    WebWidget *Widget;
+
+    /// True if the tab is pinned
+    bool IsPinned;
+
+    /// Last time the tab was shown, in milliseconds since the epoch
+    qint64 LastActive;
+};
+
+/**
+ * @class TabLifecycleManager
+ * @brief Keeps the memory used by web pages within a budget, by escalating background tabs across all windows
+ *        from frozen, to discarded, to hibernated.
+ *
+ *        Each check measures the resident memory of the browser and its renderer processes, along with the number
+ *        of tabs that have a web view. While either is over its budget, the least valuable background tabs are
+ *        moved one step further. Tabs are ranked by the last time they were shown, with pinned tabs kept until
+ *        last. Tabs that are playing audio or that the user has typed into are left alone.
+ *
+ *        Checks are only scheduled while at least one of the budgets is set.
+ */
+class TabLifecycleManager : public QObject, public ISettingsObserver
+{
+    Q_OBJECT
+
+public:
+    /// Maximum number of tabs that are moved to their next lifecycle state by a single memory check
+    static constexpr int MaxTransitionsPerCheck = 4;
+
+    /// Constructs the tab lifecycle manager, given the browser settings which contain the memory and tab budgets
+    explicit TabLifecycleManager(Settings *settings, QObject *parent = nullptr);
+
+    /// Returns true if a memory or tab budget is set, in which case checks are requested periodically
+    bool isEnabled() const;
+
+    /// Checks the memory usage and number of live tabs of the given windows, and escalates background tabs
+    /// while either is over its budget
+    void evaluate(const std::vector<MainWindow*> &windows);
+
+    /// Returns the number of times the given transition has been applied to a tab
+    quint64 getTransitionCount(TabLifecycleTransition transition) const;
+
+    /// Returns the approximate amount of memory, in bytes, that was reclaimed by the given transition
+    qint64 getReclaimedMemory(TabLifecycleTransition transition) const;
+
+    /// Returns the resident memory of the browser as of the last check, in bytes, or -1 if it is not known
+    qint64 getLastMemoryUsage() const;
+
+    /// Returns the number of tabs with a web view as of the last check
+    int getLastLiveTabCount() const;
+
+    /// Orders the candidates in the order in which they are unloaded: unpinned tabs before pinned tabs,
+    /// and the least recently used tabs first
+    static void rankCandidates(std::vector<TabLifecycleCandidate> &candidates);
+
+    /**
+     * @brief Returns the number of tabs to move to their next lifecycle state, or 0 if the browser is within its budgets
+     * @param memoryUsage Resident memory of the browser in bytes, or -1 if it is not known
+     * @param memoryBudget Memory budget in bytes, or 0 for no limit
+     * @param numLiveTabs Number of tabs with a web view
+     * @param maxLiveTabs Maximum number of tabs with a web view, or 0 for no limit
+     */
+    static int getTransitionLimit(qint64 memoryUsage, qint64 memoryBudget, int numLiveTabs, int maxLiveTabs);
+
+Q_SIGNALS:
+    /// Emitted periodically while a budget is set, when the open windows should be passed to \ref evaluate
+    void checkRequested();
+
+private Q_SLOTS:
+    /// Starts or stops the periodic checks when the memory or tab budget is changed
+    void onSettingChanged(BrowserSetting setting, const QVariant &value) override;
+
+private:
+    /// Starts the periodic checks if a budget is set, or stops them if not
+    void updateCheckTimer();
+
+    /// Measures the memory usage after the transitions of the last check have taken effect, and attributes the
+    /// difference to those transitions
+    void measureReclaimedMemory(qint64 memoryBefore, const std::array<int, 3> &numTransitions);
+
+private:
+    /// Browser settings
+    Settings *m_settings;
+
+    /// Requests a check on a regular interval while a budget is set
+    QTimer m_checkTimer;
+
+    /// Number of times each transition was applied
+    std::array<quint64, 3> m_transitionCounts;
+
+    /// Memory reclaimed by each transition, in bytes
+    std::array<qint64, 3> m_reclaimedMemory;
+
+    /// Resident memory of the browser as of the last check
+    qint64 m_lastMemoryUsage;
+
+    /// Number of tabs with a web view as of the last check
+    int m_lastLiveTabCount;
+
+    /// True while the memory reclaimed by the last check's transitions is being measured
+    bool m_measurePending;
+};
+
+#endif // TABLIFECYCLEMANAGER_H
@@ -269,7 +269,8 @@ bool URLLineEdit::isInputForBookmarkShortcut(const QString &input)
     if (delimIdx > 0)
         urlTextStart = urlTextStart.left(delimIdx);
 
-    for (auto it : *m_bookmarkManager)
+    const BookmarkManager::Snapshot bookmarks = m_bookmarkManager->getSnapshot();
+    for (auto it : *bookmarks)
     {
         if (it->getType() == BookmarkNode::Bookmark
                 && (urlTextStart.compare(it->getShortcut()) == 0 || urlText.compare(it->getShortcut()) == 0))
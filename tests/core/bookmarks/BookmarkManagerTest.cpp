@@ -1,15 +1,17 @@
+#include "BookmarkImporter.h"
 #include "BookmarkManager.h"
 #include "BookmarkNode.h"
+#include "BookmarkSnapshot.h"
 #include "BookmarkStore.h"
 #include "DatabaseTaskScheduler.h"
 #include "ServiceLocator.h"
 
-#include <chrono>
 #include <memory>
-#include <thread>
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
+#include <QTemporaryFile>
 #include <QTest>
 
 /// Tests the functionality of the BookmarkManager class
@@ -35,6 +37,12 @@ private slots:
 
     void testBookmarkCheckWithTrailingSlash();
 
+    void testSnapshotIsUnaffectedByChanges();
+
+    void testSnapshotIsInTreeOrder();
+
+    void testImportingBookmarks();
+
 private:
     /// Root node/folder used in bookmark management tests
     std::shared_ptr<BookmarkNode> m_root;
@@ -68,8 +76,6 @@ void BookmarkManagerTest::cleanupTestCase()
 {
     if (m_manager)
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        m_manager->waitToFinishList();
         delete m_manager;
         m_manager = nullptr;
     }
@@ -236,6 +242,114 @@ void BookmarkManagerTest::testBookmarkCheckWithTrailingSlash()
     QVERIFY2(m_manager->isBookmarked(compareToUrl), "Bookmark manager should ignore trailing slashes when checking if a URL is bookmarked");
 }
 
+void BookmarkManagerTest::testSnapshotIsUnaffectedByChanges()
+{
+    QUrl bookmarkUrl { QLatin1String("https://snapshot.example.com/") };
+
+    const BookmarkManager::Snapshot before = m_manager->getSnapshot();
+    QVERIFY2(before != nullptr, "Bookmark snapshot should not be null");
+    const std::size_t numNodesBefore = before->size();
+
+    m_manager->appendBookmark(QLatin1String("Snapshot"), bookmarkUrl, m_root.get());
+    BookmarkNode *node = m_manager->getBookmark(bookmarkUrl);
+    QVERIFY2(node != nullptr, "Bookmark manager should have inserted the bookmark into the collection");
+
+    QCOMPARE(before->size(), numNodesBefore);
+
+    const BookmarkManager::Snapshot after = m_manager->getSnapshot();
+    QCOMPARE(after->size(), numNodesBefore + 1);
+
+    const BookmarkSnapshotNode *copy = nullptr;
+    for (const BookmarkSnapshotNode *it : *after)
+    {
+        if (it->getURL() == bookmarkUrl)
+            copy = it;
+    }
+    QVERIFY2(copy != nullptr, "Snapshot should contain a copy of the new bookmark");
+
+    // The copy in the snapshot outlives the node that was removed from the tree
+    m_manager->removeBookmark(node);
+    QCOMPARE(after->size(), numNodesBefore + 1);
+    QCOMPARE(copy->getURL(), bookmarkUrl);
+    QCOMPARE(copy->getName(), QLatin1String("Snapshot"));
+    QCOMPARE(m_manager->getSnapshot()->size(), numNodesBefore);
+}
+
+void BookmarkManagerTest::testSnapshotIsInTreeOrder()
+{
+    BookmarkNode *folder = m_manager->addFolder(QLatin1String("Ordered"), m_root.get());
+    m_manager->appendBookmark(QLatin1String("Second"), QUrl(QLatin1String("https://second.example.com/")), folder);
+    m_manager->insertBookmark(QLatin1String("First"), QUrl(QLatin1String("https://first.example.com/")), folder, 0);
+    BookmarkNode *subFolder = m_manager->addFolder(QLatin1String("Nested"), folder);
+    m_manager->appendBookmark(QLatin1String("Third"), QUrl(QLatin1String("https://third.example.com/")), subFolder);
+    m_manager->appendBookmark(QLatin1String("After"), QUrl(QLatin1String("https://after.example.com/")), m_root.get());
+
+    const BookmarkManager::Snapshot snapshot = m_manager->getSnapshot();
+
+    QStringList names;
+    const BookmarkSnapshotNode *folderCopy = nullptr;
+    for (const BookmarkSnapshotNode *it : *snapshot)
+    {
+        if (it->getName() == QLatin1String("Ordered"))
+            folderCopy = it;
+        if (folderCopy != nullptr)
+            names << it->getName();
+    }
+    QCOMPARE(names, QStringList({ QLatin1String("Ordered"), QLatin1String("First"), QLatin1String("Second"),
+                                  QLatin1String("Nested"), QLatin1String("Third"), QLatin1String("After") }));
+
+    // Changing a bookmark outside of the folder does not copy the folder again
+    m_manager->setBookmarkName(m_manager->getBookmark(QUrl(QLatin1String("https://after.example.com/"))), QLatin1String("Renamed"));
+
+    const BookmarkManager::Snapshot renamed = m_manager->getSnapshot();
+    QVERIFY(renamed != snapshot);
+
+    const BookmarkSnapshotNode *renamedFolderCopy = nullptr;
+    for (const BookmarkSnapshotNode *it : *renamed)
+    {
+        if (it->getName() == QLatin1String("Ordered"))
+            renamedFolderCopy = it;
+    }
+    QCOMPARE(renamedFolderCopy, folderCopy);
+}
+
+void BookmarkManagerTest::testImportingBookmarks()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write("<!DOCTYPE NETSCAPE-Bookmark-file-1>\n"
+               "<TITLE>Bookmarks</TITLE>\n"
+               "<DL><p>\n"
+               "    <DT><H3 ADD_DATE=\"1\">News &amp; Weather</H3>\n"
+               "    <DL><p>\n"
+               "        <DT><A HREF=\"https://news.example.com/\" ADD_DATE=\"2\">News</A>\n"
+               "        <DT><A HREF=\"https://weather.example.com/\">Weather</A>\n"
+               "    </DL><p>\n"
+               "    <DT><A HREF=\"https://imported.example.com/\">Imported</A>\n"
+               "</DL><p>\n");
+    file.close();
+
+    BookmarkNode *importFolder = m_manager->addFolder(QLatin1String("Imported Bookmarks"), m_root.get());
+    QVERIFY(importFolder != nullptr);
+
+    BookmarkImporter importer(m_manager);
+    QVERIFY(importer.import(file.fileName(), importFolder));
+
+    QCOMPARE(importFolder->getNumChildren(), 2);
+
+    BookmarkNode *newsFolder = importFolder->getNode(0);
+    QCOMPARE(newsFolder->getType(), BookmarkNode::Folder);
+    QCOMPARE(newsFolder->getName(), QLatin1String("News & Weather"));
+    QCOMPARE(newsFolder->getNumChildren(), 2);
+    QCOMPARE(newsFolder->getNode(1)->getPosition(), 1);
+    QCOMPARE(newsFolder->getNode(1)->getName(), QLatin1String("Weather"));
+
+    BookmarkNode *bookmark = m_manager->getBookmark(QUrl(QLatin1String("https://imported.example.com/")));
+    QVERIFY2(bookmark != nullptr, "Imported bookmark should be in the bookmark collection");
+    QVERIFY2(bookmark->getParent() == importFolder, "Imported bookmark's parent should be the import folder");
+    QVERIFY(m_manager->isBookmarked(QUrl(QLatin1String("https://news.example.com/"))));
+}
+
 QTEST_APPLESS_MAIN(BookmarkManagerTest)
 
 #include "BookmarkManagerTest.moc"
@@ -0,0 +1,131 @@
+#include "CookieJar.h"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QNetworkCookie>
+#include <QObject>
+#include <QString>
+#include <QTest>
+#include <QUrl>
+#include <QWebEngineProfile>
+
+/// Test cases for the domain index and third party exemptions of the \ref CookieJar class
+class CookieJarTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    CookieJarTest() :
+        QObject(nullptr)
+    {
+    }
+
+private:
+    /// Returns a cookie with the given name, set for the given domain
+    QNetworkCookie makeCookie(const QByteArray &name, const QString &domain)
+    {
+        QNetworkCookie cookie(name, QByteArray("value"));
+        cookie.setDomain(domain);
+        cookie.setPath(QLatin1String("/"));
+        return cookie;
+    }
+
+private slots:
+    /// Tests that a cookie applies to the host it was set for and to its subdomains, but not to sibling subdomains
+    void testHasCookiesForParentDomains()
+    {
+        QWebEngineProfile profile;
+        CookieJar jar(nullptr, &profile);
+        jar.setCookiesEnabled(true);
+
+        jar.onCookieAdded(makeCookie(QByteArray("session"), QLatin1String("a.example.com")));
+
+        QVERIFY(jar.hasCookiesFor(QLatin1String("a.example.com")));
+        QVERIFY(jar.hasCookiesFor(QLatin1String("A.Example.com")));
+        QVERIFY(jar.hasCookiesFor(QLatin1String("www.a.example.com")));
+        QVERIFY(!jar.hasCookiesFor(QLatin1String("b.example.com")));
+        QVERIFY(!jar.hasCookiesFor(QLatin1String("example.com")));
+        QVERIFY(!jar.hasCookiesFor(QLatin1String("ba.example.com")));
+        QVERIFY(!jar.hasCookiesFor(QString()));
+
+        // A cookie set for the parent domain, with a leading dot, applies to every subdomain
+        jar.onCookieAdded(makeCookie(QByteArray("prefs"), QLatin1String(".example.com")));
+        QVERIFY(jar.hasCookiesFor(QLatin1String("b.example.com")));
+        QVERIFY(jar.hasCookiesFor(QLatin1String("example.com")));
+        QVERIFY(!jar.hasCookiesFor(QLatin1String("example.org")));
+    }
+
+    /// Tests that a domain stays in the index until the last of its cookies is removed
+    void testRemovingCookiesUpdatesIndex()
+    {
+        QWebEngineProfile profile;
+        CookieJar jar(nullptr, &profile);
+        jar.setCookiesEnabled(true);
+
+        const QNetworkCookie first = makeCookie(QByteArray("first"), QLatin1String("example.com"));
+        const QNetworkCookie second = makeCookie(QByteArray("second"), QLatin1String("example.com"));
+        jar.onCookieAdded(first);
+        jar.onCookieAdded(second);
+        QVERIFY(jar.hasCookiesFor(QLatin1String("example.com")));
+
+        jar.onCookieRemoved(first);
+        QVERIFY(jar.hasCookiesFor(QLatin1String("example.com")));
+
+        jar.onCookieRemoved(second);
+        QVERIFY(!jar.hasCookiesFor(QLatin1String("example.com")));
+        QVERIFY(jar.m_cookieDomains.empty());
+    }
+
+    /// Tests that expired cookies are removed from the index, while session cookies and unexpired cookies are kept
+    void testRemoveExpiredUpdatesIndex()
+    {
+        QWebEngineProfile profile;
+        CookieJar jar(nullptr, &profile);
+        jar.setCookiesEnabled(true);
+
+        QNetworkCookie expired = makeCookie(QByteArray("expired"), QLatin1String("old.example.com"));
+        expired.setExpirationDate(QDateTime::currentDateTime().addDays(-1));
+
+        QNetworkCookie unexpired = makeCookie(QByteArray("unexpired"), QLatin1String("new.example.com"));
+        unexpired.setExpirationDate(QDateTime::currentDateTime().addDays(1));
+
+        jar.onCookieAdded(expired);
+        jar.onCookieAdded(unexpired);
+        jar.onCookieAdded(makeCookie(QByteArray("session"), QLatin1String("session.example.com")));
+        QVERIFY(jar.hasCookiesFor(QLatin1String("old.example.com")));
+
+        jar.removeExpired();
+
+        QVERIFY(!jar.hasCookiesFor(QLatin1String("old.example.com")));
+        QVERIFY(jar.hasCookiesFor(QLatin1String("new.example.com")));
+        QVERIFY(jar.hasCookiesFor(QLatin1String("session.example.com")));
+        QCOMPARE(jar.m_cookieDomains.size(), static_cast<std::size_t>(2));
+    }
+
+    /// Tests that an exemption from the third party filter covers the host and its subdomains, but not unrelated hosts
+    void testExemptionsCoverSubdomains()
+    {
+        QWebEngineProfile profile;
+        CookieJar jar(nullptr, &profile);
+
+        QVERIFY(!jar.isExemptThirdParty(QLatin1String("example.com")));
+
+        jar.addThirdPartyExemption(QUrl(QLatin1String("https://example.com")));
+
+        QVERIFY(jar.isExemptThirdParty(QLatin1String("example.com")));
+        QVERIFY(jar.isExemptThirdParty(QLatin1String("Cdn.Example.com")));
+        QVERIFY(jar.isExemptThirdParty(QLatin1String("static.cdn.example.com")));
+        QVERIFY(!jar.isExemptThirdParty(QLatin1String("notexample.com")));
+        QVERIFY(!jar.isExemptThirdParty(QLatin1String("example.com.evil.org")));
+        QVERIFY(!jar.isExemptThirdParty(QLatin1String("example.org")));
+        QVERIFY(!jar.isExemptThirdParty(QString()));
+
+        jar.removeThirdPartyExemption(QUrl(QLatin1String("https://example.com")));
+        QVERIFY(!jar.isExemptThirdParty(QLatin1String("cdn.example.com")));
+        QVERIFY(jar.getExemptThirdPartyHosts().isEmpty());
+    }
+};
+
+QTEST_MAIN(CookieJarTest)
+
+#include "CookieJarTest.moc"
@@ -1,7 +1,9 @@
 #include "DatabaseFactory.h"
+#include "DatabaseTaskScheduler.h"
 #include "FakeDatabaseWorker.h"
 
 #include <algorithm>
+#include <future>
 #include <QFile>
 #include <QString>
 #include <QTest>
@@ -21,6 +23,12 @@ private slots:
 
     void testSaveAndRetrieveRecordsFromDatabase();
 
+    void testPreparedStatementReuseAndStats();
+
+    void testReadOnlyWorkerInReaderPool();
+
+    void testTaskPriorities();
+
 private:
     QString m_dbFile;
 };
@@ -76,6 +84,109 @@ void DatabaseWorkerTest::testSaveAndRetrieveRecordsFromDatabase()
     }
 }
 
+void DatabaseWorkerTest::testPreparedStatementReuseAndStats()
+{
+    auto testDatabase = DatabaseFactory::createWorker<FakeDatabaseWorker>(m_dbFile);
+
+    std::vector<std::string> records { "Tom", "Dick", "Harry" };
+    testDatabase->setEntries(records);
+    testDatabase->save();
+
+    auto &dbHandle = testDatabase->getHandle();
+    dbHandle.resetStatementStats();
+
+    const std::string sql { "SELECT COUNT(id) FROM Information WHERE name = ?" };
+    for (const std::string &name : records)
+    {
+        // Each statement is returned to the cache at the end of the iteration, and must come back in a reset state
+        auto query = dbHandle.prepare(sql);
+        query << name;
+        QVERIFY2(query.next(), "Cached statement should execute successfully after being reused");
+
+        int count = -1;
+        query >> count;
+        QCOMPARE(count, 1);
+    }
+
+    const std::vector<sqlite::StatementStats> stats = dbHandle.getStatementStats();
+    auto it = std::find_if(stats.begin(), stats.end(), [&sql](const sqlite::StatementStats &stat) {
+        return stat.sql == sql;
+    });
+    QVERIFY2(it != stats.end(), "Statement statistics should include the executed query");
+    QCOMPARE(it->numExecutions, static_cast<uint64_t>(records.size()));
+    QVERIFY(it->totalTime.count() > 0);
+}
+
+void DatabaseWorkerTest::testReadOnlyWorkerInReaderPool()
+{
+    {
+        auto testDatabase = DatabaseFactory::createWorker<FakeDatabaseWorker>(m_dbFile);
+        testDatabase->setEntries({ "Tom", "Dick", "Harry" });
+    }
+
+    DatabaseTaskScheduler taskScheduler;
+    taskScheduler.addWorker("FakeDatabaseWorker",
+                            std::bind(DatabaseFactory::createDBWorker<FakeDatabaseWorker>, m_dbFile),
+                            std::bind(DatabaseFactory::createReadOnlyWorker<FakeDatabaseWorker>, m_dbFile));
+
+    std::promise<DatabaseWorker*> primaryWorker;
+    taskScheduler.onInit("FakeDatabaseWorker", [&taskScheduler, &primaryWorker](){
+        primaryWorker.set_value(taskScheduler.getWorker("FakeDatabaseWorker"));
+    });
+    taskScheduler.run();
+
+    DatabaseWorker *primary = primaryWorker.get_future().get();
+    QVERIFY(primary != nullptr);
+
+    std::promise<std::pair<int, bool>> readResult;
+    taskScheduler.postRead("FakeDatabaseWorker", [primary, &readResult](DatabaseWorker *worker){
+        FakeDatabaseWorker *reader = static_cast<FakeDatabaseWorker*>(worker);
+
+        int count = -1;
+        auto query = reader->getHandle().prepare(R"(SELECT COUNT(id) FROM Information)");
+        if (query.next())
+            query >> count;
+
+        const bool canWrite = reader->exec(QLatin1String("DELETE FROM Information"));
+        readResult.set_value({ worker != primary ? count : -1, canWrite });
+    });
+
+    const std::pair<int, bool> result = readResult.get_future().get();
+    QCOMPARE(result.first, 3);
+    QVERIFY2(!result.second, "Read-only worker should not be able to modify the database");
+
+    taskScheduler.stop();
+}
+
+void DatabaseWorkerTest::testTaskPriorities()
+{
+    DatabaseTaskScheduler taskScheduler;
+    taskScheduler.addWorker("FakeDatabaseWorker", std::bind(DatabaseFactory::createDBWorker<FakeDatabaseWorker>, m_dbFile));
+
+    taskScheduler.run();
+
+    // Hold the strand in its first task until every other task has been posted
+    std::promise<void> startedFirst, postedAll;
+    std::shared_future<void> waitForPosts = postedAll.get_future().share();
+    taskScheduler.post("FakeDatabaseWorker", [&startedFirst, waitForPosts](){
+        startedFirst.set_value();
+        waitForPosts.wait();
+    });
+    startedFirst.get_future().wait();
+
+    std::vector<int> order;
+    taskScheduler.post(DatabaseTaskPriority::Background, "FakeDatabaseWorker", [&order](){ order.push_back(3); });
+    taskScheduler.post(DatabaseTaskPriority::Normal, "FakeDatabaseWorker", [&order](){ order.push_back(2); });
+    taskScheduler.post(DatabaseTaskPriority::Interactive, "FakeDatabaseWorker", [&order](){ order.push_back(0); });
+    taskScheduler.post(DatabaseTaskPriority::Interactive, "FakeDatabaseWorker", [&order](){ order.push_back(1); });
+
+    postedAll.set_value();
+    taskScheduler.stop();
+
+    const std::vector<int> expected { 0, 1, 2, 3 };
+    QCOMPARE(order, expected);
+}
+
 QTEST_APPLESS_MAIN(DatabaseWorkerTest)
 
 #include "DatabaseWorkerTest.moc"
@@ -2,15 +2,17 @@
 
 #include <QTest>
 
-FakeDatabaseWorker::FakeDatabaseWorker(const QString &dbFile) :
-    DatabaseWorker(dbFile),
+FakeDatabaseWorker::FakeDatabaseWorker(const QString &dbFile, sqlite::Database::OpenMode openMode) :
+    DatabaseWorker(dbFile, openMode),
+    m_readOnly(openMode == sqlite::Database::OpenMode::ReadOnly),
     m_entries()
 {
 }
 
 FakeDatabaseWorker::~FakeDatabaseWorker()
 {
-    save();
+    if (!m_readOnly)
+        save();
 }
 
 sqlite::Database &FakeDatabaseWorker::getHandle()
@@ -18,9 +18,9 @@ class FakeDatabaseWorker final : public DatabaseWorker
     /**
      * @brief FakeDatabaseWorker Constructs an object that interacts with a SQLite database
      * @param dbFile Full path of the database file
-     * @param dbName Name of the database. If empty, will be the application's default database
+     * @param openMode Mode in which the database connection is opened
      */
-    explicit FakeDatabaseWorker(const QString &dbFile);
+    explicit FakeDatabaseWorker(const QString &dbFile, sqlite::Database::OpenMode openMode = sqlite::Database::OpenMode::ReadWrite);
 
     /// Closes the database connection
     ~FakeDatabaseWorker();
@@ -48,6 +48,9 @@ class FakeDatabaseWorker final : public DatabaseWorker
     void load() override;
 
 private:
+    /// True if the worker was opened in read-only mode, in which case it does not save its entries
+    bool m_readOnly;
+
     /// Contains entries of strings corresponding to the 'name' column of the Information table
     std::vector<std::string> m_entries;
 };
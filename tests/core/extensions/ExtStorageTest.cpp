@@ -0,0 +1,135 @@
+#include "DatabaseFactory.h"
+#include "ExtStorage.h"
+
+#include <memory>
+
+#include <QChar>
+#include <QFile>
+#include <QObject>
+#include <QString>
+#include <QTest>
+#include <QVariant>
+
+/// Test cases for the \ref ExtStorage class
+class ExtStorageTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    ExtStorageTest() :
+        QObject(nullptr),
+        m_dbFile(QLatin1String("ExtStorageTest.db"))
+    {
+    }
+
+private slots:
+    /// Called before any tests are executed
+    void initTestCase()
+    {
+        if (QFile::exists(m_dbFile))
+            QFile::remove(m_dbFile);
+    }
+
+    /// Called after every test function, removing the database file
+    void cleanup()
+    {
+        if (QFile::exists(m_dbFile))
+            QFile::remove(m_dbFile);
+    }
+
+    /// Tests that changes are visible to the storage that made them before they are written to the database
+    void testReadYourWritesBeforeFlush()
+    {
+        auto storage = DatabaseFactory::createWorker<ExtStorage>(m_dbFile);
+        storage->setItem(QLatin1String("ext1"), QLatin1String("stored"), QLatin1String("old"));
+        storage->flush();
+
+        storage->setItem(QLatin1String("ext1"), QLatin1String("counter"), QLatin1String("1"));
+        storage->setItem(QLatin1String("ext1"), QLatin1String("counter"), QLatin1String("2"));
+        storage->removeItem(QLatin1String("ext1"), QLatin1String("stored"));
+
+        QCOMPARE(storage->getItem(QLatin1String("ext1"), QLatin1String("counter")).toString(), QLatin1String("2"));
+        QVERIFY(storage->getItem(QLatin1String("ext1"), QLatin1String("stored")).isNull());
+
+        QVariantMap request;
+        request.insert(QLatin1String("counter"), QLatin1String("0"));
+        request.insert(QLatin1String("stored"), QLatin1String("default"));
+        const QVariantMap result = storage->getResult(QLatin1String("ext1"), request);
+        QCOMPARE(result.value(QLatin1String("counter")).toString(), QLatin1String("2"));
+        QCOMPARE(result.value(QLatin1String("stored")).toString(), QLatin1String("default"));
+
+        QCOMPARE(storage->listKeys(QLatin1String("ext1")), QVariantList { QLatin1String("ext1counter") });
+
+        // Another connection to the database only sees the changes that were written
+        {
+            auto reader = DatabaseFactory::createWorker<ExtStorage>(m_dbFile);
+            QCOMPARE(reader->getItem(QLatin1String("ext1"), QLatin1String("stored")).toString(), QLatin1String("old"));
+            QVERIFY(reader->getItem(QLatin1String("ext1"), QLatin1String("counter")).isNull());
+        }
+
+        storage->flush();
+
+        auto reader = DatabaseFactory::createWorker<ExtStorage>(m_dbFile);
+        QCOMPARE(reader->getItem(QLatin1String("ext1"), QLatin1String("counter")).toString(), QLatin1String("2"));
+        QVERIFY(reader->getItem(QLatin1String("ext1"), QLatin1String("stored")).isNull());
+    }
+
+    /// Tests that the keys of an extension do not include the keys of extensions with neighbouring identifiers,
+    /// whether the keys are pending or were written to the database
+    void testListKeysPrefixBoundaries()
+    {
+        // U+FFFF is encoded as EF BF BF, so the upper bound of the prefix is found by incrementing its last byte
+        const QString uid = QLatin1String("ext") + QChar(0xFFFF);
+        const QString lowerUid = QLatin1String("ext") + QChar(0xFFFE);
+        const QString higherUid = QLatin1String("ex") + QChar(0xFFFF);
+        const QString supplementaryUid = QLatin1String("ext") + QString::fromUcs4(U"\U00010000");
+
+        auto storage = DatabaseFactory::createWorker<ExtStorage>(m_dbFile);
+        storage->setItem(uid, QLatin1String("a"), QLatin1String("1"));
+        storage->setItem(lowerUid, QLatin1String("a"), QLatin1String("1"));
+        storage->setItem(higherUid, QLatin1String("a"), QLatin1String("1"));
+        storage->setItem(supplementaryUid, QLatin1String("a"), QLatin1String("1"));
+        storage->setItem(QLatin1String("ext"), QLatin1String("a"), QLatin1String("1"));
+        storage->flush();
+
+        storage->setItem(uid, QLatin1String("b"), QLatin1String("2"));
+        storage->setItem(supplementaryUid, QLatin1String("b"), QLatin1String("2"));
+
+        const QVariantList expected { uid + QLatin1String("a"), uid + QLatin1String("b") };
+        QCOMPARE(storage->listKeys(uid), expected);
+
+        storage->flush();
+        QCOMPARE(storage->listKeys(uid), expected);
+
+        // Identifiers that contain wildcard characters of a LIKE pattern only match themselves
+        storage->setItem(QLatin1String("ext_1"), QLatin1String("a"), QLatin1String("1"));
+        storage->setItem(QLatin1String("extA1"), QLatin1String("a"), QLatin1String("1"));
+        QCOMPARE(storage->listKeys(QLatin1String("ext_")), QVariantList { QLatin1String("ext_1a") });
+    }
+
+    /// Tests that pending changes are written to the database when the storage is destroyed
+    void testFlushOnDestruction()
+    {
+        {
+            auto storage = DatabaseFactory::createWorker<ExtStorage>(m_dbFile);
+            storage->setItem(QLatin1String("ext1"), QLatin1String("removed"), QLatin1String("value"));
+            storage->flush();
+
+            storage->setItem(QLatin1String("ext1"), QLatin1String("kept"), QLatin1String("value"));
+            storage->removeItem(QLatin1String("ext1"), QLatin1String("removed"));
+        }
+
+        auto storage = DatabaseFactory::createWorker<ExtStorage>(m_dbFile);
+        QCOMPARE(storage->getItem(QLatin1String("ext1"), QLatin1String("kept")).toString(), QLatin1String("value"));
+        QVERIFY(storage->getItem(QLatin1String("ext1"), QLatin1String("removed")).isNull());
+        QCOMPARE(storage->listKeys(QLatin1String("ext1")), QVariantList { QLatin1String("ext1kept") });
+    }
+
+private:
+    /// Database file name used for tests
+    QString m_dbFile;
+};
+
+QTEST_GUILESS_MAIN(ExtStorageTest)
+
+#include "ExtStorageTest.moc"
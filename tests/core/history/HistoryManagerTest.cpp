@@ -9,6 +9,7 @@
 #include <QSignalSpy>
 #include <QString>
 #include <QTest>
+#include <QThread>
 
 /// Test cases for the \ref HistoryManager class
 class HistoryManagerTest : public QObject
@@ -64,12 +65,9 @@ private slots:
         QUrl secondUrl { QUrl::fromUserInput("https://a.datacenter.website.net/landing") }, secondUrlRequested { QUrl::fromUserInput("website.net") };
         m_historyManager->addVisit(secondUrl, QLatin1String("Some Website"), QDateTime::currentDateTime(), secondUrlRequested, false);
 
-        auto verifyTrueCB = [](bool result){
-            QVERIFY(result);
-        };
-        m_historyManager->contains(firstUrl, verifyTrueCB);
-        m_historyManager->contains(secondUrl, verifyTrueCB);
-        m_historyManager->contains(secondUrlRequested, verifyTrueCB);
+        QVERIFY(m_historyManager->contains(firstUrl).get());
+        QVERIFY(m_historyManager->contains(secondUrl).get());
+        QVERIFY(m_historyManager->contains(secondUrlRequested).get());
 
         HistoryEntry entry = m_historyManager->getEntry(firstUrl);
         QCOMPARE(entry.URL, firstUrl);
@@ -92,26 +90,19 @@ private slots:
 
         taskScheduler.run();
 
-        auto verifyTrueCB = [](bool result){
-            QVERIFY(result);
-        };
-        auto verifyFalseCB = [](bool result){
-            QVERIFY(!result);
-        };
-
         // Let initialization routine complete
         QTest::qWait(1500);
 
         QUrl firstUrl { QUrl::fromUserInput("https://a.datacenter.website.net/landing") }, firstUrlRequested { QUrl::fromUserInput("website.net") };
         m_historyManager->addVisit(firstUrl, QLatin1String("Some Website"), QDateTime::currentDateTime(), firstUrlRequested, true);
 
-        m_historyManager->contains(firstUrl, verifyTrueCB);
-        m_historyManager->contains(firstUrlRequested, verifyTrueCB);
+        QVERIFY(m_historyManager->contains(firstUrl).get());
+        QVERIFY(m_historyManager->contains(firstUrlRequested).get());
 
         m_historyManager->clearAllHistory();
 
-        m_historyManager->contains(firstUrl, verifyFalseCB);
-        m_historyManager->contains(firstUrlRequested, verifyFalseCB);
+        QVERIFY(!m_historyManager->contains(firstUrl).get());
+        QVERIFY(!m_historyManager->contains(firstUrlRequested).get());
         //QVERIFY2(!m_historyManager->contains(firstUrl), "HistoryManager::clearAllHistory did not remove the entry");
         //QVERIFY2(!m_historyManager->contains(firstUrlRequested), "HistoryManager::clearAllHistory did not remove the entry");
 
@@ -122,8 +113,8 @@ private slots:
         m_historyManager->addVisit(firstUrl, QLatin1String("Some Website"), firstDate, firstUrlRequested, true);
         m_historyManager->addVisit(secondUrl, QLatin1String("Viper Browser"), secondDate, secondUrlRequested, true);
 
-        m_historyManager->contains(firstUrl, verifyTrueCB);
-        m_historyManager->contains(secondUrl, verifyTrueCB);
+        QVERIFY(m_historyManager->contains(firstUrl).get());
+        QVERIFY(m_historyManager->contains(secondUrl).get());
         //QVERIFY(m_historyManager->contains(firstUrl));
         //QVERIFY(m_historyManager->contains(secondUrl));
 
@@ -134,14 +125,14 @@ private slots:
         QVERIFY(spy.wait(5500));
         QCOMPARE(spy.count(), 1);
 
-        m_historyManager->contains(firstUrl, verifyFalseCB);
-        m_historyManager->contains(secondUrl, verifyTrueCB);
+        QVERIFY(!m_historyManager->contains(firstUrl).get());
+        QVERIFY(m_historyManager->contains(secondUrl).get());
         //QVERIFY2(!m_historyManager->contains(firstUrl), "HistoryManager::clearHistoryInRange did not remove the entry");
         //QVERIFY2(m_historyManager->contains(secondUrl), "HistoryManager::clearHistoryInRange removed an entry outside of the given range");
 
         m_historyManager->clearHistoryFrom(QDateTime::currentDateTime().addDays(-1));
 
-        m_historyManager->contains(secondUrl, verifyFalseCB);
+        QVERIFY(!m_historyManager->contains(secondUrl).get());
         //QVERIFY2(!m_historyManager->contains(secondUrl), "HistoryManager::clearHistoryFrom did not remove the entry");
 
         QVERIFY(spy.wait(5500));
@@ -168,15 +159,40 @@ private slots:
         m_historyManager->addVisit(firstUrl, QLatin1String("Viper Browser"), QDateTime::currentDateTime(), firstUrlRequested, false);
         m_historyManager->addVisit(secondUrl, QLatin1String("Some Website"), QDateTime::currentDateTime(), secondUrlRequested, false);
 
-        m_historyManager->getTimesVisitedHost(firstUrl, [](int count){
-            QCOMPARE(count, 1);
-        });
-        m_historyManager->getTimesVisitedHost(secondUrl, [](int count){
-            QCOMPARE(count, 1);
-        });
-        m_historyManager->getTimesVisitedHost(secondUrlRequested, [](int count){
-            QCOMPARE(count, 2);
-        });
+        QCOMPARE(m_historyManager->getTimesVisitedHost(firstUrl).get(), 1);
+        QCOMPARE(m_historyManager->getTimesVisitedHost(secondUrl).get(), 1);
+        QCOMPARE(m_historyManager->getTimesVisitedHost(secondUrlRequested).get(), 2);
+
+        QTest::qWait(300);
+    }
+
+    /// Tests that visits to URLs which differ only in case are counted as visits to the same entry
+    void testEntryLookupIgnoresCase()
+    {
+        DatabaseTaskScheduler taskScheduler;
+        taskScheduler.addWorker("HistoryStore", std::bind(DatabaseFactory::createDBWorker<HistoryStore>, "HistoryManagerTest.db"));
+
+        ViperServiceLocator serviceLocator;
+
+        m_historyManager = new HistoryManager(serviceLocator, taskScheduler);
+
+        taskScheduler.run();
+
+        // Let initialization routine complete
+        QTest::qWait(500);
+
+        const QUrl firstUrl { QUrl::fromUserInput("https://viper-browser.com/About") };
+        const QUrl secondUrl { QUrl::fromUserInput("https://viper-browser.com/ABOUT") };
+        const QUrl otherUrl { QUrl::fromUserInput("https://viper-browser.com/contact") };
+        m_historyManager->addVisit(firstUrl, QLatin1String("About"), QDateTime::currentDateTime(), firstUrl, false);
+        m_historyManager->addVisit(secondUrl, QLatin1String("About"), QDateTime::currentDateTime(), secondUrl, false);
+        m_historyManager->addVisit(otherUrl, QLatin1String("Contact"), QDateTime::currentDateTime(), otherUrl, false);
+
+        HistoryEntry entry = m_historyManager->getEntry(QUrl::fromUserInput("https://viper-browser.com/about"));
+        QCOMPARE(entry.URL, firstUrl);
+        QCOMPARE(entry.NumVisits, 2);
+
+        QCOMPARE(m_historyManager->getEntry(otherUrl).NumVisits, 1);
 
         QTest::qWait(300);
     }
@@ -203,15 +219,54 @@ private slots:
         QUrl secondUrl { QUrl::fromUserInput("https://a.datacenter.website.net/landing") }, secondUrlRequested { QUrl::fromUserInput("website.net") };
         m_historyManager->addVisit(secondUrl, QLatin1String("Some Website"), QDateTime::currentDateTime(), secondUrlRequested, true);
 
-        m_historyManager->getHistoryFrom(firstDate, [=](std::vector<URLRecord> records){
-            const URLRecord &firstRecord = records.at(0);
-            QCOMPARE(firstRecord.getUrl(), firstUrl);
-            QCOMPARE(firstRecord.getLastVisit(), firstDate);
+        const std::vector<URLRecord> records = m_historyManager->getHistoryFrom(firstDate).get();
+        QVERIFY(records.size() >= 2);
+
+        const URLRecord &firstRecord = records.at(0);
+        QCOMPARE(firstRecord.getUrl(), firstUrl);
+        QCOMPARE(firstRecord.getLastVisit(), firstDate);
+
+        QCOMPARE(records.at(1).getUrl(), secondUrlRequested);
+    }
 
-            QCOMPARE(records.at(1).getUrl(), secondUrlRequested);
+    /// Verifies that results are delivered on the thread of the context object, and that
+    /// cancelled requests never invoke their continuation
+    void testFutureContinuationAndCancellation()
+    {
+        DatabaseTaskScheduler taskScheduler;
+        taskScheduler.addWorker("HistoryStore", std::bind(DatabaseFactory::createDBWorker<HistoryStore>, "HistoryManagerTest.db"));
+
+        ViperServiceLocator serviceLocator;
+
+        m_historyManager = new HistoryManager(serviceLocator, taskScheduler);
+
+        taskScheduler.run();
+
+        QUrl url { QUrl::fromUserInput("https://viper-browser.com") };
+        m_historyManager->addVisit(url, QLatin1String("Viper Browser"), QDateTime::currentDateTime(), url, true);
+
+        QObject context;
+        bool delivered = false, deliveredOnContextThread = false;
+        m_historyManager->contains(url).then(&context, [&](bool &&result){
+            delivered = result;
+            deliveredOnContextThread = QThread::currentThread() == context.thread();
         });
+        QTRY_VERIFY(delivered);
+        QVERIFY(deliveredOnContextThread);
 
-        QTest::qWait(1500);
+        bool cancelledWasDelivered = false;
+        DatabaseFuture<std::vector<URLRecord>> future = m_historyManager->getHistoryFrom(QDateTime::currentDateTime().addDays(-1));
+        future.then(&context, [&](std::vector<URLRecord> &&){
+            cancelledWasDelivered = true;
+        });
+        future.cancel();
+
+        QVERIFY(future.isCancelled());
+        QVERIFY(future.get().empty());
+
+        // Process any continuation that may have been queued before the cancellation took effect
+        QTest::qWait(100);
+        QVERIFY(!cancelledWasDelivered);
     }
 
 private:
@@ -1,6 +1,7 @@
 #include "DatabaseFactory.h"
 #include "HistoryStore.h"
 
+#include <algorithm>
 #include <QFile>
 #include <QObject>
 #include <QString>
@@ -132,6 +133,99 @@ private slots:
         QCOMPARE(records.at(1).getUrl(), secondUrlRequested);
     }
 
+    /// Tests paging through visits with the cursor returned by getHistoryPage
+    void testGetHistoryPage()
+    {
+        std::unique_ptr<HistoryStore> historyStore = DatabaseFactory::createWorker<HistoryStore>(m_dbFile);
+
+        const QUrl firstUrl { QUrl::fromUserInput("https://viper-browser.com") };
+        const QUrl secondUrl { QUrl::fromUserInput("https://a.datacenter.website.net/landing") };
+
+        // Visits, from the least to the most recent: first, second, first, second, first
+        const QDateTime now = QDateTime::currentDateTime();
+        std::vector<QDateTime> visitDates;
+        for (int i = 4; i >= 0; --i)
+        {
+            const QDateTime visitDate = now.addSecs(-60 * i);
+            const QUrl &url = (i % 2 == 0) ? firstUrl : secondUrl;
+            historyStore->addVisit(url, QLatin1String("Title"), visitDate, url, false);
+            visitDates.push_back(visitDate);
+        }
+
+        std::vector<QDateTime> pagedVisits;
+        HistoryCursor cursor;
+        int numPages = 0;
+        for (;;)
+        {
+            HistoryPage page = historyStore->getHistoryPage(cursor, 2);
+            ++numPages;
+
+            QVERIFY(page.Records.size() <= 2);
+            for (const URLRecord &record : page.Records)
+            {
+                for (const VisitEntry &visit : record.getVisits())
+                    pagedVisits.push_back(visit);
+            }
+
+            cursor = page.Next;
+            if (!page.HasMore)
+                break;
+
+            QVERIFY2(numPages < 10, "Paging through history should terminate");
+        }
+
+        // Five visits in pages of two, with the last page being empty or partially filled
+        QVERIFY(numPages >= 3);
+        QCOMPARE(pagedVisits.size(), visitDates.size());
+
+        std::sort(pagedVisits.begin(), pagedVisits.end());
+        QCOMPARE(pagedVisits, visitDates);
+
+        // The first page starts with the most recent visit
+        HistoryPage firstPage = historyStore->getHistoryPage(HistoryCursor(), 1);
+        QCOMPARE(firstPage.Records.size(), std::size_t{1});
+        QCOMPARE(firstPage.Records.at(0).getUrl(), firstUrl);
+        QCOMPARE(firstPage.Records.at(0).getLastVisit(), visitDates.back());
+        QVERIFY(firstPage.HasMore);
+    }
+
+    /// Tests that the words of each entry are indexed once, in either the FTS5 table or the word tables
+    void testWordIndex()
+    {
+        std::unique_ptr<HistoryStore> historyStore = DatabaseFactory::createWorker<HistoryStore>(m_dbFile);
+
+        const QUrl firstUrl { QUrl::fromUserInput("https://viper-browser.com/viper") };
+        const QUrl secondUrl { QUrl::fromUserInput("https://charity.org/faq") };
+        historyStore->addVisit(firstUrl, QLatin1String("Viper Browser"), QDateTime::currentDateTime(), firstUrl, false);
+        historyStore->addVisit(secondUrl, QLatin1String("Donate Today"), QDateTime::currentDateTime(), secondUrl, false);
+        historyStore->addVisit(secondUrl, QLatin1String("Donate Today | FAQ"), QDateTime::currentDateTime(), secondUrl, false);
+
+        const std::map<int, QString> words = historyStore->getWords();
+        const std::map<int, std::vector<int>> wordMapping = historyStore->getEntryWordMapping();
+        if (historyStore->hasFullTextIndex())
+        {
+            QVERIFY2(words.empty(), "Word table should not be used with the full-text index");
+            QVERIFY(wordMapping.empty());
+            return;
+        }
+
+        // Each word is stored once, even when it appears more than once in an entry or in several entries
+        std::vector<QString> wordList;
+        for (const auto &it : words)
+            wordList.push_back(it.second);
+        std::sort(wordList.begin(), wordList.end());
+        QVERIFY(std::adjacent_find(wordList.begin(), wordList.end()) == wordList.end());
+        QVERIFY(std::find(wordList.begin(), wordList.end(), QLatin1String("VIPER")) != wordList.end());
+        QVERIFY(std::find(wordList.begin(), wordList.end(), QLatin1String("DONATE")) != wordList.end());
+
+        QCOMPARE(wordMapping.size(), std::size_t{2});
+        for (const auto &it : wordMapping)
+        {
+            for (int wordId : it.second)
+                QVERIFY2(words.find(wordId) != words.end(), "Entry should only be associated with known words");
+        }
+    }
+
     /*
      * todo: test cases for:
 
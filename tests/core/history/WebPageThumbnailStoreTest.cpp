@@ -0,0 +1,144 @@
+#include "DatabaseFactory.h"
+#include "DatabaseTaskScheduler.h"
+#include "FavoritePagesManager.h"
+#include "WebPageThumbnailStore.h"
+
+#include <memory>
+#include <vector>
+
+#include <QColor>
+#include <QFile>
+#include <QImage>
+#include <QObject>
+#include <QString>
+#include <QTest>
+#include <QUrl>
+
+/// Test cases for the \ref WebPageThumbnailStore class
+class WebPageThumbnailStoreTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    WebPageThumbnailStoreTest() :
+        QObject(nullptr),
+        m_dbFile(QLatin1String("WebPageThumbnailStoreTest.db"))
+    {
+    }
+
+private slots:
+    /// Called before any tests are executed
+    void initTestCase()
+    {
+        if (QFile::exists(m_dbFile))
+            QFile::remove(m_dbFile);
+    }
+
+    /// Called after every test function, removing the database file
+    void cleanup()
+    {
+        if (QFile::exists(m_dbFile))
+            QFile::remove(m_dbFile);
+    }
+
+    /// Tests that captures of a page are scaled down to the size of a thumbnail, and that smaller captures keep their size
+    void testScaleThumbnail()
+    {
+        QImage capture(1600, 1200, QImage::Format_ARGB32);
+        capture.fill(QColor(Qt::darkCyan));
+
+        const QImage thumbnail = WebPageThumbnailStore::scaleThumbnail(capture);
+        QCOMPARE(thumbnail.width(), WebPageThumbnailStore::ThumbnailWidth);
+        QCOMPARE(thumbnail.height(), WebPageThumbnailStore::ThumbnailHeight);
+        QCOMPARE(thumbnail.format(), QImage::Format_RGB32);
+
+        QImage smallCapture(200, 100, QImage::Format_ARGB32);
+        smallCapture.fill(QColor(Qt::darkCyan));
+
+        const QImage smallThumbnail = WebPageThumbnailStore::scaleThumbnail(smallCapture);
+        QCOMPARE(smallThumbnail.size(), smallCapture.size());
+        QCOMPARE(smallThumbnail.format(), QImage::Format_RGB32);
+    }
+
+    /// Tests that the thumbnails of the most visited hosts are written to the database in one batch,
+    /// and that the other thumbnails stay marked for the next save
+    void testSavesThumbnailsOfMostVisitedHosts()
+    {
+        DatabaseTaskScheduler taskScheduler;
+        taskScheduler.run();
+
+        auto store = DatabaseFactory::createWorker<WebPageThumbnailStore>(m_dbFile, taskScheduler, nullptr, nullptr);
+        addThumbnail(*store, QLatin1String("first.example.com"));
+        addThumbnail(*store, QLatin1String("second.example.com"));
+        addThumbnail(*store, QLatin1String("third.example.com"));
+
+        store->onMostVisitedPagesLoaded(getPages({ QLatin1String("first.example.com"), QLatin1String("second.example.com") }));
+
+        QCOMPARE(store->m_dirtyHosts.size(), static_cast<std::size_t>(1));
+        QVERIFY(store->m_dirtyHosts.count("third.example.com") == 1);
+
+        auto reader = DatabaseFactory::createWorker<WebPageThumbnailStore>(m_dbFile, taskScheduler, nullptr, nullptr);
+        QTRY_VERIFY(!reader->getThumbnail(QUrl(QLatin1String("https://first.example.com/"))).isNull());
+        QVERIFY(!reader->getThumbnail(QUrl(QLatin1String("https://second.example.com/page"))).isNull());
+        QVERIFY(reader->getThumbnail(QUrl(QLatin1String("https://third.example.com/"))).isNull());
+
+        reader.reset();
+        store.reset();
+        taskScheduler.stop();
+    }
+
+    /// Tests that thumbnails waiting for the database strand are written when the store is destroyed
+    void testWritesPendingThumbnailsOnDestruction()
+    {
+        // The scheduler is not running, so the write task stays queued until after the store is destroyed
+        DatabaseTaskScheduler taskScheduler;
+
+        auto store = DatabaseFactory::createWorker<WebPageThumbnailStore>(m_dbFile, taskScheduler, nullptr, nullptr);
+        addThumbnail(*store, QLatin1String("first.example.com"));
+
+        store->onMostVisitedPagesLoaded(getPages({ QLatin1String("first.example.com") }));
+        QCOMPARE(store->m_pendingWrites->Thumbnails.size(), static_cast<std::size_t>(1));
+
+        store.reset();
+
+        auto reader = DatabaseFactory::createWorker<WebPageThumbnailStore>(m_dbFile, taskScheduler, nullptr, nullptr);
+        QVERIFY(!reader->getThumbnail(QUrl(QLatin1String("https://first.example.com/"))).isNull());
+        reader.reset();
+
+        // The queued task must not touch the destroyed store
+        taskScheduler.run();
+        taskScheduler.stop();
+    }
+
+private:
+    /// Places a thumbnail of the given host into the store's cache, marking it as changed
+    void addThumbnail(WebPageThumbnailStore &store, const QString &host)
+    {
+        QImage image(WebPageThumbnailStore::ThumbnailWidth, WebPageThumbnailStore::ThumbnailHeight, QImage::Format_RGB32);
+        image.fill(QColor(Qt::darkCyan));
+
+        store.cacheThumbnail(host.toStdString(), image);
+        store.m_dirtyHosts.insert(host.toStdString());
+    }
+
+    /// Returns the information of a page on each of the given hosts, as loaded from the history
+    std::vector<WebPageInformation> getPages(const std::vector<QString> &hosts)
+    {
+        std::vector<WebPageInformation> pages;
+        for (const QString &host : hosts)
+        {
+            WebPageInformation page;
+            page.URL = QUrl(QString("https://%1/").arg(host));
+            pages.push_back(page);
+        }
+        return pages;
+    }
+
+private:
+    /// Database file name used for tests
+    QString m_dbFile;
+};
+
+QTEST_GUILESS_MAIN(WebPageThumbnailStoreTest)
+
+#include "WebPageThumbnailStoreTest.moc"
@@ -0,0 +1,81 @@
+#include "BrowserTabWidget.h"
+#include "ServiceLocator.h"
+#include "WebState.h"
+#include "WebWidget.h"
+
+#include <QObject>
+#include <QString>
+#include <QTest>
+#include <QUrl>
+#include <QWebEngineProfile>
+
+/// Tests that the tabs restored from a session keep the state they were restored with, and load it once
+class SessionRestoreTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    SessionRestoreTest() :
+        QObject(nullptr)
+    {
+    }
+
+private slots:
+    /// Tests that a tab restored as a placeholder keeps the URL of the session, instead of loading the new tab page
+    void testPlaceholderKeepsUrl()
+    {
+        ViperServiceLocator serviceLocator;
+        BrowserTabWidget tabWidget(serviceLocator, false, nullptr);
+
+        const QUrl url(QLatin1String("https://viper-browser.com/about"));
+
+        WebState state;
+        state.title = QLatin1String("About");
+        state.url = url;
+
+        WebWidget *ww = tabWidget.newPlaceholderTabAtIndex(0, std::move(state));
+        QVERIFY(ww != nullptr);
+        QVERIFY(ww->isPlaceholder());
+        QCOMPARE(ww->url(), url);
+        QCOMPARE(ww->getState().url, url);
+        QCOMPARE(ww->getTitle(), QLatin1String("About"));
+        QCOMPARE(tabWidget.tabText(tabWidget.indexOf(ww)), QLatin1String("About"));
+    }
+
+    /// Tests that a restored background tab loads its page with a single navigation, without loading the new tab page first
+    void testRestoredTabNavigatesOnce()
+    {
+        ViperServiceLocator serviceLocator;
+        serviceLocator.addService("PublicWebProfile", QWebEngineProfile::defaultProfile());
+        BrowserTabWidget tabWidget(serviceLocator, false, nullptr);
+
+        WebState state;
+        state.url = QUrl(QLatin1String("about:blank"));
+
+        WebWidget *ww = tabWidget.newBackgroundTabAtIndex(0, std::move(state));
+        QVERIFY(ww != nullptr);
+        QCOMPARE(ww->getWakeNavigationCount(), 1);
+    }
+
+    /// Tests that waking a placeholder tab loads its page with a single navigation
+    void testPlaceholderWakesWithOneNavigation()
+    {
+        ViperServiceLocator serviceLocator;
+        serviceLocator.addService("PublicWebProfile", QWebEngineProfile::defaultProfile());
+        BrowserTabWidget tabWidget(serviceLocator, false, nullptr);
+
+        WebState state;
+        state.url = QUrl(QLatin1String("about:blank"));
+
+        WebWidget *ww = tabWidget.newPlaceholderTabAtIndex(0, std::move(state));
+        QCOMPARE(ww->getWakeNavigationCount(), 0);
+
+        ww->setHibernation(false);
+        QVERIFY(!ww->isHibernating());
+        QCOMPARE(ww->getWakeNavigationCount(), 1);
+    }
+};
+
+QTEST_MAIN(SessionRestoreTest)
+
+#include "SessionRestoreTest.moc"
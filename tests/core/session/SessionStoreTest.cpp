@@ -0,0 +1,159 @@
+#include "SessionStore.h"
+
+#include <QFile>
+#include <QObject>
+#include <QString>
+#include <QTest>
+
+class SessionStoreTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    SessionStoreTest() :
+        QObject(nullptr),
+        m_snapshotFile(QLatin1String("SessionStoreTest.snapshot")),
+        m_logFile(QLatin1String("SessionStoreTest.log"))
+    {
+    }
+
+private:
+    /// Returns a tab in the given window, at the given index
+    SessionTab makeTab(quint32 tabId, quint32 windowId, int index, const QString &url)
+    {
+        SessionTab tab;
+        tab.TabId = tabId;
+        tab.WindowId = windowId;
+        tab.Index = index;
+        tab.URL = QUrl(url);
+        tab.Title = url;
+        tab.FaviconId = static_cast<int>(tabId);
+        tab.History = url.toLatin1();
+        tab.LastActive = 1000 + tabId;
+        return tab;
+    }
+
+    /// Returns a session with one window and two tabs
+    SessionState makeSession()
+    {
+        SessionState state;
+
+        SessionWindow window;
+        window.WindowId = 1;
+        window.Geometry = QRect(10, 20, 800, 600);
+        window.CurrentTab = 1;
+        state.Windows[window.WindowId] = window;
+
+        state.Tabs[2] = makeTab(2, 1, 0, QLatin1String("https://viper-browser.com"));
+        state.Tabs[3] = makeTab(3, 1, 1, QLatin1String("https://example.com"));
+        return state;
+    }
+
+    /// Returns a record of the given type for the given tab
+    SessionRecord makeTabRecord(SessionRecordType type, const SessionTab &tab)
+    {
+        SessionRecord record;
+        record.Type = type;
+        record.Tab = tab;
+        return record;
+    }
+
+private slots:
+    /// Called after every test function, removing the session files
+    void cleanup()
+    {
+        QFile::remove(m_snapshotFile);
+        QFile::remove(m_logFile);
+    }
+
+    /// Tests that the changes appended to the log are replayed onto the snapshot
+    void testReplayLog()
+    {
+        {
+            SessionStore store(m_snapshotFile, m_logFile);
+            store.reset(makeSession());
+            store.append({ makeTabRecord(SessionRecordType::TabOpened, makeTab(4, 1, 2, QLatin1String("https://new.com"))),
+                           makeTabRecord(SessionRecordType::TabNavigated, makeTab(2, 1, 0, QLatin1String("https://viper-browser.com/about"))) });
+
+            SessionRecord closeRecord;
+            closeRecord.Type = SessionRecordType::TabClosed;
+            closeRecord.Tab.TabId = 3;
+            store.append({ closeRecord });
+        }
+
+        SessionState state;
+        QVERIFY(SessionStore::readSession(m_snapshotFile, m_logFile, state));
+        QCOMPARE(state.Windows.size(), std::size_t{1});
+        QCOMPARE(state.Windows.at(1).Geometry, QRect(10, 20, 800, 600));
+
+        const std::vector<SessionTab> tabs = state.getTabsOfWindow(1);
+        QCOMPARE(tabs.size(), std::size_t{2});
+        QCOMPARE(tabs.at(0).URL, QUrl(QLatin1String("https://viper-browser.com/about")));
+        QCOMPARE(tabs.at(0).FaviconId, 2);
+        QCOMPARE(tabs.at(0).LastActive, qint64{1002});
+        QCOMPARE(tabs.at(1).URL, QUrl(QLatin1String("https://new.com")));
+        QCOMPARE(tabs.at(1).History, QByteArray("https://new.com"));
+    }
+
+    /// Tests that a record that was only partially written to the log is ignored
+    void testPartialRecordIgnored()
+    {
+        {
+            SessionStore store(m_snapshotFile, m_logFile);
+            store.reset(makeSession());
+            store.append({ makeTabRecord(SessionRecordType::TabOpened, makeTab(4, 1, 2, QLatin1String("https://new.com"))) });
+        }
+
+        // Simulate a crash while a record was being appended
+        QFile log(m_logFile);
+        QVERIFY(log.open(QIODevice::ReadWrite));
+        QVERIFY(log.resize(log.size() - 3));
+        log.close();
+
+        SessionState state;
+        QVERIFY(SessionStore::readSession(m_snapshotFile, m_logFile, state));
+        QCOMPARE(state.Tabs.size(), std::size_t{2});
+        QVERIFY(state.Tabs.find(4) == state.Tabs.end());
+    }
+
+    /// Tests that a log that was written before the current snapshot is not replayed
+    void testStaleLogIgnored()
+    {
+        {
+            SessionStore store(m_snapshotFile, m_logFile);
+            store.reset(makeSession());
+            store.append({ makeTabRecord(SessionRecordType::TabOpened, makeTab(4, 1, 2, QLatin1String("https://new.com"))) });
+        }
+
+        QFile::remove(m_logFile + QLatin1String(".old"));
+        QVERIFY(QFile::copy(m_logFile, m_logFile + QLatin1String(".old")));
+
+        // Compact the session, then restore the log of the previous snapshot, as if the browser crashed
+        // after writing the new snapshot but before emptying the log
+        {
+            SessionStore store(m_snapshotFile, m_logFile);
+            SessionState state = makeSession();
+            state.Tabs.erase(3);
+            store.reset(state);
+        }
+
+        QVERIFY(QFile::remove(m_logFile));
+        QVERIFY(QFile::rename(m_logFile + QLatin1String(".old"), m_logFile));
+
+        SessionState state;
+        QVERIFY(SessionStore::readSession(m_snapshotFile, m_logFile, state));
+        QCOMPARE(state.Tabs.size(), std::size_t{1});
+        QVERIFY(state.Tabs.find(2) != state.Tabs.end());
+    }
+
+private:
+    /// Session snapshot file used for testing
+    QString m_snapshotFile;
+
+    /// Session log file used for testing
+    QString m_logFile;
+};
+
+QTEST_APPLESS_MAIN(SessionStoreTest)
+
+#include "SessionStoreTest.moc"
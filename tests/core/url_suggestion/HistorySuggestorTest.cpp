@@ -68,7 +68,7 @@ private Q_SLOTS:
 
         ViperServiceLocator serviceLocator;
 
-        FaviconManager faviconManager(TEST_FAVICON_DB_FILE);
+        FaviconManager faviconManager(taskScheduler, TEST_FAVICON_DB_FILE);
         HistoryManager historyManager(serviceLocator, taskScheduler);
 
         QVERIFY(serviceLocator.addService(faviconManager.objectName().toStdString(), &faviconManager));
@@ -145,7 +145,7 @@ private Q_SLOTS:
 
         ViperServiceLocator serviceLocator;
 
-        FaviconManager faviconManager(TEST_FAVICON_DB_FILE);
+        FaviconManager faviconManager(taskScheduler, TEST_FAVICON_DB_FILE);
         HistoryManager historyManager(serviceLocator, taskScheduler);
 
         QVERIFY(serviceLocator.addService(faviconManager.objectName().toStdString(), &faviconManager));
@@ -0,0 +1,75 @@
+#include "UserScriptIndex.h"
+
+#include <QObject>
+#include <QString>
+#include <QTest>
+
+class UserScriptIndexTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    UserScriptIndexTest() :
+        QObject(nullptr)
+    {
+    }
+
+private slots:
+    /// Tests that scripts whose rules name a host are only candidates for pages of that host
+    void testExactHost()
+    {
+        UserScriptIndex index;
+        index.addScript(0, { QLatin1String("https://example.com/*") });
+        index.addScript(1, { QLatin1String("http://www.example.com:8080/path/*") });
+
+        QCOMPARE(index.getCandidates(QLatin1String("example.com")), std::vector<std::size_t>({ 0 }));
+        QCOMPARE(index.getCandidates(QLatin1String("WWW.Example.com")), std::vector<std::size_t>({ 1 }));
+        QVERIFY(index.getCandidates(QLatin1String("viper-browser.com")).empty());
+    }
+
+    /// Tests that scripts with a "*." host rule are candidates for the domain and all of its subdomains
+    void testSubdomains()
+    {
+        UserScriptIndex index;
+        index.addScript(0, { QLatin1String("*://*.example.com/*") });
+
+        QCOMPARE(index.getCandidates(QLatin1String("example.com")), std::vector<std::size_t>({ 0 }));
+        QCOMPARE(index.getCandidates(QLatin1String("a.b.example.com")), std::vector<std::size_t>({ 0 }));
+        QVERIFY(index.getCandidates(QLatin1String("notexample.com")).empty());
+    }
+
+    /// Tests that scripts with rules that do not name a single host are candidates for every host
+    void testAnyHost()
+    {
+        UserScriptIndex index;
+        index.addScript(0, {});
+        index.addScript(1, { QLatin1String("/^https?://.*\\.org/") });
+        index.addScript(2, { QLatin1String("<all_urls>") });
+        index.addScript(3, { QLatin1String("http://*example.com/*") });
+        index.addScript(4, { QLatin1String("https://example.com/*"), QLatin1String("*") });
+        index.addScript(5, { QLatin1String("https://example.org/*") });
+
+        const std::vector<std::size_t> expected { 0, 1, 2, 3, 4 };
+        QCOMPARE(index.getCandidates(QLatin1String("viper-browser.com")), expected);
+        QCOMPARE(index.getCandidates(QString()), expected);
+        QCOMPARE(index.getCandidates(QLatin1String("example.org")), std::vector<std::size_t>({ 0, 1, 2, 3, 4, 5 }));
+    }
+
+    /// Tests that a script matched by several of its rules is only returned once
+    void testNoDuplicates()
+    {
+        UserScriptIndex index;
+        index.addScript(7, { QLatin1String("https://example.com/*"),
+                             QLatin1String("http://example.com/*"),
+                             QLatin1String("*://*.example.com/*") });
+
+        QCOMPARE(index.getCandidates(QLatin1String("example.com")), std::vector<std::size_t>({ 7 }));
+
+        index.clear();
+        QVERIFY(index.getCandidates(QLatin1String("example.com")).empty());
+    }
+};
+
+QTEST_APPLESS_MAIN(UserScriptIndexTest)
+
+#include "UserScriptIndexTest.moc"
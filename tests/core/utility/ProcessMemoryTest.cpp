@@ -0,0 +1,79 @@
+#include "ProcessMemory.h"
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QList>
+#include <QObject>
+#include <QTest>
+
+class ProcessMemoryTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /// Tests that the fields of a stat file are read after the process name, even if the name contains spaces and parentheses
+    void testParseStatFields()
+    {
+        const QByteArray stat("1234 (Web (Content) Process) S 42 1234 1234 0 -1 4194560 100 0 0 0 250 75 0 0 20 0 1 0\n");
+
+        const QList<QByteArray> fields = ProcessMemory::parseStatFields(stat);
+        QCOMPARE(fields.size(), 20);
+        QCOMPARE(fields.at(0), QByteArray("S"));
+        QCOMPARE(fields.at(1), QByteArray("42"));
+        QCOMPARE(fields.last(), QByteArray("0"));
+
+        QCOMPARE(ProcessMemory::parseParentPid(stat), qint64{42});
+    }
+
+    /// Tests that malformed stat files are rejected
+    void testParseMalformedStat()
+    {
+        QVERIFY(ProcessMemory::parseStatFields(QByteArray()).isEmpty());
+        QVERIFY(ProcessMemory::parseStatFields(QByteArray("1234 viper S 1")).isEmpty());
+        QVERIFY(ProcessMemory::parseStatFields(QByteArray("1234 (viper)")).isEmpty());
+
+        QCOMPARE(ProcessMemory::parseParentPid(QByteArray("1234 (viper) S")), qint64{-1});
+        QCOMPARE(ProcessMemory::parseParentPid(QByteArray("1234 (viper) S abc 1")), qint64{-1});
+    }
+
+    /// Tests that the user and kernel mode clock ticks are read from the utime and stime fields of a stat file
+    void testParseCpuTicks()
+    {
+        QCOMPARE(ProcessMemory::parseCpuTicks(QByteArray("1234 (Web (Content) Process) S 42 1234 1234 0 -1 4194560 100 0 0 0 250 75 0 0 20 0 1 0\n")),
+                 qint64{325});
+        QCOMPARE(ProcessMemory::parseCpuTicks(QByteArray("1234 (viper) R 1 1234 1234 0 -1 4194304 0 0 0 0 0 0")), qint64{0});
+    }
+
+    /// Tests that stat files without numeric utime and stime fields are rejected
+    void testParseMalformedCpuTicks()
+    {
+        QCOMPARE(ProcessMemory::parseCpuTicks(QByteArray()), qint64{-1});
+        QCOMPARE(ProcessMemory::parseCpuTicks(QByteArray("1234 (viper) S 42 1234 1234 0 -1 4194560 100 0 0 0 250")), qint64{-1});
+        QCOMPARE(ProcessMemory::parseCpuTicks(QByteArray("1234 (viper) S 42 1234 1234 0 -1 4194560 100 0 0 0 250 x75")), qint64{-1});
+    }
+
+    /// Tests that the number of resident pages is read from the second field of a statm file
+    void testParseResidentPages()
+    {
+        QCOMPARE(ProcessMemory::parseResidentPages(QByteArray("254630 31052 12345 412 0 60123 0\n")), qint64{31052});
+        QCOMPARE(ProcessMemory::parseResidentPages(QByteArray("254630")), qint64{-1});
+        QCOMPARE(ProcessMemory::parseResidentPages(QByteArray("254630 pages 0")), qint64{-1});
+        QCOMPARE(ProcessMemory::parseResidentPages(QByteArray()), qint64{-1});
+    }
+
+    /// Tests that the memory and CPU time of the running process can be measured
+    void testResidentSizeOfCurrentProcess()
+    {
+#if defined(Q_OS_LINUX)
+        QVERIFY(ProcessMemory::getResidentSize(QCoreApplication::applicationPid()) > 0);
+        QVERIFY(ProcessMemory::getBrowserResidentSize() > 0);
+        QVERIFY(ProcessMemory::getCpuTime(QCoreApplication::applicationPid()) >= 0);
+#else
+        QSKIP("Process memory is only measured on Linux");
+#endif
+    }
+};
+
+QTEST_GUILESS_MAIN(ProcessMemoryTest)
+
+#include "ProcessMemoryTest.moc"
@@ -0,0 +1,87 @@
+#include "TraceLog.h"
+
+#include <thread>
+#include <vector>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QObject>
+#include <QString>
+#include <QTest>
+
+class TraceLogTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    /// Returns the span events of the current trace with the given name
+    std::vector<QJsonObject> getSpans(const QString &name)
+    {
+        std::vector<QJsonObject> result;
+
+        const QJsonDocument trace = QJsonDocument::fromJson(TraceLog::toJson());
+        const QJsonArray events = trace.object().value(QLatin1String("traceEvents")).toArray();
+        for (const QJsonValue &event : events)
+        {
+            const QJsonObject eventObj = event.toObject();
+            if (eventObj.value(QLatin1String("ph")).toString() == QLatin1String("X")
+                    && eventObj.value(QLatin1String("name")).toString() == name)
+                result.push_back(eventObj);
+        }
+        return result;
+    }
+
+private slots:
+    /// Tests that no spans are recorded while tracing is disabled
+    void testDisabled()
+    {
+        TraceLog::setEnabled(false);
+        {
+            VIPER_TRACE_SCOPE("test", "DisabledSpan");
+        }
+
+        QVERIFY(getSpans(QLatin1String("DisabledSpan")).empty());
+    }
+
+    /// Tests that spans recorded on different threads are exported with their own thread identifiers
+    void testSpansOnThreads()
+    {
+        TraceLog::setEnabled(true);
+        {
+            VIPER_TRACE_SCOPE("test", "MainThreadSpan");
+        }
+
+        std::thread worker([](){
+            VIPER_TRACE_SCOPE("test", "WorkerThreadSpan");
+        });
+        worker.join();
+        TraceLog::setEnabled(false);
+
+        const std::vector<QJsonObject> mainSpans = getSpans(QLatin1String("MainThreadSpan"));
+        const std::vector<QJsonObject> workerSpans = getSpans(QLatin1String("WorkerThreadSpan"));
+        QCOMPARE(mainSpans.size(), std::size_t{1});
+        QCOMPARE(workerSpans.size(), std::size_t{1});
+
+        QCOMPARE(mainSpans.at(0).value(QLatin1String("cat")).toString(), QLatin1String("test"));
+        QVERIFY(mainSpans.at(0).value(QLatin1String("dur")).toDouble() >= 0.0);
+        QVERIFY(mainSpans.at(0).value(QLatin1String("tid")).toInt() != workerSpans.at(0).value(QLatin1String("tid")).toInt());
+    }
+
+    /// Tests that spans are kept once a thread has recorded more spans than fit in a single chunk of its buffer
+    void testManySpans()
+    {
+        TraceLog::setEnabled(true);
+        for (int i = 0; i < 10000; ++i)
+        {
+            VIPER_TRACE_SCOPE("test", "RepeatedSpan");
+        }
+        TraceLog::setEnabled(false);
+
+        QCOMPARE(getSpans(QLatin1String("RepeatedSpan")).size(), std::size_t{10000});
+    }
+};
+
+QTEST_APPLESS_MAIN(TraceLogTest)
+
+#include "TraceLogTest.moc"
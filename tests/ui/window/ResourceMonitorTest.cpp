@@ -0,0 +1,104 @@
+#include "IResourceReporter.h"
+#include "ResourceMonitor.h"
+
+#include <utility>
+#include <vector>
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QObject>
+#include <QString>
+#include <QTest>
+
+/// Reports a fixed list of resources
+class FakeResourceReporter : public IResourceReporter
+{
+public:
+    /// Constructs the reporter with the resources it reports
+    explicit FakeResourceReporter(std::vector<ResourceUsage> usage) :
+        m_usage(std::move(usage))
+    {
+    }
+
+    /// Returns the resources given to the constructor
+    std::vector<ResourceUsage> getResourceUsage() const override
+    {
+        return m_usage;
+    }
+
+private:
+    /// Resources returned by the reporter
+    std::vector<ResourceUsage> m_usage;
+};
+
+/// Test cases for the \ref ResourceMonitor class
+class ResourceMonitorTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /// Tests that the report contains the browser process, one entry for each part of every subsystem, and the tabs
+    void testReportShape()
+    {
+        FakeResourceReporter history({
+            ResourceUsage { QStringLiteral("History entries"), 12, 4096 },
+            ResourceUsage { QStringLiteral("Recent history"), 3, -1 }
+        });
+        FakeResourceReporter favicons({ ResourceUsage { QStringLiteral("Favicons"), 5, 2048 } });
+
+        ResourceMonitor monitor;
+        monitor.addReporter(&history);
+        monitor.addReporter(&favicons);
+        monitor.addReporter(&favicons);
+
+        const QJsonObject report = monitor.getReport({}, nullptr);
+        QVERIFY(report.value(QStringLiteral("timestamp")).toInteger() > 0);
+
+        const QJsonObject browser = report.value(QStringLiteral("browser")).toObject();
+        QCOMPARE(browser.value(QStringLiteral("pid")).toInteger(), QCoreApplication::applicationPid());
+        QVERIFY(browser.contains(QStringLiteral("residentSize")));
+        QVERIFY(browser.contains(QStringLiteral("cpuTime")));
+        QVERIFY(browser.contains(QStringLiteral("totalResidentSize")));
+
+        // A reporter that is added twice is only reported once
+        const QJsonArray subsystems = report.value(QStringLiteral("subsystems")).toArray();
+        QCOMPARE(subsystems.size(), 3);
+
+        const QJsonObject entries = subsystems.at(0).toObject();
+        QCOMPARE(entries.value(QStringLiteral("name")).toString(), QStringLiteral("History entries"));
+        QCOMPARE(entries.value(QStringLiteral("items")).toInteger(), qint64{12});
+        QCOMPARE(entries.value(QStringLiteral("estimatedSize")).toInteger(), qint64{4096});
+        QCOMPARE(subsystems.at(1).toObject().value(QStringLiteral("estimatedSize")).toInteger(), qint64{-1});
+        QCOMPARE(subsystems.at(2).toObject().value(QStringLiteral("name")).toString(), QStringLiteral("Favicons"));
+
+        QVERIFY(report.value(QStringLiteral("tabs")).isArray());
+        QVERIFY(report.value(QStringLiteral("tabs")).toArray().isEmpty());
+
+        // The lifecycle counters are left out without a lifecycle manager
+        QVERIFY(!report.contains(QStringLiteral("tabLifecycle")));
+
+        monitor.removeReporter(&history);
+        QCOMPARE(monitor.getReport({}, nullptr).value(QStringLiteral("subsystems")).toArray().size(), 1);
+    }
+
+    /// Tests that the names of subsystems are escaped in the HTML page, and that unknown sizes are shown as a dash
+    void testHtmlEscapesNames()
+    {
+        FakeResourceReporter reporter({ ResourceUsage { QStringLiteral("<script>"), 1, -1 } });
+
+        ResourceMonitor monitor;
+        monitor.addReporter(&reporter);
+
+        const QByteArray html = ResourceMonitor::toHtml(monitor.getReport({}, nullptr));
+        QVERIFY(html.contains("&lt;script&gt;"));
+        QVERIFY(!html.contains("<script>"));
+        QVERIFY(html.contains("<td class=\"num\">&mdash;</td>"));
+    }
+};
+
+QTEST_GUILESS_MAIN(ResourceMonitorTest)
+
+#include "ResourceMonitorTest.moc"
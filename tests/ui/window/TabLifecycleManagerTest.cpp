@@ -0,0 +1,75 @@
+#include "TabLifecycleManager.h"
+
+#include <utility>
+#include <vector>
+
+#include <QObject>
+#include <QTest>
+
+class TabLifecycleManagerTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    /// Returns a candidate without a web widget, identified by the time it was last shown
+    TabLifecycleCandidate makeCandidate(bool isPinned, qint64 lastActive)
+    {
+        return TabLifecycleCandidate { nullptr, isPinned, lastActive };
+    }
+
+private slots:
+    /// Tests that unpinned tabs are unloaded before pinned tabs, and that the least recently used tabs are unloaded first
+    void testRankCandidates()
+    {
+        std::vector<TabLifecycleCandidate> candidates {
+            makeCandidate(false, 300), makeCandidate(true, 100), makeCandidate(false, 100),
+            makeCandidate(true, 50),   makeCandidate(false, 200)
+        };
+
+        TabLifecycleManager::rankCandidates(candidates);
+
+        const std::vector<std::pair<bool, qint64>> expected {
+            { false, 100 }, { false, 200 }, { false, 300 }, { true, 50 }, { true, 100 }
+        };
+        QCOMPARE(candidates.size(), expected.size());
+        for (std::size_t i = 0; i < expected.size(); ++i)
+        {
+            QCOMPARE(candidates.at(i).IsPinned, expected.at(i).first);
+            QCOMPARE(candidates.at(i).LastActive, expected.at(i).second);
+        }
+    }
+
+    /// Tests that no tabs are unloaded while the browser is within its budgets, or when the budgets are disabled
+    void testWithinBudgets()
+    {
+        const qint64 mebibyte = 1024 * 1024;
+
+        QCOMPARE(TabLifecycleManager::getTransitionLimit(1000 * mebibyte, 4096 * mebibyte, 10, 50), 0);
+        QCOMPARE(TabLifecycleManager::getTransitionLimit(4096 * mebibyte, 4096 * mebibyte, 50, 50), 0);
+        QCOMPARE(TabLifecycleManager::getTransitionLimit(8192 * mebibyte, 0, 100, 0), 0);
+        QCOMPARE(TabLifecycleManager::getTransitionLimit(-1, 4096 * mebibyte, 10, 50), 0);
+    }
+
+    /// Tests the number of tabs that are unloaded when the memory budget or the maximum number of live tabs is exceeded
+    void testOverBudgets()
+    {
+        const qint64 mebibyte = 1024 * 1024;
+
+        // Going over the memory budget unloads a fixed number of tabs per check
+        QCOMPARE(TabLifecycleManager::getTransitionLimit(4097 * mebibyte, 4096 * mebibyte, 10, 50),
+                 TabLifecycleManager::MaxTransitionsPerCheck);
+
+        // Every tab over the maximum is unloaded at once
+        QCOMPARE(TabLifecycleManager::getTransitionLimit(1000 * mebibyte, 4096 * mebibyte, 51, 50), 1);
+        QCOMPARE(TabLifecycleManager::getTransitionLimit(1000 * mebibyte, 0, 60, 50), 10);
+
+        // When both budgets are exceeded, the larger number of transitions is used
+        QCOMPARE(TabLifecycleManager::getTransitionLimit(5000 * mebibyte, 4096 * mebibyte, 52, 50),
+                 TabLifecycleManager::MaxTransitionsPerCheck);
+        QCOMPARE(TabLifecycleManager::getTransitionLimit(5000 * mebibyte, 4096 * mebibyte, 60, 50), 10);
+    }
+};
+
+QTEST_APPLESS_MAIN(TabLifecycleManagerTest)
+
+#include "TabLifecycleManagerTest.moc"